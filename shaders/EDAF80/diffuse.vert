@@ -9,13 +9,36 @@
 // Similarly, normal is set to location 1, which corresponds to attribute 1 of
 // the vertex array, and therefore will be filled with normals taken out of our
 // buffer.
-layout (location = 0) in vec3 vertex;
+layout (location = 0) in vec4 vertex;
 layout (location = 1) in vec3 normal;
 
 uniform mat4 vertex_model_to_world;
 uniform mat4 normal_model_to_world;
 uniform mat4 vertex_world_to_clip;
 
+// Meshes uploaded with a packed vertex layout store their attributes
+// compressed; see `bonobo::vertex_decoding`.
+uniform bool vertex_attributes_packed;
+uniform vec3 position_dequantisation_offset;
+uniform vec3 position_dequantisation_scale;
+
+vec3 decode_position(vec4 stored)
+{
+	return vertex_attributes_packed ? position_dequantisation_offset + position_dequantisation_scale * stored.xyz : stored.xyz;
+}
+
+// Packed normals and tangents are octahedral-encoded.
+vec3 decode_unit_vector(vec3 stored)
+{
+	if (!vertex_attributes_packed)
+		return stored;
+
+	vec3 v = vec3(stored.xy, 1.0 - abs(stored.x) - abs(stored.y));
+	if (v.z < 0.0)
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
 // This is the custom output of this shader. If you want to retrieve this data
 // from another shader further down the pipeline, you need to declare the exact
 // same structure as in (for input), with matching name for the structure
@@ -29,10 +52,11 @@ out VS_OUT {
 
 void main()
 {
-	vs_out.vertex = vec3(vertex_model_to_world * vec4(vertex, 1.0));
-	vs_out.normal = vec3(normal_model_to_world * vec4(normal, 0.0));
+	vec3 position = decode_position(vertex);
+	vs_out.vertex = vec3(vertex_model_to_world * vec4(position, 1.0));
+	vs_out.normal = vec3(normal_model_to_world * vec4(decode_unit_vector(normal), 0.0));
 
-	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(vertex, 1.0);
+	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(position, 1.0);
 }
 
 
@@ -1,6 +1,6 @@
 #version 410
 
-layout (location = 0) in vec3 vertex;
+layout (location = 0) in vec4 vertex;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec3 texcoord;
 layout (location = 3) in vec3 tangent;
@@ -10,6 +10,43 @@ uniform mat4 vertex_model_to_world;
 uniform mat4 normal_model_to_world;
 uniform mat4 vertex_world_to_clip;
 
+// Meshes uploaded with a packed vertex layout store their attributes
+// compressed; see `bonobo::vertex_decoding`.
+uniform bool vertex_attributes_packed;
+uniform vec3 position_dequantisation_offset;
+uniform vec3 position_dequantisation_scale;
+uniform vec2 texcoord_dequantisation_offset;
+uniform vec2 texcoord_dequantisation_scale;
+
+vec3 decode_position(vec4 stored)
+{
+	return vertex_attributes_packed ? position_dequantisation_offset + position_dequantisation_scale * stored.xyz : stored.xyz;
+}
+
+// Packed normals and tangents are octahedral-encoded.
+vec3 decode_unit_vector(vec3 stored)
+{
+	if (!vertex_attributes_packed)
+		return stored;
+
+	vec3 v = vec3(stored.xy, 1.0 - abs(stored.x) - abs(stored.y));
+	if (v.z < 0.0)
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
+vec2 decode_texcoord(vec3 stored)
+{
+	return vertex_attributes_packed ? texcoord_dequantisation_offset + texcoord_dequantisation_scale * stored.xy : stored.xy;
+}
+
+// Packed binormals are not stored, only their sign, in the w component
+// of the position.
+vec3 decode_binormal(vec3 stored, vec3 normal, vec3 tangent, float sign_bit)
+{
+	return vertex_attributes_packed ? (sign_bit * 2.0 - 1.0) * cross(normal, tangent) : stored;
+}
+
 out VS_OUT {
 	vec2 texcoord;
 	vec3 normal;
@@ -19,16 +56,19 @@ out VS_OUT {
 
 void main()
 {
-	vec4 vertex_world = vertex_model_to_world * vec4(vertex, 1.0);
+	vec4 vertex_world = vertex_model_to_world * vec4(decode_position(vertex), 1.0);
 	gl_Position = vertex_world_to_clip * vertex_world;
 
 	// Compute tangent, binormal, normal in world coordinates
-	vec3 T = normalize(vec3(normal_model_to_world * vec4(tangent, 0.0)));
-	vec3 B = normalize(vec3(normal_model_to_world * vec4(binormal, 0.0)));
-	vec3 N = normalize(vec3(normal_model_to_world * vec4(normal, 0.0)));
+	vec3 normal_model = decode_unit_vector(normal);
+	vec3 tangent_model = decode_unit_vector(tangent);
+	vec3 binormal_model = decode_binormal(binormal, normal_model, tangent_model, vertex.w);
+	vec3 T = normalize(vec3(normal_model_to_world * vec4(tangent_model, 0.0)));
+	vec3 B = normalize(vec3(normal_model_to_world * vec4(binormal_model, 0.0)));
+	vec3 N = normalize(vec3(normal_model_to_world * vec4(normal_model, 0.0)));
 
 	// Texture coordinates
-	vs_out.texcoord = texcoord.xy;
+	vs_out.texcoord = decode_texcoord(texcoord);
 	// Normal, in world space
 	vs_out.normal = N;
 	// Position, in world space
@@ -1,16 +1,28 @@
 #version 410
 
-layout (location = 0) in vec3 vertex;
+layout (location = 0) in vec4 vertex;
 
 uniform mat4 vertex_model_to_world;
 uniform mat4 vertex_world_to_clip;
 
+// Meshes uploaded with a packed vertex layout store their attributes
+// compressed; see `bonobo::vertex_decoding`.
+uniform bool vertex_attributes_packed;
+uniform vec3 position_dequantisation_offset;
+uniform vec3 position_dequantisation_scale;
+
+vec3 decode_position(vec4 stored)
+{
+	return vertex_attributes_packed ? position_dequantisation_offset + position_dequantisation_scale * stored.xyz : stored.xyz;
+}
+
 out VS_OUT {
 	vec3 texcoord;
 } vs_out;
 
 void main()
 {
-	vs_out.texcoord = vertex;
-	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(vertex, 1.0);
+	vec3 position = decode_position(vertex);
+	vs_out.texcoord = position;
+	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(position, 1.0);
 }
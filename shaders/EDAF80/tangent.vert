@@ -1,12 +1,35 @@
 #version 410
 
-layout (location = 0) in vec3 vertex;
+layout (location = 0) in vec4 vertex;
 layout (location = 3) in vec3 tangent;
 
 uniform mat4 vertex_model_to_world;
 uniform mat4 normal_model_to_world;
 uniform mat4 vertex_world_to_clip;
 
+// Meshes uploaded with a packed vertex layout store their attributes
+// compressed; see `bonobo::vertex_decoding`.
+uniform bool vertex_attributes_packed;
+uniform vec3 position_dequantisation_offset;
+uniform vec3 position_dequantisation_scale;
+
+vec3 decode_position(vec4 stored)
+{
+	return vertex_attributes_packed ? position_dequantisation_offset + position_dequantisation_scale * stored.xyz : stored.xyz;
+}
+
+// Packed normals and tangents are octahedral-encoded.
+vec3 decode_unit_vector(vec3 stored)
+{
+	if (!vertex_attributes_packed)
+		return stored;
+
+	vec3 v = vec3(stored.xy, 1.0 - abs(stored.x) - abs(stored.y));
+	if (v.z < 0.0)
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
 out VS_OUT {
 	vec3 tangent;
 } vs_out;
@@ -14,7 +37,7 @@ out VS_OUT {
 
 void main()
 {
-	vs_out.tangent = normalize(vec3(normal_model_to_world * vec4(tangent, 0.0)));
+	vs_out.tangent = normalize(vec3(normal_model_to_world * vec4(decode_unit_vector(tangent), 0.0)));
 
-	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(vertex, 1.0);
+	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(decode_position(vertex), 1.0);
 }
@@ -1,11 +1,29 @@
 #version 410
 
-layout (location = 0) in vec3 vertex;
+layout (location = 0) in vec4 vertex;
 layout (location = 2) in vec3 texcoord;
 
 uniform mat4 vertex_model_to_world;
 uniform mat4 vertex_world_to_clip;
 
+// Meshes uploaded with a packed vertex layout store their attributes
+// compressed; see `bonobo::vertex_decoding`.
+uniform bool vertex_attributes_packed;
+uniform vec3 position_dequantisation_offset;
+uniform vec3 position_dequantisation_scale;
+uniform vec2 texcoord_dequantisation_offset;
+uniform vec2 texcoord_dequantisation_scale;
+
+vec3 decode_position(vec4 stored)
+{
+	return vertex_attributes_packed ? position_dequantisation_offset + position_dequantisation_scale * stored.xyz : stored.xyz;
+}
+
+vec2 decode_texcoord(vec3 stored)
+{
+	return vertex_attributes_packed ? texcoord_dequantisation_offset + texcoord_dequantisation_scale * stored.xy : stored.xy;
+}
+
 out VS_OUT {
 	vec2 texcoord;
 } vs_out;
@@ -13,7 +31,7 @@ out VS_OUT {
 
 void main()
 {
-	vs_out.texcoord = texcoord.xy;
+	vs_out.texcoord = decode_texcoord(texcoord);
 
-	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(vertex, 1.0);
+	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(decode_position(vertex), 1.0);
 }
@@ -1,6 +1,6 @@
 #version 410
 
-layout (location = 0) in vec3 vertex;
+layout (location = 0) in vec4 vertex;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec3 texcoord;
 layout (location = 3) in vec3 tangent;
@@ -11,6 +11,69 @@ uniform mat4 normal_model_to_world;
 uniform mat4 vertex_world_to_clip;
 uniform float time;
 
+// Meshes from `parametric_shapes::createProceduralQuad()` have no vertex
+// buffer: each vertex is rebuilt from gl_VertexID instead, knowing the
+// number of vertices along each side of the grid and its size.
+uniform bool use_procedural_grid;
+uniform ivec2 grid_vertices_count;
+uniform vec2 grid_size;
+
+// Geometry clipmaps: the same patch, a grid of clipmap_patch_cells cells
+// built as above, is drawn once per instance. Instances 0 to 15 form a
+// 4×4 block making up the finest level, then each coarser level adds a
+// ring of 12 patches with cells twice as large around the previous one.
+// All levels are centred on clipmap_centre, in model space, which is
+// snapped to the cells of the coarsest level so that no vertex slides
+// across the waves as the camera moves.
+uniform bool use_clipmap;
+uniform vec2 clipmap_centre;
+uniform float clipmap_cell_size; // of the finest level
+uniform int clipmap_patch_cells;
+
+const ivec2 clipmap_ring_patches[12] = ivec2[12](
+	ivec2(0, 0), ivec2(1, 0), ivec2(2, 0), ivec2(3, 0),
+	ivec2(0, 1),                           ivec2(3, 1),
+	ivec2(0, 2),                           ivec2(3, 2),
+	ivec2(0, 3), ivec2(1, 3), ivec2(2, 3), ivec2(3, 3)
+);
+
+// Meshes uploaded with a packed vertex layout store their attributes
+// compressed; see `bonobo::vertex_decoding`.
+uniform bool vertex_attributes_packed;
+uniform vec3 position_dequantisation_offset;
+uniform vec3 position_dequantisation_scale;
+uniform vec2 texcoord_dequantisation_offset;
+uniform vec2 texcoord_dequantisation_scale;
+
+vec3 decode_position(vec4 stored)
+{
+	return vertex_attributes_packed ? position_dequantisation_offset + position_dequantisation_scale * stored.xyz : stored.xyz;
+}
+
+// Packed normals and tangents are octahedral-encoded.
+vec3 decode_unit_vector(vec3 stored)
+{
+	if (!vertex_attributes_packed)
+		return stored;
+
+	vec3 v = vec3(stored.xy, 1.0 - abs(stored.x) - abs(stored.y));
+	if (v.z < 0.0)
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
+vec2 decode_texcoord(vec3 stored)
+{
+	return vertex_attributes_packed ? texcoord_dequantisation_offset + texcoord_dequantisation_scale * stored.xy : stored.xy;
+}
+
+// Packed binormals are not stored, only their sign, in the w component
+// of the position.
+vec3 decode_binormal(vec3 stored, vec3 normal, vec3 tangent, float sign_bit)
+{
+	return vertex_attributes_packed ? (sign_bit * 2.0 - 1.0) * cross(normal, tangent) : stored;
+}
+
 out VS_OUT {
 	vec3 vertex;
 	vec3 normal;
@@ -36,26 +99,99 @@ void wave(in wave_par par, in vec3 v, in float time, out float G, out float dGdx
 	dGdy = 0.5 * par.k * par.f * par.A * pow(s, par.k - 1.0) * c * par.D.y;
 }
 
+// Average of a wave over two points, as seen halfway along a straight
+// edge between them.
+void wave_average(in wave_par par, in vec3 v0, in vec3 v1, in float time, out float G, out float dGdx, out float dGdy) {
+	float G0, dG0dx, dG0dy, G1, dG1dx, dG1dy;
+	wave(par, v0, time, G0, dG0dx, dG0dy);
+	wave(par, v1, time, G1, dG1dx, dG1dy);
+	G = 0.5 * (G0 + G1);
+	dGdx = 0.5 * (dG0dx + dG1dx);
+	dGdy = 0.5 * (dG0dy + dG1dy);
+}
+
 #define M_PI 3.1415926535897932384626433832795
 
 void main()
 {
+	float scale = 100.0;
+
+	vec3 position;
+	vec3 normal_model;
+	vec3 tangent_model;
+	vec3 binormal_model;
+	vec2 texcoord_model;
+	vec2 stitch_offset = vec2(0.0);
+	if (use_clipmap) {
+		int level = 0;
+		ivec2 patch_index = ivec2(gl_InstanceID % 4, gl_InstanceID / 4);
+		if (gl_InstanceID >= 16) {
+			level = 1 + (gl_InstanceID - 16) / 12;
+			patch_index = clipmap_ring_patches[(gl_InstanceID - 16) % 12];
+		}
+
+		// Coordinates of the vertex in cells from the centre of its level
+		int patch_vertices_count = clipmap_patch_cells + 1;
+		ivec2 ij = ivec2(gl_VertexID / patch_vertices_count, gl_VertexID % patch_vertices_count);
+		ivec2 cell = (patch_index - 2) * clipmap_patch_cells + ij;
+		float cell_size = clipmap_cell_size * float(1 << level);
+		position = vec3(clipmap_centre + vec2(cell) * cell_size, 0.0);
+
+		// Every other vertex along the outer edge of a level has no
+		// counterpart in the coarser level around it: it takes the
+		// average of its two neighbours, which do, so that no crack
+		// opens between the levels.
+		int edge = 2 * clipmap_patch_cells;
+		if (abs(cell.x) == edge && (cell.y & 1) != 0)
+			stitch_offset = vec2(0.0, cell_size);
+		else if (abs(cell.y) == edge && (cell.x & 1) != 0)
+			stitch_offset = vec2(cell_size, 0.0);
+
+		// Same mapping as for the quad, except that it does not stop at
+		// its edges.
+		texcoord_model = position.yx / scale;
+		normal_model = vec3(0.0, 0.0, 1.0);
+		tangent_model = vec3(1.0, 0.0, 0.0);
+		binormal_model = vec3(0.0, 1.0, 0.0);
+	} else if (use_procedural_grid) {
+		// Same layout as `parametric_shapes::buildQuad()`: one row of
+		// constant x after the other.
+		ivec2 ij = ivec2(gl_VertexID / grid_vertices_count.y, gl_VertexID % grid_vertices_count.y);
+		vec2 uv = vec2(ij) / vec2(grid_vertices_count - 1);
+		position = vec3(uv * grid_size, 0.0);
+		texcoord_model = uv.yx;
+		normal_model = vec3(0.0, 0.0, 1.0);
+		tangent_model = vec3(1.0, 0.0, 0.0);
+		binormal_model = vec3(0.0, 1.0, 0.0);
+	} else {
+		position = decode_position(vertex);
+		normal_model = decode_unit_vector(normal);
+		tangent_model = decode_unit_vector(tangent);
+		binormal_model = decode_binormal(binormal, normal_model, tangent_model, vertex.w);
+		texcoord_model = decode_texcoord(texcoord);
+	}
+
 	// Define wave parameters
 	wave_par wave_par1 = wave_par(1.0, vec3(-1.0, 0.0, 0.0), 0.2, 0.5, 2.0);
 	wave_par wave_par2 = wave_par(0.5, vec3(-0.7, 0.7, 0.0), 0.4, 1.3, 2.0);
 
 	// Adjust direction vector slightly so that the wave offset if the same for texture
 	// coordinates 0 and 1, i.e. so there is no gap at the edges of the sphere.
-	float scale = 100.0;
 	wave_par2.D.y = 4.0 * M_PI / scale / wave_par2.f;
 
 	// Evaluate wave equation
 	float G1, G2, dG1dx, dG1dy, dG2dx, dG2dy;
 	// Scale texture coordinate from (0,1) to (0,100). This is equivalent to the
 	// vertex position for the quad, and proportional to theta/pi for the sphere.
-	vec3 v = scale * texcoord.yxz;
-	wave(wave_par1, v, time, G1, dG1dx, dG1dy);
-	wave(wave_par2, v, time, G2, dG2dx, dG2dy);
+	vec3 v = use_clipmap ? vec3(position.xy, 0.0) : scale * vec3(texcoord_model.yx, 0.0);
+	if (stitch_offset != vec2(0.0)) {
+		vec3 offset = vec3(stitch_offset, 0.0);
+		wave_average(wave_par1, v - offset, v + offset, time, G1, dG1dx, dG1dy);
+		wave_average(wave_par2, v - offset, v + offset, time, G2, dG2dx, dG2dy);
+	} else {
+		wave(wave_par1, v, time, G1, dG1dx, dG1dy);
+		wave(wave_par2, v, time, G2, dG2dx, dG2dy);
+	}
 
 	// TBN in wave coordinate space
 	vec3 t = vec3(1.0, 0.0, dG1dx + dG1dx);
@@ -63,10 +199,10 @@ void main()
 	vec3 n = vec3(-(dG1dx + dG2dx), -(dG1dy + dG2dy), 1.0);
 
 	// TBN surface matrix
-	mat3 TBN_surface = mat3(tangent, binormal, normal);
+	mat3 TBN_surface = mat3(tangent_model, binormal_model, normal_model);
 
 	// Compute vertex position and normal
-	vec4 displaced_vertex = vec4(vertex + (G1 + G2) * normal, 1.0);
+	vec4 displaced_vertex = vec4(position + (G1 + G2) * normal_model, 1.0);
 	vs_out.vertex = vec3(vertex_model_to_world * displaced_vertex);
 	vs_out.normal = vec3(normal_model_to_world * vec4(TBN_surface * n, 0.0));
 
@@ -74,9 +210,9 @@ void main()
 	vec2 tex_scale = vec2(8.0, 4.0);
 	float normal_time = mod(time, 100.0);
 	vec2 normal_speed = vec2(-0.05, 0.0);
-	vs_out.normalcoord0 = texcoord.xy * tex_scale + normal_time * normal_speed;
-	vs_out.normalcoord1 = texcoord.xy * tex_scale * 2.0 + normal_time * normal_speed * 4.0;
-	vs_out.normalcoord2 = texcoord.xy * tex_scale * 4.0 + normal_time * normal_speed * 8.0;
+	vs_out.normalcoord0 = texcoord_model * tex_scale + normal_time * normal_speed;
+	vs_out.normalcoord1 = texcoord_model * tex_scale * 2.0 + normal_time * normal_speed * 4.0;
+	vs_out.normalcoord2 = texcoord_model * tex_scale * 4.0 + normal_time * normal_speed * 8.0;
 
 	// Compute tangent space to world space matrix
 	vec3 T = normalize(vec3(normal_model_to_world * vec4(TBN_surface * t, 0.0)));
@@ -21,6 +21,14 @@ layout (location = 0) out vec4 geometry_diffuse;
 layout (location = 1) out vec4 geometry_specular;
 layout (location = 2) out vec4 geometry_normal;
 
+// Normal maps only store x and y, see `bonobo::texture_role_t::normal_map`;
+// z is reconstructed knowing that the normal is of unit length and points
+// away from the surface.
+vec3 sample_normal_map(vec2 texcoord)
+{
+	vec2 xy = texture(normals_texture, texcoord).rg * 2.0 - 1.0;
+	return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
 
 void main()
 {
@@ -32,11 +40,13 @@ void main()
 	if (has_diffuse_texture)
 		geometry_diffuse = texture(diffuse_texture, fs_in.texcoord);
 
-	// Specular color
+	// Specular color, from a mask only storing its red channel
 	geometry_specular = vec4(0.0f);
 	if (has_specular_texture)
-		geometry_specular = texture(specular_texture, fs_in.texcoord);
+		geometry_specular = vec4(texture(specular_texture, fs_in.texcoord).rrr, 1.0);
 
-	// Worldspace normal
+	// Worldspace normal; when adding normal mapping, read the
+	// tangent-space normal with `sample_normal_map(fs_in.texcoord)` rather than
+	// sampling the texture directly, as only its x and y are stored.
 	geometry_normal.xyz = vec3(0.0);
 }
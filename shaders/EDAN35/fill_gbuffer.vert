@@ -13,12 +13,49 @@ layout (std140) uniform CameraViewProjTransforms
 
 uniform mat4 vertex_model_to_world;
 
-layout (location = 0) in vec3 vertex;
+layout (location = 0) in vec4 vertex;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec3 texcoord;
 layout (location = 3) in vec3 tangent;
 layout (location = 4) in vec3 binormal;
 
+// Meshes uploaded with a packed vertex layout store their attributes
+// compressed; see `bonobo::vertex_decoding`.
+uniform bool vertex_attributes_packed;
+uniform vec3 position_dequantisation_offset;
+uniform vec3 position_dequantisation_scale;
+uniform vec2 texcoord_dequantisation_offset;
+uniform vec2 texcoord_dequantisation_scale;
+
+vec3 decode_position(vec4 stored)
+{
+	return vertex_attributes_packed ? position_dequantisation_offset + position_dequantisation_scale * stored.xyz : stored.xyz;
+}
+
+// Packed normals and tangents are octahedral-encoded.
+vec3 decode_unit_vector(vec3 stored)
+{
+	if (!vertex_attributes_packed)
+		return stored;
+
+	vec3 v = vec3(stored.xy, 1.0 - abs(stored.x) - abs(stored.y));
+	if (v.z < 0.0)
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
+vec2 decode_texcoord(vec3 stored)
+{
+	return vertex_attributes_packed ? texcoord_dequantisation_offset + texcoord_dequantisation_scale * stored.xy : stored.xy;
+}
+
+// Packed binormals are not stored, only their sign, in the w component
+// of the position.
+vec3 decode_binormal(vec3 stored, vec3 normal, vec3 tangent, float sign_bit)
+{
+	return vertex_attributes_packed ? (sign_bit * 2.0 - 1.0) * cross(normal, tangent) : stored;
+}
+
 out VS_OUT {
 	vec3 normal;
 	vec2 texcoord;
@@ -28,10 +65,13 @@ out VS_OUT {
 
 
 void main() {
-	vs_out.normal   = normalize(normal);
-	vs_out.texcoord = texcoord.xy;
-	vs_out.tangent  = normalize(tangent);
-	vs_out.binormal = normalize(binormal);
+	vec3 normal_model  = decode_unit_vector(normal);
+	vec3 tangent_model = decode_unit_vector(tangent);
+
+	vs_out.normal   = normalize(normal_model);
+	vs_out.texcoord = decode_texcoord(texcoord);
+	vs_out.tangent  = normalize(tangent_model);
+	vs_out.binormal = normalize(decode_binormal(binormal, normal_model, tangent_model, vertex.w));
 
-	gl_Position = camera.view_projection * vertex_model_to_world * vec4(vertex, 1.0);
+	gl_Position = camera.view_projection * vertex_model_to_world * vec4(decode_position(vertex), 1.0);
 }
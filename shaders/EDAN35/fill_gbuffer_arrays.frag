@@ -0,0 +1,66 @@
+#version 410
+
+// Counterpart to fill_gbuffer.frag for materials packed by
+// `bonobo::material_packer`: all meshes share the same texture arrays,
+// and each draw only selects its layers.
+
+// Must match `constant::max_packed_materials_nb`.
+#define MAX_MATERIALS_NB 1024
+
+// Layers of the diffuse, specular, normals and opacity textures of each
+// material, or -1 when missing.
+layout (std140) uniform MaterialLayers
+{
+	ivec4 material_layers[MAX_MATERIALS_NB];
+};
+
+uniform int material_index;
+uniform sampler2DArray diffuse_textures;
+uniform sampler2DArray specular_textures;
+uniform sampler2DArray normals_textures;
+uniform sampler2DArray opacity_textures;
+uniform mat4 normal_model_to_world;
+
+in VS_OUT {
+	vec3 normal;
+	vec2 texcoord;
+	vec3 tangent;
+	vec3 binormal;
+} fs_in;
+
+layout (location = 0) out vec4 geometry_diffuse;
+layout (location = 1) out vec4 geometry_specular;
+layout (location = 2) out vec4 geometry_normal;
+
+// Normal maps only store x and y, see `bonobo::texture_role_t::normal_map`;
+// z is reconstructed knowing that the normal is of unit length and points
+// away from the surface.
+vec3 sample_normal_map(vec2 texcoord, int layer)
+{
+	vec2 xy = texture(normals_textures, vec3(texcoord, layer)).rg * 2.0 - 1.0;
+	return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
+
+void main()
+{
+	ivec4 layers = material_layers[material_index];
+
+	if (layers.w >= 0 && texture(opacity_textures, vec3(fs_in.texcoord, layers.w)).r < 1.0)
+		discard;
+
+	// Diffuse color
+	geometry_diffuse = vec4(0.0f);
+	if (layers.x >= 0)
+		geometry_diffuse = texture(diffuse_textures, vec3(fs_in.texcoord, layers.x));
+
+	// Specular color, from a mask only storing its red channel
+	geometry_specular = vec4(0.0f);
+	if (layers.y >= 0)
+		geometry_specular = vec4(texture(specular_textures, vec3(fs_in.texcoord, layers.y)).rrr, 1.0);
+
+	// Worldspace normal; when adding normal mapping, read the
+	// tangent-space normal with
+	// `sample_normal_map(fs_in.texcoord, layers.z)` rather than sampling
+	// the texture directly, as only its x and y are stored.
+	geometry_normal.xyz = vec3(0.0);
+}
@@ -14,16 +14,34 @@ layout (std140) uniform LightViewProjTransforms
 uniform int light_index;
 uniform mat4 vertex_model_to_world;
 
-layout (location = 0) in vec3 vertex;
+layout (location = 0) in vec4 vertex;
 layout (location = 2) in vec3 texcoord;
 
+// Meshes uploaded with a packed vertex layout store their attributes
+// compressed; see `bonobo::vertex_decoding`.
+uniform bool vertex_attributes_packed;
+uniform vec3 position_dequantisation_offset;
+uniform vec3 position_dequantisation_scale;
+uniform vec2 texcoord_dequantisation_offset;
+uniform vec2 texcoord_dequantisation_scale;
+
+vec3 decode_position(vec4 stored)
+{
+	return vertex_attributes_packed ? position_dequantisation_offset + position_dequantisation_scale * stored.xyz : stored.xyz;
+}
+
+vec2 decode_texcoord(vec3 stored)
+{
+	return vertex_attributes_packed ? texcoord_dequantisation_offset + texcoord_dequantisation_scale * stored.xy : stored.xy;
+}
+
 out VS_OUT {
 	vec2 texcoord;
 } vs_out;
 
 void main()
 {
-	vs_out.texcoord = texcoord.xy;
+	vs_out.texcoord = decode_texcoord(texcoord);
 
-	gl_Position = lights[light_index].view_projection * vertex_model_to_world * vec4(vertex, 1.0);
+	gl_Position = lights[light_index].view_projection * vertex_model_to_world * vec4(decode_position(vertex), 1.0);
 }
@@ -0,0 +1,26 @@
+#version 410
+
+// Counterpart to fill_shadowmap.frag for materials packed by
+// `bonobo::material_packer`, see fill_gbuffer_arrays.frag.
+
+// Must match `constant::max_packed_materials_nb`.
+#define MAX_MATERIALS_NB 1024
+
+layout (std140) uniform MaterialLayers
+{
+	ivec4 material_layers[MAX_MATERIALS_NB];
+};
+
+uniform int material_index;
+uniform sampler2DArray opacity_textures;
+
+in VS_OUT {
+	vec2 texcoord;
+} fs_in;
+
+void main()
+{
+	int layer = material_layers[material_index].w;
+	if (layer >= 0 && texture(opacity_textures, vec3(fs_in.texcoord, layer)).r < 1.0)
+		discard;
+}
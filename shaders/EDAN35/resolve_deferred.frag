@@ -9,6 +9,16 @@ layout (pixel_center_integer) in vec4 gl_FragCoord;
 
 out vec4 frag_color;
 
+// Lighting is computed in linear space, as the diffuse textures are
+// sRGB-encoded and decoded when sampled; encode the result back for
+// display.
+vec3 linear_to_srgb(vec3 linear)
+{
+	vec3 low  = linear * 12.92;
+	vec3 high = 1.055 * pow(linear, vec3(1.0 / 2.4)) - 0.055;
+	return mix(high, low, lessThanEqual(linear, vec3(0.0031308)));
+}
+
 void main()
 {
 	ivec2 pixel_coord = ivec2(gl_FragCoord.xy);
@@ -20,5 +30,6 @@ void main()
 	vec3 light_s  = texelFetch(light_s_texture,  pixel_coord, 0).rgb;
 	const vec3 ambient = vec3(0.15);
 
-	frag_color =  vec4((ambient + light_d) * diffuse + light_s * specular, 1.0);
+	vec3 color = (ambient + light_d) * diffuse + light_s * specular;
+	frag_color = vec4(linear_to_srgb(clamp(color, 0.0, 1.0)), 1.0);
 }
@@ -142,19 +142,23 @@ int main()
 
 
 	//
-	// Load all textures.
+	// Load all textures; they get block-compressed once and cached next
+	// to the images, which divides the memory they take on the GPU by
+	// eight, or by four for those with an alpha channel.
 	//
-	GLuint const sun_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_sun.jpg"));
-	GLuint const mercury_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_mercury.jpg"));
-	GLuint const venus_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_venus_atmosphere.jpg"));
-	GLuint const earth_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_earth_daymap.jpg"));
-	GLuint const moon_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_moon.jpg"));
-	GLuint const mars_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_mars.jpg"));
-	GLuint const jupiter_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_jupiter.jpg"));
-	GLuint const saturn_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_saturn.jpg"));
-	GLuint const saturn_ring_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_saturn_ring_alpha.png"));
-	GLuint const uranus_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_uranus.jpg"));
-	GLuint const neptune_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_neptune.jpg"));
+	bonobo::texture_load_options planet_texture_options;
+	planet_texture_options.compress = true;
+	GLuint const sun_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_sun.jpg"), planet_texture_options);
+	GLuint const mercury_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_mercury.jpg"), planet_texture_options);
+	GLuint const venus_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_venus_atmosphere.jpg"), planet_texture_options);
+	GLuint const earth_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_earth_daymap.jpg"), planet_texture_options);
+	GLuint const moon_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_moon.jpg"), planet_texture_options);
+	GLuint const mars_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_mars.jpg"), planet_texture_options);
+	GLuint const jupiter_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_jupiter.jpg"), planet_texture_options);
+	GLuint const saturn_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_saturn.jpg"), planet_texture_options);
+	GLuint const saturn_ring_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_saturn_ring_alpha.png"), planet_texture_options);
+	GLuint const uranus_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_uranus.jpg"), planet_texture_options);
+	GLuint const neptune_texture = bonobo::loadTexture2D(config::resources_path("planets/2k_neptune.jpg"), planet_texture_options);
 
 
 	//
@@ -352,17 +356,17 @@ int main()
 		glfwSwapBuffers(window);
 	}
 
-	glDeleteTextures(1, &neptune_texture);
-	glDeleteTextures(1, &uranus_texture);
-	glDeleteTextures(1, &saturn_ring_texture);
-	glDeleteTextures(1, &saturn_texture);
-	glDeleteTextures(1, &jupiter_texture);
-	glDeleteTextures(1, &mars_texture);
-	glDeleteTextures(1, &moon_texture);
-	glDeleteTextures(1, &earth_texture);
-	glDeleteTextures(1, &venus_texture);
-	glDeleteTextures(1, &mars_texture);
-	glDeleteTextures(1, &sun_texture);
+	bonobo::releaseTexture(neptune_texture);
+	bonobo::releaseTexture(uranus_texture);
+	bonobo::releaseTexture(saturn_ring_texture);
+	bonobo::releaseTexture(saturn_texture);
+	bonobo::releaseTexture(jupiter_texture);
+	bonobo::releaseTexture(mars_texture);
+	bonobo::releaseTexture(moon_texture);
+	bonobo::releaseTexture(earth_texture);
+	bonobo::releaseTexture(venus_texture);
+	bonobo::releaseTexture(mercury_texture);
+	bonobo::releaseTexture(sun_texture);
 
 	bonobo::deinit();
 
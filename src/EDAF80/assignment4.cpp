@@ -102,9 +102,24 @@ edaf80::Assignment4::run()
 		glUniform4fv(glGetUniformLocation(program, "color_deep"), 1, glm::value_ptr(color_deep));
 		glUniform4fv(glGetUniformLocation(program, "color_shallow"), 1, glm::value_ptr(color_shallow));
 		glUniform3fv(glGetUniformLocation(program, "camera_position"), 1, glm::value_ptr(camera_position));
+		glUniform1i(glGetUniformLocation(program, "use_procedural_grid"), 0);
+		glUniform1i(glGetUniformLocation(program, "use_clipmap"), 0);
 	};
 
-	auto water_shape = parametric_shapes::createQuad(100.0f, 100.0f, 1000, 1000);
+	// The water quad has no vertex buffer: water.vert rebuilds each
+	// vertex from its index, saving the upload of a million vertices.
+	float const water_size = 100.0f;
+	unsigned int const water_split_count = 1000u;
+	auto const set_water_grid_uniforms = [&set_water_uniforms,water_size,water_split_count](GLuint program){
+		set_water_uniforms(program);
+		auto const vertices_count = static_cast<GLint>(water_split_count + 2u);
+		glUniform1i(glGetUniformLocation(program, "use_procedural_grid"), 1);
+		glUniform2i(glGetUniformLocation(program, "grid_vertices_count"), vertices_count, vertices_count);
+		glUniform2f(glGetUniformLocation(program, "grid_size"), water_size, water_size);
+	};
+
+	auto water_shape = parametric_shapes::createProceduralQuad(water_size, water_size,
+	                                                           water_split_count, water_split_count);
 	if (water_shape.vao == 0u) {
 		LogError("Failed to retrieve the mesh for the water");
 		return;
@@ -120,11 +135,49 @@ edaf80::Assignment4::run()
 
 	Node water;
 	water.set_geometry(water_shape);
-	water.set_program(&water_shader, set_water_uniforms);
+	water.set_program(&water_shader, set_water_grid_uniforms);
 	water.add_texture("cubemap", cubemap, GL_TEXTURE_CUBE_MAP);
 	water.add_texture("normal_map", normal_map, GL_TEXTURE_2D);
 	water.get_transform().SetRotateX(-glm::half_pi<float>());
 
+	// Alternatively, the water follows the camera as geometry clipmaps:
+	// cells as small as the quad's around the camera, twice as large
+	// with each level, up to about 200 m away, for a fraction of the
+	// vertices. All levels are instances of a single patch, see water.vert.
+	unsigned int const clipmap_patch_cells = 32u;
+	unsigned int const clipmap_levels_nb = 6u;
+	auto const clipmap_patches_nb = static_cast<GLsizei>(16u + 12u * (clipmap_levels_nb - 1u));
+	float const clipmap_cell_size = water_size / static_cast<float>(water_split_count + 1u);
+	float const clipmap_coarsest_cell_size = clipmap_cell_size * static_cast<float>(1u << (clipmap_levels_nb - 1u));
+
+	auto clipmap_patch_shape = parametric_shapes::createProceduralQuad(clipmap_patch_cells * clipmap_cell_size,
+	                                                                   clipmap_patch_cells * clipmap_cell_size,
+	                                                                   clipmap_patch_cells - 1u, clipmap_patch_cells - 1u);
+	if (clipmap_patch_shape.vao == 0u) {
+		LogError("Failed to retrieve the mesh for the water clipmap");
+		return;
+	}
+
+	Node water_clipmap;
+	water_clipmap.set_geometry(clipmap_patch_shape);
+	water_clipmap.set_instances_nb(clipmap_patches_nb);
+	water_clipmap.add_texture("cubemap", cubemap, GL_TEXTURE_CUBE_MAP);
+	water_clipmap.add_texture("normal_map", normal_map, GL_TEXTURE_2D);
+	water_clipmap.get_transform().SetRotateX(-glm::half_pi<float>());
+	auto const water_world_to_model = glm::inverse(water_clipmap.get_transform().GetMatrix());
+
+	auto const set_water_clipmap_uniforms = [&set_water_uniforms,&camera_position,water_world_to_model,
+	                                         clipmap_cell_size,clipmap_coarsest_cell_size,clipmap_patch_cells](GLuint program){
+		set_water_uniforms(program);
+		auto const camera_model = glm::vec2(water_world_to_model * glm::vec4(camera_position, 1.0f));
+		auto const centre = glm::floor(camera_model / clipmap_coarsest_cell_size + 0.5f) * clipmap_coarsest_cell_size;
+		glUniform1i(glGetUniformLocation(program, "use_clipmap"), 1);
+		glUniform2fv(glGetUniformLocation(program, "clipmap_centre"), 1, glm::value_ptr(centre));
+		glUniform1f(glGetUniformLocation(program, "clipmap_cell_size"), clipmap_cell_size);
+		glUniform1i(glGetUniformLocation(program, "clipmap_patch_cells"), static_cast<GLint>(clipmap_patch_cells));
+	};
+	water_clipmap.set_program(&water_shader, set_water_clipmap_uniforms);
+
 	auto sphere = parametric_shapes::createSphere(20.0f, 100u, 100u);
 	if (sphere.vao == 0u) {
 		LogError("Failed to create sphere");
@@ -142,11 +195,14 @@ edaf80::Assignment4::run()
 	glClearDepthf(1.0f);
 	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_PRIMITIVE_RESTART);
+	glPrimitiveRestartIndex(parametric_shapes::primitive_restart_index);
 
 
 	auto lastTime = std::chrono::high_resolution_clock::now();
 
 	bool pause_animation = true;
+	bool use_water_clipmap = true;
 	bool use_orbit_camera = false;
 	auto cull_mode = bonobo::cull_mode_t::disabled;
 	auto polygon_mode = bonobo::polygon_mode_t::fill;
@@ -218,7 +274,10 @@ edaf80::Assignment4::run()
 
 		if (!shader_reload_failed) {
 			skybox.render(mCamera.GetWorldToClipMatrix());
-			water.render(mCamera.GetWorldToClipMatrix());
+			if (use_water_clipmap)
+				water_clipmap.render(mCamera.GetWorldToClipMatrix());
+			else
+				water.render(mCamera.GetWorldToClipMatrix());
 			water_sphere.render(mCamera.GetWorldToClipMatrix());
 		}
 
@@ -234,6 +293,7 @@ edaf80::Assignment4::run()
 		bool opened = ImGui::Begin("Scene Control", nullptr, ImGuiWindowFlags_None);
 		if (opened) {
 			ImGui::Checkbox("Pause animation", &pause_animation);
+			ImGui::Checkbox("Use clipmap for the water", &use_water_clipmap);
 			ImGui::Checkbox("Use orbit camera", &use_orbit_camera);
 			ImGui::Separator();
 			auto const cull_mode_changed = bonobo::uiSelectCullMode("Cull mode", cull_mode);
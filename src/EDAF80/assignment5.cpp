@@ -1,6 +1,7 @@
 #include "assignment5.hpp"
 #include "interpolation.hpp"
 #include "parametric_shapes.hpp"
+#include "shape_cache.hpp"
 #include "spaceship.hpp"
 #include "torus.hpp"
 
@@ -39,6 +40,7 @@ edaf80::Assignment5::Assignment5(WindowManager& windowManager) :
 
 edaf80::Assignment5::~Assignment5()
 {
+	ShapeCache::GetShared().Clear();
 	bonobo::deinit();
 }
 
@@ -206,6 +208,10 @@ edaf80::Assignment5::run()
 			control_point_index++;
 		}
 	}
+	auto const shape_cache_stats = ShapeCache::GetShared().GetStatistics();
+	LogInfo("Shape cache: %zu builds and uploads avoided, %.3f MiB saved; %zu shapes (%.3f MiB) cached",
+	        shape_cache_stats.hits, shape_cache_stats.bytes_saved / (1024.0 * 1024.0),
+	        shape_cache_stats.shapes_nb, shape_cache_stats.bytes_resident / (1024.0 * 1024.0));
 
 
 	glClearDepthf(1.0f);
@@ -336,6 +342,7 @@ edaf80::Assignment5::run()
 				torus.render(mCamera.GetWorldToClipMatrix(), show_basis, basis_thickness_scale, basis_length_scale);
 			}
 
+			spaceship.select_lods(mCamera.mWorld.GetTranslation(), static_cast<float>(framebuffer_height), mCamera.GetFov());
 			spaceship.render(mCamera.GetWorldToClipMatrix(), show_basis, 0.4f * basis_thickness_scale, 0.4f * basis_length_scale);
 		}
 
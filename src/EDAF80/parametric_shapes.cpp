@@ -1,585 +1,536 @@
 #include "parametric_shapes.hpp"
 #include "core/Log.h"
+#include "core/mesh_upload.hpp"
+#include "core/opengl.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/UploadManager.hpp"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <future>
 #include <iostream>
+#include <utility>
 #include <vector>
 
-bonobo::mesh_data
-parametric_shapes::createQuad(float const width, float const height,
-                              unsigned int const horizontal_split_count,
-                              unsigned int const vertical_split_count)
+namespace
+{
+	namespace constant
+	{
+		// Below that many vertices per band, splitting a shape costs
+		// more in synchronisation than it saves.
+		constexpr std::size_t min_vertices_per_band = 16u * 1024u;
+	}
+
+	// Cosine and sine of `count` angles, `d_angle` apart and starting at
+	// 0. For rings closing on themselves, the last angle is folded back
+	// onto the first one so that both sides of the seam get exactly the
+	// same vertices.
+	std::vector<glm::vec2> makeAngleRing(unsigned int const count, float const d_angle, bool const closes)
+	{
+		auto ring = std::vector<glm::vec2>(count);
+		for (unsigned int i = 0u; i < count; ++i) {
+			float const angle = (closes && i == count - 1u) ? 0.0f : d_angle * static_cast<float>(i);
+			ring[i] = glm::vec2(std::cos(angle), std::sin(angle));
+		}
+		return ring;
+	}
+
+	// Calls `process_rows(first_row, last_row)` over [0, rows_nb),
+	// split into bands run on the shared thread pool when there is
+	// enough work for it.
+	template<typename F>
+	void forEachRowBand(unsigned int const rows_nb, std::size_t const vertices_per_row,
+	                    parametric_shapes::execution_policy const& policy, F const& process_rows)
+	{
+		// Workers waiting on tasks queued behind them on their own pool
+		// could all end up waiting, hence doing all rows right away.
+		std::size_t bands_nb = 1u;
+		if (policy.use_thread_pool) {
+			auto const& thread_pool = ThreadPool::GetShared();
+			if (!thread_pool.IsWorkerThread()) {
+				bands_nb = std::min({ rows_nb * vertices_per_row / constant::min_vertices_per_band,
+				                      static_cast<std::size_t>(rows_nb),
+				                      thread_pool.GetThreadCount() + 1u });
+			}
+		}
+		if (bands_nb <= 1u) {
+			process_rows(0u, rows_nb);
+			return;
+		}
+
+		// The calling thread takes the first band rather than idling.
+		auto& thread_pool = ThreadPool::GetShared();
+		auto const band_start = [rows_nb,bands_nb](std::size_t band){
+			return static_cast<unsigned int>(rows_nb * band / bands_nb);
+		};
+		std::vector<std::future<void>> pending_bands;
+		pending_bands.reserve(bands_nb - 1u);
+		for (std::size_t band = 1u; band < bands_nb; ++band) {
+			auto const first_row = band_start(band);
+			auto const last_row = band_start(band + 1u);
+			pending_bands.push_back(thread_pool.Enqueue([&process_rows,first_row,last_row](){ process_rows(first_row, last_row); }));
+		}
+		process_rows(0u, band_start(1u));
+
+		// Wait for all bands before letting any exception through, as
+		// they all reference the caller's buffers.
+		for (auto& band : pending_bands)
+			band.wait();
+		for (auto& band : pending_bands)
+			band.get();
+	}
+
+	// Two triangles per cell of a grid of `rows_nb` by `columns_nb`
+	// edges, whose vertices are laid out row after row; `cell_to_triangles`
+	// returns the indices of both triangles of a cell given those of
+	// its four corners.
+	template<typename F>
+	std::vector<glm::uvec3> makeGridIndices(unsigned int const rows_nb, unsigned int const columns_nb,
+	                                        parametric_shapes::execution_policy const& policy,
+	                                        F const& cell_to_triangles)
+	{
+		auto const row_vertices_count = columns_nb + 1u;
+		auto index_sets = std::vector<glm::uvec3>(2u * rows_nb * columns_nb);
+
+		forEachRowBand(rows_nb, 2u * columns_nb, policy, [&](unsigned int first_row, unsigned int last_row){
+			std::size_t index = 2u * static_cast<std::size_t>(first_row) * columns_nb;
+			for (unsigned int i = first_row; i < last_row; ++i) {
+				for (unsigned int j = 0u; j < columns_nb; ++j) {
+					auto const triangles = cell_to_triangles(row_vertices_count * (i + 0u) + (j + 0u),
+					                                         row_vertices_count * (i + 0u) + (j + 1u),
+					                                         row_vertices_count * (i + 1u) + (j + 0u),
+					                                         row_vertices_count * (i + 1u) + (j + 1u));
+					index_sets[index++] = triangles.first;
+					index_sets[index++] = triangles.second;
+				}
+			}
+		});
+
+		return index_sets;
+	}
+
+	// Winding used by the quad, sphere and torus.
+	std::pair<glm::uvec3, glm::uvec3> makeCellTriangles(GLuint const i0j0, GLuint const i0j1, GLuint const i1j0, GLuint const i1j1)
+	{
+		return std::make_pair(glm::uvec3(i1j1, i0j1, i0j0), glm::uvec3(i1j0, i1j1, i0j0));
+	}
+
+	parametric_shapes::mesh_buffers makeBuffers(char const* name, std::size_t const vertices_nb)
+	{
+		parametric_shapes::mesh_buffers mesh;
+		mesh.name = name;
+		mesh.vertices.resize(vertices_nb);
+		mesh.normals.resize(vertices_nb);
+		mesh.texcoords.resize(vertices_nb);
+		mesh.tangents.resize(vertices_nb);
+		mesh.binormals.resize(vertices_nb);
+		return mesh;
+	}
+}
+
+parametric_shapes::mesh_buffers
+parametric_shapes::buildQuad(float const width, float const height,
+                             unsigned int const horizontal_split_count,
+                             unsigned int const vertical_split_count,
+                             execution_policy const& policy)
 {
 	auto const horizontal_slice_edges_count = horizontal_split_count + 1u;
 	auto const vertical_slice_edges_count = vertical_split_count + 1u;
 	auto const horizontal_slice_vertices_count = horizontal_slice_edges_count + 1u;
 	auto const vertical_slice_vertices_count = vertical_slice_edges_count + 1u;
-	auto const vertices_nb = horizontal_slice_vertices_count * vertical_slice_vertices_count;
+	auto const vertices_nb = static_cast<std::size_t>(horizontal_slice_vertices_count) * vertical_slice_vertices_count;
 
-	auto vertices  = std::vector<glm::vec3>(vertices_nb);
-	auto normals   = std::vector<glm::vec3>(vertices_nb);
-	auto texcoords = std::vector<glm::vec3>(vertices_nb);
-	auto tangents  = std::vector<glm::vec3>(vertices_nb);
-	auto binormals = std::vector<glm::vec3>(vertices_nb);
+	auto mesh = makeBuffers("Quad", vertices_nb);
 
 	float const d_width = width / (static_cast<float>(horizontal_slice_edges_count));
 	float const d_height = height / (static_cast<float>(vertical_slice_edges_count));
 
-	// generate vertices iteratively
-	size_t index = 0u;
-	float x = 0.0f;
-	for (unsigned int i = 0u; i < horizontal_slice_vertices_count; ++i) {
-		float y = 0.0f;
+	// generate vertices, one row of constant x at a time
+	forEachRowBand(horizontal_slice_vertices_count, vertical_slice_vertices_count, policy, [&](unsigned int first_row, unsigned int last_row){
+		std::size_t index = static_cast<std::size_t>(first_row) * vertical_slice_vertices_count;
+		for (unsigned int i = first_row; i < last_row; ++i) {
+			float const x = d_width * static_cast<float>(i);
 
-		for (unsigned int j = 0u; j < vertical_slice_vertices_count; ++j) {
-			// vertex
-			vertices[index] = glm::vec3(x, y, 0.0f);
+			for (unsigned int j = 0u; j < vertical_slice_vertices_count; ++j) {
+				float const y = d_height * static_cast<float>(j);
 
-			// texture coordinates
-			texcoords[index] = glm::vec3(static_cast<float>(j) / (static_cast<float>(vertical_slice_edges_count)),
-			                             static_cast<float>(i) / (static_cast<float>(horizontal_slice_edges_count)),
-			                             0.0f);
+				// vertex
+				mesh.vertices[index] = glm::vec3(x, y, 0.0f);
 
-			// tangent
-			tangents[index] = glm::vec3(1.0f, 0.0f, 0.0f);
+				// texture coordinates
+				mesh.texcoords[index] = glm::vec3(static_cast<float>(j) / (static_cast<float>(vertical_slice_edges_count)),
+				                                  static_cast<float>(i) / (static_cast<float>(horizontal_slice_edges_count)),
+				                                  0.0f);
 
-			// binormal
-			binormals[index] = glm::vec3(0.0f, 1.0f, 0.0f);
+				// tangent
+				mesh.tangents[index] = glm::vec3(1.0f, 0.0f, 0.0f);
 
-			// normal
-			normals[index] = glm::vec3(0.0f, 0.0f, 1.0f);
+				// binormal
+				mesh.binormals[index] = glm::vec3(0.0f, 1.0f, 0.0f);
 
-			y += d_height;
-			++index;
+				// normal
+				mesh.normals[index] = glm::vec3(0.0f, 0.0f, 1.0f);
+
+				++index;
+			}
 		}
+	});
 
-		x += d_width;
-	}
+	mesh.indices = makeGridIndices(horizontal_slice_edges_count, vertical_slice_edges_count, policy, makeCellTriangles);
 
-	// create index array
-	auto index_sets = std::vector<glm::uvec3>(2u * horizontal_slice_edges_count * vertical_slice_edges_count);
+	return mesh;
+}
 
-	// generate indices iteratively
-	index = 0u;
-	for (unsigned int i = 0u; i < horizontal_slice_edges_count; ++i)
-	{
-		for (unsigned int j = 0u; j < vertical_slice_edges_count; ++j)
-		{
-			index_sets[index] = glm::uvec3(vertical_slice_vertices_count * (i + 1u) + (j + 1u),
-			                               vertical_slice_vertices_count * (i + 0u) + (j + 1u),
-			                               vertical_slice_vertices_count * (i + 0u) + (j + 0u));
-			++index;
-
-			index_sets[index] = glm::uvec3(vertical_slice_vertices_count * (i + 1u) + (j + 0u),
-			                               vertical_slice_vertices_count * (i + 1u) + (j + 1u),
-			                               vertical_slice_vertices_count * (i + 0u) + (j + 0u));
-			++index;
+std::vector<GLuint>
+parametric_shapes::buildQuadStripIndices(unsigned int const horizontal_split_count,
+                                         unsigned int const vertical_split_count,
+                                         execution_policy const& policy)
+{
+	auto const horizontal_slice_edges_count = horizontal_split_count + 1u;
+	auto const vertical_slice_vertices_count = vertical_split_count + 2u;
+
+	// Each row of cells zigzags between its two rows of vertices, going
+	// up in j, then restarts; triangles keep the winding of buildQuad().
+	auto const row_indices_count = 2u * static_cast<std::size_t>(vertical_slice_vertices_count) + 1u;
+	auto indices = std::vector<GLuint>(horizontal_slice_edges_count * row_indices_count - 1u);
+
+	forEachRowBand(horizontal_slice_edges_count, row_indices_count, policy, [&](unsigned int first_row, unsigned int last_row){
+		std::size_t index = first_row * row_indices_count;
+		for (unsigned int i = first_row; i < last_row; ++i) {
+			for (unsigned int j = 0u; j < vertical_slice_vertices_count; ++j) {
+				indices[index++] = vertical_slice_vertices_count * (i + 0u) + j;
+				indices[index++] = vertical_slice_vertices_count * (i + 1u) + j;
+			}
+			if (i + 1u < horizontal_slice_edges_count)
+				indices[index++] = primitive_restart_index;
 		}
-	}
-
-	bonobo::mesh_data data;
-	glGenVertexArrays(1, &data.vao);
-	assert(data.vao != 0u);
-	glBindVertexArray(data.vao);
-
-	auto const vertices_offset = 0u;
-	auto const vertices_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3));
-	auto const normals_offset = vertices_size;
-	auto const normals_size = static_cast<GLsizeiptr>(normals.size() * sizeof(glm::vec3));
-	auto const texcoords_offset = normals_offset + normals_size;
-	auto const texcoords_size = static_cast<GLsizeiptr>(texcoords.size() * sizeof(glm::vec3));
-	auto const tangents_offset = texcoords_offset + texcoords_size;
-	auto const tangents_size = static_cast<GLsizeiptr>(tangents.size() * sizeof(glm::vec3));
-	auto const binormals_offset = tangents_offset + tangents_size;
-	auto const binormals_size = static_cast<GLsizeiptr>(binormals.size() * sizeof(glm::vec3));
-	auto const bo_size = static_cast<GLsizeiptr>(vertices_size
-	                                            +normals_size
-	                                            +texcoords_size
-	                                            +tangents_size
-	                                            +binormals_size
-	                                            );
-	glGenBuffers(1, &data.bo);
-	assert(data.bo != 0u);
-	glBindBuffer(GL_ARRAY_BUFFER, data.bo);
-	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-	glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(vertices.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::vertices));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(0x0));
-
-	glBufferSubData(GL_ARRAY_BUFFER, normals_offset, normals_size, static_cast<GLvoid const*>(normals.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::normals));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::normals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(normals_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, texcoords_offset, texcoords_size, static_cast<GLvoid const*>(texcoords.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::texcoords));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::texcoords), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(texcoords_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, tangents_offset, tangents_size, static_cast<GLvoid const*>(tangents.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::tangents));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::tangents), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(tangents_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, binormals_offset, binormals_size, static_cast<GLvoid const*>(binormals.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::binormals));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::binormals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(binormals_offset));
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0u);
-
-	data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
-	glGenBuffers(1, &data.ibo);
-	assert(data.ibo != 0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_sets.size() * sizeof(glm::uvec3)), reinterpret_cast<GLvoid const*>(index_sets.data()), GL_STATIC_DRAW);
+	});
 
-	glBindVertexArray(0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
-
-	return data;
+	return indices;
 }
 
-bonobo::mesh_data
-parametric_shapes::createSphere(float const radius,
-                                unsigned int const longitude_split_count,
-                                unsigned int const latitude_split_count)
+parametric_shapes::mesh_buffers
+parametric_shapes::buildSphere(float const radius,
+                               unsigned int const longitude_split_count,
+                               unsigned int const latitude_split_count,
+                               execution_policy const& policy)
 {
 	auto const longitude_slice_edges_count = longitude_split_count + 1u;
 	auto const latitude_slice_edges_count = latitude_split_count + 1u;
 	auto const longitude_slice_vertices_count = longitude_slice_edges_count + 1u;
 	auto const latitude_slice_vertices_count = latitude_slice_edges_count + 1u;
-	auto const vertices_nb = longitude_slice_vertices_count * latitude_slice_vertices_count;
+	auto const vertices_nb = static_cast<std::size_t>(longitude_slice_vertices_count) * latitude_slice_vertices_count;
 
-	auto vertices  = std::vector<glm::vec3>(vertices_nb);
-	auto normals   = std::vector<glm::vec3>(vertices_nb);
-	auto texcoords = std::vector<glm::vec3>(vertices_nb);
-	auto tangents  = std::vector<glm::vec3>(vertices_nb);
-	auto binormals = std::vector<glm::vec3>(vertices_nb);
+	auto mesh = makeBuffers("Sphere", vertices_nb);
 
 	float const d_theta = glm::two_pi<float>() / (static_cast<float>(longitude_slice_edges_count));
 	float const d_phi = glm::pi<float>() / (static_cast<float>(latitude_slice_edges_count));
 
-	// generate vertices iteratively
-	size_t index = 0u;
-	float theta = 0.0f;
-	for (unsigned int i = 0u; i < longitude_slice_vertices_count; ++i) {
-		if (i == longitude_slice_vertices_count - 1) {
-			theta = 0.0f;
-		}
-		float const cos_theta = std::cos(theta);
-		float const sin_theta = std::sin(theta);
-
-		float phi = 0.0f;
-		for (unsigned int j = 0u; j < latitude_slice_vertices_count; ++j) {
-			float const cos_phi = std::cos(phi);
-			float const sin_phi = std::sin(phi);
-
-			// vertex
-			vertices[index] = glm::vec3(radius * sin_theta * sin_phi,
-			                            -radius * cos_phi,
-			                            radius * cos_theta * sin_phi);
-
-			// texture coordinates
-			texcoords[index] = glm::vec3(static_cast<float>(i) / (static_cast<float>(longitude_slice_edges_count)),
-			                             static_cast<float>(j) / (static_cast<float>(latitude_slice_edges_count)),
-			                             0.0f);
-
-			// tangent
-			auto const t = glm::vec3(radius * cos_theta /* * sin_phi */,
-			                         0.0f,
-			                         -radius * sin_theta /* * sin_phi */);
-			tangents[index] = glm::normalize(t);
-
-			// binormal
-			auto const b = glm::vec3(radius * sin_theta * cos_phi,
-			                         radius * sin_phi,
-			                         radius * cos_theta * cos_phi);
-			binormals[index] = glm::normalize(b);
-
-			// normal
-			auto const n = glm::cross(t, b);
-			normals[index] = glm::normalize(n);
-
-			phi += d_phi;
-			++index;
-		}
-
-		theta += d_theta;
-	}
-
-	// create index array
-	auto index_sets = std::vector<glm::uvec3>(2u * longitude_slice_edges_count * latitude_slice_edges_count);
-
-	// generate indices iteratively
-	index = 0u;
-	for (unsigned int i = 0u; i < longitude_slice_edges_count; ++i)
-	{
-		for (unsigned int j = 0u; j < latitude_slice_edges_count; ++j)
-		{
-			index_sets[index] = glm::uvec3(latitude_slice_vertices_count * (i + 1u) + (j + 1u),
-			                               latitude_slice_vertices_count * (i + 0u) + (j + 1u),
-			                               latitude_slice_vertices_count * (i + 0u) + (j + 0u));
-			++index;
-
-			index_sets[index] = glm::uvec3(latitude_slice_vertices_count * (i + 1u) + (j + 0u),
-			                               latitude_slice_vertices_count * (i + 1u) + (j + 1u),
-			                               latitude_slice_vertices_count * (i + 0u) + (j + 0u));
-			++index;
+	// cosines and sines of all longitudes and latitudes, rather than of
+	// every vertex
+	auto const thetas = makeAngleRing(longitude_slice_vertices_count, d_theta, true);
+	auto const phis = makeAngleRing(latitude_slice_vertices_count, d_phi, false);
+
+	// generate vertices, one line of longitude at a time
+	forEachRowBand(longitude_slice_vertices_count, latitude_slice_vertices_count, policy, [&](unsigned int first_row, unsigned int last_row){
+		std::size_t index = static_cast<std::size_t>(first_row) * latitude_slice_vertices_count;
+		for (unsigned int i = first_row; i < last_row; ++i) {
+			float const cos_theta = thetas[i].x;
+			float const sin_theta = thetas[i].y;
+
+			for (unsigned int j = 0u; j < latitude_slice_vertices_count; ++j) {
+				float const cos_phi = phis[j].x;
+				float const sin_phi = phis[j].y;
+
+				// vertex
+				mesh.vertices[index] = glm::vec3(radius * sin_theta * sin_phi,
+				                                 -radius * cos_phi,
+				                                 radius * cos_theta * sin_phi);
+
+				// texture coordinates
+				mesh.texcoords[index] = glm::vec3(static_cast<float>(i) / (static_cast<float>(longitude_slice_edges_count)),
+				                                  static_cast<float>(j) / (static_cast<float>(latitude_slice_edges_count)),
+				                                  0.0f);
+
+				// tangent
+				auto const t = glm::vec3(radius * cos_theta /* * sin_phi */,
+				                         0.0f,
+				                         -radius * sin_theta /* * sin_phi */);
+				mesh.tangents[index] = glm::normalize(t);
+
+				// binormal
+				auto const b = glm::vec3(radius * sin_theta * cos_phi,
+				                         radius * sin_phi,
+				                         radius * cos_theta * cos_phi);
+				mesh.binormals[index] = glm::normalize(b);
+
+				// normal
+				auto const n = glm::cross(t, b);
+				mesh.normals[index] = glm::normalize(n);
+
+				++index;
+			}
 		}
-	}
-
-	bonobo::mesh_data data;
-	glGenVertexArrays(1, &data.vao);
-	assert(data.vao != 0u);
-	glBindVertexArray(data.vao);
-
-	auto const vertices_offset = 0u;
-	auto const vertices_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3));
-	auto const normals_offset = vertices_size;
-	auto const normals_size = static_cast<GLsizeiptr>(normals.size() * sizeof(glm::vec3));
-	auto const texcoords_offset = normals_offset + normals_size;
-	auto const texcoords_size = static_cast<GLsizeiptr>(texcoords.size() * sizeof(glm::vec3));
-	auto const tangents_offset = texcoords_offset + texcoords_size;
-	auto const tangents_size = static_cast<GLsizeiptr>(tangents.size() * sizeof(glm::vec3));
-	auto const binormals_offset = tangents_offset + tangents_size;
-	auto const binormals_size = static_cast<GLsizeiptr>(binormals.size() * sizeof(glm::vec3));
-	auto const bo_size = static_cast<GLsizeiptr>(vertices_size
-	                                            +normals_size
-	                                            +texcoords_size
-	                                            +tangents_size
-	                                            +binormals_size
-	                                            );
-	glGenBuffers(1, &data.bo);
-	assert(data.bo != 0u);
-	glBindBuffer(GL_ARRAY_BUFFER, data.bo);
-	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-	glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(vertices.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::vertices));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(0x0));
-
-	glBufferSubData(GL_ARRAY_BUFFER, normals_offset, normals_size, static_cast<GLvoid const*>(normals.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::normals));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::normals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(normals_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, texcoords_offset, texcoords_size, static_cast<GLvoid const*>(texcoords.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::texcoords));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::texcoords), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(texcoords_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, tangents_offset, tangents_size, static_cast<GLvoid const*>(tangents.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::tangents));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::tangents), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(tangents_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, binormals_offset, binormals_size, static_cast<GLvoid const*>(binormals.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::binormals));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::binormals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(binormals_offset));
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0u);
-
-	data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
-	glGenBuffers(1, &data.ibo);
-	assert(data.ibo != 0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_sets.size() * sizeof(glm::uvec3)), reinterpret_cast<GLvoid const*>(index_sets.data()), GL_STATIC_DRAW);
+	});
 
-	glBindVertexArray(0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+	mesh.indices = makeGridIndices(longitude_slice_edges_count, latitude_slice_edges_count, policy, makeCellTriangles);
 
-	return data;
+	return mesh;
 }
 
-bonobo::mesh_data
-parametric_shapes::createTorus(float const major_radius,
-                               float const minor_radius,
-                               unsigned int const major_split_count,
-                               unsigned int const minor_split_count)
+parametric_shapes::mesh_buffers
+parametric_shapes::buildTorus(float const major_radius,
+                              float const minor_radius,
+                              unsigned int const major_split_count,
+                              unsigned int const minor_split_count,
+                              execution_policy const& policy)
 {
 	auto const major_slice_edges_count = major_split_count + 1u;
 	auto const minor_slice_edges_count = minor_split_count + 1u;
 	auto const major_slice_vertices_count = major_slice_edges_count + 1u;
 	auto const minor_slice_vertices_count = minor_slice_edges_count + 1u;
-	auto const vertices_nb = major_slice_vertices_count * minor_slice_vertices_count;
+	auto const vertices_nb = static_cast<std::size_t>(major_slice_vertices_count) * minor_slice_vertices_count;
 
-	auto vertices  = std::vector<glm::vec3>(vertices_nb);
-	auto normals   = std::vector<glm::vec3>(vertices_nb);
-	auto texcoords = std::vector<glm::vec3>(vertices_nb);
-	auto tangents  = std::vector<glm::vec3>(vertices_nb);
-	auto binormals = std::vector<glm::vec3>(vertices_nb);
+	auto mesh = makeBuffers("Torus", vertices_nb);
 
 	float const d_phi = glm::two_pi<float>() / (static_cast<float>(major_slice_edges_count));
 	float const d_theta = glm::two_pi<float>() / (static_cast<float>(minor_slice_edges_count));
 
-	// generate vertices iteratively
-	size_t index = 0u;
-	float phi = 0.0f;
-	for (unsigned int i = 0u; i < major_slice_vertices_count; ++i) {
-		if (i == major_slice_vertices_count - 1) {
-			phi = 0.0f;
-		}
-		float const cos_phi = std::cos(phi);
-		float const sin_phi = std::sin(phi);
-
-		float theta = 0.0f;
-		for (unsigned int j = 0u; j < minor_slice_vertices_count; ++j) {
-			if (j == minor_slice_vertices_count - 1) {
-				theta = 0.0f;
+	// cosines and sines of all angles around both rings, rather than of
+	// every vertex
+	auto const phis = makeAngleRing(major_slice_vertices_count, d_phi, true);
+	auto const thetas = makeAngleRing(minor_slice_vertices_count, d_theta, true);
+
+	// generate vertices, one cross-section at a time
+	forEachRowBand(major_slice_vertices_count, minor_slice_vertices_count, policy, [&](unsigned int first_row, unsigned int last_row){
+		std::size_t index = static_cast<std::size_t>(first_row) * minor_slice_vertices_count;
+		for (unsigned int i = first_row; i < last_row; ++i) {
+			float const cos_phi = phis[i].x;
+			float const sin_phi = phis[i].y;
+
+			for (unsigned int j = 0u; j < minor_slice_vertices_count; ++j) {
+				float const cos_theta = thetas[j].x;
+				float const sin_theta = thetas[j].y;
+
+				// vertex
+				mesh.vertices[index] = glm::vec3((major_radius + minor_radius * cos_theta) * cos_phi,
+				                                 -minor_radius * sin_theta,
+				                                 (major_radius + minor_radius * cos_theta) * sin_phi);
+
+				// texture coordinates
+				mesh.texcoords[index] = glm::vec3(static_cast<float>(j) / (static_cast<float>(minor_slice_vertices_count)),
+				                                  static_cast<float>(i) / (static_cast<float>(major_slice_vertices_count)),
+				                                  0.0f);
+
+				// tangent
+				auto const t = glm::vec3(-minor_radius * sin_theta * cos_phi,
+				                         -minor_radius * cos_theta,
+				                         -minor_radius * sin_theta * sin_phi);
+				mesh.tangents[index] = glm::normalize(t);
+
+				// binormal
+				auto const b = glm::vec3(-(major_radius + minor_radius * cos_theta) * sin_phi,
+				                         0.0f,
+				                         (major_radius + minor_radius * cos_theta) * cos_phi);
+				mesh.binormals[index] = glm::normalize(b);
+
+				// normal
+				auto const n = glm::cross(t, b);
+				mesh.normals[index] = glm::normalize(n);
+
+				++index;
 			}
-			float const cos_theta = std::cos(theta);
-			float const sin_theta = std::sin(theta);
-
-			// vertex
-			vertices[index] = glm::vec3((major_radius + minor_radius * cos_theta) * cos_phi,
-			                            -minor_radius * sin_theta,
-			                            (major_radius + minor_radius * cos_theta) * sin_phi);
-
-			// texture coordinates
-			texcoords[index] = glm::vec3(static_cast<float>(j) / (static_cast<float>(minor_slice_vertices_count)),
-			                             static_cast<float>(i) / (static_cast<float>(major_slice_vertices_count)),
-			                             0.0f);
-
-			// tangent
-			auto const t = glm::vec3(-minor_radius * sin_theta * cos_phi,
-			                         -minor_radius * cos_theta,
-			                         -minor_radius * sin_theta * sin_phi);
-			tangents[index] = glm::normalize(t);
-
-			// binormal
-			auto const b = glm::vec3(-(major_radius + minor_radius * cos_theta) * sin_phi,
-			                         0.0f,
-			                         (major_radius + minor_radius * cos_theta) * cos_phi);
-			binormals[index] = glm::normalize(b);
-
-			// normal
-			auto const n = glm::cross(t, b);
-			normals[index] = glm::normalize(n);
-
-			theta += d_theta;
-			++index;
 		}
+	});
 
-		phi += d_phi;
-	}
-
-	// create index array
-	auto index_sets = std::vector<glm::uvec3>(2u * major_slice_edges_count * minor_slice_edges_count);
-
-	// generate indices iteratively
-	index = 0u;
-	for (unsigned int i = 0u; i < major_slice_edges_count; ++i)
-	{
-		for (unsigned int j = 0u; j < minor_slice_edges_count; ++j)
-		{
-			index_sets[index] = glm::uvec3(minor_slice_vertices_count * (i + 1u) + (j + 1u),
-			                               minor_slice_vertices_count * (i + 0u) + (j + 1u),
-			                               minor_slice_vertices_count * (i + 0u) + (j + 0u));
-			++index;
-
-			index_sets[index] = glm::uvec3(minor_slice_vertices_count * (i + 1u) + (j + 0u),
-			                               minor_slice_vertices_count * (i + 1u) + (j + 1u),
-			                               minor_slice_vertices_count * (i + 0u) + (j + 0u));
-			++index;
-		}
-	}
-
-	bonobo::mesh_data data;
-	glGenVertexArrays(1, &data.vao);
-	assert(data.vao != 0u);
-	glBindVertexArray(data.vao);
-
-	auto const vertices_offset = 0u;
-	auto const vertices_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3));
-	auto const normals_offset = vertices_size;
-	auto const normals_size = static_cast<GLsizeiptr>(normals.size() * sizeof(glm::vec3));
-	auto const texcoords_offset = normals_offset + normals_size;
-	auto const texcoords_size = static_cast<GLsizeiptr>(texcoords.size() * sizeof(glm::vec3));
-	auto const tangents_offset = texcoords_offset + texcoords_size;
-	auto const tangents_size = static_cast<GLsizeiptr>(tangents.size() * sizeof(glm::vec3));
-	auto const binormals_offset = tangents_offset + tangents_size;
-	auto const binormals_size = static_cast<GLsizeiptr>(binormals.size() * sizeof(glm::vec3));
-	auto const bo_size = static_cast<GLsizeiptr>(vertices_size
-	                                            +normals_size
-	                                            +texcoords_size
-	                                            +tangents_size
-	                                            +binormals_size
-	                                            );
-	glGenBuffers(1, &data.bo);
-	assert(data.bo != 0u);
-	glBindBuffer(GL_ARRAY_BUFFER, data.bo);
-	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-	glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(vertices.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::vertices));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(0x0));
-
-	glBufferSubData(GL_ARRAY_BUFFER, normals_offset, normals_size, static_cast<GLvoid const*>(normals.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::normals));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::normals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(normals_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, texcoords_offset, texcoords_size, static_cast<GLvoid const*>(texcoords.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::texcoords));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::texcoords), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(texcoords_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, tangents_offset, tangents_size, static_cast<GLvoid const*>(tangents.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::tangents));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::tangents), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(tangents_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, binormals_offset, binormals_size, static_cast<GLvoid const*>(binormals.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::binormals));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::binormals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(binormals_offset));
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0u);
-
-	data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
-	glGenBuffers(1, &data.ibo);
-	assert(data.ibo != 0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_sets.size() * sizeof(glm::uvec3)), reinterpret_cast<GLvoid const*>(index_sets.data()), GL_STATIC_DRAW);
-
-	glBindVertexArray(0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+	mesh.indices = makeGridIndices(major_slice_edges_count, minor_slice_edges_count, policy, makeCellTriangles);
 
-	return data;
+	return mesh;
 }
 
-bonobo::mesh_data
-parametric_shapes::createCircleRing(float const radius,
-                                    float const spread_length,
-                                    unsigned int const circle_split_count,
-                                    unsigned int const spread_split_count)
+parametric_shapes::mesh_buffers
+parametric_shapes::buildCircleRing(float const radius,
+                                   float const spread_length,
+                                   unsigned int const circle_split_count,
+                                   unsigned int const spread_split_count,
+                                   execution_policy const& policy)
 {
 	auto const circle_slice_edges_count = circle_split_count + 1u;
 	auto const spread_slice_edges_count = spread_split_count + 1u;
 	auto const circle_slice_vertices_count = circle_slice_edges_count + 1u;
 	auto const spread_slice_vertices_count = spread_slice_edges_count + 1u;
-	auto const vertices_nb = circle_slice_vertices_count * spread_slice_vertices_count;
+	auto const vertices_nb = static_cast<std::size_t>(circle_slice_vertices_count) * spread_slice_vertices_count;
 
-	auto vertices  = std::vector<glm::vec3>(vertices_nb);
-	auto normals   = std::vector<glm::vec3>(vertices_nb);
-	auto texcoords = std::vector<glm::vec3>(vertices_nb);
-	auto tangents  = std::vector<glm::vec3>(vertices_nb);
-	auto binormals = std::vector<glm::vec3>(vertices_nb);
+	auto mesh = makeBuffers("Circle ring", vertices_nb);
 
 	float const spread_start = radius - 0.5f * spread_length;
 	float const d_theta = glm::two_pi<float>() / (static_cast<float>(circle_slice_edges_count));
 	float const d_spread = spread_length / (static_cast<float>(spread_slice_edges_count));
 
-	// generate vertices iteratively
-	size_t index = 0u;
-	float theta = 0.0f;
-	for (unsigned int i = 0u; i < circle_slice_vertices_count; ++i) {
-		float const cos_theta = std::cos(theta);
-		float const sin_theta = std::sin(theta);
-
-		float distance_to_centre = spread_start;
-		for (unsigned int j = 0u; j < spread_slice_vertices_count; ++j) {
-			// vertex
-			vertices[index] = glm::vec3(distance_to_centre * cos_theta,
-			                            distance_to_centre * sin_theta,
-			                            0.0f);
-
-			// texture coordinates
-			texcoords[index] = glm::vec3(static_cast<float>(j) / (static_cast<float>(spread_slice_vertices_count)),
-			                             static_cast<float>(i) / (static_cast<float>(circle_slice_vertices_count)),
-			                             0.0f);
-
-			// tangent
-			auto const t = glm::vec3(cos_theta, sin_theta, 0.0f);
-			tangents[index] = t;
-
-			// binormal
-			auto const b = glm::vec3(-sin_theta, cos_theta, 0.0f);
-			binormals[index] = b;
-
-			// normal
-			auto const n = glm::cross(t, b);
-			normals[index] = n;
-
-			distance_to_centre += d_spread;
-			++index;
-		}
+	// cosines and sines of all angles around the circle, rather than of
+	// every vertex
+	auto const thetas = makeAngleRing(circle_slice_vertices_count, d_theta, false);
 
-		theta += d_theta;
-	}
+	// generate vertices, one line going out from the centre at a time
+	forEachRowBand(circle_slice_vertices_count, spread_slice_vertices_count, policy, [&](unsigned int first_row, unsigned int last_row){
+		std::size_t index = static_cast<std::size_t>(first_row) * spread_slice_vertices_count;
+		for (unsigned int i = first_row; i < last_row; ++i) {
+			float const cos_theta = thetas[i].x;
+			float const sin_theta = thetas[i].y;
 
-	// create index array
-	auto index_sets = std::vector<glm::uvec3>(2u * circle_slice_edges_count * spread_slice_edges_count);
+			for (unsigned int j = 0u; j < spread_slice_vertices_count; ++j) {
+				float const distance_to_centre = spread_start + d_spread * static_cast<float>(j);
 
-	// generate indices iteratively
-	index = 0u;
-	for (unsigned int i = 0u; i < circle_slice_edges_count; ++i)
-	{
-		for (unsigned int j = 0u; j < spread_slice_edges_count; ++j)
-		{
-			index_sets[index] = glm::uvec3(spread_slice_vertices_count * (i + 0u) + (j + 0u),
-			                               spread_slice_vertices_count * (i + 0u) + (j + 1u),
-			                               spread_slice_vertices_count * (i + 1u) + (j + 1u));
-			++index;
-
-			index_sets[index] = glm::uvec3(spread_slice_vertices_count * (i + 0u) + (j + 0u),
-			                               spread_slice_vertices_count * (i + 1u) + (j + 1u),
-			                               spread_slice_vertices_count * (i + 1u) + (j + 0u));
-			++index;
+				// vertex
+				mesh.vertices[index] = glm::vec3(distance_to_centre * cos_theta,
+				                                 distance_to_centre * sin_theta,
+				                                 0.0f);
+
+				// texture coordinates
+				mesh.texcoords[index] = glm::vec3(static_cast<float>(j) / (static_cast<float>(spread_slice_vertices_count)),
+				                                  static_cast<float>(i) / (static_cast<float>(circle_slice_vertices_count)),
+				                                  0.0f);
+
+				// tangent
+				auto const t = glm::vec3(cos_theta, sin_theta, 0.0f);
+				mesh.tangents[index] = t;
+
+				// binormal
+				auto const b = glm::vec3(-sin_theta, cos_theta, 0.0f);
+				mesh.binormals[index] = b;
+
+				// normal
+				auto const n = glm::cross(t, b);
+				mesh.normals[index] = n;
+
+				++index;
+			}
 		}
+	});
+
+	// the circle ring winds its triangles the other way round
+	mesh.indices = makeGridIndices(circle_slice_edges_count, spread_slice_edges_count, policy,
+	                               [](GLuint i0j0, GLuint i0j1, GLuint i1j0, GLuint i1j1){
+		return std::make_pair(glm::uvec3(i0j0, i0j1, i1j1), glm::uvec3(i0j0, i1j1, i1j0));
+	});
+
+	return mesh;
+}
+
+bonobo::mesh_upload_options
+parametric_shapes::getDefaultUploadOptions()
+{
+	bonobo::mesh_upload_options upload_options;
+	upload_options.use_geometry_arena = true;
+	return upload_options;
+}
+
+bonobo::mesh_data
+parametric_shapes::upload(mesh_buffers const& mesh,
+                          bonobo::mesh_upload_options const& upload_options)
+{
+	if (mesh.vertices.empty() || mesh.indices.empty()) {
+		LogError("Mesh \"%s\" has no geometry to upload.", mesh.name.c_str());
+		return bonobo::mesh_data();
 	}
 
-	bonobo::mesh_data data;
-	glGenVertexArrays(1, &data.vao);
-	assert(data.vao != 0u);
-	glBindVertexArray(data.vao);
-
-	auto const vertices_offset = 0u;
-	auto const vertices_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(glm::vec3));
-	auto const normals_offset = vertices_size;
-	auto const normals_size = static_cast<GLsizeiptr>(normals.size() * sizeof(glm::vec3));
-	auto const texcoords_offset = normals_offset + normals_size;
-	auto const texcoords_size = static_cast<GLsizeiptr>(texcoords.size() * sizeof(glm::vec3));
-	auto const tangents_offset = texcoords_offset + texcoords_size;
-	auto const tangents_size = static_cast<GLsizeiptr>(tangents.size() * sizeof(glm::vec3));
-	auto const binormals_offset = tangents_offset + tangents_size;
-	auto const binormals_size = static_cast<GLsizeiptr>(binormals.size() * sizeof(glm::vec3));
-	auto const bo_size = static_cast<GLsizeiptr>(vertices_size
-	                                            +normals_size
-	                                            +texcoords_size
-	                                            +tangents_size
-	                                            +binormals_size
-	                                            );
-	glGenBuffers(1, &data.bo);
-	assert(data.bo != 0u);
-	glBindBuffer(GL_ARRAY_BUFFER, data.bo);
-	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-	glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(vertices.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::vertices));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(0x0));
-
-	glBufferSubData(GL_ARRAY_BUFFER, normals_offset, normals_size, static_cast<GLvoid const*>(normals.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::normals));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::normals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(normals_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, texcoords_offset, texcoords_size, static_cast<GLvoid const*>(texcoords.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::texcoords));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::texcoords), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(texcoords_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, tangents_offset, tangents_size, static_cast<GLvoid const*>(tangents.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::tangents));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::tangents), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(tangents_offset));
-
-	glBufferSubData(GL_ARRAY_BUFFER, binormals_offset, binormals_size, static_cast<GLvoid const*>(binormals.data()));
-	glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::binormals));
-	glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::binormals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(binormals_offset));
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0u);
-
-	data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
-	glGenBuffers(1, &data.ibo);
-	assert(data.ibo != 0u);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_sets.size() * sizeof(glm::uvec3)), reinterpret_cast<GLvoid const*>(index_sets.data()), GL_STATIC_DRAW);
+	bonobo::mesh_source source;
+	source.name = mesh.name;
+	source.vertices_nb = static_cast<std::uint32_t>(mesh.vertices.size());
+	source.vertices = mesh.vertices.data();
+	source.normals = mesh.normals.empty() ? nullptr : mesh.normals.data();
+	source.texcoords = mesh.texcoords.empty() ? nullptr : mesh.texcoords.data();
+	source.tangents = mesh.tangents.empty() ? nullptr : mesh.tangents.data();
+	source.binormals = mesh.binormals.empty() ? nullptr : mesh.binormals.data();
+	source.indices_nb = static_cast<std::uint32_t>(mesh.indices.size() * 3u);
+	source.indices = glm::value_ptr(mesh.indices.front());
+
+	return bonobo::uploadMesh(source, upload_options);
+}
+
+bonobo::mesh_data
+parametric_shapes::createQuad(float const width, float const height,
+                              unsigned int const horizontal_split_count,
+                              unsigned int const vertical_split_count,
+                              bonobo::mesh_upload_options const& upload_options)
+{
+	return upload(buildQuad(width, height, horizontal_split_count, vertical_split_count),
+	              upload_options);
+}
+
+bonobo::mesh_data
+parametric_shapes::createProceduralQuad(float const width, float const height,
+                                        unsigned int const horizontal_split_count,
+                                        unsigned int const vertical_split_count)
+{
+	auto const indices = buildQuadStripIndices(horizontal_split_count, vertical_split_count);
+
+	bonobo::mesh_data mesh;
+	mesh.name = "Procedural quad";
+	mesh.drawing_mode = GL_TRIANGLE_STRIP;
+	mesh.vertices_nb = static_cast<GLsizei>((horizontal_split_count + 2u) * (vertical_split_count + 2u));
+	mesh.indices_nb = static_cast<GLsizei>(indices.size());
+	mesh.indices_type = GL_UNSIGNED_INT;
+	mesh.bounding_center = glm::vec3(0.5f * width, 0.5f * height, 0.0f);
+	mesh.bounding_radius = 0.5f * std::sqrt(width * width + height * height);
+
+	// The VAO has no attribute enabled, only the index buffer.
+	glGenVertexArrays(1, &mesh.vao);
+	assert(mesh.vao != 0u);
+	glBindVertexArray(mesh.vao);
+
+	glGenBuffers(1, &mesh.ibo);
+	assert(mesh.ibo != 0u);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+	auto const size = static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint));
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
 
 	glBindVertexArray(0u);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
 
-	return data;
+	utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, mesh.vao, mesh.name + " VAO");
+	utils::opengl::debug::nameObject(GL_BUFFER, mesh.ibo, mesh.name + " IBO");
+
+	UploadManager::GetShared().UploadBuffer(mesh.ibo, 0, size, indices.data());
+
+	return mesh;
+}
+
+bonobo::mesh_data
+parametric_shapes::createSphere(float const radius,
+                                unsigned int const longitude_split_count,
+                                unsigned int const latitude_split_count,
+                                bonobo::mesh_upload_options const& upload_options)
+{
+	return upload(buildSphere(radius, longitude_split_count, latitude_split_count),
+	              upload_options);
+}
+
+bonobo::mesh_data
+parametric_shapes::createTorus(float const major_radius,
+                               float const minor_radius,
+                               unsigned int const major_split_count,
+                               unsigned int const minor_split_count,
+                               bonobo::mesh_upload_options const& upload_options)
+{
+	return upload(buildTorus(major_radius, minor_radius, major_split_count, minor_split_count),
+	              upload_options);
+}
+
+bonobo::mesh_data
+parametric_shapes::createCircleRing(float const radius,
+                                    float const spread_length,
+                                    unsigned int const circle_split_count,
+                                    unsigned int const spread_split_count,
+                                    bonobo::mesh_upload_options const& upload_options)
+{
+	return upload(buildCircleRing(radius, spread_length, circle_split_count, spread_split_count),
+	              upload_options);
 }
@@ -2,10 +2,42 @@
 
 #include "core/helpers.hpp"
 
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
 namespace parametric_shapes
 {
-	//! \brief Create a quad a given tesselation level and make it
-	//!        available to OpenGL.
+	//! \brief Geometry of a shape, computed on the CPU and not yet
+	//!        handed over to OpenGL.
+	//!
+	//! All attribute arrays have one element per vertex; `indices` holds
+	//! one element per triangle.
+	struct mesh_buffers {
+		std::string name;
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec3> texcoords;
+		std::vector<glm::vec3> tangents;
+		std::vector<glm::vec3> binormals;
+		std::vector<glm::uvec3> indices;
+	};
+
+	//! \brief How the build*() functions get their work done; it does
+	//!        not affect the output.
+	struct execution_policy {
+		//! Split large shapes into bands of rows computed on
+		//! `ThreadPool::GetShared()`; ignored when called from one of its
+		//! workers, which then computes the whole shape itself.
+		bool use_thread_pool{ true };
+	};
+
+	// The build*() functions below neither log nor call into OpenGL, so
+	// that they can be called from worker threads, or from programs
+	// without any OpenGL context.
+
+	//! \brief Compute a quad for a given tesselation level.
 	//!
 	//! @param width the width of the quad
 	//! @param height the height of the quad
@@ -17,14 +49,14 @@ namespace parametric_shapes
 	//!                             should be split: 0 means each vertical
 	//!                             line consist of a single edge, 1 gives
 	//!                             you two edges, and so on.
-	//! @return wrapper around OpenGL objects' name containing the geometry
-	//!         data
-	bonobo::mesh_data createQuad(float const width, float const height,
-	                             unsigned int const horizontal_split_count = 0u,
-	                             unsigned int const vertical_split_count = 0u);
+	//! @param policy how to spread the work
+	//! @return the geometry, ready to be passed to `upload()`
+	mesh_buffers buildQuad(float const width, float const height,
+	                       unsigned int const horizontal_split_count = 0u,
+	                       unsigned int const vertical_split_count = 0u,
+	                       execution_policy const& policy = execution_policy());
 
-	//! \brief Create a sphere for a given tesselation level and make it
-	//!        available to OpenGL.
+	//! \brief Compute a sphere for a given tesselation level.
 	//!
 	//! @param radius radius of the sphere
 	//! @param longitude_split_count the number of times the longitude
@@ -40,14 +72,14 @@ namespace parametric_shapes
 	//!                             edge spanning the full 180°, with 1 you
 	//!                             get two edges (each spanning 90°); 1 is
 	//!                             the minimum for getting a 3-D shape.
-	//! @return wrapper around OpenGL objects' name containing the geometry
-	//!         data
-	bonobo::mesh_data createSphere(float const radius,
-	                               unsigned int const longitude_split_count,
-	                               unsigned int const latitude_split_count);
+	//! @param policy how to spread the work
+	//! @return the geometry, ready to be passed to `upload()`
+	mesh_buffers buildSphere(float const radius,
+	                         unsigned int const longitude_split_count,
+	                         unsigned int const latitude_split_count,
+	                         execution_policy const& policy = execution_policy());
 
-	//! \brief Create a torus for a given tesselation level and make it
-	//!        available to OpenGL.
+	//! \brief Compute a torus for a given tesselation level.
 	//!
 	//! @param major_radius radius from the centre to the middle of the
 	//!                     cross-section
@@ -67,15 +99,15 @@ namespace parametric_shapes
 	//!                          with 1 you get two edges (each spanning
 	//!                          180°); 2 is the minimum for getting a 3-D
 	//!                          shape.
-	//! @return wrapper around OpenGL objects' name containing the geometry
-	//!         data
-	bonobo::mesh_data createTorus(float const major_radius,
-	                              float const minor_radius,
-	                              unsigned int const major_split_count,
-	                              unsigned int const minor_split_count);
+	//! @param policy how to spread the work
+	//! @return the geometry, ready to be passed to `upload()`
+	mesh_buffers buildTorus(float const major_radius,
+	                        float const minor_radius,
+	                        unsigned int const major_split_count,
+	                        unsigned int const minor_split_count,
+	                        execution_policy const& policy = execution_policy());
 
-	//! \brief Create a circle ring for a given tesselation level and make it
-	//!        available to OpenGL.
+	//! \brief Compute a circle ring for a given tesselation level.
 	//!
 	//! @param radius radius from the centre to the middle of the
 	//!               cross-section
@@ -93,10 +125,94 @@ namespace parametric_shapes
 	//!                           single edge spanning the full spread,
 	//!                           with 1 you get two edges (each spanning
 	//!                           half the spread).
+	//! @param policy how to spread the work
+	//! @return the geometry, ready to be passed to `upload()`
+	mesh_buffers buildCircleRing(float const radius,
+	                             float const spread_length,
+	                             unsigned int const circle_split_count,
+	                             unsigned int const spread_split_count,
+	                             execution_policy const& policy = execution_policy());
+
+	//! \brief Index marking the end of a strip in the indices returned
+	//!        by `buildQuadStripIndices()`, to be passed to
+	//!        `glPrimitiveRestartIndex()`.
+	constexpr GLuint primitive_restart_index = 0xffffffffu;
+
+	//! \brief Compute the indices of a quad with the same vertices as
+	//!        `buildQuad()`, as one triangle strip per row of cells.
+	//!
+	//! @param horizontal_split_count see `buildQuad()`
+	//! @param vertical_split_count see `buildQuad()`
+	//! @param policy how to spread the work
+	//! @return the indices, with strips separated by
+	//!         `primitive_restart_index`
+	std::vector<GLuint> buildQuadStripIndices(unsigned int const horizontal_split_count,
+	                                          unsigned int const vertical_split_count,
+	                                          execution_policy const& policy = execution_policy());
+
+	//! \brief Upload options used when none are given: shapes get
+	//!        suballocated from the geometry arena, as `Node` draws them
+	//!        with their base vertex and indices offset.
+	bonobo::mesh_upload_options getDefaultUploadOptions();
+
+	//! \brief Make a shape available to OpenGL; needs a current context.
+	//!
+	//! @param mesh geometry, as returned by one of the build*() functions
+	//! @param upload_options how to lay out the geometry in OpenGL buffers
 	//! @return wrapper around OpenGL objects' name containing the geometry
-	//!         data
+	//!         data, or an empty one if `mesh` has no vertices or indices
+	bonobo::mesh_data upload(mesh_buffers const& mesh,
+	                         bonobo::mesh_upload_options const& upload_options = getDefaultUploadOptions());
+
+	//! \brief Shorthand for `upload(buildQuad(…), upload_options)`.
+	bonobo::mesh_data createQuad(float const width, float const height,
+	                             unsigned int const horizontal_split_count = 0u,
+	                             unsigned int const vertical_split_count = 0u,
+	                             bonobo::mesh_upload_options const& upload_options = getDefaultUploadOptions());
+
+	//! \brief Create a quad whose vertices are left for the vertex
+	//!        shader to rebuild, and make it available to OpenGL.
+	//!
+	//! No vertex buffer gets created: the mesh only holds the indices
+	//! from `buildQuadStripIndices()`, drawn as GL_TRIANGLE_STRIP with
+	//! primitive restart, which the caller has to enable with
+	//! `primitive_restart_index`. The vertex shader has to rebuild each
+	//! vertex from `gl_VertexID` as `buildQuad()` would have laid it
+	//! out, i.e. row i = `gl_VertexID / (vertical_split_count + 2)` and
+	//! column j = `gl_VertexID % (vertical_split_count + 2)`, with
+	//! position (i·width/(horizontal_split_count + 1),
+	//! j·height/(vertical_split_count + 1), 0), texture coordinates
+	//! (j/(vertical_split_count + 1), i/(horizontal_split_count + 1)),
+	//! tangent +x, binormal +y and normal +z.
+	//!
+	//! @param width see `buildQuad()`
+	//! @param height see `buildQuad()`
+	//! @param horizontal_split_count see `buildQuad()`
+	//! @param vertical_split_count see `buildQuad()`
+	//! @return wrapper around OpenGL objects' name containing the
+	//!         indices; `vertices_nb` is the number of vertices the
+	//!         shader has to rebuild
+	bonobo::mesh_data createProceduralQuad(float const width, float const height,
+	                                       unsigned int const horizontal_split_count,
+	                                       unsigned int const vertical_split_count);
+
+	//! \brief Shorthand for `upload(buildSphere(…), upload_options)`.
+	bonobo::mesh_data createSphere(float const radius,
+	                               unsigned int const longitude_split_count,
+	                               unsigned int const latitude_split_count,
+	                               bonobo::mesh_upload_options const& upload_options = getDefaultUploadOptions());
+
+	//! \brief Shorthand for `upload(buildTorus(…), upload_options)`.
+	bonobo::mesh_data createTorus(float const major_radius,
+	                              float const minor_radius,
+	                              unsigned int const major_split_count,
+	                              unsigned int const minor_split_count,
+	                              bonobo::mesh_upload_options const& upload_options = getDefaultUploadOptions());
+
+	//! \brief Shorthand for `upload(buildCircleRing(…), upload_options)`.
 	bonobo::mesh_data createCircleRing(float const radius,
 	                                   float const spread_length,
 	                                   unsigned int const circle_split_count,
-	                                   unsigned int const spread_split_count);
+	                                   unsigned int const spread_split_count,
+	                                   bonobo::mesh_upload_options const& upload_options = getDefaultUploadOptions());
 }
@@ -0,0 +1,213 @@
+#include "shape_cache.hpp"
+#include "parametric_shapes.hpp"
+
+#include "core/mesh_upload.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+	// Parametric shapes provide all five attributes.
+	constexpr std::uint32_t all_attributes_mask = (1u << 5) - 1u;
+
+	// Floats are keyed by their bits, as any decimal rendering short
+	// enough to be practical would merge nearby values.
+	void appendToKey(std::string& key, float value)
+	{
+		std::uint32_t bits = 0u;
+		static_assert(sizeof(bits) == sizeof(value), "float is expected to be 32-bit");
+		std::memcpy(&bits, &value, sizeof(bits));
+		key += ' ';
+		key += std::to_string(bits);
+	}
+
+	void appendToKey(std::string& key, unsigned int value)
+	{
+		key += ' ';
+		key += std::to_string(value);
+	}
+
+	// Only options affecting the content of the buffers are part of the
+	// key; where those buffers live does not matter to their users.
+	void appendToKey(std::string& key, bonobo::mesh_upload_options const& upload_options)
+	{
+		appendToKey(key, static_cast<unsigned int>(upload_options.vertex_layout));
+		appendToKey(key, upload_options.allow_short_indices ? 1u : 0u);
+	}
+
+	std::uint64_t getSize(bonobo::mesh_data const& mesh, bonobo::vertex_layout_t layout)
+	{
+		auto const index_size = mesh.indices_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+		return static_cast<std::uint64_t>(mesh.vertices_nb) * bonobo::getVertexSize(layout, all_attributes_mask)
+		     + static_cast<std::uint64_t>(mesh.indices_nb) * index_size;
+	}
+}
+
+std::size_t
+ShapeCache::mesh_id_hash::operator()(mesh_id const& id) const
+{
+	return std::hash<GLuint>()(id.first) ^ (std::hash<std::size_t>()(id.second) << 1);
+}
+
+template<typename F>
+bonobo::mesh_data
+ShapeCache::Acquire(std::string const& key, F const& build,
+                    bonobo::mesh_upload_options const& upload_options)
+{
+	auto const it = ids.find(key);
+	if (it != ids.end()) {
+		auto& entry = entries.at(it->second);
+		++entry.references_nb;
+		++statistics.hits;
+		statistics.bytes_saved += entry.size_in_bytes;
+		return entry.mesh;
+	}
+
+	++statistics.misses;
+	auto mesh = parametric_shapes::upload(build(), upload_options);
+	if (mesh.vao == 0u)
+		return mesh;
+
+	auto const id = mesh_id(mesh.ibo, mesh.indices_offset);
+	assert(entries.find(id) == entries.end());
+
+	auto const size_in_bytes = getSize(mesh, upload_options.vertex_layout);
+	ids.emplace(key, id);
+	entries.emplace(id, Entry{ key, mesh, 1u, size_in_bytes });
+	++statistics.shapes_nb;
+	statistics.bytes_resident += size_in_bytes;
+
+	return mesh;
+}
+
+bonobo::mesh_data
+ShapeCache::AcquireQuad(float width, float height,
+                        unsigned int horizontal_split_count, unsigned int vertical_split_count,
+                        bonobo::mesh_upload_options const& upload_options)
+{
+	std::string key = "quad";
+	appendToKey(key, width);
+	appendToKey(key, height);
+	appendToKey(key, horizontal_split_count);
+	appendToKey(key, vertical_split_count);
+	appendToKey(key, upload_options);
+
+	return Acquire(key, [&](){
+		return parametric_shapes::buildQuad(width, height, horizontal_split_count, vertical_split_count);
+	}, upload_options);
+}
+
+bonobo::mesh_data
+ShapeCache::AcquireSphere(float radius,
+                          unsigned int longitude_split_count, unsigned int latitude_split_count,
+                          bonobo::mesh_upload_options const& upload_options)
+{
+	std::string key = "sphere";
+	appendToKey(key, radius);
+	appendToKey(key, longitude_split_count);
+	appendToKey(key, latitude_split_count);
+	appendToKey(key, upload_options);
+
+	return Acquire(key, [&](){
+		return parametric_shapes::buildSphere(radius, longitude_split_count, latitude_split_count);
+	}, upload_options);
+}
+
+bonobo::mesh_data
+ShapeCache::AcquireTorus(float major_radius, float minor_radius,
+                         unsigned int major_split_count, unsigned int minor_split_count,
+                         bonobo::mesh_upload_options const& upload_options)
+{
+	std::string key = "torus";
+	appendToKey(key, major_radius);
+	appendToKey(key, minor_radius);
+	appendToKey(key, major_split_count);
+	appendToKey(key, minor_split_count);
+	appendToKey(key, upload_options);
+
+	return Acquire(key, [&](){
+		return parametric_shapes::buildTorus(major_radius, minor_radius, major_split_count, minor_split_count);
+	}, upload_options);
+}
+
+bonobo::mesh_data
+ShapeCache::AcquireCircleRing(float radius, float spread_length,
+                              unsigned int circle_split_count, unsigned int spread_split_count,
+                              bonobo::mesh_upload_options const& upload_options)
+{
+	std::string key = "circle ring";
+	appendToKey(key, radius);
+	appendToKey(key, spread_length);
+	appendToKey(key, circle_split_count);
+	appendToKey(key, spread_split_count);
+	appendToKey(key, upload_options);
+
+	return Acquire(key, [&](){
+		return parametric_shapes::buildCircleRing(radius, spread_length, circle_split_count, spread_split_count);
+	}, upload_options);
+}
+
+bool
+ShapeCache::Acquire(bonobo::mesh_data const& mesh)
+{
+	auto const it = entries.find(mesh_id(mesh.ibo, mesh.indices_offset));
+	if (it == entries.end() || mesh.vao == 0u)
+		return false;
+
+	++it->second.references_nb;
+	++statistics.hits;
+	statistics.bytes_saved += it->second.size_in_bytes;
+
+	return true;
+}
+
+bool
+ShapeCache::Release(bonobo::mesh_data& mesh)
+{
+	auto const it = entries.find(mesh_id(mesh.ibo, mesh.indices_offset));
+	if (it == entries.end() || mesh.vao == 0u)
+		return false;
+
+	mesh.vao = 0u;
+	mesh.bo = 0u;
+	mesh.ibo = 0u;
+	mesh.is_in_geometry_arena = false;
+
+	assert(it->second.references_nb > 0u);
+	if (--it->second.references_nb > 0u)
+		return true;
+
+	bonobo::releaseMesh(it->second.mesh);
+	--statistics.shapes_nb;
+	statistics.bytes_resident -= it->second.size_in_bytes;
+	ids.erase(it->second.key);
+	entries.erase(it);
+
+	return true;
+}
+
+void
+ShapeCache::Clear()
+{
+	for (auto& entry : entries)
+		bonobo::releaseMesh(entry.second.mesh);
+	ids.clear();
+	entries.clear();
+	statistics.shapes_nb = 0u;
+	statistics.bytes_resident = 0u;
+}
+
+ShapeCache::Statistics
+ShapeCache::GetStatistics() const
+{
+	return statistics;
+}
+
+ShapeCache&
+ShapeCache::GetShared()
+{
+	static ShapeCache cache;
+	return cache;
+}
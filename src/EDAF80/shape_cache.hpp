@@ -0,0 +1,109 @@
+#pragma once
+
+#include "parametric_shapes.hpp"
+
+#include "core/helpers.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+//! \brief Process-wide set of the parametric shapes made available to
+//!        OpenGL, so that identical shapes are only built and uploaded
+//!        once.
+//!
+//! Shapes are keyed by their kind, all their construction parameters,
+//! their vertex layout and whether short indices are allowed; whether
+//! they come from the geometry arena is up to their first upload. They
+//! are reference-counted: each `Acquire*()` must be balanced by a
+//! `Release()`, and the last one frees the geometry. The returned
+//! `mesh_data` all refer to the same buffers; any texture binding or
+//! material set on them is per copy.
+//!
+//! The cache calls into OpenGL, so it must only be used from the thread
+//! owning the context.
+class ShapeCache
+{
+public:
+	struct Statistics {
+		std::size_t hits{ 0u };               //!< each one a build and an upload avoided
+		std::size_t misses{ 0u };
+		std::uint64_t bytes_saved{ 0u };      //!< GPU memory that would have been spent on duplicates
+		std::size_t shapes_nb{ 0u };          //!< shapes currently cached
+		std::uint64_t bytes_resident{ 0u };   //!< GPU memory used by those shapes
+	};
+
+	//! The destructor does not free any geometry, as the OpenGL context
+	//! is likely gone by the time static objects get destroyed; call
+	//! `Clear()` before destroying the context instead.
+	ShapeCache() = default;
+	ShapeCache(ShapeCache const&) = delete;
+	ShapeCache& operator=(ShapeCache const&) = delete;
+
+	//! \brief Cached counterpart to `parametric_shapes::createQuad()`.
+	bonobo::mesh_data AcquireQuad(float width, float height,
+	                              unsigned int horizontal_split_count, unsigned int vertical_split_count,
+	                              bonobo::mesh_upload_options const& upload_options = parametric_shapes::getDefaultUploadOptions());
+
+	//! \brief Cached counterpart to `parametric_shapes::createSphere()`.
+	bonobo::mesh_data AcquireSphere(float radius,
+	                                unsigned int longitude_split_count, unsigned int latitude_split_count,
+	                                bonobo::mesh_upload_options const& upload_options = parametric_shapes::getDefaultUploadOptions());
+
+	//! \brief Cached counterpart to `parametric_shapes::createTorus()`.
+	bonobo::mesh_data AcquireTorus(float major_radius, float minor_radius,
+	                               unsigned int major_split_count, unsigned int minor_split_count,
+	                               bonobo::mesh_upload_options const& upload_options = parametric_shapes::getDefaultUploadOptions());
+
+	//! \brief Cached counterpart to `parametric_shapes::createCircleRing()`.
+	bonobo::mesh_data AcquireCircleRing(float radius, float spread_length,
+	                                    unsigned int circle_split_count, unsigned int spread_split_count,
+	                                    bonobo::mesh_upload_options const& upload_options = parametric_shapes::getDefaultUploadOptions());
+
+	//! \brief Take one more reference to a cached shape, e.g. for a copy
+	//!        of an object holding it.
+	//!
+	//! @return whether the shape is managed by the cache
+	bool Acquire(bonobo::mesh_data const& mesh);
+
+	//! \brief Drop a reference to a shape, freeing its geometry if it
+	//!        was the last one, and reset the names of `mesh`.
+	//!
+	//! @return whether the shape is managed by the cache; meshes which
+	//!         are not are left untouched
+	bool Release(bonobo::mesh_data& mesh);
+
+	//! \brief Free all shapes, whatever their reference count; must be
+	//!        called before the OpenGL context goes away.
+	void Clear();
+
+	Statistics GetStatistics() const;
+
+	//! \brief Cache shared by all users of the parametric shapes.
+	static ShapeCache& GetShared();
+
+private:
+	// Meshes from the geometry arena share their VAO and buffers, but
+	// never their index range.
+	using mesh_id = std::pair<GLuint, std::size_t>;
+	struct mesh_id_hash {
+		std::size_t operator()(mesh_id const& id) const;
+	};
+
+	struct Entry {
+		std::string key;
+		bonobo::mesh_data mesh;
+		std::uint32_t references_nb{ 0u };
+		std::uint64_t size_in_bytes{ 0u };
+	};
+
+	template<typename F>
+	bonobo::mesh_data Acquire(std::string const& key, F const& build,
+	                          bonobo::mesh_upload_options const& upload_options);
+
+	std::unordered_map<std::string, mesh_id> ids;
+	std::unordered_map<mesh_id, Entry, mesh_id_hash> entries;
+	Statistics statistics;
+};
@@ -2,91 +2,49 @@
 #include "core/helpers.hpp"
 #include "core/Log.h"
 
-#include <assimp/Importer.hpp>
-#include <assimp/matrix4x4.h>
-#include <assimp/scene.h>
-
 #include <stack>
 
-/// @brief Count number of nodes in the assimp scene graph
-/// @param[in] node Input node
-/// @return Number of nodes
-size_t num_nodes(struct aiNode *node)
-{
-	size_t n = 1;
-	for (auto i = 0u; i < node->mNumChildren; i++) {
-		n += num_nodes(node->mChildren[i]);
-	}
-	return n;
-}
-
-/// @brief Convert assimp transform to TRS transform
-/// @param[in] ai_trafo Input transform
-/// @param[out] trs_trafo Output transform
-void ai_transform_to_trs_transform(const aiMatrix4x4 &ai_trafo, TRSTransformf &trs_trafo)
-{
-	aiVector3t<ai_real> scaling;
-	aiQuaterniont<ai_real> rotation;
-	aiVector3t<ai_real> position;
-	ai_trafo.Decompose(scaling, rotation, position);
-
-	trs_trafo.SetScale(glm::vec3(scaling.x, scaling.y, scaling.z));
-	trs_trafo.SetTranslate(glm::vec3(position.x, position.y, position.z));
-	glm::quat quat(rotation.w, rotation.x, rotation.y, rotation.z);
-	trs_trafo.SetRotate(glm::angle(quat), glm::axis(quat));
-}
-
 bool Spaceship::load(const std::string &path)
 {
 	_meshes.clear();
 	_nodes.clear();
-
-	// Load meshes
-	_meshes = bonobo::loadObjects(path);
-	if (_meshes.size() == 0) {
+	_parents.clear();
+
+	// Load meshes and scene graph, from a single import; levels of
+	// detail let the ship get cheaper as it flies away from the camera.
+	bonobo::object_load_options options;
+	options.build_lods = true;
+	auto scene = bonobo::loadScene(path, options);
+	if (scene.meshes.size() == 0) {
 		LogError("Failed to load meshes from '%s'", path.c_str());
 		return false;
 	}
+	_meshes = std::move(scene.meshes);
 
-	// Load scene graph
-	Assimp::Importer importer;
-	auto const assimp_scene = importer.ReadFile(path, 0);
-	if (assimp_scene == nullptr || assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || assimp_scene->mRootNode == nullptr) {
-		LogError("Failed to import scene from '%s'", path.c_str());
-		return false;
-	}
-
-	std::stack<std::pair<struct aiNode *, Node *>> stack;
-	stack.emplace(assimp_scene->mRootNode, nullptr);
-
-	_nodes.reserve(num_nodes(assimp_scene->mRootNode));
-
-	while(!stack.empty()) {
-		struct aiNode *ai_node;
-		Node *parent;
-		std::tie(ai_node, parent) = stack.top();
-		stack.pop();
-
+	// Parents come before their children, and reserving ensures that
+	// the pointers to them stay valid.
+	_nodes.reserve(scene.nodes.size());
+	_parents.reserve(scene.nodes.size());
+	for (auto const& scene_node : scene.nodes) {
 		Node node;
 
-		if (ai_node->mNumMeshes == 1) {
-			node.set_geometry(_meshes.at(ai_node->mMeshes[0]));
+		if (scene_node.meshes.size() == 1) {
+			node.set_geometry(_meshes.at(scene_node.meshes[0]));
 		}
-		else if (ai_node->mNumMeshes > 1) {
-			LogWarning("Unsupported number of meshes (%u) for node %s",
-			           ai_node->mNumMeshes, ai_node->mName.C_Str());
+		else if (scene_node.meshes.size() > 1) {
+			LogWarning("Unsupported number of meshes (%zu) for node %s",
+			           scene_node.meshes.size(), scene_node.name.c_str());
 		}
 
-		ai_transform_to_trs_transform(ai_node->mTransformation, node.get_transform());
+		node.get_transform().SetScale(scene_node.scale);
+		node.get_transform().SetTranslate(scene_node.translation);
+		node.get_transform().SetRotate(glm::angle(scene_node.rotation), glm::axis(scene_node.rotation));
 
 		_nodes.push_back(node);
+		_parents.push_back(scene_node.parent);
 
-		if (parent != nullptr) {
-			parent->add_child(&_nodes.back());
-		}
-
-		for (auto i = 0u; i < ai_node->mNumChildren; ++i) {
-			stack.emplace(ai_node->mChildren[i], &_nodes.back());
+		if (scene_node.parent >= 0) {
+			_nodes.at(static_cast<size_t>(scene_node.parent)).add_child(&_nodes.back());
 		}
 	}
 
@@ -116,6 +74,18 @@ void Spaceship::render(const glm::mat4 &view_projection, bool show_basis, float
 	}
 }
 
+void Spaceship::select_lods(const glm::vec3 &camera_position, float screen_height_px, float vertical_fov, float max_error_px)
+{
+	// Parents come before their children, so their world transforms are
+	// always known by the time their children need them.
+	std::vector<glm::mat4> worlds(_nodes.size());
+	for (size_t i = 0; i < _nodes.size(); i++) {
+		auto const parent_transform = _parents[i] >= 0 ? worlds[static_cast<size_t>(_parents[i])] : _transform;
+		worlds[i] = parent_transform * _nodes[i].get_transform().GetMatrix();
+		_nodes[i].select_lod(worlds[i], camera_position, screen_height_px, vertical_fov, max_error_px);
+	}
+}
+
 bool Spaceship::update(InputHandler &input_handler, const float elapsed_time_s)
 {
 	if (input_handler.GetKeycodeState(GLFW_KEY_UP) & PRESSED)
@@ -6,6 +6,9 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
+#include <cstdint>
+#include <vector>
+
 /// @brief Spaceship class
 class Spaceship
 {
@@ -25,6 +28,13 @@ public:
 	/// @param length_scale Length of axes
 	void render(const glm::mat4 &view_projection, bool show_basis, float thickness_scale, float length_scale) const;
 
+	/// @brief Select the level of detail of each node from its distance to the camera
+	/// @param camera_position Camera position, in world space
+	/// @param screen_height_px Height of the viewport, in pixels
+	/// @param vertical_fov Vertical field of view of the camera, in radians
+	/// @param max_error_px How far, in pixels, the rendered surface may be from the full geometry
+	void select_lods(const glm::vec3 &camera_position, float screen_height_px, float vertical_fov, float max_error_px = 1.0f);
+
 	/// @brief Update the position of the spaceship
 	/// @param input_handler Input handler
 	/// @param elapsed_time_s Elapsed time in seconds since last update
@@ -54,6 +64,7 @@ public:
 private:
 	std::vector<bonobo::mesh_data> _meshes;
 	std::vector<Node> _nodes;
+	std::vector<std::int32_t> _parents;
 	glm::mat4 _transform;
 	glm::vec3 _velocity;
 	glm::vec3 _angular_velocity;
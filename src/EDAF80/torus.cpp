@@ -1,13 +1,16 @@
 #include "torus.hpp"
 #include "util.hpp"
-#include "parametric_shapes.hpp"
+#include "shape_cache.hpp"
+
+#include <utility>
 
 const unsigned int Torus::MAJOR_SPLIT_COUNT = 63;
 const unsigned int Torus::MINOR_SPLIT_COUNT = 63;
 
 Torus::Torus(const glm::mat4 &transform, const float major_radius, const float minor_radius)
 {
-	_shape = parametric_shapes::createTorus(major_radius, minor_radius, MAJOR_SPLIT_COUNT, MINOR_SPLIT_COUNT);
+	// All toruses of the same size share their geometry.
+	_shape = ShapeCache::GetShared().AcquireTorus(major_radius, minor_radius, MAJOR_SPLIT_COUNT, MINOR_SPLIT_COUNT);
 
 	_node.set_geometry(_shape);
 	glm_mat4_to_trs_transform(transform, _node.get_transform());
@@ -19,6 +22,65 @@ Torus::Torus(const glm::mat4 &transform, const float major_radius, const float m
 	_active = true;
 }
 
+Torus::~Torus()
+{
+	ShapeCache::GetShared().Release(_shape);
+}
+
+Torus::Torus(const Torus &other)
+	: _shape(other._shape)
+	, _node(other._node)
+	, _world_to_model(other._world_to_model)
+	, _major_radius(other._major_radius)
+	, _active(other._active)
+{
+	ShapeCache::GetShared().Acquire(_shape);
+}
+
+Torus &Torus::operator=(const Torus &other)
+{
+	// Take the new reference first, in case both share the same shape.
+	ShapeCache::GetShared().Acquire(other._shape);
+	ShapeCache::GetShared().Release(_shape);
+
+	_shape = other._shape;
+	_node = other._node;
+	_world_to_model = other._world_to_model;
+	_major_radius = other._major_radius;
+	_active = other._active;
+
+	return *this;
+}
+
+Torus::Torus(Torus &&other) noexcept
+	: _shape(other._shape)
+	, _node(std::move(other._node))
+	, _world_to_model(other._world_to_model)
+	, _major_radius(other._major_radius)
+	, _active(other._active)
+{
+	other._shape = bonobo::mesh_data();
+}
+
+Torus &Torus::operator=(Torus &&other) noexcept
+{
+	if (this == &other) {
+		return *this;
+	}
+
+	ShapeCache::GetShared().Release(_shape);
+
+	_shape = other._shape;
+	_node = std::move(other._node);
+	_world_to_model = other._world_to_model;
+	_major_radius = other._major_radius;
+	_active = other._active;
+
+	other._shape = bonobo::mesh_data();
+
+	return *this;
+}
+
 void Torus::render(const glm::mat4 &view_projection, bool show_basis, float thickness_scale, float length_scale) const
 {
 	if (!_active) {
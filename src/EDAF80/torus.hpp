@@ -16,6 +16,17 @@ public:
 	/// @param minor_radius Minor radius
 	Torus(const glm::mat4 &transform, const float major_radius, const float minor_radius);
 
+	/// @brief Give the torus' reference to its shape back to the shape cache
+	~Torus();
+
+	/// @brief Copies share the shape, each holding a reference to it
+	Torus(const Torus &other);
+	Torus &operator=(const Torus &other);
+
+	/// @brief Moved-from toruses are left without a shape
+	Torus(Torus &&other) noexcept;
+	Torus &operator=(Torus &&other) noexcept;
+
 	/// @brief Render the torus
 	/// @param view_projection World space to clip space matrix
 	/// @param show_basis Show axes of local coordinate system
@@ -8,8 +8,10 @@
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
 #include "core/helpers.hpp"
+#include "core/material_packer.hpp"
 #include "core/node.hpp"
 #include "core/opengl.hpp"
+#include "core/SceneStreamer.hpp"
 #include "core/ShaderProgramManager.hpp"
 
 #include <imgui.h>
@@ -18,6 +20,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <tinyfiledialogs.h>
 
+#include <algorithm>
 #include <array>
 #include <clocale>
 #include <cstdlib>
@@ -33,6 +36,12 @@ namespace constant
 	constexpr size_t lights_nb           = 4;
 	constexpr float  light_intensity     = 72.0f * (scale_lengths * scale_lengths);
 	constexpr float  light_angle_falloff = glm::radians(37.0f);
+
+	constexpr float  streaming_budget_ms = 2.0f; // Time spent uploading Sponza's meshes and textures, per frame.
+
+	constexpr bool    compress_sponza_textures = false; // Block-compress Sponza's textures; they then keep their own sizes in texture arrays, so unless all textures of a slot share one, they keep being bound per mesh.
+	constexpr GLsizei packed_textures_size     = 1024; // Sponza's textures are resampled to that size when packed into texture arrays.
+	constexpr size_t  max_packed_materials_nb  = 1024; // Must match MAX_MATERIALS_NB in EDAN35/fill_gbuffer_arrays.frag and EDAN35/fill_shadowmap_arrays.frag.
 }
 
 namespace
@@ -92,6 +101,7 @@ namespace
 	enum class UBO : uint32_t {
 		CameraViewProjTransforms = 0u,
 		LightViewProjTransforms,
+		MaterialLayers,
 		Count
 	};
 	using UBOs = std::array<GLuint, toU(UBO::Count)>;
@@ -124,6 +134,15 @@ namespace
 		GLuint has_specular_texture{ 0u };
 		GLuint has_normals_texture{ 0u };
 		GLuint has_opacity_texture{ 0u };
+		bonobo::vertex_decoding_locations vertex_decoding;
+
+		// Only used by the texture arrays variant.
+		GLuint ubo_MaterialLayers{ 0u };
+		GLuint material_index{ 0u };
+		GLuint diffuse_textures{ 0u };
+		GLuint specular_textures{ 0u };
+		GLuint normals_textures{ 0u };
+		GLuint opacity_textures{ 0u };
 	};
 	void fillGBufferShaderLocations(GLuint gbuffer_shader, GBufferShaderLocations& locations);
 
@@ -134,6 +153,10 @@ namespace
 		GLuint vertex_model_to_world{ 0u };
 		GLuint opacity_texture{ 0u };
 		GLuint has_opacity_texture{ 0u };
+		bonobo::vertex_decoding_locations vertex_decoding;
+		GLuint ubo_MaterialLayers{ 0u };
+		GLuint material_index{ 0u };
+		GLuint opacity_textures{ 0u };
 	};
 	void fillShadowmapShaderLocations(GLuint shadowmap_shader, FillShadowmapShaderLocations& locations);
 
@@ -185,39 +208,52 @@ edan35::Assignment2::~Assignment2()
 void
 edan35::Assignment2::run()
 {
-	// Load the geometry of Sponza
-	auto const sponza_geometry = bonobo::loadObjects(config::resources_path("sponza/sponza.obj"));
-	if (sponza_geometry.empty()) {
-		LogError("Failed to load the Sponza model");
-		return;
-	}
+	// Stream the geometry of Sponza in, while already rendering; as it
+	// gets drawn once for the G-buffer and once per shadow map, it is
+	// worth optimising its meshes and packing their vertices.
+	bonobo::object_load_options sponza_load_options;
+	sponza_load_options.optimize_meshes = true;
+	// Positions are kept as floats: quantising them to each mesh's own
+	// bounds, as `packed_quantized` does, opens cracks where neighbouring
+	// meshes meet. Texture coordinates still get 16 bits over each mesh's
+	// range, which only starts to show on meshes tiling a texture
+	// hundreds of times.
+	sponza_load_options.mesh_upload.vertex_layout = bonobo::vertex_layout_t::packed;
+	// Sharing a few large buffers between all meshes lets the draw loops
+	// below skip most VAO binds.
+	sponza_load_options.mesh_upload.use_geometry_arena = true;
+	// Only keep the channels each texture needs; the shaders read masks
+	// from the red channel, and diffuse textures get decoded from sRGB.
+	sponza_load_options.use_texture_roles = true;
+	// Distant meshes get drawn with coarser levels of detail, selected
+	// per pass from the camera or the light.
+	sponza_load_options.build_lods = true;
+	sponza_load_options.compress_textures = constant::compress_sponza_textures;
+	SceneStreamer sponza_streamer(config::resources_path("sponza/sponza.obj"), sponza_load_options);
+	auto const& sponza_geometry = sponza_streamer.GetMeshes();
+
+	// Textures still being streamed in are bound to the debug texture;
+	// treat them as missing until then.
+	const GLuint debug_texture_id = bonobo::getDebugTextureID();
+	auto const get_texture_id = [debug_texture_id](bonobo::texture_bindings const& bindings, std::string const& name){
+		auto const texture = bindings.find(name);
+		if (texture == bindings.end() || texture->second == debug_texture_id)
+			return 0u;
+		return texture->second;
+	};
 	std::vector<GeometryTextureData> sponza_geometry_texture_data;
-	sponza_geometry_texture_data.reserve(sponza_geometry.size());
-	for (auto const& geometry : sponza_geometry) {
-		auto const diffuse_texture = geometry.bindings.find("diffuse_texture");
-		auto const specular_texture = geometry.bindings.find("specular_texture");
-		auto const normals_texture = geometry.bindings.find("normals_texture");
-		auto const opacity_texture = geometry.bindings.find("opacity_texture");
-
-		GeometryTextureData data;
-		if (diffuse_texture != geometry.bindings.end())
-		{
-			data.diffuse_texture_id = diffuse_texture->second;
+	auto const update_sponza_geometry_texture_data = [&](){
+		sponza_geometry_texture_data.clear();
+		sponza_geometry_texture_data.reserve(sponza_geometry.size());
+		for (auto const& geometry : sponza_geometry) {
+			GeometryTextureData data;
+			data.diffuse_texture_id = get_texture_id(geometry.bindings, "diffuse_texture");
+			data.specular_texture_id = get_texture_id(geometry.bindings, "specular_texture");
+			data.normals_texture_id = get_texture_id(geometry.bindings, "normals_texture");
+			data.opacity_texture_id = get_texture_id(geometry.bindings, "opacity_texture");
+			sponza_geometry_texture_data.emplace_back(std::move(data));
 		}
-		if (specular_texture != geometry.bindings.end())
-		{
-			data.specular_texture_id = specular_texture->second;
-		}
-		if (normals_texture != geometry.bindings.end())
-		{
-			data.normals_texture_id = normals_texture->second;
-		}
-		if (opacity_texture != geometry.bindings.end())
-		{
-			data.opacity_texture_id = opacity_texture->second;
-		}
-		sponza_geometry_texture_data.emplace_back(std::move(data));
-	}
+	};
 
 	auto const cone_geometry = loadCone();
 	Node cone;
@@ -243,6 +279,64 @@ edan35::Assignment2::run()
 	ElapsedTimeQueries const elapsed_time_queries = createElapsedTimeQueries();
 	UBOs const ubos = createUniformBufferObjects();
 
+	// Once streamed in, Sponza's textures get packed into one texture
+	// array per slot, so that the G-buffer and shadow maps can be filled
+	// without binding any texture per mesh. The source textures are then
+	// released, rather than taking GPU memory a second time.
+	std::vector<std::string> const material_slots = { "diffuse_texture", "specular_texture", "normals_texture", "opacity_texture" };
+	bonobo::packed_materials sponza_materials;
+	auto const pack_sponza_materials = [&](){
+		bonobo::material_packing_options packing_options;
+		packing_options.resampled_size = constant::packed_textures_size;
+		packing_options.ignored_texture = debug_texture_id;
+		sponza_materials = bonobo::material_packer::pack(sponza_geometry, material_slots, packing_options);
+
+		// The shader expects a single array per slot, which compressed
+		// textures of different sizes would prevent.
+		auto const has_single_arrays = std::all_of(sponza_materials.arrays.begin(), sponza_materials.arrays.end(),
+		                                           [](std::vector<bonobo::texture_array> const& arrays){ return arrays.size() <= 1u; });
+		if (sponza_geometry.size() > constant::max_packed_materials_nb || !has_single_arrays) {
+			LogWarning("Sponza's materials do not fit in texture arrays; textures will keep being bound per mesh.");
+			bonobo::material_packer::release(sponza_materials);
+			return;
+		}
+
+		std::vector<glm::ivec4> material_layers;
+		material_layers.reserve(sponza_materials.meshes.size());
+		GLsizei layers_nb = 0;
+		for (auto const& mesh_textures : sponza_materials.meshes) {
+			glm::ivec4 layers(-1);
+			for (std::size_t slot = 0u; slot < mesh_textures.size(); ++slot)
+				layers[static_cast<int>(slot)] = mesh_textures[slot].layer;
+			material_layers.push_back(layers);
+		}
+		for (auto const& arrays : sponza_materials.arrays)
+			for (auto const& array : arrays)
+				layers_nb += array.layers_nb;
+		glBindBuffer(GL_UNIFORM_BUFFER, ubos[toU(UBO::MaterialLayers)]);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, material_layers.size() * sizeof(glm::ivec4), material_layers.data());
+		glBindBuffer(GL_UNIFORM_BUFFER, 0u);
+
+		if (constant::compress_sponza_textures)
+			LogInfo("Packed Sponza's textures into %d layers, at their own sizes.", layers_nb);
+		else
+			LogInfo("Packed Sponza's textures into %d layers of %dx%d.", layers_nb, constant::packed_textures_size, constant::packed_textures_size);
+
+		sponza_streamer.ReleaseTextures();
+		update_sponza_geometry_texture_data();
+	};
+	auto const are_sponza_materials_packed = [&sponza_materials](){
+		return !sponza_materials.slots.empty();
+	};
+	auto const bind_packed_textures = [&](){
+		for (std::size_t slot = 0u; slot < sponza_materials.arrays.size(); ++slot) {
+			auto const& arrays = sponza_materials.arrays[slot];
+			glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(slot));
+			glBindTexture(GL_TEXTURE_2D_ARRAY, arrays.empty() ? 0u : arrays.front().texture);
+			glBindSampler(static_cast<GLuint>(slot), samplers[toU(Sampler::Mipmaps)]);
+		}
+	};
+
 	//
 	// Load all the shader programs used
 	//
@@ -269,6 +363,18 @@ edan35::Assignment2::run()
 	GBufferShaderLocations fill_gbuffer_shader_locations;
 	fillGBufferShaderLocations(fill_gbuffer_shader, fill_gbuffer_shader_locations);
 
+	GLuint fill_gbuffer_arrays_shader = 0u;
+	program_manager.CreateAndRegisterProgram("Fill G-Buffer (texture arrays)",
+	                                         { { ShaderType::vertex, "EDAN35/fill_gbuffer.vert" },
+	                                           { ShaderType::fragment, "EDAN35/fill_gbuffer_arrays.frag" } },
+	                                         fill_gbuffer_arrays_shader);
+	if (fill_gbuffer_arrays_shader == 0u) {
+		LogError("Failed to load G-buffer filling shader using texture arrays");
+		return;
+	}
+	GBufferShaderLocations fill_gbuffer_arrays_shader_locations;
+	fillGBufferShaderLocations(fill_gbuffer_arrays_shader, fill_gbuffer_arrays_shader_locations);
+
 	GLuint fill_shadowmap_shader = 0u;
 	program_manager.CreateAndRegisterProgram("Fill shadow map",
 	                                         { { ShaderType::vertex, "EDAN35/fill_shadowmap.vert" },
@@ -281,6 +387,18 @@ edan35::Assignment2::run()
 	FillShadowmapShaderLocations fill_shadowmap_shader_locations;
 	fillShadowmapShaderLocations(fill_shadowmap_shader, fill_shadowmap_shader_locations);
 
+	GLuint fill_shadowmap_arrays_shader = 0u;
+	program_manager.CreateAndRegisterProgram("Fill shadow map (texture arrays)",
+	                                         { { ShaderType::vertex, "EDAN35/fill_shadowmap.vert" },
+	                                           { ShaderType::fragment, "EDAN35/fill_shadowmap_arrays.frag" } },
+	                                         fill_shadowmap_arrays_shader);
+	if (fill_shadowmap_arrays_shader == 0u) {
+		LogError("Failed to load shadowmap filling shader using texture arrays");
+		return;
+	}
+	FillShadowmapShaderLocations fill_shadowmap_arrays_shader_locations;
+	fillShadowmapShaderLocations(fill_shadowmap_arrays_shader, fill_shadowmap_arrays_shader_locations);
+
 	GLuint accumulate_lights_shader = 0u;
 	program_manager.CreateAndRegisterProgram("Accumulate light",
 	                                         { { ShaderType::vertex, "EDAN35/accumulate_lights.vert" },
@@ -318,8 +436,6 @@ edan35::Assignment2::run()
 	ViewProjTransforms camera_view_proj_transforms;
 	std::array<ViewProjTransforms, constant::lights_nb> light_view_proj_transforms;
 
-	const GLuint debug_texture_id = bonobo::getDebugTextureID();
-
 	auto const bind_texture_with_sampler = [](GLenum target, unsigned int slot, GLuint program, std::string const& name, GLuint texture, GLuint sampler){
 		glActiveTexture(GL_TEXTURE0 + slot);
 		glBindTexture(target, texture);
@@ -345,7 +461,8 @@ edan35::Assignment2::run()
 
 	float const lightProjectionNearPlane = 0.01f * constant::scale_lengths;
 	float const lightProjectionFarPlane = 20.0f * constant::scale_lengths;
-	auto lightProjection = glm::perspective(0.5f * glm::pi<float>(),
+	float const light_fov = 0.5f * glm::pi<float>();
+	auto lightProjection = glm::perspective(light_fov,
 	                                        static_cast<float>(constant::shadowmap_res_x) / static_cast<float>(constant::shadowmap_res_y),
 	                                        lightProjectionNearPlane, lightProjectionFarPlane);
 
@@ -394,6 +511,12 @@ edan35::Assignment2::run()
 		inputHandler.Advance();
 		mCamera.Update(deltaTimeUs, inputHandler);
 
+		if (sponza_streamer.Update(constant::streaming_budget_ms)) {
+			update_sponza_geometry_texture_data();
+			if (sponza_streamer.IsDone() && !sponza_streamer.HasFailed())
+				pack_sponza_materials();
+		}
+
 		camera_view_proj_transforms.view_projection = mCamera.GetWorldToClipMatrix();
 		camera_view_proj_transforms.view_projection_inverse = mCamera.GetClipToWorldMatrix();
 
@@ -411,7 +534,9 @@ edan35::Assignment2::run()
 			else
 			{
 				fillGBufferShaderLocations(fill_gbuffer_shader, fill_gbuffer_shader_locations);
+				fillGBufferShaderLocations(fill_gbuffer_arrays_shader, fill_gbuffer_arrays_shader_locations);
 				fillShadowmapShaderLocations(fill_shadowmap_shader, fill_shadowmap_shader_locations);
+				fillShadowmapShaderLocations(fill_shadowmap_arrays_shader, fill_shadowmap_arrays_shader_locations);
 				fillAccumulateLightsShaderLocations(accumulate_lights_shader, accumulate_light_shader_locations);
 			}
 		}
@@ -464,12 +589,30 @@ edan35::Assignment2::run()
 			glViewport(0, 0, framebuffer_width, framebuffer_height);
 			glClear(GL_DEPTH_BUFFER_BIT);
 			// XXX: Is any other clearing needed?
-
-			glUseProgram(fill_gbuffer_shader);
-			glUniform1i(fill_gbuffer_shader_locations.diffuse_texture, 0);
-			glUniform1i(fill_gbuffer_shader_locations.specular_texture, 1);
-			glUniform1i(fill_gbuffer_shader_locations.normals_texture, 2);
-			glUniform1i(fill_gbuffer_shader_locations.opacity_texture, 3);
+			glEnable(GL_FRAMEBUFFER_SRGB); // Encode the diffuse colours when writing them.
+
+			auto const use_packed_textures = are_sponza_materials_packed();
+			auto const& gbuffer_locations = use_packed_textures ? fill_gbuffer_arrays_shader_locations : fill_gbuffer_shader_locations;
+			if (use_packed_textures) {
+				// All textures are bound once, and each draw only selects
+				// its layers.
+				glUseProgram(fill_gbuffer_arrays_shader);
+				glUniform1i(gbuffer_locations.diffuse_textures, 0);
+				glUniform1i(gbuffer_locations.specular_textures, 1);
+				glUniform1i(gbuffer_locations.normals_textures, 2);
+				glUniform1i(gbuffer_locations.opacity_textures, 3);
+				bind_packed_textures();
+			} else {
+				glUseProgram(fill_gbuffer_shader);
+				glUniform1i(gbuffer_locations.diffuse_texture, 0);
+				glUniform1i(gbuffer_locations.specular_texture, 1);
+				glUniform1i(gbuffer_locations.normals_texture, 2);
+				glUniform1i(gbuffer_locations.opacity_texture, 3);
+			}
+			// Meshes sharing a page of the geometry arena share their VAO
+			// as well, so only bind it when it changes.
+			auto const camera_position = mCamera.mWorld.GetTranslation();
+			GLuint bound_vao = 0u;
 			for (std::size_t i = 0; i < sponza_geometry.size(); ++i)
 			{
 				auto const& geometry = sponza_geometry[i];
@@ -480,44 +623,52 @@ edan35::Assignment2::run()
 				auto const vertex_model_to_world = glm::mat4(1.0f);
 				auto const normal_model_to_world = glm::mat4(1.0f);
 
-				glUniformMatrix4fv(fill_gbuffer_shader_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
-				glUniformMatrix4fv(fill_gbuffer_shader_locations.normal_model_to_world, 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
+				glUniformMatrix4fv(gbuffer_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
+				glUniformMatrix4fv(gbuffer_locations.normal_model_to_world, 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
+				bonobo::setVertexDecodingUniforms(gbuffer_locations.vertex_decoding, geometry.decoding);
 
-				auto const default_sampler = samplers[toU(Sampler::Nearest)];
-				auto const mipmap_sampler = samplers[toU(Sampler::Mipmaps)];
+				if (use_packed_textures) {
+					glUniform1i(gbuffer_locations.material_index, static_cast<GLint>(i));
+				} else {
+					auto const default_sampler = samplers[toU(Sampler::Nearest)];
+					auto const mipmap_sampler = samplers[toU(Sampler::Mipmaps)];
 
-				glUniform1i(fill_gbuffer_shader_locations.has_diffuse_texture, texture_data.diffuse_texture_id != 0u ? 1 : 0);
-				glBindSampler(0u, texture_data.diffuse_texture_id != 0u ? mipmap_sampler : default_sampler);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, texture_data.diffuse_texture_id != 0u ? texture_data.diffuse_texture_id : debug_texture_id);
+					glUniform1i(fill_gbuffer_shader_locations.has_diffuse_texture, texture_data.diffuse_texture_id != 0u ? 1 : 0);
+					glBindSampler(0u, texture_data.diffuse_texture_id != 0u ? mipmap_sampler : default_sampler);
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D, texture_data.diffuse_texture_id != 0u ? texture_data.diffuse_texture_id : debug_texture_id);
 
-				glUniform1i(fill_gbuffer_shader_locations.has_specular_texture, texture_data.specular_texture_id != 0u ? 1 : 0);
-				glBindSampler(1u, texture_data.specular_texture_id != 0u ? mipmap_sampler : default_sampler);
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, texture_data.specular_texture_id != 0u ? texture_data.specular_texture_id : debug_texture_id);
+					glUniform1i(fill_gbuffer_shader_locations.has_specular_texture, texture_data.specular_texture_id != 0u ? 1 : 0);
+					glBindSampler(1u, texture_data.specular_texture_id != 0u ? mipmap_sampler : default_sampler);
+					glActiveTexture(GL_TEXTURE1);
+					glBindTexture(GL_TEXTURE_2D, texture_data.specular_texture_id != 0u ? texture_data.specular_texture_id : debug_texture_id);
 
-				glUniform1i(fill_gbuffer_shader_locations.has_normals_texture, texture_data.normals_texture_id != 0u ? 1 : 0);
-				glBindSampler(2u, texture_data.normals_texture_id != 0u ? mipmap_sampler : default_sampler);
-				glActiveTexture(GL_TEXTURE2);
-				glBindTexture(GL_TEXTURE_2D, texture_data.normals_texture_id != 0u ? texture_data.normals_texture_id : debug_texture_id);
+					glUniform1i(fill_gbuffer_shader_locations.has_normals_texture, texture_data.normals_texture_id != 0u ? 1 : 0);
+					glBindSampler(2u, texture_data.normals_texture_id != 0u ? mipmap_sampler : default_sampler);
+					glActiveTexture(GL_TEXTURE2);
+					glBindTexture(GL_TEXTURE_2D, texture_data.normals_texture_id != 0u ? texture_data.normals_texture_id : debug_texture_id);
 
-				glUniform1i(fill_gbuffer_shader_locations.has_opacity_texture, texture_data.opacity_texture_id != 0u ? 1 : 0);
-				glBindSampler(3u, texture_data.opacity_texture_id != 0u ? mipmap_sampler : default_sampler);
-				glActiveTexture(GL_TEXTURE3);
-				glBindTexture(GL_TEXTURE_2D, texture_data.opacity_texture_id != 0u ? texture_data.opacity_texture_id : debug_texture_id);
+					glUniform1i(fill_gbuffer_shader_locations.has_opacity_texture, texture_data.opacity_texture_id != 0u ? 1 : 0);
+					glBindSampler(3u, texture_data.opacity_texture_id != 0u ? mipmap_sampler : default_sampler);
+					glActiveTexture(GL_TEXTURE3);
+					glBindTexture(GL_TEXTURE_2D, texture_data.opacity_texture_id != 0u ? texture_data.opacity_texture_id : debug_texture_id);
+				}
 
-				glBindVertexArray(geometry.vao);
-				if (geometry.ibo != 0u)
-					glDrawElements(geometry.drawing_mode, geometry.indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-				else
-					glDrawArrays(geometry.drawing_mode, 0, geometry.vertices_nb);
+				if (geometry.vao != bound_vao) {
+					glBindVertexArray(geometry.vao);
+					bound_vao = geometry.vao;
+				}
+				bonobo::drawMesh(geometry, bonobo::selectLod(geometry, vertex_model_to_world, camera_position,
+				                                             static_cast<float>(framebuffer_height), mCamera.GetFov()));
 
 
 				utils::opengl::debug::endDebugGroup();
 			}
 			glBindTexture(GL_TEXTURE_2D, 0);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 			glBindVertexArray(0u);
 			glUseProgram(0u);
+			glDisable(GL_FRAMEBUFFER_SRGB);
 
 			glEndQuery(GL_TIME_ELAPSED);
 			utils::opengl::debug::endDebugGroup();
@@ -546,9 +697,22 @@ edan35::Assignment2::run()
 				glViewport(0, 0, constant::shadowmap_res_x, constant::shadowmap_res_y);
 				// XXX: Is any clearing needed?
 
-				glUseProgram(fill_shadowmap_shader);
-				glUniform1i(fill_shadowmap_shader_locations.light_index, static_cast<int>(i));
-				glUniform1i(fill_shadowmap_shader_locations.opacity_texture, 0);
+				auto const& shadowmap_locations = use_packed_textures ? fill_shadowmap_arrays_shader_locations : fill_shadowmap_shader_locations;
+				if (use_packed_textures) {
+					glUseProgram(fill_shadowmap_arrays_shader);
+					glUniform1i(shadowmap_locations.opacity_textures, 0);
+					// Opacity is the last of `material_slots`.
+					auto const& opacity_arrays = sponza_materials.arrays.back();
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D_ARRAY, opacity_arrays.empty() ? 0u : opacity_arrays.front().texture);
+					glBindSampler(0u, samplers[toU(Sampler::Mipmaps)]);
+				} else {
+					glUseProgram(fill_shadowmap_shader);
+					glUniform1i(shadowmap_locations.opacity_texture, 0);
+				}
+				glUniform1i(shadowmap_locations.light_index, static_cast<int>(i));
+				auto const light_position = glm::vec3(glm::inverse(light_view_matrix)[3]);
+				GLuint bound_vao = 0u;
 				for (std::size_t i = 0; i < sponza_geometry.size(); ++i)
 				{
 					auto const& geometry = sponza_geometry[i];
@@ -557,23 +721,30 @@ edan35::Assignment2::run()
 					utils::opengl::debug::beginDebugGroup(geometry.name);
 
 					auto const vertex_model_to_world = glm::mat4(1.0f);
-					glUniformMatrix4fv(fill_shadowmap_shader_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
-
-					glUniform1i(fill_shadowmap_shader_locations.has_opacity_texture, texture_data.opacity_texture_id != 0u ? 1 : 0);
-					glBindSampler(0u, texture_data.opacity_texture_id != 0u ? samplers[toU(Sampler::Mipmaps)] : samplers[toU(Sampler::Nearest)]);
-					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, texture_data.opacity_texture_id != 0u ? texture_data.opacity_texture_id : debug_texture_id);
-
-					glBindVertexArray(geometry.vao);
-					if (geometry.ibo != 0u)
-						glDrawElements(geometry.drawing_mode, geometry.indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-					else
-						glDrawArrays(geometry.drawing_mode, 0, geometry.vertices_nb);
+					glUniformMatrix4fv(shadowmap_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
+					bonobo::setVertexDecodingUniforms(shadowmap_locations.vertex_decoding, geometry.decoding);
+
+					if (use_packed_textures) {
+						glUniform1i(shadowmap_locations.material_index, static_cast<GLint>(i));
+					} else {
+						glUniform1i(shadowmap_locations.has_opacity_texture, texture_data.opacity_texture_id != 0u ? 1 : 0);
+						glBindSampler(0u, texture_data.opacity_texture_id != 0u ? samplers[toU(Sampler::Mipmaps)] : samplers[toU(Sampler::Nearest)]);
+						glActiveTexture(GL_TEXTURE0);
+						glBindTexture(GL_TEXTURE_2D, texture_data.opacity_texture_id != 0u ? texture_data.opacity_texture_id : debug_texture_id);
+					}
+
+					if (geometry.vao != bound_vao) {
+						glBindVertexArray(geometry.vao);
+						bound_vao = geometry.vao;
+					}
+					bonobo::drawMesh(geometry, bonobo::selectLod(geometry, vertex_model_to_world, light_position,
+					                                             static_cast<float>(constant::shadowmap_res_y), light_fov));
 
 
 					utils::opengl::debug::endDebugGroup();
 				}
 				glBindTexture(GL_TEXTURE_2D, 0);
+				glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 				glBindVertexArray(0u);
 				glUseProgram(0u);
 
@@ -831,6 +1002,7 @@ edan35::Assignment2::run()
 		first_frame = false;
 	}
 
+	bonobo::material_packer::release(sponza_materials);
 	glDeleteBuffers(static_cast<GLsizei>(ubos.size()), ubos.data());
 	glDeleteQueries(static_cast<GLsizei>(elapsed_time_queries.size()), elapsed_time_queries.data());
 	glDeleteSamplers(static_cast<GLsizei>(samplers.size()), samplers.data());
@@ -841,8 +1013,12 @@ edan35::Assignment2::run()
 	resolve_deferred_shader = 0u;
 	glDeleteProgram(accumulate_lights_shader);
 	accumulate_lights_shader = 0u;
+	glDeleteProgram(fill_shadowmap_arrays_shader);
+	fill_shadowmap_arrays_shader = 0u;
 	glDeleteProgram(fill_shadowmap_shader);
 	fill_shadowmap_shader = 0u;
+	glDeleteProgram(fill_gbuffer_arrays_shader);
+	fill_gbuffer_arrays_shader = 0u;
 	glDeleteProgram(fill_gbuffer_shader);
 	fill_gbuffer_shader = 0u;
 	glDeleteProgram(fallback_shader);
@@ -878,8 +1054,10 @@ Textures createTextures(GLsizei framebuffer_width, GLsizei framebuffer_height)
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, constant::shadowmap_res_x, constant::shadowmap_res_y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::ShadowMap)], "Shadow map");
 
+	// Diffuse colours are sampled in linear space: store them sRGB-encoded
+	// to keep the precision of the darker ones.
 	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferDiffuse)]);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::GBufferDiffuse)], "GBuffer diffuse");
 
 	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferSpecular)]);
@@ -1051,6 +1229,11 @@ UBOs createUniformBufferObjects()
 	glBindBufferBase(GL_UNIFORM_BUFFER, toU(UBO::LightViewProjTransforms), ubos[toU(UBO::LightViewProjTransforms)]);
 	utils::opengl::debug::nameObject(GL_BUFFER, ubos[toU(UBO::LightViewProjTransforms)], "Light view-projection transforms");
 
+	glBindBuffer(GL_UNIFORM_BUFFER, ubos[toU(UBO::MaterialLayers)]);
+	glBufferData(GL_UNIFORM_BUFFER, constant::max_packed_materials_nb * sizeof(glm::ivec4), nullptr, GL_STATIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, toU(UBO::MaterialLayers), ubos[toU(UBO::MaterialLayers)]);
+	utils::opengl::debug::nameObject(GL_BUFFER, ubos[toU(UBO::MaterialLayers)], "Material layers");
+
 	glBindBuffer(GL_UNIFORM_BUFFER, 0u);
 	return ubos;
 }
@@ -1068,8 +1251,17 @@ void fillGBufferShaderLocations(GLuint gbuffer_shader, GBufferShaderLocations& l
 	locations.has_specular_texture = glGetUniformLocation(gbuffer_shader, "has_specular_texture");
 	locations.has_normals_texture = glGetUniformLocation(gbuffer_shader, "has_normals_texture");
 	locations.has_opacity_texture = glGetUniformLocation(gbuffer_shader, "has_opacity_texture");
+	locations.vertex_decoding = bonobo::getVertexDecodingLocations(gbuffer_shader);
+	locations.ubo_MaterialLayers = glGetUniformBlockIndex(gbuffer_shader, "MaterialLayers");
+	locations.material_index = glGetUniformLocation(gbuffer_shader, "material_index");
+	locations.diffuse_textures = glGetUniformLocation(gbuffer_shader, "diffuse_textures");
+	locations.specular_textures = glGetUniformLocation(gbuffer_shader, "specular_textures");
+	locations.normals_textures = glGetUniformLocation(gbuffer_shader, "normals_textures");
+	locations.opacity_textures = glGetUniformLocation(gbuffer_shader, "opacity_textures");
 
 	glUniformBlockBinding(gbuffer_shader, locations.ubo_CameraViewProjTransforms, toU(UBO::CameraViewProjTransforms));
+	if (locations.ubo_MaterialLayers != GL_INVALID_INDEX)
+		glUniformBlockBinding(gbuffer_shader, locations.ubo_MaterialLayers, toU(UBO::MaterialLayers));
 
 }
 
@@ -1080,8 +1272,14 @@ void fillShadowmapShaderLocations(GLuint shadowmap_shader, FillShadowmapShaderLo
 	locations.vertex_model_to_world = glGetUniformLocation(shadowmap_shader, "vertex_model_to_world");
 	locations.opacity_texture = glGetUniformLocation(shadowmap_shader, "opacity_texture");
 	locations.has_opacity_texture = glGetUniformLocation(shadowmap_shader, "has_opacity_texture");
+	locations.vertex_decoding = bonobo::getVertexDecodingLocations(shadowmap_shader);
+	locations.ubo_MaterialLayers = glGetUniformBlockIndex(shadowmap_shader, "MaterialLayers");
+	locations.material_index = glGetUniformLocation(shadowmap_shader, "material_index");
+	locations.opacity_textures = glGetUniformLocation(shadowmap_shader, "opacity_textures");
 
 	glUniformBlockBinding(shadowmap_shader, locations.ubo_LightViewProjTransforms, toU(UBO::LightViewProjTransforms));
+	if (locations.ubo_MaterialLayers != GL_INVALID_INDEX)
+		glUniformBlockBinding(shadowmap_shader, locations.ubo_MaterialLayers, toU(UBO::MaterialLayers));
 }
 
 void fillAccumulateLightsShaderLocations(GLuint accumulate_lights_shader, AccumulateLightsShaderLocations& locations)
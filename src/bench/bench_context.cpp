@@ -0,0 +1,43 @@
+#include "bench_context.hpp"
+
+#include "config.hpp"
+#include "core/helpers.hpp"
+
+#include <stdexcept>
+
+BenchContext::BenchContext(WindowManager& window_manager, std::string const& title) :
+	mInputHandler(),
+	mCamera(0.5f * glm::half_pi<float>(),
+	        static_cast<float>(config::resolution_x) / static_cast<float>(config::resolution_y),
+	        1.0f, 10000.0f),
+	mWindowManager(window_manager), mWindow(nullptr)
+{
+	WindowManager::WindowDatum window_datum{ mInputHandler, mCamera, config::resolution_x, config::resolution_y, 0, 0, 0, 0};
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	mWindow = mWindowManager.CreateGLFWWindow(title, window_datum, 1u, false, false, WindowManager::SwapStrategy::disable_vsync);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	if (mWindow == nullptr) {
+		throw std::runtime_error("Failed to get a window: aborting!");
+	}
+
+	bonobo::init();
+}
+
+BenchContext::~BenchContext()
+{
+	bonobo::deinit();
+	mWindowManager.DestroyWindow(mWindow);
+}
+
+GLFWwindow*
+BenchContext::GetWindow() const
+{
+	return mWindow;
+}
+
+FPSCameraf&
+BenchContext::GetCamera()
+{
+	return mCamera;
+}
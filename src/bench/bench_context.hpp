@@ -0,0 +1,29 @@
+#pragma once
+
+#include "core/FPSCamera.h"
+#include "core/InputHandler.h"
+#include "core/WindowManager.hpp"
+
+#include <string>
+
+//! \brief Hidden window providing an OpenGL context to the benchmarks.
+//!
+//! The framebuffer of the window is never presented, so benchmarks should
+//! render into their own framebuffer objects.
+class BenchContext
+{
+public:
+	BenchContext(WindowManager& window_manager, std::string const& title);
+	~BenchContext();
+	BenchContext(BenchContext const&) = delete;
+	BenchContext& operator=(BenchContext const&) = delete;
+
+	GLFWwindow* GetWindow() const;
+	FPSCameraf& GetCamera();
+
+private:
+	InputHandler mInputHandler;
+	FPSCameraf mCamera;
+	WindowManager& mWindowManager;
+	GLFWwindow* mWindow;
+};
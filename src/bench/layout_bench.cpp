@@ -0,0 +1,183 @@
+// Compares the GPU cost of drawing Sponza with each vertex layout, once
+// with a program reading all attributes (like the G-buffer pass of
+// EDAN35) and once with a program reading positions only (like its
+// shadow map passes). Each layout is measured with every mesh owning its
+// VAO, and with the meshes suballocated from the geometry arena.
+
+#include "bench_context.hpp"
+
+#include "config.hpp"
+#include "core/Bonobo.h"
+#include "core/helpers.hpp"
+#include "core/mesh_upload.hpp"
+#include "core/opengl.hpp"
+#include "core/ShaderProgramManager.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <array>
+#include <clocale>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	namespace constant
+	{
+		constexpr GLsizei framebuffer_width = 1920;
+		constexpr GLsizei framebuffer_height = 1080;
+		constexpr unsigned int warmup_frames_nb = 10u;
+		constexpr unsigned int measured_frames_nb = 200u;
+	}
+
+	struct layout_entry {
+		bonobo::vertex_layout_t layout;
+		char const* name;
+	};
+
+	struct pass_entry {
+		GLuint const* program;
+		char const* name;
+	};
+
+	void destroyMeshes(std::vector<bonobo::mesh_data>& meshes)
+	{
+		for (auto& mesh : meshes) {
+			for (auto const& binding : mesh.bindings)
+				bonobo::releaseTexture(binding.second);
+			bonobo::releaseMesh(mesh);
+		}
+		meshes.clear();
+	}
+
+	// Returns the average GPU time, in milliseconds, for drawing all
+	// meshes with the given program.
+	float timePass(std::vector<bonobo::mesh_data> const& meshes, GLuint program,
+	               glm::mat4 const& world_to_clip, GLuint query)
+	{
+		glUseProgram(program);
+		glUniformMatrix4fv(glGetUniformLocation(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+		glUniformMatrix4fv(glGetUniformLocation(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(world_to_clip));
+		auto const vertex_decoding_locations = bonobo::getVertexDecodingLocations(program);
+
+		GLuint64 total_elapsed_time = 0u;
+		for (unsigned int frame = 0u; frame < constant::warmup_frames_nb + constant::measured_frames_nb; ++frame) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			GLuint bound_vao = 0u;
+			for (auto const& mesh : meshes) {
+				if (mesh.vao != bound_vao) {
+					glBindVertexArray(mesh.vao);
+					bound_vao = mesh.vao;
+				}
+				bonobo::setVertexDecodingUniforms(vertex_decoding_locations, mesh.decoding);
+				bonobo::drawMesh(mesh);
+			}
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 elapsed_time = 0u;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+			if (frame >= constant::warmup_frames_nb)
+				total_elapsed_time += elapsed_time;
+		}
+		glBindVertexArray(0u);
+		glUseProgram(0u);
+
+		return static_cast<float>(total_elapsed_time) / (1000000.0f * static_cast<float>(constant::measured_frames_nb));
+	}
+}
+
+int main()
+{
+	std::setlocale(LC_ALL, "");
+
+	Bonobo framework;
+
+	try {
+		BenchContext context(framework.GetWindowManager(), "CG_Labs: vertex layout benchmark");
+
+		ShaderProgramManager program_manager;
+		GLuint all_attributes_shader = 0u;
+		program_manager.CreateAndRegisterProgram("All attributes",
+		                                         { { ShaderType::vertex, "bench/all_attributes.vert" },
+		                                           { ShaderType::fragment, "bench/all_attributes.frag" } },
+		                                         all_attributes_shader);
+		GLuint positions_only_shader = 0u;
+		program_manager.CreateAndRegisterProgram("Positions only",
+		                                         { { ShaderType::vertex, "common/fallback.vert" },
+		                                           { ShaderType::fragment, "common/fallback.frag" } },
+		                                         positions_only_shader);
+		if (all_attributes_shader == 0u || positions_only_shader == 0u) {
+			LogError("Failed to load the benchmark shaders");
+			return 1;
+		}
+
+		GLuint color_texture = bonobo::createTexture(constant::framebuffer_width, constant::framebuffer_height);
+		GLuint depth_texture = bonobo::createTexture(constant::framebuffer_width, constant::framebuffer_height, GL_TEXTURE_2D, GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT);
+		GLuint const framebuffer = bonobo::createFBO({ color_texture }, depth_texture);
+		GLuint query = 0u;
+		glGenQueries(1, &query);
+
+		// Look down the length of the atrium, which keeps most of the
+		// scene in view.
+		auto& camera = context.GetCamera();
+		camera.mWorld.SetTranslate(glm::vec3(-1200.0f, 300.0f, -40.0f));
+		camera.mWorld.LookAt(glm::vec3(1200.0f, 300.0f, -40.0f));
+		camera.SetAspect(static_cast<float>(constant::framebuffer_width) / static_cast<float>(constant::framebuffer_height));
+		auto const world_to_clip = camera.GetWorldToClipMatrix();
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, constant::framebuffer_width, constant::framebuffer_height);
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_BACK);
+
+		std::array<layout_entry, 4> const layouts = {
+			layout_entry{ bonobo::vertex_layout_t::planar, "planar" },
+			layout_entry{ bonobo::vertex_layout_t::interleaved, "interleaved" },
+			layout_entry{ bonobo::vertex_layout_t::packed, "packed" },
+			layout_entry{ bonobo::vertex_layout_t::packed_quantized, "quantised" }
+		};
+		std::array<pass_entry, 2> const passes = {
+			pass_entry{ &all_attributes_shader, "all attributes" },
+			pass_entry{ &positions_only_shader, "positions only" }
+		};
+
+		for (auto const& layout : layouts) {
+			// Sponza's meshes have all five attributes.
+			LogInfo("%-12s layout: %zu bytes per vertex", layout.name, bonobo::getVertexSize(layout.layout, 0x1fu));
+			for (auto const use_geometry_arena : { false, true }) {
+				bonobo::object_load_options options;
+				options.mesh_upload.vertex_layout = layout.layout;
+				options.mesh_upload.use_geometry_arena = use_geometry_arena;
+				auto meshes = bonobo::loadObjects(config::resources_path("sponza/sponza.obj"), options);
+				if (meshes.empty()) {
+					LogError("Failed to load the Sponza model");
+					return 1;
+				}
+
+				for (auto const& pass : passes) {
+					auto const pass_time = timePass(meshes, *pass.program, world_to_clip, query);
+					LogInfo("%-12s layout, %-14s %-15s pass: %.3f ms per frame (averaged over %u frames)",
+					        layout.name, use_geometry_arena ? "shared VAOs," : "one VAO each,",
+					        pass.name, pass_time, constant::measured_frames_nb);
+				}
+
+				destroyMeshes(meshes);
+			}
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0u);
+		glDeleteQueries(1, &query);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteTextures(1, &depth_texture);
+		glDeleteTextures(1, &color_texture);
+	} catch (std::runtime_error const& e) {
+		LogError(e.what());
+		return 1;
+	}
+
+	return 0;
+}
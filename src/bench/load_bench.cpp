@@ -0,0 +1,405 @@
+// Loads a list of scenes and textures several times, the way the
+// assignments do, and reports where the time went (scene import, image
+// decoding, mip generation, block compression and OpenGL uploads) along
+// with the peak resident set size of the process, as JSON.
+//
+// Usage: CG_Labs_LoadBench [--runs N] [--no-caches] [--texture-roles] [--compress] [--output FILE] [ASSET...]
+//
+// Each asset is, relative to the resources folder, either an image, a
+// folder holding the six faces of a cube map (named posx.jpg, negx.jpg…
+// or right.png, left.png…), or a scene file; a default set is loaded
+// when none is given. Everything gets released at the end of each run,
+// so that the texture registry does not turn later runs into lookups;
+// the object and texture caches on disk are kept, unless --no-caches is
+// given, so the first run is the one to look at for cold loads. With
+// --texture-roles, the textures of scenes only keep the channels their
+// material slot needs; with --compress, all textures get block-compressed
+// and the quality of each one gets reported. Compare the reported texture
+// sizes.
+
+#include "bench_context.hpp"
+
+#include "config.hpp"
+#include "core/Bonobo.h"
+#include "core/helpers.hpp"
+#include "core/opengl.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/various.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <clocale>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	namespace constant
+	{
+		constexpr unsigned int default_runs_nb = 5u;
+		constexpr char const* default_output = "load_bench.json";
+	}
+
+	enum class asset_kind_t : unsigned int {
+		scene = 0u,
+		texture,
+		cube_map
+	};
+
+	struct asset {
+		std::string name;
+		asset_kind_t kind{ asset_kind_t::scene };
+		std::vector<std::string> paths; //!< one per cube map face, a single one otherwise
+	};
+
+	struct run_result {
+		float wall_time_ms{ 0.0f };
+		bonobo::load_statistics statistics;
+	};
+
+	struct loaded_assets {
+		std::vector<bonobo::mesh_data> meshes;
+		std::vector<GLuint> textures;
+	};
+
+	char const* getKindName(asset_kind_t kind)
+	{
+		switch (kind) {
+		case asset_kind_t::scene:    return "scene";
+		case asset_kind_t::texture:  return "texture";
+		case asset_kind_t::cube_map: return "cube map";
+		}
+		return "unknown";
+	}
+
+	bool isFile(std::string const& path)
+	{
+		return static_cast<bool>(std::ifstream(utils::widen(path)));
+	}
+
+	bool hasImageExtension(std::string const& path)
+	{
+		auto const dot = path.rfind('.');
+		if (dot == std::string::npos)
+			return false;
+		auto extension = path.substr(dot + 1u);
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+		               [](char c){ return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+		for (auto const candidate : { "jpg", "jpeg", "png", "tga", "bmp", "hdr", "psd", "gif" })
+			if (extension == candidate)
+				return true;
+		return false;
+	}
+
+	// Looks for the six faces of a cube map in `folder`, in the order
+	// expected by `bonobo::loadTextureCubeMap()`.
+	bool findCubeMapFaces(std::string const& folder, std::vector<std::string>& faces)
+	{
+		static char const* const face_names[2][6] = {
+			{ "posx", "negx", "posy", "negy", "posz", "negz" },
+			{ "right", "left", "top", "bottom", "front", "back" }
+		};
+		for (auto const& names : face_names)
+			for (auto const extension : { ".jpg", ".png" }) {
+				faces.clear();
+				for (auto const name : names) {
+					auto const path = config::resources_path(folder + "/" + name + extension);
+					if (!isFile(path))
+						break;
+					faces.push_back(path);
+				}
+				if (faces.size() == 6u)
+					return true;
+			}
+		faces.clear();
+		return false;
+	}
+
+	asset makeAsset(std::string const& name)
+	{
+		asset entry;
+		entry.name = name;
+		if (hasImageExtension(name)) {
+			entry.kind = asset_kind_t::texture;
+			entry.paths.push_back(config::resources_path(name));
+		} else if (findCubeMapFaces(name, entry.paths)) {
+			entry.kind = asset_kind_t::cube_map;
+		} else {
+			entry.kind = asset_kind_t::scene;
+			entry.paths.push_back(config::resources_path(name));
+		}
+		return entry;
+	}
+
+	std::vector<std::string> getDefaultAssetNames()
+	{
+		return {
+			"sponza/sponza.obj",
+			"spaceship/scene.gltf",
+			"cubemaps/NissiBeach2",
+			"cubemaps/Space",
+			"planets/2k_sun.jpg",
+			"planets/2k_mercury.jpg",
+			"planets/2k_venus_atmosphere.jpg",
+			"planets/2k_earth_daymap.jpg",
+			"planets/2k_moon.jpg",
+			"planets/2k_mars.jpg",
+			"planets/2k_jupiter.jpg",
+			"planets/2k_saturn.jpg",
+			"planets/2k_saturn_ring_alpha.png",
+			"planets/2k_uranus.jpg",
+			"planets/2k_neptune.jpg"
+		};
+	}
+
+	// Loads an asset and waits for the GPU to be done with its uploads.
+	run_result loadAsset(asset const& entry, bool use_caches, bool use_texture_roles, bool compress_textures,
+	                     loaded_assets& loaded)
+	{
+		run_result result;
+
+		glFinish();
+		auto const start_time = std::chrono::high_resolution_clock::now();
+
+		switch (entry.kind) {
+		case asset_kind_t::scene:
+		{
+			bonobo::object_load_options options;
+			options.use_object_cache = use_caches;
+			options.use_texture_cache = use_caches;
+			options.use_texture_roles = use_texture_roles;
+			options.compress_textures = compress_textures;
+			auto meshes = bonobo::loadObjects(entry.paths.front(), options, &result.statistics);
+			loaded.meshes.insert(loaded.meshes.end(), meshes.begin(), meshes.end());
+			break;
+		}
+		case asset_kind_t::texture:
+		{
+			bonobo::texture_load_options options;
+			options.use_texture_cache = use_caches;
+			options.compress = compress_textures;
+			loaded.textures.push_back(bonobo::loadTexture2D(entry.paths.front(), options, &result.statistics));
+			break;
+		}
+		case asset_kind_t::cube_map:
+		{
+			bonobo::texture_load_options options;
+			options.use_texture_cache = use_caches;
+			options.compress = compress_textures;
+			loaded.textures.push_back(bonobo::loadTextureCubeMap(entry.paths[0], entry.paths[1],
+			                                                     entry.paths[2], entry.paths[3],
+			                                                     entry.paths[4], entry.paths[5],
+			                                                     options, &result.statistics));
+			break;
+		}
+		}
+
+		glFinish();
+		auto const end_time = std::chrono::high_resolution_clock::now();
+		result.wall_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
+
+		return result;
+	}
+
+	void releaseAssets(loaded_assets& loaded)
+	{
+		for (auto& mesh : loaded.meshes) {
+			for (auto const& binding : mesh.bindings)
+				bonobo::releaseTexture(binding.second);
+			bonobo::releaseMesh(mesh);
+		}
+		for (auto const texture : loaded.textures)
+			bonobo::releaseTexture(texture);
+		loaded = loaded_assets();
+	}
+
+	std::uint64_t getPeakResidentSetSize()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0u;
+		return static_cast<std::uint64_t>(counters.PeakWorkingSetSize);
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0u;
+#if defined(__APPLE__)
+		return static_cast<std::uint64_t>(usage.ru_maxrss); // in bytes
+#else
+		return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024u; // in kilobytes
+#endif
+#endif
+	}
+
+	float getMedian(std::vector<float> values)
+	{
+		if (values.empty())
+			return 0.0f;
+		std::sort(values.begin(), values.end());
+		auto const middle = values.size() / 2u;
+		return values.size() % 2u == 1u ? values[middle] : 0.5f * (values[middle - 1u] + values[middle]);
+	}
+
+	std::string escapeJson(std::string const& text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+		for (auto const c : text) {
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	void writeRun(std::FILE* output, run_result const& run, bool is_last)
+	{
+		auto const& statistics = run.statistics;
+		std::fprintf(output,
+		             "        { \"wall_time_ms\": %.3f, \"import_time_ms\": %.3f, \"decode_time_ms\": %.3f, "
+		             "\"mip_generation_time_ms\": %.3f, \"compression_time_ms\": %.3f, \"upload_time_ms\": %.3f, "
+		             "\"scenes_from_cache_nb\": %zu, \"images_nb\": %zu, \"images_from_cache_nb\": %zu, \"meshes_nb\": %zu, "
+		             "\"textures_size\": %llu }%s\n",
+		             run.wall_time_ms, statistics.import_time_ms, statistics.decode_time_ms,
+		             statistics.mip_generation_time_ms, statistics.compression_time_ms, statistics.upload_time_ms,
+		             statistics.scenes_from_cache_nb, statistics.images_nb, statistics.images_from_cache_nb, statistics.meshes_nb,
+		             static_cast<unsigned long long>(statistics.textures_size),
+		             is_last ? "" : ",");
+	}
+
+	// Images decode the same way on every run, so only those of the
+	// first one get written; identical images have no finite PSNR.
+	void writeCompressedImages(std::FILE* output, std::vector<bonobo::load_statistics::compressed_image> const& images)
+	{
+		for (std::size_t i = 0u; i < images.size(); ++i) {
+			char psnr[32] = "null";
+			if (std::isfinite(images[i].psnr_db))
+				std::snprintf(psnr, sizeof(psnr), "%.3f", images[i].psnr_db);
+			std::fprintf(output, "        { \"filename\": \"%s\", \"format\": \"%s\", \"psnr_db\": %s }%s\n",
+			             escapeJson(images[i].filename).c_str(), bonobo::getBlockFormatName(images[i].format), psnr,
+			             i + 1u == images.size() ? "" : ",");
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::setlocale(LC_ALL, "");
+	// JSON requires a dot as decimal separator, whatever the user's
+	// locale says.
+	std::setlocale(LC_NUMERIC, "C");
+
+	unsigned int runs_nb = constant::default_runs_nb;
+	bool use_caches = true;
+	bool use_texture_roles = false;
+	bool compress_textures = false;
+	std::string output_path = constant::default_output;
+	std::vector<std::string> asset_names;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+			runs_nb = static_cast<unsigned int>(std::max(std::atoi(argv[++i]), 1));
+		} else if (std::strcmp(argv[i], "--no-caches") == 0) {
+			use_caches = false;
+		} else if (std::strcmp(argv[i], "--texture-roles") == 0) {
+			use_texture_roles = true;
+		} else if (std::strcmp(argv[i], "--compress") == 0) {
+			compress_textures = true;
+		} else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+			output_path = argv[++i];
+		} else if (argv[i][0] == '-') {
+			std::fprintf(stderr, "Usage: %s [--runs N] [--no-caches] [--texture-roles] [--compress] [--output FILE] [ASSET...]\n", argv[0]);
+			return 1;
+		} else {
+			asset_names.emplace_back(argv[i]);
+		}
+	}
+	if (asset_names.empty())
+		asset_names = getDefaultAssetNames();
+
+	Bonobo framework;
+
+	try {
+		BenchContext context(framework.GetWindowManager(), "CG_Labs: asset loading benchmark");
+
+		std::vector<asset> assets;
+		assets.reserve(asset_names.size());
+		for (auto const& name : asset_names)
+			assets.push_back(makeAsset(name));
+
+		// results[a][r] is the outcome of loading asset `a` during run `r`.
+		std::vector<std::vector<run_result>> results(assets.size());
+		std::vector<float> runs_wall_time_ms(runs_nb, 0.0f);
+		for (unsigned int run = 0u; run < runs_nb; ++run) {
+			loaded_assets loaded;
+			for (std::size_t a = 0u; a < assets.size(); ++a) {
+				results[a].push_back(loadAsset(assets[a], use_caches, use_texture_roles, compress_textures, loaded));
+				runs_wall_time_ms[run] += results[a].back().wall_time_ms;
+			}
+			releaseAssets(loaded);
+			LogInfo("Run %u of %u: %.3f ms", run + 1u, runs_nb, runs_wall_time_ms[run]);
+		}
+		auto const peak_rss = getPeakResidentSetSize();
+
+		std::FILE* output = std::fopen(output_path.c_str(), "w");
+		if (output == nullptr) {
+			LogError("Failed to open \"%s\" for writing the results", output_path.c_str());
+			return 1;
+		}
+		std::fprintf(output, "{\n");
+		std::fprintf(output, "  \"runs_nb\": %u,\n", runs_nb);
+		std::fprintf(output, "  \"use_caches\": %s,\n", use_caches ? "true" : "false");
+		std::fprintf(output, "  \"use_texture_roles\": %s,\n", use_texture_roles ? "true" : "false");
+		std::fprintf(output, "  \"compress_textures\": %s,\n", compress_textures ? "true" : "false");
+		std::fprintf(output, "  \"worker_threads_nb\": %zu,\n", ThreadPool::GetShared().GetThreadCount());
+		std::fprintf(output, "  \"peak_rss_bytes\": %llu,\n", static_cast<unsigned long long>(peak_rss));
+		std::fprintf(output, "  \"median_wall_time_ms\": %.3f,\n", getMedian(runs_wall_time_ms));
+		std::fprintf(output, "  \"assets\": [\n");
+		for (std::size_t a = 0u; a < assets.size(); ++a) {
+			std::vector<float> wall_times_ms;
+			for (auto const& run : results[a])
+				wall_times_ms.push_back(run.wall_time_ms);
+
+			std::fprintf(output, "    {\n");
+			std::fprintf(output, "      \"name\": \"%s\",\n", escapeJson(assets[a].name).c_str());
+			std::fprintf(output, "      \"kind\": \"%s\",\n", getKindName(assets[a].kind));
+			std::fprintf(output, "      \"median_wall_time_ms\": %.3f,\n", getMedian(wall_times_ms));
+			if (compress_textures && !results[a].empty()) {
+				std::fprintf(output, "      \"compressed_images\": [\n");
+				writeCompressedImages(output, results[a].front().statistics.compressed_images);
+				std::fprintf(output, "      ],\n");
+			}
+			std::fprintf(output, "      \"runs\": [\n");
+			for (std::size_t r = 0u; r < results[a].size(); ++r)
+				writeRun(output, results[a][r], r + 1u == results[a].size());
+			std::fprintf(output, "      ]\n");
+			std::fprintf(output, "    }%s\n", a + 1u == assets.size() ? "" : ",");
+		}
+		std::fprintf(output, "  ]\n");
+		std::fprintf(output, "}\n");
+		std::fclose(output);
+
+		LogInfo("Median run: %.3f ms; peak resident set size: %.1f MiB; results written to \"%s\"",
+		        getMedian(runs_wall_time_ms), static_cast<double>(peak_rss) / (1024.0 * 1024.0), output_path.c_str());
+	} catch (std::runtime_error const& e) {
+		LogError(e.what());
+		return 1;
+	}
+
+	return 0;
+}
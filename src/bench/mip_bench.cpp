@@ -0,0 +1,180 @@
+// Compares generating the mip chain of a texture on the CPU, with the
+// different filters and code paths of the mip generator, and uploading
+// all its levels, with uploading only the first level and having the
+// driver generate the others; timings include waiting for the GPU.
+
+#include "bench_context.hpp"
+
+#include "core/Bonobo.h"
+#include "core/helpers.hpp"
+#include "core/mip_generator.hpp"
+#include "core/opengl.hpp"
+#include "core/texture_cache.hpp"
+#include "core/texture_upload.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/UploadManager.hpp"
+
+#include <array>
+#include <chrono>
+#include <clocale>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	namespace constant
+	{
+		constexpr unsigned int warmup_runs_nb = 1u;
+		constexpr unsigned int measured_runs_nb = 5u;
+	}
+
+	struct cpu_variant {
+		char const* name;
+		bonobo::mip_settings mips;
+		bonobo::mip_generator::execution_policy policy;
+	};
+
+	struct cpu_timings {
+		float generation_ms{ 0.0f };
+		float total_ms{ 0.0f };
+	};
+
+	cpu_variant makeVariant(char const* name, bonobo::mip_filter_t filter, bool is_srgb, bool use_simd, bool use_thread_pool)
+	{
+		cpu_variant variant;
+		variant.name = name;
+		variant.mips.filter = filter;
+		variant.mips.is_srgb = is_srgb;
+		variant.policy.use_simd = use_simd;
+		variant.policy.use_thread_pool = use_thread_pool;
+		return variant;
+	}
+
+	// Smooth gradients with some noise on top, so that the filters have
+	// something to work with and nothing can take shortcuts.
+	std::vector<std::uint8_t> makeImage(std::uint32_t side, std::uint32_t channels_nb)
+	{
+		std::vector<std::uint8_t> texels(static_cast<std::size_t>(side) * side * channels_nb);
+		for (std::uint32_t y = 0u; y < side; ++y)
+			for (std::uint32_t x = 0u; x < side; ++x)
+				for (std::uint32_t c = 0u; c < channels_nb; ++c) {
+					auto const i = (static_cast<std::size_t>(y) * side + x) * channels_nb + c;
+					auto const noise = static_cast<std::uint32_t>(i * 2654435761u >> 28);
+					texels[i] = static_cast<std::uint8_t>(((x + y * (c + 1u)) * 255u / (2u * side) + noise) & 0xffu);
+				}
+		return texels;
+	}
+
+	// Returns the average time, in milliseconds, of uploading the first
+	// level and having the driver generate the others.
+	float timeDriverPath(std::vector<std::uint8_t> const& texels, std::uint32_t side, std::uint32_t channels_nb)
+	{
+		auto const format = channels_nb == 1u ? GL_RED : GL_RGBA;
+		auto const internal_format = channels_nb == 1u ? GL_R8 : GL_RGBA;
+		auto& upload_manager = UploadManager::GetShared();
+
+		float total_ms = 0.0f;
+		for (unsigned int run = 0u; run < constant::warmup_runs_nb + constant::measured_runs_nb; ++run) {
+			glFinish();
+			auto const start_time = std::chrono::high_resolution_clock::now();
+
+			GLuint texture = 0u;
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			upload_manager.UploadTexImage2D(GL_TEXTURE_2D, 0, internal_format,
+			                                static_cast<GLsizei>(side), static_cast<GLsizei>(side),
+			                                format, GL_UNSIGNED_BYTE, texels.data());
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glFinish();
+
+			auto const end_time = std::chrono::high_resolution_clock::now();
+			glBindTexture(GL_TEXTURE_2D, 0u);
+			glDeleteTextures(1, &texture);
+
+			if (run >= constant::warmup_runs_nb)
+				total_ms += std::chrono::duration<float, std::milli>(end_time - start_time).count();
+		}
+
+		return total_ms / constant::measured_runs_nb;
+	}
+
+	// Returns the average times, in milliseconds, of generating the mip
+	// chain on the CPU, and of generating and uploading it.
+	cpu_timings timeCpuPath(std::vector<std::uint8_t> const& texels, std::uint32_t side, std::uint32_t channels_nb,
+	                        cpu_variant const& variant)
+	{
+		cpu_timings timings;
+		for (unsigned int run = 0u; run < constant::warmup_runs_nb + constant::measured_runs_nb; ++run) {
+			glFinish();
+			auto const start_time = std::chrono::high_resolution_clock::now();
+
+			bonobo::mipmapped_image image;
+			image.channels_nb = channels_nb;
+			image.levels.push_back({ side, side, texels.data() });
+			bonobo::texture_cache::generateMipChain(image, variant.mips, variant.policy);
+			auto const generation_end_time = std::chrono::high_resolution_clock::now();
+
+			auto const texture = bonobo::uploadTexture2D(image, true);
+			glFinish();
+			auto const end_time = std::chrono::high_resolution_clock::now();
+			glDeleteTextures(1, &texture);
+
+			if (run >= constant::warmup_runs_nb) {
+				timings.generation_ms += std::chrono::duration<float, std::milli>(generation_end_time - start_time).count();
+				timings.total_ms += std::chrono::duration<float, std::milli>(end_time - start_time).count();
+			}
+		}
+
+		timings.generation_ms /= constant::measured_runs_nb;
+		timings.total_ms /= constant::measured_runs_nb;
+		return timings;
+	}
+}
+
+int main()
+{
+	std::setlocale(LC_ALL, "");
+
+	Bonobo framework;
+
+	try {
+		BenchContext context(framework.GetWindowManager(), "CG_Labs: mip generation benchmark");
+
+		LogInfo("Mip generator %s SIMD code paths; thread pool of %zu workers",
+		        bonobo::mip_generator::hasSimd() ? "with" : "without", ThreadPool::GetShared().GetThreadCount());
+
+		using bonobo::mip_filter_t;
+		std::array<cpu_variant, 7> const variants = {
+			makeVariant("box, scalar, 1 thread",         mip_filter_t::box,    false, false, false),
+			makeVariant("box, SIMD, 1 thread",           mip_filter_t::box,    false, true,  false),
+			makeVariant("box, SIMD, pool",               mip_filter_t::box,    false, true,  true),
+			makeVariant("box sRGB, SIMD, pool",          mip_filter_t::box,    true,  true,  true),
+			makeVariant("Kaiser, scalar, 1 thread",      mip_filter_t::kaiser, false, false, false),
+			makeVariant("Kaiser, SIMD, pool",            mip_filter_t::kaiser, false, true,  true),
+			makeVariant("Kaiser sRGB, SIMD, pool",       mip_filter_t::kaiser, true,  true,  true)
+		};
+
+		std::array<std::uint32_t, 4> const sides = { 512u, 1024u, 2048u, 4096u };
+		std::array<std::uint32_t, 2> const channel_counts = { 4u, 1u };
+		for (auto const channels_nb : channel_counts) {
+			char const* const format_name = channels_nb == 1u ? "R8   " : "RGBA8";
+			for (auto const side : sides) {
+				auto const texels = makeImage(side, channels_nb);
+
+				LogInfo("%4ux%-4u %s, %-26s: %8.2f ms",
+				        side, side, format_name, "driver (glGenerateMipmap)", timeDriverPath(texels, side, channels_nb));
+				for (auto const& variant : variants) {
+					auto const timings = timeCpuPath(texels, side, channels_nb, variant);
+					LogInfo("%4ux%-4u %s, %-26s: %8.2f ms, of which %8.2f ms generating",
+					        side, side, format_name, variant.name, timings.total_ms, timings.generation_ms);
+				}
+			}
+		}
+	} catch (std::runtime_error const& e) {
+		LogError(e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+// Times building the parametric shapes on the CPU, at increasing
+// tesselation levels, on the calling thread only and split across the
+// shared thread pool. No window or OpenGL context gets created: only the
+// build*() functions are exercised, not the upload.
+
+#include "EDAF80/parametric_shapes.hpp"
+
+#include "core/Log.h"
+#include "core/ThreadPool.hpp"
+
+#include <array>
+#include <chrono>
+#include <clocale>
+#include <cstddef>
+#include <functional>
+
+namespace
+{
+	namespace constant
+	{
+		constexpr unsigned int warmup_runs_nb = 1u;
+		constexpr unsigned int measured_runs_nb = 10u;
+	}
+
+	struct shape_variant {
+		char const* name;
+		std::function<parametric_shapes::mesh_buffers (unsigned int, parametric_shapes::execution_policy const&)> build;
+	};
+
+	// Returns the average time, in milliseconds, of building a shape, and
+	// the number of vertices and triangles it ended up with.
+	float timeBuild(shape_variant const& variant, unsigned int split_count,
+	                parametric_shapes::execution_policy const& policy,
+	                std::size_t& vertices_nb, std::size_t& triangles_nb)
+	{
+		float total_ms = 0.0f;
+		for (unsigned int run = 0u; run < constant::warmup_runs_nb + constant::measured_runs_nb; ++run) {
+			auto const start_time = std::chrono::high_resolution_clock::now();
+			auto const mesh = variant.build(split_count, policy);
+			auto const end_time = std::chrono::high_resolution_clock::now();
+
+			vertices_nb = mesh.vertices.size();
+			triangles_nb = mesh.indices.size();
+			if (run >= constant::warmup_runs_nb)
+				total_ms += std::chrono::duration<float, std::milli>(end_time - start_time).count();
+		}
+
+		return total_ms / constant::measured_runs_nb;
+	}
+}
+
+int main()
+{
+	std::setlocale(LC_ALL, "");
+
+	std::array<shape_variant, 4> const variants = {
+		shape_variant{ "quad",        [](unsigned int n, parametric_shapes::execution_policy const& p){ return parametric_shapes::buildQuad(1.0f, 1.0f, n, n, p); } },
+		shape_variant{ "sphere",      [](unsigned int n, parametric_shapes::execution_policy const& p){ return parametric_shapes::buildSphere(1.0f, n, n, p); } },
+		shape_variant{ "torus",       [](unsigned int n, parametric_shapes::execution_policy const& p){ return parametric_shapes::buildTorus(1.0f, 0.25f, n, n, p); } },
+		shape_variant{ "circle ring", [](unsigned int n, parametric_shapes::execution_policy const& p){ return parametric_shapes::buildCircleRing(1.0f, 0.5f, n, n, p); } }
+	};
+
+	LogInfo("Thread pool of %zu workers", ThreadPool::GetShared().GetThreadCount());
+
+	parametric_shapes::execution_policy single_thread;
+	single_thread.use_thread_pool = false;
+	parametric_shapes::execution_policy pooled;
+	pooled.use_thread_pool = true;
+
+	std::array<unsigned int, 6> const split_counts = { 15u, 63u, 99u, 255u, 999u, 2047u };
+	for (auto const& variant : variants) {
+		for (auto const split_count : split_counts) {
+			std::size_t vertices_nb = 0u;
+			std::size_t triangles_nb = 0u;
+			auto const single_thread_ms = timeBuild(variant, split_count, single_thread, vertices_nb, triangles_nb);
+			auto const pooled_ms = timeBuild(variant, split_count, pooled, vertices_nb, triangles_nb);
+			LogInfo("%-11s, %4u splits (%8zu vertices, %8zu triangles): %8.3f ms on 1 thread, %8.3f ms on the pool (x%.2f)",
+			        variant.name, split_count, vertices_nb, triangles_nb,
+			        single_thread_ms, pooled_ms, single_thread_ms / pooled_ms);
+		}
+	}
+
+	return 0;
+}
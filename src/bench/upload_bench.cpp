@@ -0,0 +1,149 @@
+// Compares the throughput of uploading buffer and texture data straight
+// from client memory with going through the staging ring of the upload
+// manager; timings include waiting for the GPU to finish the copies.
+
+#include "bench_context.hpp"
+
+#include "core/Bonobo.h"
+#include "core/helpers.hpp"
+#include "core/opengl.hpp"
+#include "core/UploadManager.hpp"
+
+#include <array>
+#include <chrono>
+#include <clocale>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	namespace constant
+	{
+		constexpr unsigned int warmup_runs_nb = 2u;
+		constexpr unsigned int measured_runs_nb = 20u;
+	}
+
+	enum class upload_path_t : unsigned int {
+		direct = 0u,
+		staged
+	};
+
+	char const* getPathName(upload_path_t path)
+	{
+		return path == upload_path_t::direct ? "direct" : "staged";
+	}
+
+	// Returns the throughput, in MB/s, of uploading `data` into a buffer
+	// object of the same size.
+	float timeBufferUploads(std::vector<std::uint8_t> const& data, upload_path_t path)
+	{
+		auto const size = static_cast<GLsizeiptr>(data.size());
+
+		GLuint buffer = 0u;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
+		glFinish();
+
+		auto& upload_manager = UploadManager::GetShared();
+		std::chrono::high_resolution_clock::time_point start_time;
+		for (unsigned int run = 0u; run < constant::warmup_runs_nb + constant::measured_runs_nb; ++run) {
+			if (run == constant::warmup_runs_nb) {
+				glFinish();
+				start_time = std::chrono::high_resolution_clock::now();
+			}
+			if (path == upload_path_t::direct)
+				glBufferSubData(GL_ARRAY_BUFFER, 0, size, data.data());
+			else
+				upload_manager.UploadBuffer(buffer, 0, size, data.data());
+		}
+		glFinish();
+		auto const end_time = std::chrono::high_resolution_clock::now();
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0u);
+		glDeleteBuffers(1, &buffer);
+
+		auto const seconds = std::chrono::duration<float>(end_time - start_time).count();
+		return static_cast<float>(data.size()) * constant::measured_runs_nb / (seconds * 1.0e6f);
+	}
+
+	// Returns the throughput, in MB/s, of uploading `data` as the first
+	// level of a RGBA8 2D-texture.
+	float timeTextureUploads(std::vector<std::uint8_t> const& data, GLsizei side, upload_path_t path)
+	{
+		GLuint texture = 0u;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glFinish();
+
+		auto& upload_manager = UploadManager::GetShared();
+		std::chrono::high_resolution_clock::time_point start_time;
+		for (unsigned int run = 0u; run < constant::warmup_runs_nb + constant::measured_runs_nb; ++run) {
+			if (run == constant::warmup_runs_nb) {
+				glFinish();
+				start_time = std::chrono::high_resolution_clock::now();
+			}
+			if (path == upload_path_t::direct)
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, side, side, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+			else
+				upload_manager.UploadTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, side, side, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+		}
+		glFinish();
+		auto const end_time = std::chrono::high_resolution_clock::now();
+
+		glBindTexture(GL_TEXTURE_2D, 0u);
+		glDeleteTextures(1, &texture);
+
+		auto const seconds = std::chrono::duration<float>(end_time - start_time).count();
+		return static_cast<float>(data.size()) * constant::measured_runs_nb / (seconds * 1.0e6f);
+	}
+}
+
+int main()
+{
+	std::setlocale(LC_ALL, "");
+
+	Bonobo framework;
+
+	try {
+		BenchContext context(framework.GetWindowManager(), "CG_Labs: upload benchmark");
+
+		LogInfo("Staging ring is %s",
+		        UploadManager::GetShared().IsPersistentlyMapped() ? "persistently mapped" : "mapped for each upload");
+
+		std::array<upload_path_t, 2> const paths = { upload_path_t::direct, upload_path_t::staged };
+
+		std::array<std::size_t, 4> const buffer_sizes = { 64u * 1024u, 1024u * 1024u, 16u * 1024u * 1024u, 64u * 1024u * 1024u };
+		for (auto const buffer_size : buffer_sizes) {
+			// Not all zeroes, so that nothing can take shortcuts.
+			std::vector<std::uint8_t> data(buffer_size);
+			for (std::size_t i = 0u; i < data.size(); ++i)
+				data[i] = static_cast<std::uint8_t>(i * 2654435761u >> 24);
+
+			for (auto const path : paths)
+				LogInfo("Buffer  %8zu KiB, %s: %9.1f MB/s",
+				        buffer_size / 1024u, getPathName(path), timeBufferUploads(data, path));
+		}
+
+		std::array<GLsizei, 4> const texture_sides = { 256, 1024, 2048, 4096 };
+		for (auto const side : texture_sides) {
+			std::vector<std::uint8_t> data(static_cast<std::size_t>(side) * static_cast<std::size_t>(side) * 4u);
+			for (std::size_t i = 0u; i < data.size(); ++i)
+				data[i] = static_cast<std::uint8_t>(i * 2654435761u >> 24);
+
+			for (auto const path : paths)
+				LogInfo("Texture %4dx%-4d RGBA8, %s: %9.1f MB/s",
+				        side, side, getPathName(path), timeTextureUploads(data, side, path));
+		}
+
+		auto const stats = UploadManager::GetShared().GetStatistics();
+		LogInfo("Upload manager: %.1f MiB staged in %zu copies, stalled %zu times for %.3f ms in total",
+		        stats.bytes_uploaded / (1024.0 * 1024.0), stats.copies_nb, stats.stalls_nb, stats.stall_time_ms);
+	} catch (std::runtime_error const& e) {
+		LogError(e.what());
+		return 1;
+	}
+
+	return 0;
+}
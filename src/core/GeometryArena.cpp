@@ -0,0 +1,217 @@
+#include "GeometryArena.hpp"
+
+#include "mesh_upload.hpp"
+
+#include "core/opengl.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <string>
+
+namespace
+{
+	// Keeps 32-bit indices aligned, whatever the type of the indices
+	// placed before them.
+	constexpr std::size_t indices_alignment = 4u;
+
+	// Index ranges are rounded up to keep all offsets aligned, and never
+	// empty so that no two meshes of a page share their indices offset.
+	std::size_t getIndicesRangeSize(std::size_t indices_size)
+	{
+		return std::max((indices_size + indices_alignment - 1u) & ~(indices_alignment - 1u), indices_alignment);
+	}
+
+	// The ranges below are `GeometryArena::Range`s, sorted by offset: the
+	// first fitting one gets taken from, and released ones get merged
+	// with their neighbours.
+	template<typename R>
+	std::size_t findRange(std::vector<R> const& free_ranges, std::size_t size)
+	{
+		for (std::size_t i = 0u; i < free_ranges.size(); ++i)
+			if (free_ranges[i].size >= size)
+				return i;
+		return free_ranges.size();
+	}
+
+	template<typename R>
+	std::size_t takeRange(std::vector<R>& free_ranges, std::size_t i, std::size_t size)
+	{
+		auto const offset = free_ranges[i].offset;
+		free_ranges[i].offset += size;
+		free_ranges[i].size -= size;
+		if (free_ranges[i].size == 0u)
+			free_ranges.erase(free_ranges.begin() + static_cast<std::ptrdiff_t>(i));
+		return offset;
+	}
+
+	template<typename R>
+	void giveRange(std::vector<R>& free_ranges, std::size_t offset, std::size_t size)
+	{
+		if (size == 0u)
+			return;
+
+		auto next = std::find_if(free_ranges.begin(), free_ranges.end(),
+		                         [offset](R const& range){ return range.offset > offset; });
+		auto const merges_previous = next != free_ranges.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+		auto const merges_next = next != free_ranges.end() && offset + size == next->offset;
+		if (merges_previous && merges_next) {
+			std::prev(next)->size += size + next->size;
+			free_ranges.erase(next);
+		} else if (merges_previous) {
+			std::prev(next)->size += size;
+		} else if (merges_next) {
+			next->offset = offset;
+			next->size += size;
+		} else {
+			free_ranges.insert(next, R{ offset, size });
+		}
+	}
+}
+
+std::unique_ptr<GeometryArena> GeometryArena::shared;
+
+GeometryArena::GeometryArena(std::uint32_t page_vertices_nb, std::size_t page_indices_size) :
+	page_vertices_nb(page_vertices_nb), page_indices_size(page_indices_size)
+{
+}
+
+GeometryArena::~GeometryArena()
+{
+	for (auto& page : pages) {
+		glDeleteVertexArrays(1, &page.vao);
+		glDeleteBuffers(1, &page.ibo);
+		glDeleteBuffers(1, &page.bo);
+	}
+}
+
+GeometryArena::Allocation
+GeometryArena::Allocate(bonobo::vertex_layout_t layout, std::uint32_t attributes_mask,
+                        std::uint32_t vertices_nb, std::size_t indices_size)
+{
+	auto const indices_range_size = getIndicesRangeSize(indices_size);
+	auto const fits = [=](Page const& page){
+		return page.layout == layout && page.attributes_mask == attributes_mask
+		    && findRange(page.free_vertices, vertices_nb) < page.free_vertices.size()
+		    && findRange(page.free_indices, indices_range_size) < page.free_indices.size();
+	};
+
+	// Space released by earlier meshes is reused before growing the
+	// arena by a new page.
+	auto page_it = std::find_if(pages.begin(), pages.end(), fits);
+	Page& page = page_it != pages.end()
+	           ? *page_it
+	           : CreatePage(layout, attributes_mask,
+	                        std::max(page_vertices_nb, vertices_nb),
+	                        std::max(page_indices_size, indices_range_size));
+
+	Block block;
+	block.vertices_offset = takeRange(page.free_vertices, findRange(page.free_vertices, vertices_nb), vertices_nb);
+	block.vertices_nb = vertices_nb;
+	block.indices_size = indices_range_size;
+	block.size_in_bytes = static_cast<std::uint64_t>(vertices_nb) * bonobo::getVertexSize(layout, attributes_mask) + indices_size;
+	auto const indices_offset = takeRange(page.free_indices, findRange(page.free_indices, indices_range_size), indices_range_size);
+	page.blocks.emplace(indices_offset, block);
+
+	Allocation allocation;
+	allocation.vao = page.vao;
+	allocation.bo = page.bo;
+	allocation.ibo = page.ibo;
+	allocation.vertices_capacity = page.vertices_capacity;
+	allocation.base_vertex = static_cast<GLint>(block.vertices_offset);
+	allocation.indices_offset = indices_offset;
+
+	++statistics.meshes_nb;
+	statistics.bytes_used += block.size_in_bytes;
+
+	return allocation;
+}
+
+void
+GeometryArena::Release(bonobo::mesh_data const& mesh)
+{
+	auto const page_it = std::find_if(pages.begin(), pages.end(),
+	                                  [&mesh](Page const& page){ return page.bo == mesh.bo; });
+	if (page_it == pages.end())
+		return;
+
+	auto const block_it = page_it->blocks.find(mesh.indices_offset);
+	if (block_it == page_it->blocks.end())
+		return;
+
+	auto const& block = block_it->second;
+	giveRange(page_it->free_vertices, block.vertices_offset, block.vertices_nb);
+	giveRange(page_it->free_indices, block_it->first, block.indices_size);
+
+	assert(statistics.meshes_nb > 0u);
+	--statistics.meshes_nb;
+	statistics.bytes_used -= block.size_in_bytes;
+	statistics.bytes_released += block.size_in_bytes;
+
+	page_it->blocks.erase(block_it);
+}
+
+GeometryArena::Statistics
+GeometryArena::GetStatistics() const
+{
+	return statistics;
+}
+
+GeometryArena&
+GeometryArena::GetShared()
+{
+	if (shared == nullptr)
+		shared.reset(new GeometryArena());
+	return *shared;
+}
+
+void
+GeometryArena::DestroyShared()
+{
+	shared.reset();
+}
+
+GeometryArena::Page&
+GeometryArena::CreatePage(bonobo::vertex_layout_t layout, std::uint32_t attributes_mask,
+                          std::uint32_t vertices_capacity, std::size_t indices_capacity)
+{
+	Page page;
+	page.layout = layout;
+	page.attributes_mask = attributes_mask;
+	page.vertices_capacity = vertices_capacity;
+	page.indices_capacity = indices_capacity;
+	page.free_vertices.push_back({ 0u, vertices_capacity });
+	page.free_indices.push_back({ 0u, indices_capacity });
+
+	auto const bo_size = static_cast<GLsizeiptr>(vertices_capacity * bonobo::getVertexSize(layout, attributes_mask));
+
+	glGenVertexArrays(1, &page.vao);
+	assert(page.vao != 0u);
+	glBindVertexArray(page.vao);
+
+	glGenBuffers(1, &page.bo);
+	assert(page.bo != 0u);
+	glBindBuffer(GL_ARRAY_BUFFER, page.bo);
+	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
+	bonobo::setupVertexAttributes(layout, attributes_mask, vertices_capacity);
+
+	glGenBuffers(1, &page.ibo);
+	assert(page.ibo != 0u);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices_capacity), nullptr, GL_STATIC_DRAW);
+
+	glBindVertexArray(0u);
+	glBindBuffer(GL_ARRAY_BUFFER, 0u);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+
+	auto const page_name = std::string("Geometry arena page ") + std::to_string(pages.size());
+	utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, page.vao, page_name + " VAO");
+	utils::opengl::debug::nameObject(GL_BUFFER, page.bo, page_name + " VBO");
+	utils::opengl::debug::nameObject(GL_BUFFER, page.ibo, page_name + " IBO");
+
+	++statistics.pages_nb;
+	statistics.bytes_reserved += static_cast<std::uint64_t>(bo_size) + indices_capacity;
+
+	pages.push_back(page);
+	return pages.back();
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "helpers.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+//! \brief Suballocates the geometry of many meshes from a few large
+//!        buffers, so that meshes with the same vertex format share a
+//!        single VAO.
+//!
+//! Each page holds a vertex buffer, an index buffer and the VAO tying
+//! them together, and is dedicated to one vertex format, i.e. one
+//! layout and one set of attributes. Meshes are placed one after the
+//! other within a page, so they must be drawn with their base vertex and
+//! the offset of their first index, see `bonobo::drawMesh()`; consecutive
+//! meshes from the same page can then be drawn without rebinding any
+//! VAO.
+//!
+//! Each page keeps lists of the vertex and index ranges that are free,
+//! which allocations take the first fitting range from and releases give
+//! back to, merged with their free neighbours; pages themselves are only
+//! deleted with the whole arena.
+//!
+//! The arena calls into OpenGL, so it must only be used from the thread
+//! owning the context.
+class GeometryArena
+{
+public:
+	struct Allocation {
+		GLuint vao{ 0u };
+		GLuint bo{ 0u };
+		GLuint ibo{ 0u };
+		std::uint32_t vertices_capacity{ 0u }; //!< vertices the page can hold, which determines where each planar attribute starts
+		GLint base_vertex{ 0 };
+		std::size_t indices_offset{ 0u };      //!< in bytes
+	};
+
+	struct Statistics {
+		std::size_t pages_nb{ 0u };
+		std::size_t meshes_nb{ 0u };          //!< meshes currently allocated
+		std::uint64_t bytes_reserved{ 0u };   //!< size of all the pages' buffers
+		std::uint64_t bytes_used{ 0u };       //!< by the meshes currently allocated
+		std::uint64_t bytes_released{ 0u };   //!< over the lifetime of the arena, made available again to later meshes
+	};
+
+	//! \brief Create an empty arena; pages get created as needed.
+	//!
+	//! @param [in] page_vertices_nb how many vertices a page can hold
+	//! @param [in] page_indices_size size in bytes of the index buffer
+	//!             of a page
+	//!
+	//! Meshes too large for a page get one sized just for them.
+	explicit GeometryArena(std::uint32_t page_vertices_nb = 512u * 1024u,
+	                       std::size_t page_indices_size = 16u * 1024u * 1024u);
+
+	//! \brief Delete all pages, invalidating all meshes allocated from
+	//!        the arena.
+	~GeometryArena();
+
+	GeometryArena(GeometryArena const&) = delete;
+	GeometryArena& operator=(GeometryArena const&) = delete;
+
+	//! \brief Reserve room for a mesh in a page matching its vertex
+	//!        format; the data itself is to be copied by the caller.
+	//!
+	//! @param [in] layout how the vertex attributes are laid out
+	//! @param [in] attributes_mask which attributes the mesh has, see
+	//!             `bonobo::getAttributesMask()`
+	//! @param [in] vertices_nb number of vertices of the mesh
+	//! @param [in] indices_size size in bytes of the mesh's indices
+	Allocation Allocate(bonobo::vertex_layout_t layout, std::uint32_t attributes_mask,
+	                    std::uint32_t vertices_nb, std::size_t indices_size);
+
+	//! \brief Give the vertex and index ranges of a mesh back to its
+	//!        page, for later meshes to reuse.
+	//!
+	//! @param [in] mesh as set up by `bonobo::uploadMesh()` from an
+	//!             allocation of this arena; other meshes are ignored
+	void Release(bonobo::mesh_data const& mesh);
+
+	Statistics GetStatistics() const;
+
+	//! \brief Arena used by `bonobo::uploadMesh()`, created on first use.
+	static GeometryArena& GetShared();
+
+	//! \brief Destroy the shared arena, if any; must be called before
+	//!        the OpenGL context goes away.
+	static void DestroyShared();
+
+private:
+	//! Free span of a page, in vertices or in bytes of indices.
+	struct Range {
+		std::size_t offset;
+		std::size_t size;
+	};
+
+	//! What a mesh took from its page, keyed by its indices offset.
+	struct Block {
+		std::size_t vertices_offset;
+		std::size_t vertices_nb;
+		std::size_t indices_size;
+		std::uint64_t size_in_bytes;
+	};
+
+	struct Page {
+		bonobo::vertex_layout_t layout;
+		std::uint32_t attributes_mask;
+		GLuint vao{ 0u };
+		GLuint bo{ 0u };
+		GLuint ibo{ 0u };
+		std::uint32_t vertices_capacity{ 0u };
+		std::size_t indices_capacity{ 0u };
+		std::vector<Range> free_vertices; //!< sorted by offset, never adjacent to one another
+		std::vector<Range> free_indices;  //!< sorted by offset, never adjacent to one another
+		std::unordered_map<std::size_t, Block> blocks;
+	};
+
+	Page& CreatePage(bonobo::vertex_layout_t layout, std::uint32_t attributes_mask,
+	                 std::uint32_t vertices_capacity, std::size_t indices_capacity);
+
+	std::uint32_t page_vertices_nb;
+	std::size_t page_indices_size;
+	std::vector<Page> pages;
+	Statistics statistics;
+
+	static std::unique_ptr<GeometryArena> shared;
+};
@@ -0,0 +1,348 @@
+#include "SceneStreamer.hpp"
+
+#include "mesh_simplifier.hpp"
+#include "mesh_upload.hpp"
+#include "texture_upload.hpp"
+#include "TextureRegistry.hpp"
+
+#include "core/Log.h"
+#include "core/opengl.hpp"
+#include "core/ThreadPool.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+SceneStreamer::SceneStreamer(std::string const& filename, bonobo::object_load_options const& options) :
+	filename(filename), options(options), start_time(std::chrono::high_resolution_clock::now())
+{
+	LogInfo("┭ Streaming \"%s\"…", filename.c_str());
+
+	import_done = ThreadPool::GetShared().Enqueue([this](){
+		if (!bonobo::importScene(this->filename, this->options.use_object_cache, importer, scene, import_report))
+			return false;
+
+		// Optimising here rather than on separate tasks avoids blocking a
+		// worker on other workers.
+		if (this->options.optimize_meshes) {
+			optimization_stats.reserve(scene.meshes.size());
+			for (auto& mesh : scene.meshes)
+				optimization_stats.push_back(bonobo::mesh_optimizer::optimize(mesh));
+		}
+		if (this->options.build_meshlets) {
+			meshlets.reserve(scene.meshes.size());
+			for (std::size_t j = 0u; j < scene.meshes.size(); ++j) {
+				meshlets.push_back(bonobo::meshlet_builder::build(scene.meshes[j]));
+				if (this->options.optimize_meshes)
+					bonobo::mesh_optimizer::optimizeMeshlets(scene.meshes[j], meshlets.back(), optimization_stats[j]);
+			}
+		}
+		if (this->options.build_lods)
+			for (auto& mesh : scene.meshes)
+				mesh.lods = bonobo::mesh_simplifier::build(mesh);
+
+		return true;
+	});
+}
+
+SceneStreamer::~SceneStreamer()
+{
+	if (import_done.valid())
+		import_done.wait();
+	for (auto& image : images)
+		if (image.pending.valid())
+			image.pending.wait();
+}
+
+bool
+SceneStreamer::Update(float budget_ms)
+{
+	if (state == State::Importing) {
+		if (import_done.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+
+		bonobo::logSceneImportReport(import_report);
+		if (!import_done.get()) {
+			LogError("Failed to stream \"%s\"", filename.c_str());
+			state = State::Failed;
+			return false;
+		}
+		LogTrivia("│ %s in %.3f ms",
+		          import_report.is_from_cache ? "Cache mapped" : "Scene imported",
+		          import_report.import_time_ms);
+		StartStreaming();
+	}
+	if (state != State::Streaming)
+		return false;
+
+	auto const update_start_time = std::chrono::high_resolution_clock::now();
+	auto const is_within_budget = [&update_start_time,budget_ms](){
+		auto const elapsed_time = std::chrono::high_resolution_clock::now() - update_start_time;
+		return std::chrono::duration<float, std::milli>(elapsed_time).count() < budget_ms;
+	};
+
+	// Geometry first, so that the whole scene shows up as early as
+	// possible, then textures in whichever order they get decoded.
+	bool has_changed = false;
+	do {
+		if (meshes.size() < scene.meshes.size()) {
+			has_changed |= UploadNextMesh();
+			continue;
+		}
+		if (!UploadNextImage())
+			break;
+		has_changed = true;
+	} while (is_within_budget());
+
+	if (meshes.size() == scene.meshes.size() && uploaded_images_nb == images.size())
+		Finish();
+
+	return has_changed;
+}
+
+bool
+SceneStreamer::IsDone() const
+{
+	return state == State::Done || state == State::Failed;
+}
+
+bool
+SceneStreamer::HasFailed() const
+{
+	return state == State::Failed;
+}
+
+std::vector<bonobo::mesh_data> const&
+SceneStreamer::GetMeshes() const
+{
+	return meshes;
+}
+
+void
+SceneStreamer::ReleaseTextures()
+{
+	assert(IsDone());
+
+	for (auto const texture : textures)
+		bonobo::releaseTexture(texture);
+	textures.clear();
+	for (auto& mesh : meshes)
+		mesh.bindings.clear();
+}
+
+void
+SceneStreamer::StartStreaming()
+{
+	state = State::Streaming;
+
+	auto const end_of_basedir = filename.rfind("/");
+	auto const parent_folder = (end_of_basedir != std::string::npos ? filename.substr(0, end_of_basedir) : ".") + "/";
+
+	// Every texture slot starts out with the placeholder, and an image
+	// referenced by multiple materials is only decoded once per role.
+	auto const placeholder = bonobo::getDebugTextureID();
+	materials_bindings.resize(scene.materials.size());
+	std::unordered_map<std::string, std::size_t> image_indices;
+	for (std::size_t i = 0; i < scene.materials.size(); ++i) {
+		auto const& material = scene.materials[i];
+		if (!material.is_used)
+			continue;
+
+		for (std::size_t t = 0; t < material.textures.size(); ++t) {
+			auto const& texture = material.textures[t];
+			materials_bindings[i].emplace(texture.name, placeholder);
+
+			auto const full_path = parent_folder + texture.path;
+			auto const role = options.use_texture_roles ? bonobo::getTextureRole(texture) : bonobo::texture_role_t::generic;
+			auto const image_index_it = image_indices.emplace(full_path + '\n' + std::to_string(static_cast<std::uint32_t>(role)), images.size());
+			if (image_index_it.second) {
+				images.emplace_back();
+				images.back().path = full_path;
+				images.back().role = role;
+			}
+			images[image_index_it.first->second].uses.emplace_back(i, t);
+		}
+	}
+
+	// Images already uploaded by a previous load are bound straight
+	// away; the others get decoded on the thread pool.
+	auto& texture_registry = TextureRegistry::GetShared();
+	auto& thread_pool = ThreadPool::GetShared();
+	std::size_t decoded_images_nb = 0u;
+	for (auto& image : images) {
+		if (options.use_texture_registry) {
+			image.registry_key = TextureRegistry::MakeKey(image.path, bonobo::texture_key_flipped | bonobo::texture_key_mipmapped
+			                                                          | bonobo::getTextureKeyFlags(image.role)
+			                                                          | (options.compress_textures ? bonobo::texture_key_compressed : 0u));
+			if (texture_registry.Contains(image.registry_key)) {
+				for (auto const& use : image.uses) {
+					auto const texture = texture_registry.Acquire(image.registry_key);
+					Bind(use.first, scene.materials[use.first].textures[use.second].name, texture);
+					++texture_count;
+				}
+				image.is_uploaded = true;
+				++uploaded_images_nb;
+				continue;
+			}
+		}
+
+		auto const& image_path = image.path;
+		auto const role = image.role;
+		auto const compress = options.compress_textures;
+		auto const use_texture_cache = options.use_texture_cache;
+		auto& report = image.report;
+		image.pending = thread_pool.Enqueue([&image_path,role,compress,use_texture_cache,&report](){
+			return bonobo::texture_cache::load(image_path, true, bonobo::mip_settings(), role, compress, use_texture_cache, report);
+		});
+		++decoded_images_nb;
+	}
+	LogTrivia("│ Decoding %zu images on %zu threads", decoded_images_nb, thread_pool.GetThreadCount());
+}
+
+bool
+SceneStreamer::UploadNextMesh()
+{
+	auto const mesh_start_time = std::chrono::high_resolution_clock::now();
+
+	auto const j = meshes.size();
+	auto const& mesh = scene.meshes[j];
+	auto object = bonobo::uploadMesh(mesh, options.mesh_upload);
+	if (mesh.material_index < scene.materials.size()) {
+		object.bindings = materials_bindings[mesh.material_index];
+		object.material = scene.materials[mesh.material_index].constants;
+	}
+	if (j < meshlets.size()) {
+		bonobo::meshlet_builder::accumulateStatistics(meshlets[j], meshlet_stats);
+		object.meshlets = std::move(meshlets[j]);
+	}
+	meshes.push_back(object);
+
+	auto const mesh_end_time = std::chrono::high_resolution_clock::now();
+	auto const upload_time_ms = std::chrono::duration<float, std::milli>(mesh_end_time - mesh_start_time).count();
+	meshes_upload_time_ms += upload_time_ms;
+
+	std::string processing;
+	if (j < optimization_stats.size() && optimization_stats[j].acmr_before > 0.0f) {
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), ", ACMR %.3f → %.3f",
+		              optimization_stats[j].acmr_before, optimization_stats[j].acmr_after);
+		processing = buffer;
+	}
+	if (!meshes.back().meshlets.empty())
+		processing += ", " + std::to_string(meshes.back().meshlets.size()) + " meshlets";
+	if (!meshes.back().lods.empty()) {
+		processing += ", LODs of ";
+		for (auto const& lod : meshes.back().lods)
+			processing += std::to_string(lod.indices_nb / 3) + (&lod == &meshes.back().lods.back() ? " triangles" : "/");
+	}
+	LogTrivia("│ ├ Mesh \"%s\" uploaded in %.3f ms%s", mesh.name.c_str(), upload_time_ms, processing.c_str());
+
+	return true;
+}
+
+bool
+SceneStreamer::UploadNextImage()
+{
+	auto& texture_registry = TextureRegistry::GetShared();
+	for (auto& image : images) {
+		if (image.is_uploaded || image.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			continue;
+
+		auto const upload_start_time = std::chrono::high_resolution_clock::now();
+
+		auto const decoded = image.pending.get();
+		image.is_uploaded = true;
+		++uploaded_images_nb;
+
+		GLuint texture = 0u;
+		for (auto const& use : image.uses) {
+			auto const& material = scene.materials[use.first];
+			auto const& texture_source = material.textures[use.second];
+			if (decoded.levels.empty()) {
+				Bind(use.first, texture_source.name, 0u);
+				LogWarning("Failed to load the %s texture for material \"%s\".", texture_source.type_as_str.c_str(), material.name.c_str());
+				continue;
+			}
+
+			// With the registry, all uses share the texture uploaded for
+			// the first one.
+			if (!options.use_texture_registry || texture == 0u) {
+				texture = bonobo::uploadTexture2D(decoded, true, image.role);
+				utils::opengl::debug::nameObject(GL_TEXTURE, texture, material.name + " " + texture_source.type_as_str);
+				auto const texture_size = bonobo::getUploadedSize(decoded, true);
+				textures_size += texture_size;
+				rgba_textures_size += bonobo::getRgbaSize(decoded, true);
+				if (options.use_texture_registry)
+					texture_registry.Insert(image.registry_key, texture, texture_size);
+			} else {
+				texture_registry.Acquire(texture);
+			}
+			Bind(use.first, texture_source.name, texture);
+			textures.push_back(texture);
+			++texture_count;
+		}
+
+		auto const upload_end_time = std::chrono::high_resolution_clock::now();
+		auto const upload_time_ms = std::chrono::duration<float, std::milli>(upload_end_time - upload_start_time).count();
+		textures_upload_time_ms += upload_time_ms;
+		if (!decoded.levels.empty() && decoded.format != bonobo::block_format_t::none)
+			LogTrivia("│ ├ Texture \"%s\" uploaded in %.3f ms, %s at %.2f dB", image.path.c_str(), upload_time_ms,
+			          bonobo::getBlockFormatName(decoded.format), image.report.psnr_db);
+		else if (!decoded.levels.empty())
+			LogTrivia("│ ├ Texture \"%s\" uploaded in %.3f ms", image.path.c_str(), upload_time_ms);
+
+		return true;
+	}
+
+	return false;
+}
+
+void
+SceneStreamer::Bind(std::size_t material_index, std::string const& name, GLuint texture)
+{
+	// A texture of 0 means the image could not be loaded: drop the
+	// binding, as `loadObjects()` would have done.
+	auto const update = [&name,texture](bonobo::texture_bindings& bindings){
+		if (texture != 0u)
+			bindings[name] = texture;
+		else
+			bindings.erase(name);
+	};
+
+	update(materials_bindings[material_index]);
+	for (std::size_t j = 0; j < meshes.size(); ++j)
+		if (scene.meshes[j].material_index == material_index)
+			update(meshes[j].bindings);
+}
+
+void
+SceneStreamer::Finish()
+{
+	state = State::Done;
+
+	if (meshlet_stats.meshlets_nb > 0u)
+		LogTrivia("│ %zu meshlets, filled at %.1f%% of their vertices and %.1f%% of their triangles on average",
+		          meshlet_stats.meshlets_nb,
+		          100.0f * meshlet_stats.vertices_nb / (meshlet_stats.meshlets_nb * bonobo::meshlet_builder::max_vertices_nb),
+		          100.0f * meshlet_stats.triangles_nb / (meshlet_stats.meshlets_nb * bonobo::meshlet_builder::max_triangles_nb));
+
+	if (options.use_texture_roles || options.compress_textures)
+		LogTrivia("│ Textures take %.3f MiB, instead of %.3f MiB as RGBA",
+		          textures_size / (1024.0f * 1024.0f), rgba_textures_size / (1024.0f * 1024.0f));
+	auto const end_time = std::chrono::high_resolution_clock::now();
+	LogInfo("┕ Scene streamed in %.3f s: %u textures (%.3f MiB) uploaded in %.3f s and %zu meshes in %.3f s",
+	        std::chrono::duration<float>(end_time - start_time).count(),
+	        texture_count, textures_size / (1024.0f * 1024.0f), textures_upload_time_ms / 1000.0f,
+	        meshes.size(), meshes_upload_time_ms / 1000.0f);
+
+	// The meshes and textures now live on the GPU; only keep what is
+	// needed for answering `GetMeshes()`.
+	scene.meshes.clear();
+	scene.materials.clear();
+	scene.mapping.close();
+	meshlets.clear();
+	importer.FreeScene();
+	images.clear();
+	materials_bindings.clear();
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "helpers.hpp"
+#include "mesh_optimizer.hpp"
+#include "meshlet_builder.hpp"
+#include "scene_import.hpp"
+#include "texture_cache.hpp"
+
+#include <assimp/Importer.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+//! \brief Asynchronous counterpart to `bonobo::loadObjects()`.
+//!
+//! The scene gets imported and its images decoded on the shared thread
+//! pool, while the render thread calls `Update()` once per frame to
+//! upload whatever is ready, within a time budget. Meshes appear as soon
+//! as they are uploaded, with all their texture bindings pointing to
+//! `bonobo::getDebugTextureID()`; each placeholder is then swapped for
+//! the actual texture once it is uploaded.
+//!
+//! The meshes and textures are not owned by the streamer: as with
+//! `loadObjects()`, release the meshes once done with them, which is safe
+//! even while streaming is still in progress. As meshes sharing a
+//! material share its textures, those are best released all at once
+//! with `ReleaseTextures()`.
+class SceneStreamer
+{
+public:
+	//! \brief Start loading a scene in the background; returns right
+	//!        away.
+	//!
+	//! @param [in] filename of the object/scene file to load
+	//! @param [in] options how to process the scene
+	SceneStreamer(std::string const& filename,
+	              bonobo::object_load_options const& options = bonobo::object_load_options());
+
+	//! \brief Wait for the background tasks still referring to the
+	//!        streamer; the data they produced is discarded.
+	~SceneStreamer();
+
+	SceneStreamer(SceneStreamer const&) = delete;
+	SceneStreamer& operator=(SceneStreamer const&) = delete;
+
+	//! \brief Upload meshes and textures which are ready, until the
+	//!        budget runs out; at least one upload is done per call, if
+	//!        any is ready.
+	//!
+	//! Must be called from the thread owning the OpenGL context.
+	//!
+	//! @param [in] budget_ms time, in milliseconds, that can be spent
+	//!             uploading
+	//! @return whether any mesh was added or any binding changed
+	bool Update(float budget_ms);
+
+	//! \brief Whether all meshes and textures have been uploaded, or the
+	//!        loading failed.
+	bool IsDone() const;
+
+	bool HasFailed() const;
+
+	//! \brief Meshes uploaded so far, in the order they appear in the
+	//!        scene file.
+	std::vector<bonobo::mesh_data> const& GetMeshes() const;
+
+	//! \brief Release all textures uploaded by the streamer, and drop
+	//!        the texture bindings of its meshes, e.g. once the textures
+	//!        have been copied elsewhere.
+	//!
+	//! Must only be called once `IsDone()`, as textures uploaded later
+	//! would be bound again.
+	void ReleaseTextures();
+
+private:
+	enum class State {
+		Importing,
+		Streaming,
+		Done,
+		Failed
+	};
+
+	struct Image {
+		std::string path;
+		std::string registry_key;
+		bonobo::texture_role_t role{ bonobo::texture_role_t::generic };
+		std::future<bonobo::mipmapped_image> pending;
+		bonobo::texture_cache::load_report report; //!< written by the decoding task, only read once `pending` is ready
+		bool is_uploaded{ false };
+		std::vector<std::pair<std::size_t, std::size_t>> uses; //!< (material, texture) pairs
+	};
+
+	void StartStreaming();
+	bool UploadNextMesh();
+	bool UploadNextImage();
+	void Bind(std::size_t material_index, std::string const& name, GLuint texture);
+	void Finish();
+
+	std::string filename;
+	bonobo::object_load_options options;
+	std::chrono::high_resolution_clock::time_point start_time;
+	State state{ State::Importing };
+
+	// Only accessed by the import task until `import_done` is ready.
+	Assimp::Importer importer;
+	bonobo::scene_source scene;
+	bonobo::scene_import_report import_report;
+	std::vector<bonobo::mesh_optimizer::statistics> optimization_stats;
+	std::vector<std::vector<bonobo::meshlet>> meshlets;
+	std::future<bool> import_done;
+
+	std::vector<Image> images;
+	std::vector<bonobo::texture_bindings> materials_bindings;
+	std::vector<bonobo::mesh_data> meshes;
+	std::vector<GLuint> textures; //!< one entry per reference taken to a texture, i.e. per binding made
+	std::size_t uploaded_images_nb{ 0u };
+	std::uint32_t texture_count{ 0u };
+	bonobo::meshlet_builder::statistics meshlet_stats;
+	float meshes_upload_time_ms{ 0.0f };
+	std::uint64_t textures_size{ 0u };
+	std::uint64_t rgba_textures_size{ 0u }; //!< what the textures would have taken without roles nor compression
+	float textures_upload_time_ms{ 0.0f };
+};
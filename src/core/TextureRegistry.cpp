@@ -0,0 +1,116 @@
+#include "TextureRegistry.hpp"
+
+#include "core/various.hpp"
+
+#include <cassert>
+
+std::string
+TextureRegistry::MakeKey(std::string const& path, std::uint32_t flags)
+{
+	std::string key;
+	std::size_t start = 0u;
+	while (start <= path.size()) {
+		auto end = path.find('\n', start);
+		if (end == std::string::npos)
+			end = path.size();
+		if (!key.empty())
+			key += '\n';
+		key += utils::get_canonical_path(path.substr(start, end - start));
+		start = end + 1u;
+	}
+
+	return key + '\n' + std::to_string(flags);
+}
+
+bool
+TextureRegistry::Contains(std::string const& key) const
+{
+	return names.find(key) != names.end();
+}
+
+GLuint
+TextureRegistry::Acquire(std::string const& key)
+{
+	auto const it = names.find(key);
+	if (it == names.end()) {
+		++statistics.misses;
+		return 0u;
+	}
+
+	auto& entry = entries.at(it->second);
+	++entry.references_nb;
+	++statistics.hits;
+	statistics.bytes_saved += entry.size_in_bytes;
+
+	return it->second;
+}
+
+bool
+TextureRegistry::Acquire(GLuint texture)
+{
+	auto const it = entries.find(texture);
+	if (it == entries.end())
+		return false;
+
+	++it->second.references_nb;
+	++statistics.hits;
+	statistics.bytes_saved += it->second.size_in_bytes;
+
+	return true;
+}
+
+void
+TextureRegistry::Insert(std::string const& key, GLuint texture, std::uint64_t size_in_bytes)
+{
+	assert(texture != 0u);
+	assert(names.find(key) == names.end());
+
+	names.emplace(key, texture);
+	entries.emplace(texture, Entry{ key, 1u, size_in_bytes });
+	++statistics.textures_nb;
+	statistics.bytes_resident += size_in_bytes;
+}
+
+bool
+TextureRegistry::Release(GLuint texture)
+{
+	auto const it = entries.find(texture);
+	if (it == entries.end())
+		return false;
+
+	assert(it->second.references_nb > 0u);
+	if (--it->second.references_nb > 0u)
+		return true;
+
+	glDeleteTextures(1, &texture);
+	--statistics.textures_nb;
+	statistics.bytes_resident -= it->second.size_in_bytes;
+	names.erase(it->second.key);
+	entries.erase(it);
+
+	return true;
+}
+
+void
+TextureRegistry::Clear()
+{
+	for (auto const& entry : entries)
+		glDeleteTextures(1, &entry.first);
+	names.clear();
+	entries.clear();
+	statistics.textures_nb = 0u;
+	statistics.bytes_resident = 0u;
+}
+
+TextureRegistry::Statistics
+TextureRegistry::GetStatistics() const
+{
+	return statistics;
+}
+
+TextureRegistry&
+TextureRegistry::GetShared()
+{
+	static TextureRegistry registry;
+	return registry;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "core/opengl.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+//! \brief Process-wide set of the textures loaded from files, so that a
+//!        file used in several places only lives once in GPU memory.
+//!
+//! Textures are keyed by the canonical path of the file(s) they were
+//! loaded from, as well as by the options affecting their content, and
+//! are reference-counted: each successful `Acquire()` or `Insert()` must
+//! be balanced by a `Release()`, and the last one deletes the texture.
+//!
+//! The registry calls into OpenGL, so it must only be used from the
+//! thread owning the context.
+class TextureRegistry
+{
+public:
+	struct Statistics {
+		std::size_t hits{ 0u };
+		std::size_t misses{ 0u };
+		std::uint64_t bytes_saved{ 0u };     //!< GPU memory that would have been spent on duplicates
+		std::size_t textures_nb{ 0u };       //!< textures currently registered
+		std::uint64_t bytes_resident{ 0u };  //!< GPU memory used by those textures
+	};
+
+	//! The destructor does not delete any texture, as the OpenGL
+	//! context is likely gone by the time static objects get destroyed;
+	//! call `Clear()` before destroying the context instead.
+	TextureRegistry() = default;
+	TextureRegistry(TextureRegistry const&) = delete;
+	TextureRegistry& operator=(TextureRegistry const&) = delete;
+
+	//! \brief Build the key identifying a texture.
+	//!
+	//! @param [in] path of the file the texture is loaded from; for
+	//!             textures made of several files, such as cube maps,
+	//!             the paths joined by newlines
+	//! @param [in] flags anything else affecting the texture's content,
+	//!             such as whether it was flipped or mipmapped
+	static std::string MakeKey(std::string const& path, std::uint32_t flags);
+
+	//! \brief Check whether a texture is registered under that key,
+	//!        without taking a reference nor affecting the statistics.
+	bool Contains(std::string const& key) const;
+
+	//! \brief Look up a texture and take a reference to it.
+	//!
+	//! @return the texture's name, or 0 (counted as a miss) if none is
+	//!         registered under that key
+	GLuint Acquire(std::string const& key);
+
+	//! \brief Take one more reference to a registered texture.
+	//!
+	//! @return whether the texture is managed by the registry
+	bool Acquire(GLuint texture);
+
+	//! \brief Register a newly created texture, with a single reference.
+	//!
+	//! @param [in] key as returned by `MakeKey()`
+	//! @param [in] texture name of the texture, which the registry takes
+	//!             ownership of
+	//! @param [in] size_in_bytes GPU memory used by the texture, for the
+	//!             statistics
+	void Insert(std::string const& key, GLuint texture, std::uint64_t size_in_bytes);
+
+	//! \brief Drop a reference to a texture, deleting it if it was the
+	//!        last one.
+	//!
+	//! @return whether the texture is managed by the registry; textures
+	//!         which are not are left untouched
+	bool Release(GLuint texture);
+
+	//! \brief Delete all textures, whatever their reference count; must
+	//!        be called before the OpenGL context goes away.
+	void Clear();
+
+	Statistics GetStatistics() const;
+
+	//! \brief Registry used by the loading helpers.
+	static TextureRegistry& GetShared();
+
+private:
+	struct Entry {
+		std::string key;
+		std::uint32_t references_nb{ 0u };
+		std::uint64_t size_in_bytes{ 0u };
+	};
+
+	std::unordered_map<std::string, GLuint> names;
+	std::unordered_map<GLuint, Entry> entries;
+	Statistics statistics;
+};
@@ -0,0 +1,66 @@
+#include "ThreadPool.hpp"
+
+namespace
+{
+	thread_local ThreadPool const* current_pool = nullptr;
+}
+
+ThreadPool::ThreadPool(std::size_t thread_count)
+{
+	if (thread_count == 0u)
+		thread_count = std::thread::hardware_concurrency();
+	if (thread_count == 0u)
+		thread_count = 1u;
+
+	workers.reserve(thread_count);
+	for (std::size_t i = 0u; i < thread_count; ++i)
+		workers.emplace_back([this](){ Work(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+std::size_t
+ThreadPool::GetThreadCount() const
+{
+	return workers.size();
+}
+
+bool
+ThreadPool::IsWorkerThread() const
+{
+	return current_pool == this;
+}
+
+ThreadPool&
+ThreadPool::GetShared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void
+ThreadPool::Work()
+{
+	current_pool = this;
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this](){ return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty())
+				return;
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+		task();
+	}
+}
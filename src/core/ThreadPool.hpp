@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//! \brief Fixed set of worker threads consuming tasks in submission order.
+//!
+//! The workers have no OpenGL context bound, so tasks must not issue any
+//! OpenGL calls. The logging functions are not thread-safe either: report
+//! results and failures through the returned future, and do the uploading
+//! and logging from the thread owning the context.
+//!
+//! The following only work on CPU memory, neither logging nor calling
+//! into OpenGL, and are therefore meant to run as tasks:
+//! * `bonobo::texture_cache`: loading, mip generation and caching of
+//!   images.
+//! * `bonobo::mesh_optimizer`: vertex cache and overdraw optimisation of
+//!   meshes.
+//! * `bonobo::mip_generator`: filtering of mip levels.
+//! * `bonobo::meshlet_builder`: splitting of meshes into meshlets.
+//! * `bonobo::mesh_simplifier`: building of LOD chains.
+//! * `bonobo::block_compressor`: BC1/BC3/BC4/BC5 encoding of images.
+class ThreadPool
+{
+public:
+	//! \brief Spawn the worker threads.
+	//!
+	//! @param [in] thread_count number of workers to spawn; 0 spawns one
+	//!             per hardware thread
+	explicit ThreadPool(std::size_t thread_count = 0u);
+
+	//! \brief Finish all pending tasks, then join the worker threads.
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+	//! \brief Queue a task for execution on one of the workers.
+	//!
+	//! @param [in] task callable taking no arguments
+	//! @return a future holding the value returned by the task
+	template<typename F>
+	std::future<typename std::result_of<F()>::type> Enqueue(F&& task);
+
+	std::size_t GetThreadCount() const;
+
+	//! \brief Whether the calling thread is one of this pool's workers.
+	//!
+	//! Tasks must not wait for other tasks of their own pool, as all
+	//! workers could end up waiting for tasks that none is left to run.
+	bool IsWorkerThread() const;
+
+	//! \brief Pool shared by the loading helpers, spawned on first use.
+	static ThreadPool& GetShared();
+
+private:
+	void Work();
+
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping{ false };
+};
+
+template<typename F>
+std::future<typename std::result_of<F()>::type>
+ThreadPool::Enqueue(F&& task)
+{
+	using result_t = typename std::result_of<F()>::type;
+
+	// std::function requires copyable callables, which std::packaged_task
+	// is not, hence the extra indirection.
+	auto packaged = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(task));
+	auto result = packaged->get_future();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.emplace([packaged](){ (*packaged)(); });
+	}
+	condition.notify_one();
+
+	return result;
+}
@@ -0,0 +1,273 @@
+#include "UploadManager.hpp"
+
+#include "core/Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	// Offsets into pixel unpack buffers must be multiples of the component
+	// size; be generous so that copies stay nicely aligned.
+	constexpr std::size_t staging_alignment = 256u;
+
+	// Size of a pixel, or 0 if the format/type combination is not handled.
+	std::size_t getPixelSize(GLenum format, GLenum type)
+	{
+		std::size_t component_size = 0u;
+		switch (type) {
+		case GL_UNSIGNED_BYTE:  component_size = 1u; break;
+		case GL_UNSIGNED_SHORT: component_size = 2u; break;
+		case GL_FLOAT:          component_size = 4u; break;
+		default:                return 0u;
+		}
+
+		switch (format) {
+		case GL_RED:  return component_size;
+		case GL_RG:   return component_size * 2u;
+		case GL_RGB:  return component_size * 3u;
+		case GL_RGBA: return component_size * 4u;
+		default:      return 0u;
+		}
+	}
+}
+
+std::unique_ptr<UploadManager> UploadManager::shared;
+
+UploadManager::UploadManager(std::size_t segment_size) : segment_size(segment_size)
+{
+	auto const ring_size = static_cast<GLsizeiptr>(segment_size * segments_nb);
+
+	glGenBuffers(1, &ring);
+	assert(ring != 0u);
+	glBindBuffer(GL_COPY_READ_BUFFER, ring);
+	if (GLAD_GL_VERSION_4_4) {
+		GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_READ_BUFFER, ring_size, nullptr, flags);
+		mapping = static_cast<std::uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, ring_size, flags));
+		is_persistent = mapping != nullptr;
+		if (!is_persistent)
+			LogWarning("Failed to persistently map the staging buffer; falling back to mapping each upload.");
+	}
+	if (!is_persistent) {
+		// Buffer storage is immutable, so start over with a new buffer.
+		if (GLAD_GL_VERSION_4_4) {
+			glDeleteBuffers(1, &ring);
+			glGenBuffers(1, &ring);
+			glBindBuffer(GL_COPY_READ_BUFFER, ring);
+		}
+		glBufferData(GL_COPY_READ_BUFFER, ring_size, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+
+	utils::opengl::debug::nameObject(GL_BUFFER, ring, "Upload staging ring");
+}
+
+UploadManager::~UploadManager()
+{
+	for (std::size_t segment = 0u; segment < segments_nb; ++segment)
+		WaitForSegment(segment);
+
+	if (is_persistent) {
+		glBindBuffer(GL_COPY_READ_BUFFER, ring);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+	}
+	glDeleteBuffers(1, &ring);
+}
+
+void
+UploadManager::UploadBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, void const* data)
+{
+	auto const* const bytes = static_cast<std::uint8_t const*>(data);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	for (std::size_t copied = 0u; copied < static_cast<std::size_t>(size);) {
+		auto const chunk_size = std::min(static_cast<std::size_t>(size) - copied, segment_size);
+		auto const staging_offset = Stage(bytes + copied, chunk_size);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, ring);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+		                    staging_offset, offset + static_cast<GLintptr>(copied),
+		                    static_cast<GLsizeiptr>(chunk_size));
+		++statistics.copies_nb;
+		copied += chunk_size;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+}
+
+void
+UploadManager::UploadTexImage2D(GLenum target, GLint level, GLint internal_format,
+                                GLsizei width, GLsizei height,
+                                GLenum format, GLenum type, void const* data)
+{
+	auto const pixel_size = getPixelSize(format, type);
+	auto const row_size = static_cast<std::size_t>(width) * pixel_size;
+	if (data == nullptr || pixel_size == 0u || row_size > segment_size) {
+		glTexImage2D(target, level, internal_format, width, height, 0, format, type, data);
+		return;
+	}
+
+	// Rows are tightly packed in client memory, but GL_UNPACK_ALIGNMENT
+	// defaults to 4.
+	GLint unpack_alignment = 4;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	auto const* const bytes = static_cast<std::uint8_t const*>(data);
+	auto const image_size = row_size * static_cast<std::size_t>(height);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+	if (image_size <= segment_size) {
+		auto const staging_offset = Stage(bytes, image_size);
+		glTexImage2D(target, level, internal_format, width, height, 0, format, type,
+		             reinterpret_cast<GLvoid const*>(staging_offset));
+		++statistics.copies_nb;
+	} else {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+		glTexImage2D(target, level, internal_format, width, height, 0, format, type, nullptr);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+
+		auto const rows_per_chunk = static_cast<GLsizei>(segment_size / row_size);
+		for (GLsizei row = 0; row < height; row += rows_per_chunk) {
+			auto const rows_nb = std::min(rows_per_chunk, height - row);
+			auto const staging_offset = Stage(bytes + static_cast<std::size_t>(row) * row_size,
+			                                  static_cast<std::size_t>(rows_nb) * row_size);
+			glTexSubImage2D(target, level, 0, row, width, rows_nb, format, type,
+			                reinterpret_cast<GLvoid const*>(staging_offset));
+			++statistics.copies_nb;
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+}
+
+void
+UploadManager::UploadCompressedTexImage2D(GLenum target, GLint level, GLenum internal_format,
+                                          GLsizei width, GLsizei height,
+                                          GLsizei image_size, void const* data)
+{
+	auto const block_rows_nb = static_cast<std::size_t>((height + 3) / 4);
+	auto const block_row_size = block_rows_nb > 0u ? static_cast<std::size_t>(image_size) / block_rows_nb : 0u;
+	if (data == nullptr || block_row_size == 0u || block_row_size > segment_size) {
+		glCompressedTexImage2D(target, level, internal_format, width, height, 0, image_size, data);
+		return;
+	}
+
+	auto const* const bytes = static_cast<std::uint8_t const*>(data);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+	if (static_cast<std::size_t>(image_size) <= segment_size) {
+		auto const staging_offset = Stage(bytes, static_cast<std::size_t>(image_size));
+		glCompressedTexImage2D(target, level, internal_format, width, height, 0, image_size,
+		                       reinterpret_cast<GLvoid const*>(staging_offset));
+		++statistics.copies_nb;
+	} else {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+		glCompressedTexImage2D(target, level, internal_format, width, height, 0, image_size, nullptr);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+
+		// Sub-images must start on a block boundary, and cover whole
+		// blocks unless they reach the edge of the image.
+		auto const block_rows_per_chunk = segment_size / block_row_size;
+		for (std::size_t block_row = 0u; block_row < block_rows_nb; block_row += block_rows_per_chunk) {
+			auto const chunk_block_rows_nb = std::min(block_rows_per_chunk, block_rows_nb - block_row);
+			auto const chunk_size = chunk_block_rows_nb * block_row_size;
+			auto const staging_offset = Stage(bytes + block_row * block_row_size, chunk_size);
+			auto const row = static_cast<GLsizei>(block_row * 4u);
+			glCompressedTexSubImage2D(target, level, 0, row, width,
+			                          std::min(static_cast<GLsizei>(chunk_block_rows_nb * 4u), height - row),
+			                          internal_format, static_cast<GLsizei>(chunk_size),
+			                          reinterpret_cast<GLvoid const*>(staging_offset));
+			++statistics.copies_nb;
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+}
+
+bool
+UploadManager::IsPersistentlyMapped() const
+{
+	return is_persistent;
+}
+
+UploadManager::Statistics
+UploadManager::GetStatistics() const
+{
+	return statistics;
+}
+
+UploadManager&
+UploadManager::GetShared()
+{
+	if (shared == nullptr)
+		shared.reset(new UploadManager());
+	return *shared;
+}
+
+void
+UploadManager::DestroyShared()
+{
+	shared.reset();
+}
+
+GLintptr
+UploadManager::Stage(void const* data, std::size_t size)
+{
+	assert(size <= segment_size);
+
+	current_offset = (current_offset + staging_alignment - 1u) & ~(staging_alignment - 1u);
+	if (current_offset + size > segment_size) {
+		// Fence the copies issued from the current segment, and move on
+		// to the next one once the GPU is done with it.
+		fences[current_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		current_segment = (current_segment + 1u) % segments_nb;
+		current_offset = 0u;
+		WaitForSegment(current_segment);
+	}
+
+	auto const offset = current_segment * segment_size + current_offset;
+	if (is_persistent) {
+		std::memcpy(mapping + offset, data, size);
+	} else {
+		glBindBuffer(GL_COPY_READ_BUFFER, ring);
+		auto* const destination = glMapBufferRange(GL_COPY_READ_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size),
+		                                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		assert(destination != nullptr);
+		std::memcpy(destination, data, size);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+	}
+
+	current_offset += size;
+	statistics.bytes_uploaded += size;
+
+	return static_cast<GLintptr>(offset);
+}
+
+void
+UploadManager::WaitForSegment(std::size_t segment)
+{
+	auto& fence = fences[segment];
+	if (fence == nullptr)
+		return;
+
+	auto status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED) {
+		auto const stall_start_time = std::chrono::high_resolution_clock::now();
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000u);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		auto const stall_end_time = std::chrono::high_resolution_clock::now();
+
+		++statistics.stalls_nb;
+		statistics.stall_time_ms += std::chrono::duration<float, std::milli>(stall_end_time - stall_start_time).count();
+	}
+	if (status == GL_WAIT_FAILED)
+		LogError("Failed to wait for the upload fence of segment %zu", segment);
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
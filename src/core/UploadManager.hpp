@@ -0,0 +1,109 @@
+#pragma once
+
+#include "core/opengl.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+//! \brief Uploads buffer and texture data through a ring of staging
+//!        buffers, rather than straight from client memory.
+//!
+//! The data is first copied into a staging buffer, from which the GPU
+//! copies it into its destination asynchronously, so the driver does not
+//! need to make its own copy nor to stall. The ring is split into
+//! segments, each one fenced once written: a segment is only reused once
+//! the GPU is done reading from it.
+//!
+//! When OpenGL 4.4 is available, the ring is persistently mapped;
+//! otherwise (as with the 4.1 contexts created by WindowManager) each
+//! staged range gets mapped unsynchronised, which is safe thanks to the
+//! fences.
+//!
+//! The manager calls into OpenGL, so it must only be used from the
+//! thread owning the context.
+class UploadManager
+{
+public:
+	struct Statistics {
+		std::uint64_t bytes_uploaded{ 0u };
+		std::size_t copies_nb{ 0u };
+		std::size_t stalls_nb{ 0u };      //!< times a segment was still in use by the GPU
+		float stall_time_ms{ 0.0f };
+	};
+
+	//! \brief Create and map the staging ring.
+	//!
+	//! @param [in] segment_size size in bytes of each segment, which is
+	//!             also the largest amount of data copied at once
+	explicit UploadManager(std::size_t segment_size = 8u * 1024u * 1024u);
+
+	//! \brief Wait for all pending copies, then delete the staging ring.
+	~UploadManager();
+
+	UploadManager(UploadManager const&) = delete;
+	UploadManager& operator=(UploadManager const&) = delete;
+
+	//! \brief Copy data into a buffer object, similarly to
+	//!        `glBufferSubData()`.
+	//!
+	//! The destination buffer must already have storage for the range;
+	//! its bindings are left untouched.
+	void UploadBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, void const* data);
+
+	//! \brief Specify a 2D image level, similarly to `glTexImage2D()`,
+	//!        for the texture currently bound to the corresponding target.
+	//!
+	//! `target` can be GL_TEXTURE_2D or any cube map face. Rows of
+	//! `data` are expected to be tightly packed, whatever the value of
+	//! GL_UNPACK_ALIGNMENT. Images larger than a segment are copied a
+	//! few rows at a time.
+	void UploadTexImage2D(GLenum target, GLint level, GLint internal_format,
+	                      GLsizei width, GLsizei height,
+	                      GLenum format, GLenum type, void const* data);
+
+	//! \brief Specify a compressed 2D image level, similarly to
+	//!        `glCompressedTexImage2D()`, for the texture currently bound to
+	//!        the corresponding target.
+	//!
+	//! The format must use 4×4 blocks, as all S3TC and RGTC formats do.
+	//! Images larger than a segment are copied a few rows of blocks at a
+	//! time.
+	void UploadCompressedTexImage2D(GLenum target, GLint level, GLenum internal_format,
+	                                GLsizei width, GLsizei height,
+	                                GLsizei image_size, void const* data);
+
+	bool IsPersistentlyMapped() const;
+
+	Statistics GetStatistics() const;
+
+	//! \brief Manager used by the loading helpers, created on first use.
+	static UploadManager& GetShared();
+
+	//! \brief Destroy the shared manager, if any; must be called before
+	//!        the OpenGL context goes away.
+	static void DestroyShared();
+
+private:
+	static constexpr std::size_t segments_nb = 4u;
+
+	//! \brief Reserve staging memory, switching to the next segment if
+	//!        needed, and copy `data` into it.
+	//!
+	//! @return the offset of the staged data within the ring
+	GLintptr Stage(void const* data, std::size_t size);
+
+	void WaitForSegment(std::size_t segment);
+
+	GLuint ring{ 0u };
+	std::size_t segment_size;
+	std::uint8_t* mapping{ nullptr };
+	bool is_persistent{ false };
+	std::array<GLsync, segments_nb> fences{};
+	std::size_t current_segment{ 0u };
+	std::size_t current_offset{ 0u };
+	Statistics statistics;
+
+	static std::unique_ptr<UploadManager> shared;
+};
@@ -0,0 +1,848 @@
+#include "block_compressor.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <vector>
+
+// As for the mip generator, SSE2 comes with x86-64 and other
+// architectures use the scalar code paths.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define BLOCK_COMPRESSOR_HAS_SSE2 1
+#	include <emmintrin.h>
+#else
+#	define BLOCK_COMPRESSOR_HAS_SSE2 0
+#endif
+
+namespace
+{
+	namespace constant
+	{
+		constexpr std::uint32_t block_width = 4u;
+		constexpr std::uint32_t texels_per_block = block_width * block_width;
+		constexpr int power_iterations_nb = 4;
+		constexpr int refinements_nb = 2;
+
+		// Below that many blocks per band, splitting a level costs more
+		// in synchronisation than it saves.
+		constexpr std::size_t min_blocks_per_band = 4u * 1024u;
+	}
+
+	// Texels of a 4×4 block, in row-major order; channels an image does
+	// not have are left at 0.
+	using texel_block = std::array<std::array<std::uint8_t, 4>, constant::texels_per_block>;
+	using color_palette = std::array<std::array<int, 3>, 4>;
+	static_assert(sizeof(texel_block) == constant::texels_per_block * 4u, "texel blocks are loaded as four rows of 16 bytes");
+
+	std::uint32_t getBlocksNb(std::uint32_t size)
+	{
+		return (size + constant::block_width - 1u) / constant::block_width;
+	}
+
+	void extractBlock(bonobo::mipmapped_image::level const& level, std::uint32_t channels_nb,
+	                  std::uint32_t block_x, std::uint32_t block_y, texel_block& block)
+	{
+		for (std::uint32_t y = 0u; y < constant::block_width; ++y) {
+			auto const source_y = std::min(block_y * constant::block_width + y, level.height - 1u);
+			for (std::uint32_t x = 0u; x < constant::block_width; ++x) {
+				auto const source_x = std::min(block_x * constant::block_width + x, level.width - 1u);
+				auto const* const source = level.texels + (static_cast<std::size_t>(source_y) * level.width + source_x) * channels_nb;
+				auto& texel = block[y * constant::block_width + x];
+				texel = { 0u, 0u, 0u, 0u };
+				for (std::uint32_t c = 0u; c < channels_nb; ++c)
+					texel[c] = source[c];
+			}
+		}
+	}
+
+	// Write back the texels of a block lying within the level.
+	void storeBlock(texel_block const& block, std::uint32_t channels_nb, std::uint32_t block_x, std::uint32_t block_y,
+	                std::uint8_t* texels, std::uint32_t width, std::uint32_t height)
+	{
+		for (std::uint32_t y = 0u; y < constant::block_width; ++y) {
+			auto const destination_y = block_y * constant::block_width + y;
+			if (destination_y >= height)
+				break;
+			for (std::uint32_t x = 0u; x < constant::block_width; ++x) {
+				auto const destination_x = block_x * constant::block_width + x;
+				if (destination_x >= width)
+					break;
+				auto* const destination = texels + (static_cast<std::size_t>(destination_y) * width + destination_x) * channels_nb;
+				for (std::uint32_t c = 0u; c < channels_nb; ++c)
+					destination[c] = block[y * constant::block_width + x][c];
+			}
+		}
+	}
+
+	std::uint16_t packColor(std::array<float, 3> const& color)
+	{
+		auto const quantize = [](float value, int max){
+			return static_cast<std::uint16_t>(std::lround(std::min(std::max(value, 0.0f), 255.0f) * max / 255.0f));
+		};
+		return static_cast<std::uint16_t>((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+	}
+
+	std::array<int, 3> unpackColor(std::uint16_t packed)
+	{
+		auto const r = (packed >> 11) & 0x1f;
+		auto const g = (packed >> 5) & 0x3f;
+		auto const b = packed & 0x1f;
+		return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+	}
+
+	// Colours of the four-colour mode, used whenever `c0 > c1`.
+	color_palette getColorPalette(std::uint16_t c0, std::uint16_t c1)
+	{
+		color_palette palette;
+		palette[0] = unpackColor(c0);
+		palette[1] = unpackColor(c1);
+		for (int c = 0; c < 3; ++c) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		return palette;
+	}
+
+	// Sums over the first three channels of a block, from which its mean,
+	// covariance and bounding box follow; being integers, they do not
+	// depend on the order texels get added in, so both code paths agree.
+	struct color_sums {
+		std::array<int, 3> sums;
+		std::array<int, 6> products; // rr, rg, rb, gg, gb, bb
+		std::array<int, 3> minimum;
+		std::array<int, 3> maximum;
+	};
+
+	void sumColorsScalar(texel_block const& block, color_sums& result)
+	{
+		result.sums = { 0, 0, 0 };
+		result.products = { 0, 0, 0, 0, 0, 0 };
+		result.minimum = { 255, 255, 255 };
+		result.maximum = { 0, 0, 0 };
+		for (auto const& texel : block) {
+			int const r = texel[0], g = texel[1], b = texel[2];
+			result.sums[0] += r;
+			result.sums[1] += g;
+			result.sums[2] += b;
+			result.products[0] += r * r;
+			result.products[1] += r * g;
+			result.products[2] += r * b;
+			result.products[3] += g * g;
+			result.products[4] += g * b;
+			result.products[5] += b * b;
+			for (int c = 0; c < 3; ++c) {
+				result.minimum[c] = std::min(result.minimum[c], static_cast<int>(texel[c]));
+				result.maximum[c] = std::max(result.maximum[c], static_cast<int>(texel[c]));
+			}
+		}
+	}
+
+	// Indices of the first texels lying furthest along `axis`, in each
+	// direction.
+	void findExtremeTexelsScalar(texel_block const& block, std::array<float, 3> const& axis,
+	                             std::uint32_t& maximum_texel, std::uint32_t& minimum_texel)
+	{
+		auto minimum_projection = std::numeric_limits<float>::max();
+		auto maximum_projection = std::numeric_limits<float>::lowest();
+		maximum_texel = minimum_texel = 0u;
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i) {
+			auto const& texel = block[i];
+			auto const projection = texel[0] * axis[0] + texel[1] * axis[1] + texel[2] * axis[2];
+			if (projection > maximum_projection) {
+				maximum_projection = projection;
+				maximum_texel = i;
+			}
+			if (projection < minimum_projection) {
+				minimum_projection = projection;
+				minimum_texel = i;
+			}
+		}
+	}
+
+	// Pick the closest palette entry for each texel, the first one on
+	// ties, and return the squared error of the whole block.
+	int pickColorIndicesScalar(texel_block const& block, color_palette const& palette, std::uint32_t& indices)
+	{
+		indices = 0u;
+		int block_error = 0;
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i) {
+			int best_error = std::numeric_limits<int>::max();
+			std::uint32_t best_index = 0u;
+			for (std::uint32_t j = 0u; j < 4u; ++j) {
+				int error = 0;
+				for (int c = 0; c < 3; ++c) {
+					auto const difference = static_cast<int>(block[i][c]) - palette[j][c];
+					error += difference * difference;
+				}
+				if (error < best_error) {
+					best_error = error;
+					best_index = j;
+				}
+			}
+			indices |= best_index << (2u * i);
+			block_error += best_error;
+		}
+		return block_error;
+	}
+
+	// Pick the closest of the eight palette entries for each value, the
+	// first one on ties.
+	std::uint64_t pickSingleChannelIndicesScalar(std::array<std::uint8_t, constant::texels_per_block> const& values,
+	                                             std::array<int, 8> const& palette)
+	{
+		std::uint64_t indices = 0u;
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i) {
+			int best_error = std::numeric_limits<int>::max();
+			std::uint64_t best_index = 0u;
+			for (int j = 0; j < 8; ++j) {
+				auto const error = std::abs(static_cast<int>(values[i]) - palette[j]);
+				if (error < best_error) {
+					best_error = error;
+					best_index = static_cast<std::uint64_t>(j);
+				}
+			}
+			indices |= best_index << (3u * i);
+		}
+		return indices;
+	}
+
+#if BLOCK_COMPRESSOR_HAS_SSE2
+	// Each 16-byte row of a block holds four RGBA texels.
+	__m128i loadTexels(texel_block const& block, std::uint32_t first_texel)
+	{
+		return _mm_loadu_si128(reinterpret_cast<__m128i const*>(block[first_texel].data()));
+	}
+
+	void sumColorsSse2(texel_block const& block, color_sums& result)
+	{
+		auto const zero = _mm_setzero_si128();
+		auto sums = zero;     // r, g, b, a of two texels, on 16 bits
+		auto squares = zero;  // rr, gg, bb, aa, on 32 bits
+		auto crosses = zero;  // rg, gb, br, aa, on 32 bits
+		auto minimum = _mm_set1_epi8(-1);
+		auto maximum = zero;
+		auto const accumulate = [&](__m128i const& pair){
+			sums = _mm_add_epi16(sums, pair);
+			// Products of 8-bit values fit in 16 bits, once unsigned.
+			auto const rotated = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pair, _MM_SHUFFLE(3, 0, 2, 1)), _MM_SHUFFLE(3, 0, 2, 1));
+			auto const pair_squares = _mm_mullo_epi16(pair, pair);
+			auto const pair_crosses = _mm_mullo_epi16(pair, rotated);
+			squares = _mm_add_epi32(squares, _mm_add_epi32(_mm_unpacklo_epi16(pair_squares, zero), _mm_unpackhi_epi16(pair_squares, zero)));
+			crosses = _mm_add_epi32(crosses, _mm_add_epi32(_mm_unpacklo_epi16(pair_crosses, zero), _mm_unpackhi_epi16(pair_crosses, zero)));
+		};
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; i += 4u) {
+			auto const texels = loadTexels(block, i);
+			minimum = _mm_min_epu8(minimum, texels);
+			maximum = _mm_max_epu8(maximum, texels);
+			accumulate(_mm_unpacklo_epi8(texels, zero));
+			accumulate(_mm_unpackhi_epi8(texels, zero));
+		}
+
+		sums = _mm_add_epi16(sums, _mm_srli_si128(sums, 8));
+		minimum = _mm_min_epu8(minimum, _mm_srli_si128(minimum, 8));
+		minimum = _mm_min_epu8(minimum, _mm_srli_si128(minimum, 4));
+		maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 8));
+		maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 4));
+
+		alignas(16) std::int32_t square_values[4];
+		alignas(16) std::int32_t cross_values[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(square_values), squares);
+		_mm_store_si128(reinterpret_cast<__m128i*>(cross_values), crosses);
+		auto const minimum_values = static_cast<std::uint32_t>(_mm_cvtsi128_si32(minimum));
+		auto const maximum_values = static_cast<std::uint32_t>(_mm_cvtsi128_si32(maximum));
+		result.sums = { _mm_extract_epi16(sums, 0), _mm_extract_epi16(sums, 1), _mm_extract_epi16(sums, 2) };
+		result.products = { square_values[0], cross_values[0], cross_values[2],
+		                    square_values[1], cross_values[1], square_values[2] };
+		for (int c = 0; c < 3; ++c) {
+			result.minimum[c] = static_cast<int>((minimum_values >> (8 * c)) & 0xffu);
+			result.maximum[c] = static_cast<int>((maximum_values >> (8 * c)) & 0xffu);
+		}
+	}
+
+	// Index of the first lane, over four vectors of four lanes each,
+	// holding the value found in all lanes of `target`.
+	std::uint32_t findFirstLane(__m128 const (&values)[4], __m128 const& target)
+	{
+		int mask = 0;
+		for (int i = 0; i < 4; ++i)
+			mask |= _mm_movemask_ps(_mm_cmpeq_ps(values[i], target)) << (4 * i);
+		std::uint32_t lane = 0u;
+		while (lane < 15u && (mask & (1 << lane)) == 0)
+			++lane;
+		return lane;
+	}
+
+	// The projections are computed with the same operations, in the same
+	// order, as the scalar version, so that they match it bit for bit.
+	void findExtremeTexelsSse2(texel_block const& block, std::array<float, 3> const& axis,
+	                           std::uint32_t& maximum_texel, std::uint32_t& minimum_texel)
+	{
+		auto const channel_mask = _mm_set1_epi32(0xff);
+		auto const axis_r = _mm_set1_ps(axis[0]);
+		auto const axis_g = _mm_set1_ps(axis[1]);
+		auto const axis_b = _mm_set1_ps(axis[2]);
+		__m128 projections[4];
+		for (std::uint32_t i = 0u; i < 4u; ++i) {
+			auto const texels = loadTexels(block, 4u * i);
+			auto const r = _mm_cvtepi32_ps(_mm_and_si128(texels, channel_mask));
+			auto const g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 8), channel_mask));
+			auto const b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 16), channel_mask));
+			projections[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, axis_r), _mm_mul_ps(g, axis_g)), _mm_mul_ps(b, axis_b));
+		}
+
+		auto maximum = _mm_max_ps(_mm_max_ps(projections[0], projections[1]), _mm_max_ps(projections[2], projections[3]));
+		auto minimum = _mm_min_ps(_mm_min_ps(projections[0], projections[1]), _mm_min_ps(projections[2], projections[3]));
+		maximum = _mm_max_ps(maximum, _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+		maximum = _mm_max_ps(maximum, _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+		minimum = _mm_min_ps(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+		minimum = _mm_min_ps(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+		maximum_texel = findFirstLane(projections, maximum);
+		minimum_texel = findFirstLane(projections, minimum);
+	}
+
+	// Errors are computed for four texels at a time, for all palette
+	// entries, keeping the first entry on ties as the scalar version does.
+	int pickColorIndicesSse2(texel_block const& block, color_palette const& palette, std::uint32_t& indices)
+	{
+		auto const zero = _mm_setzero_si128();
+		auto const color_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+		__m128i entries[4];
+		for (int j = 0; j < 4; ++j)
+			entries[j] = _mm_set_epi16(0, static_cast<short>(palette[j][2]), static_cast<short>(palette[j][1]), static_cast<short>(palette[j][0]),
+			                           0, static_cast<short>(palette[j][2]), static_cast<short>(palette[j][1]), static_cast<short>(palette[j][0]));
+
+		auto total_error = zero;
+		__m128i index_groups[4];
+		for (std::uint32_t i = 0u; i < 4u; ++i) {
+			auto const texels = loadTexels(block, 4u * i);
+			auto const low = _mm_and_si128(_mm_unpacklo_epi8(texels, zero), color_mask);
+			auto const high = _mm_and_si128(_mm_unpackhi_epi8(texels, zero), color_mask);
+			auto const get_errors = [&low,&high](__m128i const& entry){
+				auto const low_difference = _mm_sub_epi16(low, entry);
+				auto const high_difference = _mm_sub_epi16(high, entry);
+				// rr + gg and bb of each texel, then summed per texel.
+				auto const low_error = _mm_castsi128_ps(_mm_madd_epi16(low_difference, low_difference));
+				auto const high_error = _mm_castsi128_ps(_mm_madd_epi16(high_difference, high_difference));
+				return _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(low_error, high_error, _MM_SHUFFLE(2, 0, 2, 0))),
+				                     _mm_castps_si128(_mm_shuffle_ps(low_error, high_error, _MM_SHUFFLE(3, 1, 3, 1))));
+			};
+
+			auto best_error = get_errors(entries[0]);
+			auto best_index = zero;
+			for (int j = 1; j < 4; ++j) {
+				auto const error = get_errors(entries[j]);
+				auto const is_better = _mm_cmplt_epi32(error, best_error);
+				best_error = _mm_or_si128(_mm_and_si128(is_better, error), _mm_andnot_si128(is_better, best_error));
+				best_index = _mm_or_si128(_mm_and_si128(is_better, _mm_set1_epi32(j)), _mm_andnot_si128(is_better, best_index));
+			}
+			total_error = _mm_add_epi32(total_error, best_error);
+			index_groups[i] = best_index;
+		}
+
+		alignas(16) std::uint8_t texel_indices[constant::texels_per_block];
+		_mm_store_si128(reinterpret_cast<__m128i*>(texel_indices),
+		                _mm_packus_epi16(_mm_packs_epi32(index_groups[0], index_groups[1]),
+		                                 _mm_packs_epi32(index_groups[2], index_groups[3])));
+		indices = 0u;
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i)
+			indices |= static_cast<std::uint32_t>(texel_indices[i]) << (2u * i);
+
+		total_error = _mm_add_epi32(total_error, _mm_srli_si128(total_error, 8));
+		total_error = _mm_add_epi32(total_error, _mm_srli_si128(total_error, 4));
+		return _mm_cvtsi128_si32(total_error);
+	}
+
+	// Differences of 8-bit values stay within 8 bits once absolute, so
+	// the whole block gets handled at once.
+	std::uint64_t pickSingleChannelIndicesSse2(std::array<std::uint8_t, constant::texels_per_block> const& values,
+	                                           std::array<int, 8> const& palette)
+	{
+		auto const texels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(values.data()));
+		auto const get_errors = [&texels](int entry){
+			auto const value = _mm_set1_epi8(static_cast<char>(entry));
+			return _mm_or_si128(_mm_subs_epu8(texels, value), _mm_subs_epu8(value, texels));
+		};
+
+		auto best_error = get_errors(palette[0]);
+		auto best_index = _mm_setzero_si128();
+		for (int j = 1; j < 8; ++j) {
+			auto const error = get_errors(palette[j]);
+			auto const is_better = _mm_andnot_si128(_mm_cmpeq_epi8(error, best_error),
+			                                        _mm_cmpeq_epi8(_mm_min_epu8(error, best_error), error));
+			best_error = _mm_min_epu8(error, best_error);
+			best_index = _mm_or_si128(_mm_and_si128(is_better, _mm_set1_epi8(static_cast<char>(j))), _mm_andnot_si128(is_better, best_index));
+		}
+
+		alignas(16) std::uint8_t texel_indices[constant::texels_per_block];
+		_mm_store_si128(reinterpret_cast<__m128i*>(texel_indices), best_index);
+		std::uint64_t indices = 0u;
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i)
+			indices |= static_cast<std::uint64_t>(texel_indices[i]) << (3u * i);
+		return indices;
+	}
+#endif
+
+	void writeColorBlock(std::uint16_t c0, std::uint16_t c1, std::uint32_t indices, std::uint8_t* output)
+	{
+		output[0] = static_cast<std::uint8_t>(c0 & 0xff);
+		output[1] = static_cast<std::uint8_t>(c0 >> 8);
+		output[2] = static_cast<std::uint8_t>(c1 & 0xff);
+		output[3] = static_cast<std::uint8_t>(c1 >> 8);
+		for (int i = 0; i < 4; ++i)
+			output[4 + i] = static_cast<std::uint8_t>((indices >> (8 * i)) & 0xffu);
+	}
+
+	// Encode the first three channels of a block as a BC1 colour block,
+	// always in its four-colour mode so that it can be used in BC3 too.
+	void encodeColorBlock(texel_block const& block, bool use_simd, std::uint8_t* output)
+	{
+		color_sums sums;
+#if BLOCK_COMPRESSOR_HAS_SSE2
+		if (use_simd)
+			sumColorsSse2(block, sums);
+		else
+			sumColorsScalar(block, sums);
+#else
+		static_cast<void>(use_simd);
+		sumColorsScalar(block, sums);
+#endif
+		int const texels_nb = static_cast<int>(constant::texels_per_block);
+		std::array<float, 3> mean;
+		for (int c = 0; c < 3; ++c)
+			mean[c] = static_cast<float>(sums.sums[c]) / texels_nb;
+
+		// Principal axis of the texels, through power iterations on their
+		// covariance matrix, starting from the diagonal of their bounding
+		// box. The matrix is scaled by the squared number of texels, which
+		// keeps it in integers small enough for floats to hold exactly.
+		static int const product_channels[6][2] = { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 1, 1 }, { 1, 2 }, { 2, 2 } };
+		std::array<float, 6> covariance; // rr, rg, rb, gg, gb, bb
+		for (int i = 0; i < 6; ++i)
+			covariance[i] = static_cast<float>(texels_nb * sums.products[i]
+			                                   - sums.sums[product_channels[i][0]] * sums.sums[product_channels[i][1]]);
+		std::array<float, 3> axis = { static_cast<float>(sums.maximum[0] - sums.minimum[0]),
+		                              static_cast<float>(sums.maximum[1] - sums.minimum[1]),
+		                              static_cast<float>(sums.maximum[2] - sums.minimum[2]) };
+		for (int i = 0; i < constant::power_iterations_nb; ++i) {
+			std::array<float, 3> const next = {
+				covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+				covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+				covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+			};
+			auto const largest = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+			if (largest < 1e-6f)
+				break;
+			axis = { next[0] / largest, next[1] / largest, next[2] / largest };
+		}
+
+		// Start from the texels lying furthest along that axis.
+		std::uint32_t maximum_texel = 0u, minimum_texel = 0u;
+#if BLOCK_COMPRESSOR_HAS_SSE2
+		if (use_simd)
+			findExtremeTexelsSse2(block, axis, maximum_texel, minimum_texel);
+		else
+			findExtremeTexelsScalar(block, axis, maximum_texel, minimum_texel);
+#else
+		findExtremeTexelsScalar(block, axis, maximum_texel, minimum_texel);
+#endif
+		std::array<float, 3> endpoints[2];
+		for (int c = 0; c < 3; ++c) {
+			endpoints[0][c] = static_cast<float>(block[maximum_texel][c]);
+			endpoints[1][c] = static_cast<float>(block[minimum_texel][c]);
+		}
+
+		// Quantise the endpoints and pick the indices, then fit new
+		// endpoints to those indices by least squares and try again,
+		// keeping whichever attempt had the lowest error.
+		auto best_error = std::numeric_limits<int>::max();
+		std::uint16_t best_c0 = 0u, best_c1 = 0u;
+		std::uint32_t best_indices = 0u;
+		for (int refinement = 0; refinement <= constant::refinements_nb; ++refinement) {
+			auto c0 = packColor(endpoints[0]);
+			auto c1 = packColor(endpoints[1]);
+			if (c0 < c1) {
+				std::swap(c0, c1);
+				std::swap(endpoints[0], endpoints[1]);
+			}
+
+			// Equal endpoints would select the three-colour mode; a
+			// single colour only needs the first entry anyway.
+			std::uint32_t indices = 0u;
+			int error = 0;
+			if (c0 == c1) {
+				auto const color = unpackColor(c0);
+				for (auto const& texel : block)
+					for (int c = 0; c < 3; ++c)
+						error += (texel[c] - color[c]) * (texel[c] - color[c]);
+			} else {
+				auto const palette = getColorPalette(c0, c1);
+#if BLOCK_COMPRESSOR_HAS_SSE2
+				error = use_simd ? pickColorIndicesSse2(block, palette, indices)
+				                 : pickColorIndicesScalar(block, palette, indices);
+#else
+				error = pickColorIndicesScalar(block, palette, indices);
+#endif
+			}
+			if (error < best_error) {
+				best_error = error;
+				best_c0 = c0;
+				best_c1 = c1;
+				best_indices = indices;
+			}
+			if (error == 0 || c0 == c1 || refinement == constant::refinements_nb)
+				break;
+
+			// Each texel is `w * endpoints[0] + (1 - w) * endpoints[1]`.
+			static float const weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+			float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+			std::array<float, 3> ax = { 0.0f, 0.0f, 0.0f }, bx = { 0.0f, 0.0f, 0.0f };
+			for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i) {
+				auto const w = weights[(indices >> (2u * i)) & 0x3u];
+				aa += w * w;
+				bb += (1.0f - w) * (1.0f - w);
+				ab += w * (1.0f - w);
+				for (int c = 0; c < 3; ++c) {
+					ax[c] += w * block[i][c];
+					bx[c] += (1.0f - w) * block[i][c];
+				}
+			}
+			auto const determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f)
+				break;
+			for (int c = 0; c < 3; ++c) {
+				endpoints[0][c] = (bb * ax[c] - ab * bx[c]) / determinant;
+				endpoints[1][c] = (aa * bx[c] - ab * ax[c]) / determinant;
+			}
+		}
+
+		writeColorBlock(best_c0, best_c1, best_indices, output);
+	}
+
+	// Encode one channel of a block as a BC4 block, in its eight-value
+	// mode spanning the extremes of the block.
+	void encodeSingleChannelBlock(texel_block const& block, std::uint32_t channel, bool use_simd, std::uint8_t* output)
+	{
+		std::array<std::uint8_t, constant::texels_per_block> values;
+		std::uint8_t minimum = 255u, maximum = 0u;
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i) {
+			values[i] = block[i][channel];
+			minimum = std::min(minimum, values[i]);
+			maximum = std::max(maximum, values[i]);
+		}
+		output[0] = maximum;
+		output[1] = minimum;
+		std::uint64_t indices = 0u;
+		if (maximum != minimum) {
+			std::array<int, 8> palette;
+			palette[0] = maximum;
+			palette[1] = minimum;
+			for (int i = 2; i < 8; ++i)
+				palette[i] = ((8 - i) * maximum + (i - 1) * minimum + 3) / 7;
+#if BLOCK_COMPRESSOR_HAS_SSE2
+			indices = use_simd ? pickSingleChannelIndicesSse2(values, palette)
+			                   : pickSingleChannelIndicesScalar(values, palette);
+#else
+			static_cast<void>(use_simd);
+			indices = pickSingleChannelIndicesScalar(values, palette);
+#endif
+		}
+		for (int i = 0; i < 6; ++i)
+			output[2 + i] = static_cast<std::uint8_t>((indices >> (8 * i)) & 0xffu);
+	}
+
+	void decodeColorBlock(std::uint8_t const* input, bool is_four_color_only, texel_block& block)
+	{
+		auto const c0 = static_cast<std::uint16_t>(input[0] | (input[1] << 8));
+		auto const c1 = static_cast<std::uint16_t>(input[2] | (input[3] << 8));
+		auto const indices = static_cast<std::uint32_t>(input[4]) | (static_cast<std::uint32_t>(input[5]) << 8)
+		                   | (static_cast<std::uint32_t>(input[6]) << 16) | (static_cast<std::uint32_t>(input[7]) << 24);
+		auto palette = getColorPalette(c0, c1);
+		auto const is_three_color = !is_four_color_only && c0 <= c1;
+		if (is_three_color)
+			for (int c = 0; c < 3; ++c) {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i) {
+			auto const index = (indices >> (2u * i)) & 0x3u;
+			for (int c = 0; c < 3; ++c)
+				block[i][c] = static_cast<std::uint8_t>(palette[index][c]);
+			if (!is_four_color_only)
+				block[i][3] = is_three_color && index == 3u ? 0u : 255u;
+		}
+	}
+
+	void decodeSingleChannelBlock(std::uint8_t const* input, std::uint32_t channel, texel_block& block)
+	{
+		std::array<int, 8> palette;
+		palette[0] = input[0];
+		palette[1] = input[1];
+		if (palette[0] > palette[1]) {
+			for (int i = 2; i < 8; ++i)
+				palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1] + 3) / 7;
+		} else {
+			for (int i = 2; i < 6; ++i)
+				palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1] + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+		std::uint64_t indices = 0u;
+		for (int i = 0; i < 6; ++i)
+			indices |= static_cast<std::uint64_t>(input[2 + i]) << (8 * i);
+		for (std::uint32_t i = 0u; i < constant::texels_per_block; ++i)
+			block[i][channel] = static_cast<std::uint8_t>(palette[(indices >> (3u * i)) & 0x7u]);
+	}
+
+	void encodeBlock(texel_block const& block, bonobo::block_format_t format, bool use_simd, std::uint8_t* output)
+	{
+		switch (format) {
+		case bonobo::block_format_t::bc1:
+			encodeColorBlock(block, use_simd, output);
+			break;
+		case bonobo::block_format_t::bc3:
+			encodeSingleChannelBlock(block, 3u, use_simd, output);
+			encodeColorBlock(block, use_simd, output + 8);
+			break;
+		case bonobo::block_format_t::bc4:
+			encodeSingleChannelBlock(block, 0u, use_simd, output);
+			break;
+		case bonobo::block_format_t::bc5:
+			encodeSingleChannelBlock(block, 0u, use_simd, output);
+			encodeSingleChannelBlock(block, 1u, use_simd, output + 8);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+
+	void decodeBlock(std::uint8_t const* input, bonobo::block_format_t format, texel_block& block)
+	{
+		switch (format) {
+		case bonobo::block_format_t::bc1:
+			decodeColorBlock(input, false, block);
+			break;
+		case bonobo::block_format_t::bc3:
+			decodeSingleChannelBlock(input, 3u, block);
+			decodeColorBlock(input + 8, true, block);
+			break;
+		case bonobo::block_format_t::bc4:
+			decodeSingleChannelBlock(input, 0u, block);
+			break;
+		case bonobo::block_format_t::bc5:
+			decodeSingleChannelBlock(input, 0u, block);
+			decodeSingleChannelBlock(input + 8, 1u, block);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+
+	void encodeLevel(bonobo::mipmapped_image::level const& source, std::uint32_t channels_nb,
+	                 bonobo::block_format_t format, std::uint8_t* destination,
+	                 bonobo::block_compressor::execution_policy const& policy)
+	{
+		auto const blocks_per_row = getBlocksNb(source.width);
+		auto const block_rows_nb = getBlocksNb(source.height);
+		auto const block_size = bonobo::block_compressor::getBlockSize(format);
+		auto const use_simd = policy.use_simd && bonobo::block_compressor::hasSimd();
+		auto const encode_rows = [&](std::uint32_t first_row, std::uint32_t last_row){
+			texel_block block;
+			for (auto block_y = first_row; block_y < last_row; ++block_y)
+				for (std::uint32_t block_x = 0u; block_x < blocks_per_row; ++block_x) {
+					extractBlock(source, channels_nb, block_x, block_y, block);
+					encodeBlock(block, format, use_simd, destination + (static_cast<std::size_t>(block_y) * blocks_per_row + block_x) * block_size);
+				}
+		};
+
+		// Workers waiting on tasks queued behind them on their own pool
+		// could all end up waiting, hence encoding the whole level right
+		// away.
+		std::size_t bands_nb = 1u;
+		if (policy.use_thread_pool) {
+			auto const& thread_pool = ThreadPool::GetShared();
+			if (!thread_pool.IsWorkerThread()) {
+				auto const blocks_nb = static_cast<std::size_t>(blocks_per_row) * block_rows_nb;
+				bands_nb = std::min({ blocks_nb / constant::min_blocks_per_band,
+				                      static_cast<std::size_t>(block_rows_nb),
+				                      thread_pool.GetThreadCount() + 1u });
+			}
+		}
+		if (bands_nb <= 1u) {
+			encode_rows(0u, block_rows_nb);
+			return;
+		}
+
+		// The calling thread takes the first band rather than idling.
+		auto& thread_pool = ThreadPool::GetShared();
+		auto const band_start = [block_rows_nb,bands_nb](std::size_t band){
+			return static_cast<std::uint32_t>(block_rows_nb * band / bands_nb);
+		};
+		std::vector<std::future<void>> pending_bands;
+		pending_bands.reserve(bands_nb - 1u);
+		for (std::size_t band = 1u; band < bands_nb; ++band) {
+			auto const first_row = band_start(band);
+			auto const last_row = band_start(band + 1u);
+			pending_bands.push_back(thread_pool.Enqueue([&encode_rows,first_row,last_row](){ encode_rows(first_row, last_row); }));
+		}
+		encode_rows(0u, band_start(1u));
+
+		// Wait for all bands before letting any exception through, as they
+		// all reference this frame.
+		for (auto& band : pending_bands)
+			band.wait();
+		for (auto& band : pending_bands)
+			band.get();
+	}
+}
+
+bool
+bonobo::block_compressor::hasSimd()
+{
+	return BLOCK_COMPRESSOR_HAS_SSE2 != 0;
+}
+
+std::uint32_t
+bonobo::block_compressor::getBlockSize(block_format_t format)
+{
+	switch (format) {
+	case block_format_t::bc1:
+	case block_format_t::bc4: return 8u;
+	case block_format_t::bc3:
+	case block_format_t::bc5: return 16u;
+	default:                  return 0u;
+	}
+}
+
+std::size_t
+bonobo::block_compressor::getCompressedSize(block_format_t format, std::uint32_t width, std::uint32_t height)
+{
+	return static_cast<std::size_t>(getBlocksNb(width)) * getBlocksNb(height) * getBlockSize(format);
+}
+
+bonobo::block_format_t
+bonobo::block_compressor::getFormat(mipmapped_image const& image)
+{
+	if (image.levels.empty() || image.format != block_format_t::none)
+		return block_format_t::none;
+
+	switch (image.channels_nb) {
+	case 1u: return block_format_t::bc4;
+	case 2u: return block_format_t::bc5;
+	case 4u: break;
+	default: return block_format_t::none;
+	}
+
+	auto const& level = image.levels.front();
+	auto const texels_nb = static_cast<std::size_t>(level.width) * level.height;
+	for (std::size_t i = 0u; i < texels_nb; ++i)
+		if (level.texels[i * 4u + 3u] != 255u)
+			return block_format_t::bc3;
+	return block_format_t::bc1;
+}
+
+bonobo::mipmapped_image
+bonobo::block_compressor::compress(mipmapped_image const& image, block_format_t format,
+                                   execution_policy const& policy)
+{
+	assert(image.format == block_format_t::none);
+	assert(format != block_format_t::none);
+
+	mipmapped_image compressed;
+	compressed.channels_nb = image.channels_nb;
+	compressed.format = format;
+	if (image.levels.empty())
+		return compressed;
+
+	std::size_t size = 0u;
+	for (auto const& level : image.levels)
+		size += getCompressedSize(format, level.width, level.height);
+	auto block = allocateImageBuffer(size);
+	auto* blocks = block.get();
+	for (auto const& level : image.levels) {
+		encodeLevel(level, image.channels_nb, format, blocks, policy);
+		compressed.levels.push_back({ level.width, level.height, blocks });
+		blocks += getCompressedSize(format, level.width, level.height);
+	}
+	compressed.storage.push_back(std::move(block));
+
+	return compressed;
+}
+
+bonobo::mipmapped_image
+bonobo::block_compressor::decompress(mipmapped_image const& image)
+{
+	mipmapped_image decompressed;
+	decompressed.channels_nb = image.channels_nb;
+	if (image.levels.empty() || image.format == block_format_t::none)
+		return decompressed;
+
+	std::size_t size = 0u;
+	for (auto const& level : image.levels)
+		size += static_cast<std::size_t>(level.width) * level.height * image.channels_nb;
+	auto block = allocateImageBuffer(size);
+	auto* texels = block.get();
+	auto const block_size = getBlockSize(image.format);
+	texel_block decoded;
+	for (auto const& level : image.levels) {
+		auto const blocks_per_row = getBlocksNb(level.width);
+		auto const* blocks = level.texels;
+		for (std::uint32_t block_y = 0u; block_y < getBlocksNb(level.height); ++block_y)
+			for (std::uint32_t block_x = 0u; block_x < blocks_per_row; ++block_x, blocks += block_size) {
+				decodeBlock(blocks, image.format, decoded);
+				storeBlock(decoded, image.channels_nb, block_x, block_y, texels, level.width, level.height);
+			}
+		decompressed.levels.push_back({ level.width, level.height, texels });
+		texels += static_cast<std::size_t>(level.width) * level.height * image.channels_nb;
+	}
+	decompressed.storage.push_back(std::move(block));
+
+	return decompressed;
+}
+
+float
+bonobo::block_compressor::computePsnr(mipmapped_image const& original, mipmapped_image const& compressed)
+{
+	assert(!original.levels.empty() && !compressed.levels.empty());
+	assert(original.channels_nb == compressed.channels_nb);
+
+	auto const& original_level = original.levels.front();
+	auto const& compressed_level = compressed.levels.front();
+	auto const channels_nb = original.channels_nb;
+	auto const blocks_per_row = getBlocksNb(compressed_level.width);
+	auto const block_size = getBlockSize(compressed.format);
+	std::uint64_t squared_error = 0u;
+	texel_block decoded;
+	auto const* blocks = compressed_level.texels;
+	for (std::uint32_t block_y = 0u; block_y < getBlocksNb(compressed_level.height); ++block_y)
+		for (std::uint32_t block_x = 0u; block_x < blocks_per_row; ++block_x, blocks += block_size) {
+			decodeBlock(blocks, compressed.format, decoded);
+			for (std::uint32_t y = 0u; y < constant::block_width; ++y) {
+				auto const texel_y = block_y * constant::block_width + y;
+				if (texel_y >= original_level.height)
+					break;
+				for (std::uint32_t x = 0u; x < constant::block_width; ++x) {
+					auto const texel_x = block_x * constant::block_width + x;
+					if (texel_x >= original_level.width)
+						break;
+					auto const* const texel = original_level.texels + (static_cast<std::size_t>(texel_y) * original_level.width + texel_x) * channels_nb;
+					for (std::uint32_t c = 0u; c < channels_nb; ++c) {
+						auto const difference = static_cast<int>(texel[c]) - decoded[y * constant::block_width + x][c];
+						squared_error += static_cast<std::uint64_t>(difference * difference);
+					}
+				}
+			}
+		}
+
+	if (squared_error == 0u)
+		return std::numeric_limits<float>::infinity();
+	auto const samples_nb = static_cast<double>(original_level.width) * original_level.height * channels_nb;
+	auto const mean_squared_error = static_cast<double>(squared_error) / samples_nb;
+	return static_cast<float>(10.0 * std::log10(255.0 * 255.0 / mean_squared_error));
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "texture_cache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bonobo
+{
+	namespace block_compressor
+	{
+		//! \brief How the work gets done; it does not affect the output.
+		struct execution_policy {
+			//! Use the SSE2 code paths, when compiled in, for the
+			//! endpoint search and the index selection.
+			bool use_simd{ true };
+
+			//! Split large levels into bands of block rows encoded on
+			//! `ThreadPool::GetShared()`; ignored when called from one of
+			//! its workers, which then encodes the whole level itself.
+			bool use_thread_pool{ true };
+		};
+
+		//! \brief Whether SIMD code paths were compiled in.
+		bool hasSimd();
+
+		//! \brief Number of bytes of each 4×4 block of a format, or 0 for
+		//!        `block_format_t::none`.
+		std::uint32_t getBlockSize(block_format_t format);
+
+		//! \brief Number of bytes taken by a level of a given size once
+		//!        compressed; partial blocks on the right and bottom
+		//!        edges take as much space as full ones.
+		std::size_t getCompressedSize(block_format_t format, std::uint32_t width, std::uint32_t height);
+
+		//! \brief Format an image would get compressed to: BC4 for one
+		//!        channel, BC5 for two, and BC1 or BC3 for four depending
+		//!        on whether the first level has any texel that is not
+		//!        fully opaque.
+		//!
+		//! @return `block_format_t::none` for images that are already
+		//!         compressed, have no levels, or have three channels
+		block_format_t getFormat(mipmapped_image const& image);
+
+		//! \brief Compress all levels of an image.
+		//!
+		//! Colour endpoints are fitted along the principal axis of each
+		//! block, then refined by least squares; single channels use
+		//! their extremes and the eight-value mode. Texels past the edges
+		//! of levels that are not a multiple of 4 wide or high are
+		//! clamped to them.
+		//!
+		//! @param [in] image uncompressed image, with as many channels as
+		//!             `format` covers
+		//! @param [in] format format to compress to
+		//! @param [in] policy how to spread the work
+		//! @return the compressed image, with all its levels in a single
+		//!         block of `storage`
+		mipmapped_image compress(mipmapped_image const& image, block_format_t format,
+		                         execution_policy const& policy = execution_policy());
+
+		//! \brief Expand all levels of a compressed image back to texels,
+		//!        e.g. when the driver does not support its format.
+		mipmapped_image decompress(mipmapped_image const& image);
+
+		//! \brief Peak signal-to-noise ratio of the first level of a
+		//!        compressed image with respect to the original one, over
+		//!        all their channels.
+		//!
+		//! @return the ratio in decibels, higher being better; infinite
+		//!         if both images are identical
+		float computePsnr(mipmapped_image const& original, mipmapped_image const& compressed);
+	}
+}
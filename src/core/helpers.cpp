@@ -1,21 +1,39 @@
+#include "block_compressor.hpp"
 #include "config.hpp"
+#include "GeometryArena.hpp"
 #include "helpers.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "meshlet_builder.hpp"
+#include "mesh_upload.hpp"
+#include "object_cache.hpp"
+#include "scene_import.hpp"
+#include "texture_cache.hpp"
+#include "texture_upload.hpp"
+#include "TextureRegistry.hpp"
 
 #include "core/Log.h"
 #include "core/opengl.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/UploadManager.hpp"
 #include "core/various.hpp"
 
 #include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
-#include <stb_image.h>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iterator>
 #include <memory>
+#include <unordered_map>
 
 namespace
 {
@@ -71,6 +89,21 @@ bonobo::init()
 void
 bonobo::deinit()
 {
+	auto& texture_registry = TextureRegistry::GetShared();
+	auto const registry_stats = texture_registry.GetStatistics();
+	LogInfo("Texture registry: %zu hits, %zu misses, %.3f MiB saved; %zu textures (%.3f MiB) still registered",
+	        registry_stats.hits, registry_stats.misses, registry_stats.bytes_saved / (1024.0 * 1024.0),
+	        registry_stats.textures_nb, registry_stats.bytes_resident / (1024.0 * 1024.0));
+	texture_registry.Clear();
+
+	auto const arena_stats = GeometryArena::GetShared().GetStatistics();
+	LogInfo("Geometry arena: %zu meshes in %zu pages, %.3f MiB used out of %.3f MiB (%.3f MiB released for reuse)",
+	        arena_stats.meshes_nb, arena_stats.pages_nb, arena_stats.bytes_used / (1024.0 * 1024.0),
+	        arena_stats.bytes_reserved / (1024.0 * 1024.0), arena_stats.bytes_released / (1024.0 * 1024.0));
+	GeometryArena::DestroyShared();
+
+	UploadManager::DestroyShared();
+
 	glDeleteTextures(1, &debug_texture_id);
 	debug_texture_id = 0u;
 
@@ -83,277 +116,418 @@ bonobo::deinit()
 	glDeleteVertexArrays(1, &local::display_vao);
 }
 
-static std::vector<std::uint8_t>
-getTextureData(std::string const& filename, std::uint32_t& width, std::uint32_t& height, bool flip)
+namespace
 {
-	auto const channels_nb = 4u;
-	stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
-	unsigned char* image_data = stbi_load(filename.c_str(), reinterpret_cast<int*>(&width), reinterpret_cast<int*>(&height), nullptr, channels_nb);
-	if (image_data == nullptr) {
-		LogWarning("Couldn't load or decode image file %s", filename.c_str());
+	struct decoded_image {
+		bonobo::mipmapped_image image;
+		bonobo::texture_cache::load_report report;
+	};
+
+	struct processed_mesh {
+		bonobo::mesh_optimizer::statistics optimization;
+		std::vector<bonobo::meshlet> meshlets;
+	};
+
+	// Waits on all the tasks of a vector when going out of scope, so
+	// that tasks referencing locals of the caller are done with them
+	// before an exception unwinds its frame.
+	template<typename T>
+	struct pending_tasks_guard {
+		explicit pending_tasks_guard(std::vector<std::future<T>>& tasks) : tasks(tasks) {}
+		~pending_tasks_guard()
+		{
+			for (auto& task : tasks)
+				if (task.valid())
+					task.wait();
+		}
 
-		// Provide a small empty image instead in case of failure.
-		width = 16;
-		height = 16;
-		return std::vector<unsigned char>(width * height * channels_nb);
+		std::vector<std::future<T>>& tasks;
+	};
+
+	// Neither touches OpenGL nor logs, so that it can run on worker
+	// threads; `image.levels` is left empty on failure.
+	decoded_image decodeImage(std::string const& filename, bool flip, bonobo::mip_settings const& mips,
+	                          bonobo::texture_role_t role, bool compress, bool use_cache)
+	{
+		decoded_image decoded;
+		decoded.image = bonobo::texture_cache::load(filename, flip, mips, role, compress, use_cache, decoded.report);
+		return decoded;
+	}
+
+	void addToStatistics(std::string const& filename, bonobo::mipmapped_image const& image,
+	                     bonobo::texture_cache::load_report const& report, bonobo::load_statistics* statistics)
+	{
+		if (statistics == nullptr)
+			return;
+		statistics->decode_time_ms += report.decode_time_ms;
+		statistics->mip_generation_time_ms += report.mip_generation_time_ms;
+		statistics->compression_time_ms += report.compression_time_ms;
+		++statistics->images_nb;
+		if (report.was_cached)
+			++statistics->images_from_cache_nb;
+		if (image.format != bonobo::block_format_t::none)
+			statistics->compressed_images.push_back({ filename, image.format, report.psnr_db });
+	}
+
+	// E.g. ", BC1 at 38.42 dB", for appending to the logs of an image.
+	std::string describeCompression(bonobo::mipmapped_image const& image, bonobo::texture_cache::load_report const& report)
+	{
+		if (image.format == bonobo::block_format_t::none)
+			return "";
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), ", %s at %.2f dB", bonobo::getBlockFormatName(image.format), report.psnr_db);
+		return buffer;
 	}
+}
+
+static void
+replaceFailedImage(std::string const& filename, bonobo::mipmapped_image& image)
+{
+	if (!image.levels.empty())
+		return;
+
+	LogWarning("Couldn't load or decode image file %s", filename.c_str());
+
+	// Provide a small empty image instead in case of failure.
+	auto const width = 16u;
+	auto const height = 16u;
+	auto texels = bonobo::allocateImageBuffer(width * height * 4u);
+	std::memset(texels.get(), 0, width * height * 4u);
+	image.channels_nb = 4u;
+	image.levels.push_back({ width, height, texels.get() });
+	image.storage.push_back(std::move(texels));
+	bonobo::texture_cache::generateMipChain(image);
+}
 
-	std::vector<unsigned char> image(width * height * channels_nb);
-	std::memcpy(image.data(), image_data, image.size());
-	stbi_image_free(image_data);
+static bonobo::mipmapped_image
+getTextureData(std::string const& filename, bool flip, bonobo::mip_settings const& mips,
+               bonobo::texture_role_t role, bool compress, bool use_cache, bonobo::load_statistics* statistics)
+{
+	bonobo::texture_cache::load_report report;
+	auto image = bonobo::texture_cache::load(filename, flip, mips, role, compress, use_cache, report);
+	addToStatistics(filename, image, report, statistics);
+	replaceFailedImage(filename, image);
+	if (image.format != bonobo::block_format_t::none)
+		LogTrivia("Texture \"%s\" compressed to %s at %.2f dB", filename.c_str(),
+		          bonobo::getBlockFormatName(image.format), report.psnr_db);
 
 	return image;
 }
 
 std::vector<bonobo::mesh_data>
-bonobo::loadObjects(std::string const& filename)
+bonobo::loadObjects(std::string const& filename, object_load_options const& options,
+                    load_statistics* statistics)
+{
+	return loadScene(filename, options, statistics).meshes;
+}
+
+bonobo::scene_data
+bonobo::loadScene(std::string const& filename, object_load_options const& options,
+                  load_statistics* statistics)
 {
 	auto const scene_start_time = std::chrono::high_resolution_clock::now();
 
-	std::vector<bonobo::mesh_data> objects;
+	scene_data loaded_scene;
+	auto& objects = loaded_scene.meshes;
 
 	auto const end_of_basedir = filename.rfind("/");
 	auto const parent_folder = (end_of_basedir != std::string::npos ? filename.substr(0, end_of_basedir) : ".") + "/";
+
+	// The importer owns the data pointed to by `scene` when not reading
+	// from the cache, so it needs to outlive it.
 	Assimp::Importer importer;
-	auto const assimp_scene = importer.ReadFile(filename, aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_CalcTangentSpace);
-	if (assimp_scene == nullptr || assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || assimp_scene->mRootNode == nullptr) {
-		LogError("Assimp failed to load \"%s\": %s", filename.c_str(), importer.GetErrorString());
-		return objects;
+	scene_source scene;
+	scene_import_report import_report;
+	bool const is_imported = importScene(filename, options.use_object_cache, importer, scene, import_report);
+	logSceneImportReport(import_report);
+	if (!is_imported)
+		return loaded_scene;
+
+	LogInfo("┭ Loading \"%s\"…", filename.c_str());
+	LogTrivia("│ %s in %.3f ms",
+	          import_report.is_from_cache ? "Cache mapped" : "Scene imported",
+	          import_report.import_time_ms);
+	if (statistics != nullptr) {
+		statistics->import_time_ms += import_report.import_time_ms;
+		++statistics->scenes_nb;
+		if (import_report.is_from_cache)
+			++statistics->scenes_from_cache_nb;
 	}
 
-	if (assimp_scene->mNumMeshes == 0u) {
-		LogError("No mesh available; loading \"%s\" must have had issues", filename.c_str());
-		return objects;
+	auto const materials_start_time = std::chrono::high_resolution_clock::now();
+
+	// Gather all the textures used by the scene first, so that their
+	// decoding can be started ahead of the uploads; an image referenced
+	// by multiple materials is only decoded once per role.
+	std::vector<std::vector<size_t>> materials_image_indices(scene.materials.size());
+	std::vector<std::string> image_paths;
+	std::vector<texture_role_t> image_roles;
+	std::vector<uint32_t> image_uses;
+	std::unordered_map<std::string, size_t> image_indices;
+	for (size_t i = 0; i < scene.materials.size(); ++i) {
+		if (!scene.materials[i].is_used)
+			continue;
+
+		for (auto const& texture : scene.materials[i].textures) {
+			auto const full_path = parent_folder + texture.path;
+			auto const role = options.use_texture_roles ? getTextureRole(texture) : texture_role_t::generic;
+			auto const image_index_it = image_indices.emplace(full_path + '\n' + std::to_string(static_cast<uint32_t>(role)), image_paths.size());
+			if (image_index_it.second) {
+				image_paths.push_back(full_path);
+				image_roles.push_back(role);
+				image_uses.push_back(0u);
+			}
+			++image_uses[image_index_it.first->second];
+			materials_image_indices[i].push_back(image_index_it.first->second);
+		}
 	}
 
-	LogInfo("┭ Loading \"%s\"…", filename.c_str());
+	// Images already uploaded by a previous load need not be decoded.
+	auto& texture_registry = TextureRegistry::GetShared();
+	std::vector<std::string> image_keys(image_paths.size());
+	std::vector<bool> are_images_needed(image_paths.size(), true);
+	size_t needed_images_nb = image_paths.size();
+	if (options.use_texture_registry) {
+		for (size_t k = 0; k < image_paths.size(); ++k) {
+			image_keys[k] = TextureRegistry::MakeKey(image_paths[k], texture_key_flipped | texture_key_mipmapped | getTextureKeyFlags(image_roles[k])
+			                                                         | (options.compress_textures ? texture_key_compressed : 0u));
+			if (texture_registry.Contains(image_keys[k])) {
+				are_images_needed[k] = false;
+				--needed_images_nb;
+			}
+		}
+	}
 
-	std::vector<bool> are_materials_used(assimp_scene->mNumMaterials, false);
-	for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j) {
-		auto const assimp_object_mesh = assimp_scene->mMeshes[j];
-		auto const material_id = assimp_object_mesh->mMaterialIndex;
-		if (material_id >= assimp_scene->mNumMaterials)
-			LogError("Mesh \"%s\" has a material index of %u, but only %u materials are present.", assimp_object_mesh->mName.C_Str(), material_id, assimp_scene->mNumMaterials);
-		else
-			are_materials_used[material_id] = true;
+	std::vector<std::future<decoded_image>> pending_images(image_paths.size());
+	if (options.parallel_texture_decoding) {
+		auto& thread_pool = ThreadPool::GetShared();
+		for (size_t k = 0; k < image_paths.size(); ++k) {
+			if (!are_images_needed[k])
+				continue;
+			// Everything is captured by value, so that the task does not
+			// depend on this frame outliving it.
+			auto const image_path = image_paths[k];
+			auto const role = image_roles[k];
+			auto const compress = options.compress_textures;
+			auto const use_texture_cache = options.use_texture_cache;
+			pending_images[k] = thread_pool.Enqueue([image_path,role,compress,use_texture_cache](){
+				return decodeImage(image_path, true, mip_settings(), role, compress, use_texture_cache);
+			});
+		}
+		LogTrivia("│ Decoding %zu images on %zu threads", needed_images_nb, thread_pool.GetThreadCount());
 	}
 
-	auto const materials_start_time = std::chrono::high_resolution_clock::now();
-	std::vector<texture_bindings> materials_bindings(assimp_scene->mNumMaterials);
-	std::vector<material_data> material_constants(assimp_scene->mNumMaterials);
+	// The meshes are optimised, split into meshlets and simplified on
+	// the thread pool while the textures get uploaded, behind the image
+	// decodes.
+	bool const is_processing_meshes = options.optimize_meshes || options.build_meshlets || options.build_lods;
+	std::vector<std::future<processed_mesh>> pending_processings(scene.meshes.size());
+	pending_tasks_guard<processed_mesh> const processings_guard(pending_processings);
+	if (is_processing_meshes) {
+		auto& thread_pool = ThreadPool::GetShared();
+		for (size_t j = 0; j < scene.meshes.size(); ++j) {
+			auto& mesh = scene.meshes[j];
+			pending_processings[j] = thread_pool.Enqueue([&mesh,&options](){
+				processed_mesh processed;
+				if (options.optimize_meshes)
+					processed.optimization = mesh_optimizer::optimize(mesh);
+				if (options.build_meshlets)
+					processed.meshlets = meshlet_builder::build(mesh);
+				if (options.optimize_meshes && options.build_meshlets)
+					mesh_optimizer::optimizeMeshlets(mesh, processed.meshlets, processed.optimization);
+				if (options.build_lods)
+					mesh.lods = mesh_simplifier::build(mesh);
+				return processed;
+			});
+		}
+	}
+
+	std::vector<decoded_image> images(image_paths.size());
+	std::vector<bool> are_images_decoded(image_paths.size(), false);
+	float images_decode_time_ms = 0.0f;
+	float textures_upload_time_ms = 0.0f;
+	std::uint64_t textures_size = 0u;
+	std::uint64_t rgba_textures_size = 0u; // what they would have taken without roles nor compression
+
+	std::vector<texture_bindings> materials_bindings(scene.materials.size());
 	uint32_t texture_count = 0u;
-	for (size_t i = 0; i < assimp_scene->mNumMaterials; ++i) {
-		if (!are_materials_used[i])
+	uint32_t shared_texture_count = 0u;
+	for (size_t i = 0; i < scene.materials.size(); ++i) {
+		auto const& material = scene.materials[i];
+		if (!material.is_used)
 			continue;
 
 		auto const material_start_time = std::chrono::high_resolution_clock::now();
 		texture_bindings& bindings = materials_bindings[i];
-		material_data& constants = material_constants[i];
-		auto const material = assimp_scene->mMaterials[i];
-
-		auto const process_texture = [&bindings,&material,i,&parent_folder,&texture_count](aiTextureType type, std::string const& type_as_str, std::string const& name){
-			if (material->GetTextureCount(type)) {
-				auto const texture_start_time = std::chrono::high_resolution_clock::now();
-
-				if (material->GetTextureCount(type) > 1)
-					LogWarning("Material \"%s\" has more than one %s texture: discarding all but the first one.", material->GetName().C_Str(), type_as_str.c_str());
-				aiString path;
-				material->GetTexture(type, 0, &path);
-				auto const id = bonobo::loadTexture2D(parent_folder + std::string(path.C_Str()));
-				if (id == 0u) {
-					LogWarning("Failed to load the %s texture for material \"%s\".", type_as_str.c_str(), material->GetName().C_Str());
-					return;
+
+		for (size_t t = 0; t < material.textures.size(); ++t) {
+			auto const& texture = material.textures[t];
+			auto const k = materials_image_indices[i][t];
+
+			if (options.use_texture_registry) {
+				auto const shared_id = texture_registry.Acquire(image_keys[k]);
+				if (shared_id != 0u) {
+					bindings.emplace(texture.name, shared_id);
+					++texture_count;
+					++shared_texture_count;
+					LogTrivia("│ %s Texture \"%s\" shared with a previously loaded one",
+					          bindings.size() == 1 ? "┌" : "├", texture.path.c_str());
+					continue;
 				}
-				bindings.emplace(name, id);
-				++texture_count;
+			}
 
-				utils::opengl::debug::nameObject(GL_TEXTURE, id, std::string(material->GetName().C_Str()) + " " + type_as_str);
+			auto const wait_start_time = std::chrono::high_resolution_clock::now();
+			if (!are_images_decoded[k]) {
+				images[k] = options.parallel_texture_decoding ? pending_images[k].get()
+				                                              : decodeImage(image_paths[k], true, mip_settings(), image_roles[k],
+				                                                            options.compress_textures, options.use_texture_cache);
+				are_images_decoded[k] = true;
+				images_decode_time_ms += images[k].report.decode_time_ms + images[k].report.mip_generation_time_ms
+				                       + images[k].report.compression_time_ms;
+				addToStatistics(image_paths[k], images[k].image, images[k].report, statistics);
+				if (images[k].image.levels.empty())
+					LogWarning("Couldn't load or decode image file %s", image_paths[k].c_str());
+			}
+			auto const wait_end_time = std::chrono::high_resolution_clock::now();
+
+			auto const& decoded = images[k];
+			auto const decode_time_ms = decoded.report.decode_time_ms + decoded.report.mip_generation_time_ms
+			                          + decoded.report.compression_time_ms;
+			auto const was_cached = decoded.report.was_cached;
+			auto const compression = describeCompression(decoded.image, decoded.report);
+			GLuint id = 0u;
+			std::uint64_t texture_size = 0u;
+			if (!decoded.image.levels.empty()) {
+				id = uploadTexture2D(decoded.image, true, image_roles[k]);
+				texture_size = getUploadedSize(decoded.image, true);
+				textures_size += texture_size;
+				rgba_textures_size += getRgbaSize(decoded.image, true);
+			}
 
-				auto const texture_end_time = std::chrono::high_resolution_clock::now();
-				LogTrivia("│ %s Texture \"%s\" loaded in %.3f ms",
-				          bindings.size() == 1 ? "┌" : "├", path.C_Str(),
-				          std::chrono::duration<float, std::milli>(texture_end_time - texture_start_time).count());
+			// Release the decoded texels as soon as no other material
+			// needs them; with the registry, the other materials will
+			// share the texture instead.
+			if (options.use_texture_registry) {
+				if (id != 0u)
+					texture_registry.Insert(image_keys[k], id, texture_size);
+				images[k] = decoded_image();
+			} else if (--image_uses[k] == 0u) {
+				images[k] = decoded_image();
 			}
-		};
 
-		aiColor3D color;
-
-		material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-		constants.diffuse = glm::vec3(color.r, color.g, color.b);
-		material->Get(AI_MATKEY_COLOR_SPECULAR, color);
-		constants.specular = glm::vec3(color.r, color.g, color.b);
-		material->Get(AI_MATKEY_COLOR_AMBIENT, color);
-		constants.ambient = glm::vec3(color.r, color.g, color.b);
-		material->Get(AI_MATKEY_COLOR_EMISSIVE, color);
-		constants.emissive = glm::vec3(color.r, color.g, color.b);
-		material->Get(AI_MATKEY_SHININESS, constants.shininess);
-		material->Get(AI_MATKEY_REFRACTI, constants.indexOfRefraction);
-		material->Get(AI_MATKEY_OPACITY, constants.opacity);
-
-		process_texture(aiTextureType_DIFFUSE,  "diffuse",  "diffuse_texture");
-		process_texture(aiTextureType_SPECULAR, "specular", "specular_texture");
-		process_texture(aiTextureType_NORMALS,  "normals",  "normals_texture");
-		process_texture(aiTextureType_OPACITY,  "opacity",  "opacity_texture");
-		process_texture(aiTextureType_EMISSIVE,  "emissive",  "emissive_texture");
+			if (id == 0u) {
+				LogWarning("Failed to load the %s texture for material \"%s\".", texture.type_as_str.c_str(), material.name.c_str());
+				continue;
+			}
+			bindings.emplace(texture.name, id);
+			++texture_count;
+
+			utils::opengl::debug::nameObject(GL_TEXTURE, id, material.name + " " + texture.type_as_str);
+
+			auto const upload_end_time = std::chrono::high_resolution_clock::now();
+			auto const upload_time_ms = std::chrono::duration<float, std::milli>(upload_end_time - wait_end_time).count();
+			textures_upload_time_ms += upload_time_ms;
+			LogTrivia("│ %s Texture \"%s\" %s in %.3f ms (waited %.3f ms) and uploaded in %.3f ms%s",
+			          bindings.size() == 1 ? "┌" : "├", texture.path.c_str(),
+			          was_cached ? "read from cache" : "decoded", decode_time_ms,
+			          std::chrono::duration<float, std::milli>(wait_end_time - wait_start_time).count(),
+			          upload_time_ms, compression.c_str());
+		}
 
 		auto const material_end_time = std::chrono::high_resolution_clock::now();
 		LogTrivia("│ %s Material \"%s\" loaded in %.3f ms",
-		          bindings.empty() ? "╺" : "┕", material->GetName().C_Str(),
+		          bindings.empty() ? "╺" : "┕", material.name.c_str(),
 		          std::chrono::duration<float, std::milli>(material_end_time - material_start_time).count());
 	}
 	auto const materials_end_time = std::chrono::high_resolution_clock::now();
 
 	auto const meshes_start_time = std::chrono::high_resolution_clock::now();
-	objects.reserve(assimp_scene->mNumMeshes);
-	for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j) {
+	meshlet_builder::statistics meshlet_stats;
+	float meshes_upload_time_ms = 0.0f;
+	objects.reserve(scene.meshes.size());
+	for (size_t j = 0; j < scene.meshes.size(); ++j) {
 		auto const mesh_start_time = std::chrono::high_resolution_clock::now();
 
-		auto const assimp_object_mesh = assimp_scene->mMeshes[j];
-
-		if (!assimp_object_mesh->HasFaces()) {
-			LogError("Unsupported mesh \"%s\": has no faces", assimp_object_mesh->mName.C_Str());
-			continue;
-		}
-		if ((assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_POINT | aiPrimitiveType_NGONEncodingFlag))    != 0u
-		 && (assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_LINE | aiPrimitiveType_NGONEncodingFlag))     != 0u
-		 && (assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_TRIANGLE | aiPrimitiveType_NGONEncodingFlag)) != 0u) {
-			LogError("Unsupported mesh \"%s\": uses multiple primitive types", assimp_object_mesh->mName.C_Str());
-			continue;
-		}
-		if ((assimp_object_mesh->mPrimitiveTypes & static_cast<uint32_t>(aiPrimitiveType_POLYGON)) == static_cast<uint32_t>(aiPrimitiveType_POLYGON)) {
-			LogError("Unsupported mesh \"%s\": uses polygons", assimp_object_mesh->mName.C_Str());
-			continue;
-		}
-		if (!assimp_object_mesh->HasPositions()) {
-			LogError("Unsupported mesh \"%s\": has no positions", assimp_object_mesh->mName.C_Str());
-			continue;
-		}
-
-		bonobo::mesh_data object;
-		if (assimp_object_mesh->mName.length != 0)
-		{
-			object.name = std::string(assimp_object_mesh->mName.C_Str());
-		}
-
-		glGenVertexArrays(1, &object.vao);
-		assert(object.vao != 0u);
-		glBindVertexArray(object.vao);
-
-		auto const vertices_offset = 0u;
-		auto const vertices_size = static_cast<GLsizeiptr>(assimp_object_mesh->mNumVertices * sizeof(glm::vec3));
-
-		auto const normals_offset = vertices_size;
-		auto const normals_size = assimp_object_mesh->HasNormals() ? vertices_size : 0u;
-
-		auto const texcoords_offset = normals_offset + normals_size;
-		auto const texcoords_size = assimp_object_mesh->HasTextureCoords(0u) ? vertices_size : 0u;
-
-		auto const tangents_offset = texcoords_offset + texcoords_size;
-		auto const tangents_size = assimp_object_mesh->HasTangentsAndBitangents() ? vertices_size : 0u;
-
-		auto const binormals_offset = tangents_offset + tangents_size;
-		auto const binormals_size = assimp_object_mesh->HasTangentsAndBitangents() ? vertices_size : 0u;
-
-		auto const bo_size = static_cast<GLsizeiptr>(vertices_size
-		                                            +normals_size
-		                                            +texcoords_size
-		                                            +tangents_size
-		                                            +binormals_size
-		                                            );
-		glGenBuffers(1, &object.bo);
-		assert(object.bo != 0u);
-		glBindBuffer(GL_ARRAY_BUFFER, object.bo);
-		glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-		glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size, static_cast<GLvoid const*>(assimp_object_mesh->mVertices));
-		glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::vertices));
-		glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(0x0));
-
-		if (assimp_object_mesh->HasNormals()) {
-			glBufferSubData(GL_ARRAY_BUFFER, normals_offset, normals_size, static_cast<GLvoid const*>(assimp_object_mesh->mNormals));
-			glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::normals));
-			glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::normals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(normals_offset));
-		}
-
-		if (assimp_object_mesh->HasTextureCoords(0u)) {
-			glBufferSubData(GL_ARRAY_BUFFER, texcoords_offset, texcoords_size, static_cast<GLvoid const*>(assimp_object_mesh->mTextureCoords[0u]));
-			glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::texcoords));
-			glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::texcoords), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(texcoords_offset));
-		}
-
-		if (assimp_object_mesh->HasTangentsAndBitangents()) {
-			glBufferSubData(GL_ARRAY_BUFFER, tangents_offset, tangents_size, static_cast<GLvoid const*>(assimp_object_mesh->mTangents));
-			glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::tangents));
-			glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::tangents), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(tangents_offset));
-
-			glBufferSubData(GL_ARRAY_BUFFER, binormals_offset, binormals_size, static_cast<GLvoid const*>(assimp_object_mesh->mBitangents));
-			glEnableVertexAttribArray(static_cast<unsigned int>(bonobo::shader_bindings::binormals));
-			glVertexAttribPointer(static_cast<unsigned int>(bonobo::shader_bindings::binormals), 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(binormals_offset));
-		}
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0u);
-
-		auto const num_vertices_per_face = assimp_object_mesh->mFaces[0u].mNumIndices;
-		object.indices_nb = assimp_object_mesh->mNumFaces * num_vertices_per_face;
-		auto object_indices = std::make_unique<GLuint[]>(static_cast<size_t>(object.indices_nb));
-		for (size_t i = 0u; i < assimp_object_mesh->mNumFaces; ++i) {
-			auto const& face = assimp_object_mesh->mFaces[i];
-			assert(face.mNumIndices <= 3);
-			object_indices[num_vertices_per_face * i + 0u] = face.mIndices[0u];
-			if (num_vertices_per_face > 1u)
-				object_indices[num_vertices_per_face * i + 1u] = face.mIndices[1u];
-			if (num_vertices_per_face > 2u)
-				object_indices[num_vertices_per_face * i + 2u] = face.mIndices[2u];
-		}
-		glGenBuffers(1, &object.ibo);
-		assert(object.ibo != 0u);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.ibo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<unsigned int>(object.indices_nb) * sizeof(GL_UNSIGNED_INT), reinterpret_cast<GLvoid const*>(object_indices.get()), GL_STATIC_DRAW);
-		object_indices.reset(nullptr);
-
-		utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, object.vao, object.name + " VAO");
-		utils::opengl::debug::nameObject(GL_BUFFER, object.bo, object.name + " VBO");
-		utils::opengl::debug::nameObject(GL_BUFFER, object.ibo, object.name + " IBO");
-
-		glBindVertexArray(0u);
-		glBindBuffer(GL_ARRAY_BUFFER, 0u);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
-
-		auto const material_id = assimp_object_mesh->mMaterialIndex;
-		if (material_id < materials_bindings.size()) {
-			object.bindings = materials_bindings[material_id];
-			object.material = material_constants[material_id];
+		processed_mesh processed;
+		if (is_processing_meshes)
+			processed = pending_processings[j].get();
+		auto const& optimization_stats = processed.optimization;
+
+		auto const& mesh = scene.meshes[j];
+		auto const upload_start_time = std::chrono::high_resolution_clock::now();
+		auto object = bonobo::uploadMesh(mesh, options.mesh_upload);
+		meshes_upload_time_ms += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - upload_start_time).count();
+		meshlet_builder::accumulateStatistics(processed.meshlets, meshlet_stats);
+		object.meshlets = std::move(processed.meshlets);
+
+		if (mesh.material_index < scene.materials.size()) {
+			object.bindings = materials_bindings[mesh.material_index];
+			object.material = scene.materials[mesh.material_index].constants;
 		}
 
 		objects.push_back(object);
 
 		auto const mesh_end_time = std::chrono::high_resolution_clock::now();
 
-		std::string attributes = assimp_object_mesh->HasNormals() ? "normals" : "";
+		std::string attributes = mesh.normals != nullptr ? "normals" : "";
 		if (!attributes.empty())
 		  attributes += " | ";
-		if (assimp_object_mesh->HasTangentsAndBitangents())
+		if (mesh.tangents != nullptr)
 		  attributes += "tangents&bitangents";
 		if (!attributes.empty())
 		  attributes += " | ";
-		if (assimp_object_mesh->HasTextureCoords(0))
+		if (mesh.texcoords != nullptr)
 		  attributes += "texture coordinates";
-		LogTrivia("│ %s Mesh \"%s\" loaded with attributes [%s] in %.3f ms",
-		          (assimp_scene->mNumMeshes == 1u) ? "╶" : (j == 0 ? "┌" : (j == assimp_scene->mNumMeshes - 1 ? "└" : "├")),
-		          assimp_object_mesh->mName.C_Str(), attributes.c_str(),
+		std::string optimization;
+		if (options.optimize_meshes && optimization_stats.acmr_before > 0.0f) {
+			char buffer[64];
+			std::snprintf(buffer, sizeof(buffer), ", ACMR %.3f → %.3f",
+			              optimization_stats.acmr_before, optimization_stats.acmr_after);
+			optimization = buffer;
+		}
+		if (!object.meshlets.empty())
+			optimization += ", " + std::to_string(object.meshlets.size()) + " meshlets";
+		if (!object.lods.empty()) {
+			optimization += ", LODs of ";
+			for (auto const& lod : object.lods)
+				optimization += std::to_string(lod.indices_nb / 3) + (&lod == &object.lods.back() ? " triangles" : "/");
+		}
+		LogTrivia("│ %s Mesh \"%s\" loaded with attributes [%s] and %s-bit indices%s in %.3f ms",
+		          (scene.meshes.size() == 1u) ? "╶" : (j == 0 ? "┌" : (j == scene.meshes.size() - 1 ? "└" : "├")),
+		          mesh.name.c_str(), attributes.c_str(),
+		          object.indices_type == GL_UNSIGNED_SHORT ? "16" : "32",
+		          optimization.c_str(),
 		          std::chrono::duration<float, std::milli>(mesh_end_time - mesh_start_time).count());
 	}
 	auto const meshes_end_time = std::chrono::high_resolution_clock::now();
 
+	if (meshlet_stats.meshlets_nb > 0u)
+		LogTrivia("│ %zu meshlets, filled at %.1f%% of their vertices and %.1f%% of their triangles on average",
+		          meshlet_stats.meshlets_nb,
+		          100.0f * meshlet_stats.vertices_nb / (meshlet_stats.meshlets_nb * meshlet_builder::max_vertices_nb),
+		          100.0f * meshlet_stats.triangles_nb / (meshlet_stats.meshlets_nb * meshlet_builder::max_triangles_nb));
+
+	if (statistics != nullptr) {
+		statistics->upload_time_ms += textures_upload_time_ms + meshes_upload_time_ms;
+		statistics->meshes_nb += objects.size();
+		statistics->textures_size += textures_size;
+	}
+
+	if (options.use_texture_roles || options.compress_textures)
+		LogTrivia("│ Textures take %.3f MiB, instead of %.3f MiB as RGBA",
+		          textures_size / (1024.0f * 1024.0f), rgba_textures_size / (1024.0f * 1024.0f));
 	auto const scene_end_time = std::chrono::high_resolution_clock::now();
-	LogInfo("┕ Scene loaded in %.3f s: %u textures loaded in %.3f s and %zu meshes in %.3f s",
+	LogInfo("┕ Scene loaded in %.3f s: %u textures (%u shared, %.3f MiB) loaded in %.3f s (%.3f s spent decoding %zu images, %.3f s uploading) and %zu meshes in %.3f s",
 	        std::chrono::duration<float>(scene_end_time - scene_start_time).count(),
-	        texture_count,
+	        texture_count, shared_texture_count, textures_size / (1024.0f * 1024.0f),
 	        std::chrono::duration<float>(materials_end_time - materials_start_time).count(),
+	        images_decode_time_ms / 1000.0f, needed_images_nb, textures_upload_time_ms / 1000.0f,
 	        objects.size(),
 	        std::chrono::duration<float>(meshes_end_time - meshes_start_time).count());
 
-	return objects;
+	loaded_scene.nodes = std::move(scene.nodes);
+
+	return loaded_scene;
 }
 
 GLuint
@@ -370,7 +544,10 @@ bonobo::createTexture(uint32_t width, uint32_t height, GLenum target, GLint inte
 		glTexImage1D(target, 0, internal_format, static_cast<GLsizei>(width), 0, format, type, data);
 		break;
 	case GL_TEXTURE_2D:
-		glTexImage2D(target, 0, internal_format, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, format, type, data);
+		if (data != nullptr)
+			UploadManager::GetShared().UploadTexImage2D(target, 0, internal_format, static_cast<GLsizei>(width), static_cast<GLsizei>(height), format, type, data);
+		else
+			glTexImage2D(target, 0, internal_format, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, format, type, nullptr);
 		break;
 	default:
 		glDeleteTextures(1, &texture);
@@ -385,18 +562,40 @@ bonobo::createTexture(uint32_t width, uint32_t height, GLenum target, GLint inte
 GLuint
 bonobo::loadTexture2D(std::string const& filename, bool generate_mipmap)
 {
-	std::uint32_t width, height;
-	auto const data = getTextureData(filename, width, height, true);
-	if (data.empty())
-		return 0u;
+	texture_load_options options;
+	options.generate_mipmap = generate_mipmap;
+	// Callers of this overload free the texture with
+	// `glDeleteTextures()`, which a shared texture must not go through.
+	options.use_texture_registry = false;
+	return loadTexture2D(filename, options);
+}
 
-	GLuint texture = bonobo::createTexture(width, height, GL_TEXTURE_2D, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<GLvoid const*>(data.data()));
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	if (generate_mipmap)
-		glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, 0u);
+GLuint
+bonobo::loadTexture2D(std::string const& filename, texture_load_options const& options,
+                      load_statistics* statistics)
+{
+	auto& texture_registry = TextureRegistry::GetShared();
+	std::string key;
+	if (options.use_texture_registry) {
+		key = TextureRegistry::MakeKey(filename, texture_key_flipped | getTextureKeyFlags(options.role)
+		                                         | (options.generate_mipmap ? texture_key_mipmapped | getTextureKeyFlags(options.mips) : 0u)
+		                                         | (options.compress ? texture_key_compressed : 0u));
+		auto const shared_texture = texture_registry.Acquire(key);
+		if (shared_texture != 0u)
+			return shared_texture;
+	}
+
+	auto const image = getTextureData(filename, true, options.mips, options.role, options.compress, options.use_texture_cache, statistics);
+	auto const upload_start_time = std::chrono::high_resolution_clock::now();
+	auto const texture = uploadTexture2D(image, options.generate_mipmap, options.role);
+	auto const texture_size = getUploadedSize(image, options.generate_mipmap);
+	if (statistics != nullptr) {
+		statistics->upload_time_ms += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - upload_start_time).count();
+		statistics->textures_size += texture_size;
+	}
+
+	if (options.use_texture_registry)
+		texture_registry.Insert(key, texture, texture_size);
 
 	return texture;
 }
@@ -407,6 +606,36 @@ bonobo::loadTextureCubeMap(std::string const& posx, std::string const& negx,
                            std::string const& posz, std::string const& negz,
                            bool generate_mipmap)
 {
+	texture_load_options options;
+	options.generate_mipmap = generate_mipmap;
+	// Callers of this overload free the texture with
+	// `glDeleteTextures()`, which a shared texture must not go through.
+	options.use_texture_registry = false;
+	return loadTextureCubeMap(posx, negx, posy, negy, posz, negz, options);
+}
+
+GLuint
+bonobo::loadTextureCubeMap(std::string const& posx, std::string const& negx,
+                           std::string const& posy, std::string const& negy,
+                           std::string const& posz, std::string const& negz,
+                           texture_load_options const& options,
+                           load_statistics* statistics)
+{
+	bool const generate_mipmap = options.generate_mipmap;
+
+	// Cube maps are shared through the texture registry just like
+	// 2D-textures, using all six paths as key.
+	auto& texture_registry = TextureRegistry::GetShared();
+	std::string key;
+	if (options.use_texture_registry) {
+		key = TextureRegistry::MakeKey(posx + '\n' + negx + '\n' + posy + '\n' + negy + '\n' + posz + '\n' + negz,
+		                               texture_key_cube_map | (generate_mipmap ? texture_key_mipmapped | getTextureKeyFlags(options.mips) : 0u)
+		                               | (options.compress ? texture_key_compressed : 0u));
+		auto const shared_texture = texture_registry.Acquire(key);
+		if (shared_texture != 0u)
+			return shared_texture;
+	}
+
 	GLuint texture = 0u;
 	// Create an OpenGL texture object. Similarly to `glGenVertexArrays()`
 	// and `glGenBuffers()` that were used in assignment 2,
@@ -447,18 +676,63 @@ bonobo::loadTextureCubeMap(std::string const& posx, std::string const& negx,
 		{ negz, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z },
 	};
 
+	// We need to fill in the cube map using the images passed in as
+	// argument. The function `texture_cache::load()` uses stb to read in
+	// the image files (or reads them back from the texture cache, if they
+	// were already decoded during a previous run) and returns a
+	// `bonobo::mipmapped_image` pointing to all the texels of each level
+	// of the mipmap hierarchy. The six faces are independent from one
+	// another, so they all get loaded at the same time on the thread pool.
+	auto& thread_pool = ThreadPool::GetShared();
+	// The tasks capture everything by value, so that they do not depend
+	// on this frame outliving them.
+	std::future<decoded_image> pending_faces[sizeof(images) / sizeof(images[0])];
+	for (size_t i = 0; i < sizeof(images) / sizeof(images[0]); ++i) {
+		auto const filename = images[i].filename;
+		auto const mips = options.mips;
+		auto const compress = options.compress;
+		auto const use_texture_cache = options.use_texture_cache;
+		pending_faces[i] = thread_pool.Enqueue([filename,mips,compress,use_texture_cache](){
+			return decodeImage(filename, false, mips, texture_role_t::generic, compress, use_texture_cache);
+		});
+	}
+
+	mipmapped_image faces[sizeof(images) / sizeof(images[0])];
+	for (size_t i = 0; i < sizeof(images) / sizeof(images[0]); ++i) {
+		auto decoded = pending_faces[i].get();
+		faces[i] = std::move(decoded.image);
+		addToStatistics(images[i].filename, faces[i], decoded.report, statistics);
+		replaceFailedImage(images[i].filename, faces[i]);
+	}
+
+	// All faces of a cube map share a single internal format: if some
+	// faces ended up with a different block format than the others, e.g.
+	// as only some have an alpha channel, or the format is not supported,
+	// all of them get uploaded uncompressed.
+	auto const format = faces[0].format;
+	bool const is_compressed = format != block_format_t::none && isBlockFormatSupported(format)
+	                        && std::all_of(std::begin(faces), std::end(faces),
+	                                       [format](mipmapped_image const& face){ return face.format == format; });
+	if (!is_compressed) {
+		if (options.compress)
+			LogWarning("Cube map \"%s\" could not be compressed, as its faces do not share a supported block format.", posx.c_str());
+		for (auto& face : faces)
+			if (face.format != block_format_t::none)
+				face = block_compressor::decompress(face);
+	} else if (generate_mipmap) {
+		// The driver cannot generate the missing levels of compressed
+		// textures, so only those provided are used.
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(faces[0].levels.size() - 1u));
+	} else {
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
+	}
+
+	auto& upload_manager = UploadManager::GetShared();
+	std::uint64_t texture_size = 0u;
 	for (size_t i = 0; i < sizeof(images) / sizeof(images[0]); ++i)
 	{
-		// We need to fill in the cube map using the images passed in as
-		// argument. The function `getTextureData()` uses stb to read in the
-		// image files and return a `std::vector<std::uint8_t>` containing all the
-		// texels.
-		std::uint32_t width, height;
-		auto data = getTextureData(images[i].filename, width, height, false);
-		if (data.empty()) {
-			glDeleteTextures(1, &texture);
-			return 0u;
-		}
+		auto const& data = faces[i];
+		texture_size += getUploadedSize(data, generate_mipmap);
 		// With all the texels available on the CPU, we now want to push them
 		// to the GPU: this is done using `glTexImage2D()` (among others). You
 		// might have thought that the target used here would be the same as
@@ -468,27 +742,159 @@ bonobo::loadTextureCubeMap(std::string const& posx, std::string const& negx,
 		// as the target the face we want to fill in. In this case, we will
 		// start by filling the face sitting on the negative side of the
 		// x-axis by specifying GL_TEXTURE_CUBE_MAP_NEGATIVE_X.
-		glTexImage2D(images[i].target,
-		             /* mipmap level, you'll see that in EDAN35 */0,
-		             /* how are the components internally stored */GL_RGBA,
-		             /* the width of the cube map's face */static_cast<GLsizei>(width),
-		             /* the height of the cube map's face */static_cast<GLsizei>(height),
-		             /* must always be 0 */0,
-		             /* the format of the pixel data: which components are available */GL_RGBA,
-		             /* the type of each component */GL_UNSIGNED_BYTE,
-		             /* the pointer to the actual data on the CPU */reinterpret_cast<GLvoid const*>(data.data()));
+		//
+		// The mipmap hierarchy (wait for EDAN35 to understand what it does)
+		// was computed on the CPU alongside the first level, so all levels
+		// are uploaded one after the other rather than having the driver
+		// generate them.
+		//
+		// Rather than handing the texels to `glTexImage2D()` straight from
+		// client memory, they go through the upload manager, which stages
+		// them in a pixel buffer object from which the GPU then copies
+		// them asynchronously; the parameters are the same.
+		//
+		// Block-compressed faces are uploaded the same way, except that
+		// their blocks are handed over as they are, with the size of
+		// each level in bytes rather than a format and a type.
+		auto const upload_start_time = std::chrono::high_resolution_clock::now();
+		auto const levels_nb = generate_mipmap ? data.levels.size() : 1u;
+		for (size_t level = 0u; level < levels_nb; ++level) {
+			if (is_compressed) {
+				upload_manager.UploadCompressedTexImage2D(images[i].target, static_cast<GLint>(level),
+				                                          getCompressedInternalFormat(format, texture_role_t::generic),
+				                                          static_cast<GLsizei>(data.levels[level].width),
+				                                          static_cast<GLsizei>(data.levels[level].height),
+				                                          static_cast<GLsizei>(getLevelDataSize(data, level)),
+				                                          data.levels[level].texels);
+				continue;
+			}
+			upload_manager.UploadTexImage2D(images[i].target,
+			                                /* mipmap level, you'll see that in EDAN35 */static_cast<GLint>(level),
+			                                /* how are the components internally stored */GL_RGBA,
+			                                /* the width of the cube map's face */static_cast<GLsizei>(data.levels[level].width),
+			                                /* the height of the cube map's face */static_cast<GLsizei>(data.levels[level].height),
+			                                /* the format of the pixel data: which components are available */GL_RGBA,
+			                                /* the type of each component */GL_UNSIGNED_BYTE,
+			                                /* the pointer to the actual data on the CPU */data.levels[level].texels);
+		}
+		if (statistics != nullptr)
+			statistics->upload_time_ms += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - upload_start_time).count();
 	}
 
-	if (generate_mipmap)
-		// Generate the mipmap hierarchy; wait for EDAN35 to understand
-		// what it does
-		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
 	glBindTexture(GL_TEXTURE_CUBE_MAP, 0u);
 
+	if (statistics != nullptr)
+		statistics->textures_size += texture_size;
+	if (options.use_texture_registry)
+		texture_registry.Insert(key, texture, texture_size);
+
 	return texture;
 }
 
+void
+bonobo::releaseTexture(GLuint texture)
+{
+	// The debug texture is used as placeholder by SceneStreamer, and is
+	// only freed by `deinit()`.
+	if (texture == 0u || texture == debug_texture_id)
+		return;
+
+	if (!TextureRegistry::GetShared().Release(texture))
+		glDeleteTextures(1, &texture);
+}
+
+void
+bonobo::releaseMesh(mesh_data& mesh)
+{
+	if (mesh.is_in_geometry_arena) {
+		GeometryArena::GetShared().Release(mesh);
+	} else {
+		glDeleteVertexArrays(1, &mesh.vao);
+		glDeleteBuffers(1, &mesh.ibo);
+		glDeleteBuffers(1, &mesh.bo);
+	}
+	mesh.vao = 0u;
+	mesh.bo = 0u;
+	mesh.ibo = 0u;
+	mesh.is_in_geometry_arena = false;
+}
+
+bonobo::vertex_decoding_locations
+bonobo::getVertexDecodingLocations(GLuint program)
+{
+	vertex_decoding_locations locations;
+	locations.is_packed = glGetUniformLocation(program, "vertex_attributes_packed");
+	locations.position_offset = glGetUniformLocation(program, "position_dequantisation_offset");
+	locations.position_scale = glGetUniformLocation(program, "position_dequantisation_scale");
+	locations.texcoord_offset = glGetUniformLocation(program, "texcoord_dequantisation_offset");
+	locations.texcoord_scale = glGetUniformLocation(program, "texcoord_dequantisation_scale");
+	return locations;
+}
+
+void
+bonobo::setVertexDecodingUniforms(vertex_decoding_locations const& locations, vertex_decoding const& decoding)
+{
+	glUniform1i(locations.is_packed, decoding.is_packed ? 1 : 0);
+	glUniform3fv(locations.position_offset, 1, glm::value_ptr(decoding.position_offset));
+	glUniform3fv(locations.position_scale, 1, glm::value_ptr(decoding.position_scale));
+	glUniform2fv(locations.texcoord_offset, 1, glm::value_ptr(decoding.texcoord_offset));
+	glUniform2fv(locations.texcoord_scale, 1, glm::value_ptr(decoding.texcoord_scale));
+}
+
+void
+bonobo::setVertexDecodingUniforms(GLuint program, vertex_decoding const& decoding)
+{
+	setVertexDecodingUniforms(getVertexDecodingLocations(program), decoding);
+}
+
+void
+bonobo::drawMesh(mesh_data const& mesh, std::size_t lod)
+{
+	if (mesh.ibo != 0u && lod > 0u && lod <= mesh.lods.size())
+		glDrawElementsBaseVertex(mesh.drawing_mode, mesh.lods[lod - 1u].indices_nb, mesh.indices_type,
+		                         reinterpret_cast<GLvoid const*>(mesh.lods[lod - 1u].indices_offset), mesh.base_vertex);
+	else if (mesh.ibo != 0u)
+		glDrawElementsBaseVertex(mesh.drawing_mode, mesh.indices_nb, mesh.indices_type,
+		                         reinterpret_cast<GLvoid const*>(mesh.indices_offset), mesh.base_vertex);
+	else
+		glDrawArrays(mesh.drawing_mode, mesh.base_vertex, mesh.vertices_nb);
+}
+
+std::size_t
+bonobo::selectLod(std::vector<mesh_lod> const& lods,
+                  glm::vec3 const& bounding_center, float bounding_radius,
+                  glm::mat4 const& world, glm::vec3 const& camera_position,
+                  float screen_height_px, float vertical_fov,
+                  float max_error_px)
+{
+	std::size_t lod = 0u;
+	if (lods.empty())
+		return lod;
+
+	// Errors are scaled as much as the most stretched axis.
+	auto const scale = std::max(glm::length(glm::vec3(world[0])),
+	                            std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+	auto const center = glm::vec3(world * glm::vec4(bounding_center, 1.0f));
+	auto const distance = glm::distance(camera_position, center) - bounding_radius * scale;
+	if (distance <= 0.0f)
+		return lod;
+
+	auto const pixels_per_unit = screen_height_px / (2.0f * distance * std::tan(0.5f * vertical_fov));
+	while (lod < lods.size() && lods[lod].error * scale * pixels_per_unit <= max_error_px)
+		++lod;
+	return lod;
+}
+
+std::size_t
+bonobo::selectLod(mesh_data const& mesh,
+                  glm::mat4 const& world, glm::vec3 const& camera_position,
+                  float screen_height_px, float vertical_fov,
+                  float max_error_px)
+{
+	return selectLod(mesh.lods, mesh.bounding_center, mesh.bounding_radius,
+	                 world, camera_position, screen_height_px, vertical_fov, max_error_px);
+}
+
 GLuint
 bonobo::createProgram(std::string const& vert_shader_source_path, std::string const& frag_shader_source_path)
 {
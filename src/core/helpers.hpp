@@ -3,9 +3,14 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include "core/FPSCamera.h" // As it includes OpenGL headers, import it after glad
+#include "core/mip_generator.hpp"
+#include "core/texture_cache.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -38,6 +43,58 @@ namespace bonobo
 		float opacity{ 1.0f };
 	};
 
+	//! \brief How vertex shaders should decode the attributes of a mesh.
+	//!
+	//! Meshes uploaded with `vertex_layout_t::packed` or
+	//! `vertex_layout_t::packed_quantized` store unit vectors
+	//! octahedral-encoded, and their positions and texture coordinates
+	//! normalised within their bounds: the actual value is
+	//! `offset + scale * stored`. See `setVertexDecodingUniforms()`.
+	struct vertex_decoding {
+		bool is_packed{ false };
+		glm::vec3 position_offset{ 0.0f };
+		glm::vec3 position_scale{ 1.0f };
+		glm::vec2 texcoord_offset{ 0.0f };
+		glm::vec2 texcoord_scale{ 1.0f };
+	};
+
+	//! \brief Locations of the uniforms used by vertex shaders to decode
+	//!        packed attributes; -1 for those unused by a program.
+	struct vertex_decoding_locations {
+		GLint is_packed{ -1 };
+		GLint position_offset{ -1 };
+		GLint position_scale{ -1 };
+		GLint texcoord_offset{ -1 };
+		GLint texcoord_scale{ -1 };
+	};
+
+	//! \brief Cluster of neighbouring triangles of a mesh, small enough
+	//!        to be culled on its own, see `meshlet_builder::build()`.
+	//!
+	//! The triangles of a meshlet are contiguous in the index buffer of
+	//! its mesh. All its triangles face away from any camera position `c`
+	//! verifying `dot(normalize(cone_apex - c), cone_axis) >= cone_cutoff`;
+	//! meshlets with too wide a cone of normals get a cutoff of 1, so
+	//! they are never culled that way. All positions are in model space.
+	struct meshlet {
+		std::uint32_t first_index{ 0u };     //!< within the indices of the mesh
+		std::uint32_t triangles_nb{ 0u };
+		std::uint32_t vertices_nb{ 0u };     //!< distinct vertices referenced by the triangles
+		glm::vec3 center{ 0.0f };           //!< of the bounding sphere
+		float radius{ 0.0f };               //!< of the bounding sphere
+		glm::vec3 cone_apex{ 0.0f };
+		glm::vec3 cone_axis{ 0.0f, 0.0f, 1.0f };
+		float cone_cutoff{ 1.0f };
+	};
+
+	//! \brief Coarser version of a mesh, drawn with its vertices but a
+	//!        range of indices of its own, see `mesh_simplifier::build()`.
+	struct mesh_lod {
+		std::size_t indices_offset{ 0u }; //!< offset in bytes of the level's first index within the ibo of its mesh
+		GLsizei indices_nb{ 0 };
+		float error{ 0.0f };              //!< estimated maximal distance to the full mesh, in model units
+	};
+
 	//! \brief Contains the data for a mesh in OpenGL.
 	struct mesh_data {
 		GLuint vao{0u};                          //!< OpenGL name of the Vertex Array Object
@@ -48,9 +105,178 @@ namespace bonobo
 		texture_bindings bindings{};             //!< texture bindings for this mesh
 		material_data material{};                //!< constant values for the material of this mesh
 		GLenum drawing_mode{GL_TRIANGLES};       //!< OpenGL drawing mode, i.e. GL_TRIANGLES, GL_LINES, etc.
+		GLenum indices_type{GL_UNSIGNED_INT};    //!< OpenGL type of the indices stored in ibo, i.e. GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+		GLint base_vertex{0};                    //!< index of the mesh's first vertex within bo
+		std::size_t indices_offset{0u};          //!< offset in bytes of the mesh's first index within ibo
+		bool is_in_geometry_arena{false};        //!< whether vao, bo and ibo are shared with other meshes, see `GeometryArena`
+		vertex_decoding decoding{};              //!< how shaders should decode the attributes stored in bo
+		std::vector<meshlet> meshlets{};         //!< empty unless built when loading, see `object_load_options::build_meshlets`
+		std::vector<mesh_lod> lods{};            //!< from the most to the least detailed; empty unless built when loading, see `object_load_options::build_lods`
+		glm::vec3 bounding_center{0.0f};         //!< of a sphere enclosing all vertices, in model space
+		float bounding_radius{0.0f};             //!< of a sphere enclosing all vertices, in model space
 		std::string name{"un-named mesh"};       //!< Name of the mesh; used for debugging purposes.
 	};
 
+	//! \brief Node of the hierarchy of a scene, see `loadScene()`.
+	struct scene_node {
+		std::string name;
+		std::int32_t parent{ -1 };                  //!< index of the parent within the nodes of the scene, which comes before this one; -1 for the root
+		glm::vec3 translation{ 0.0f };              //!< of the node relative to its parent
+		glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f }; //!< of the node relative to its parent
+		glm::vec3 scale{ 1.0f };                    //!< of the node relative to its parent
+		std::vector<std::uint32_t> meshes;          //!< indices within the meshes of the scene
+	};
+
+	//! \brief Meshes of a scene along with its hierarchy, see
+	//!        `loadScene()`.
+	struct scene_data {
+		std::vector<mesh_data> meshes;
+		std::vector<scene_node> nodes; //!< depth-first, starting with the root; empty if loading failed
+	};
+
+	//! \brief How the vertex attributes of a mesh are laid out in its
+	//!        buffer object.
+	enum class vertex_layout_t : unsigned int {
+		planar = 0u, //!< one tightly-packed region per attribute, one after the other
+		interleaved, //!< all attributes of a vertex next to each other, see `interleaved_vertex`
+		packed,      //!< interleaved, with compressed normals, tangents and texture coordinates, see `packed_vertex`
+		packed_quantized //!< as `packed`, with 16-bit positions as well, see `packed_quantized_vertex`
+	};
+
+	//! \brief Settings controlling how CPU-side geometry gets uploaded.
+	struct mesh_upload_options {
+		vertex_layout_t vertex_layout{ vertex_layout_t::planar };
+
+		//! Store the indices as GL_UNSIGNED_SHORT rather than
+		//! GL_UNSIGNED_INT whenever all vertices can be addressed that way.
+		bool allow_short_indices{ true };
+
+		//! Suballocate the mesh from `GeometryArena::GetShared()` rather
+		//! than giving it its own buffers and VAO; such meshes must be
+		//! drawn with `drawMesh()` and freed with `releaseMesh()`. It is
+		//! off by default, as code drawing `vao` with plain
+		//! `glDrawElements()` would ignore the mesh's base vertex and
+		//! indices offset.
+		bool use_geometry_arena{ false };
+	};
+
+	//! \brief Settings controlling how `loadTexture2D()` and
+	//!        `loadTextureCubeMap()` load images.
+	struct texture_load_options {
+		//! Whether to provide a full mipmap hierarchy.
+		bool generate_mipmap{ true };
+
+		//! How that hierarchy gets filtered, on the CPU; colour maps
+		//! should set `mip_settings::is_srgb`, so that they do not get
+		//! darker in the distance.
+		mip_settings mips;
+
+		//! What the texture is used for, which decides which channels
+		//! are kept and how they are stored on the GPU; cube maps ignore
+		//! it and are always RGBA.
+		texture_role_t role{ texture_role_t::generic };
+
+		//! Block-compress the texels and their mipmap hierarchy on the
+		//! CPU, see `block_compressor::compress()`, so that they take a
+		//! quarter to an eighth of the memory on the GPU; the quality of
+		//! each image is reported through `load_statistics`. Cube maps
+		//! are only compressed if all their faces get the same format.
+		bool compress{ false };
+
+		//! Read the decoded texels and their mipmap hierarchy from a
+		//! cache stored next to each image when it is up to date,
+		//! instead of decoding the image and generating the mipmaps;
+		//! the cache is (re)written otherwise.
+		bool use_texture_cache{ true };
+
+		//! Share the texture with any previous load of the same file(s)
+		//! with the same options, through `TextureRegistry::GetShared()`;
+		//! such textures must be freed with `releaseTexture()` rather
+		//! than `glDeleteTextures()`.
+		bool use_texture_registry{ true };
+	};
+
+	//! \brief Settings controlling how `loadObjects()` processes a scene.
+	struct object_load_options {
+		//! Decode all the textures referenced by the scene on the shared
+		//! thread pool, rather than one after the other while uploading.
+		bool parallel_texture_decoding{ true };
+
+		//! Read the geometry and materials from a binary cache stored
+		//! next to the scene file when it is up to date, instead of
+		//! importing the scene with Assimp; the cache is (re)written
+		//! otherwise.
+		bool use_object_cache{ true };
+
+		//! See `texture_load_options::use_texture_cache`.
+		bool use_texture_cache{ true };
+
+		//! See `texture_load_options::use_texture_registry`; this also
+		//! makes materials sharing an image share a single texture.
+		bool use_texture_registry{ true };
+
+		//! Pick the role of each texture from the material slot it is
+		//! bound to, see `getTextureRole()`, rather than keeping all of
+		//! them as RGBA; this roughly halves their memory, but shaders
+		//! then have to read masks from their red channel and
+		//! reconstruct the z component of normal maps.
+		bool use_texture_roles{ false };
+
+		//! See `texture_load_options::compress`.
+		bool compress_textures{ false };
+
+		//! Reorder the triangles of each mesh for post-transform vertex
+		//! cache locality and then for overdraw, and its vertices for
+		//! fetch locality; see `mesh_optimizer::optimize()`.
+		bool optimize_meshes{ false };
+
+		//! Split each mesh into meshlets, for culling it piece by piece
+		//! rather than as a whole; this reorders its triangles, after
+		//! any optimisation, which then gets redone within each meshlet.
+		//! See `meshlet_builder::build()` and
+		//! `mesh_optimizer::optimizeMeshlets()`.
+		bool build_meshlets{ false };
+
+		//! Build levels of detail for each mesh, keeping 50%, 25% and
+		//! 12.5% of its triangles, as extra index ranges in its index
+		//! buffer; see `mesh_simplifier::build()`. They are built after
+		//! any optimisation and meshlets, but do not get meshlets of
+		//! their own.
+		bool build_lods{ false };
+
+		//! How to lay out the geometry of each mesh.
+		mesh_upload_options mesh_upload{};
+	};
+
+	//! \brief Where the time spent in the loading functions went, for
+	//!        profiling them.
+	//!
+	//! The loading functions add to the values already present, so that
+	//! a single instance can cover several loads. Decoding and mip
+	//! generation run on worker threads: their times are summed over all
+	//! workers, and overlap with the rest of the load.
+	struct load_statistics {
+		//! \brief Quality of an image once block-compressed.
+		struct compressed_image {
+			std::string filename;
+			block_format_t format{ block_format_t::none };
+			float psnr_db{ 0.0f }; //!< see `block_compressor::computePsnr()`
+		};
+
+		float import_time_ms{ 0.0f };         //!< reading scenes, through Assimp or from the object cache
+		float decode_time_ms{ 0.0f };         //!< decoding images, or reading them from the texture cache
+		float mip_generation_time_ms{ 0.0f }; //!< generating mip chains on the CPU
+		float compression_time_ms{ 0.0f };    //!< block-compressing images and their mip chains on the CPU
+		float upload_time_ms{ 0.0f };         //!< issuing the OpenGL uploads of textures and meshes; the GPU may still be busy with them afterwards
+		std::size_t scenes_nb{ 0u };
+		std::size_t scenes_from_cache_nb{ 0u };
+		std::size_t images_nb{ 0u };          //!< not counting those shared through the texture registry
+		std::size_t images_from_cache_nb{ 0u };
+		std::size_t meshes_nb{ 0u };
+		std::uint64_t textures_size{ 0u };    //!< bytes taken by the uploaded textures and their mip chains, not counting those shared through the texture registry
+		std::vector<compressed_image> compressed_images; //!< one per block-compressed image, whether it came from the cache or not
+	};
+
 	enum class cull_mode_t : unsigned int {
 		disabled = 0u,
 		back_faces,
@@ -72,9 +298,30 @@ namespace bonobo
 	//! \brief Load objects found in an object/scene file, using assimp.
 	//!
 	//! @param [in] filename of the object/scene file to load.
+	//! @param [in] options how to process the scene
+	//! @param [in,out] statistics if not null, gets the time spent in
+	//!                 each phase added to it
 	//! @return a vector of filled in `mesh_data` structures, one per
 	//!         object found in the input file
-	std::vector<mesh_data> loadObjects(std::string const& filename);
+	std::vector<mesh_data> loadObjects(std::string const& filename,
+	                                   object_load_options const& options = object_load_options(),
+	                                   load_statistics* statistics = nullptr);
+
+	//! \brief Load the meshes found in an object/scene file along with
+	//!        the hierarchy of nodes referencing them, in a single import.
+	//!
+	//! This works as `loadObjects()`, the node hierarchy being read from
+	//! the same Assimp import, or object cache, as the meshes.
+	//!
+	//! @param [in] filename of the object/scene file to load.
+	//! @param [in] options how to process the scene
+	//! @param [in,out] statistics if not null, gets the time spent in
+	//!                 each phase added to it
+	//! @return the meshes, one per object found in the input file, and
+	//!         the nodes
+	scene_data loadScene(std::string const& filename,
+	                     object_load_options const& options = object_load_options(),
+	                     load_statistics* statistics = nullptr);
 
 	//! \brief Creates an OpenGL texture without any content nor parameters.
 	//!
@@ -97,14 +344,31 @@ namespace bonobo
 
 	//! \brief Load an image into an OpenGL 2D-texture.
 	//!
+	//! The texture is never shared through the texture registry, so it
+	//! can be freed with `glDeleteTextures()`.
+	//!
 	//! @param [in] filename of the image.
 	//! @param [in] generate_mipmap whether or not to generate a mipmap hierarchy
 	//! @return the name of the OpenGL 2D-texture
 	GLuint loadTexture2D(std::string const& filename,
 	                     bool generate_mipmap = true);
 
+	//! \brief Load an image into an OpenGL 2D-texture.
+	//!
+	//! @param [in] filename of the image.
+	//! @param [in] options how to load the image
+	//! @param [in,out] statistics if not null, gets the time spent in
+	//!                 each phase added to it
+	//! @return the name of the OpenGL 2D-texture
+	GLuint loadTexture2D(std::string const& filename,
+	                     texture_load_options const& options,
+	                     load_statistics* statistics = nullptr);
+
 	//! \brief Load six images into an OpenGL cubemap-texture.
 	//!
+	//! The texture is never shared through the texture registry, so it
+	//! can be freed with `glDeleteTextures()`.
+	//!
 	//! @param [in] posx path to the texture on the left of the cubemap
 	//! @param [in] negx path to the texture on the right of the cubemap
 	//! @param [in] posy path to the texture on the top of the cubemap
@@ -118,6 +382,109 @@ namespace bonobo
                                   std::string const& posz, std::string const& negz,
                                   bool generate_mipmap = true);
 
+	//! \brief Load six images into an OpenGL cubemap-texture.
+	//!
+	//! @param [in] posx path to the texture on the left of the cubemap
+	//! @param [in] negx path to the texture on the right of the cubemap
+	//! @param [in] posy path to the texture on the top of the cubemap
+	//! @param [in] negy path to the texture on the bottom of the cubemap
+	//! @param [in] posz path to the texture on the back of the cubemap
+	//! @param [in] negz path to the texture on the front of the cubemap
+	//! @param [in] options how to load the images
+	//! @param [in,out] statistics if not null, gets the time spent in
+	//!                 each phase added to it
+	//! @return the name of the OpenGL cubemap-texture
+	GLuint loadTextureCubeMap(std::string const& posx, std::string const& negx,
+                                  std::string const& posy, std::string const& negy,
+                                  std::string const& posz, std::string const& negz,
+                                  texture_load_options const& options,
+                                  load_statistics* statistics = nullptr);
+
+	//! \brief Free a texture returned by one of the loading functions.
+	//!
+	//! Textures shared through the texture registry are only deleted once
+	//! their last user releases them; other textures are deleted
+	//! straight away, except for the debug texture.
+	//!
+	//! @param [in] texture name of the texture to free
+	void releaseTexture(GLuint texture);
+
+	//! \brief Free the geometry of a mesh, and reset its names.
+	//!
+	//! Meshes suballocated from the geometry arena leave their shared
+	//! VAO and buffers alone; other meshes get theirs deleted. Texture
+	//! bindings are not released.
+	//!
+	//! @param [in] mesh mesh whose geometry to free
+	void releaseMesh(mesh_data& mesh);
+
+	//! \brief Look up the uniforms a program uses for decoding packed
+	//!        vertex attributes.
+	//!
+	//! @param [in] program program whose vertex shader may decode packed
+	//!             attributes
+	vertex_decoding_locations getVertexDecodingLocations(GLuint program);
+
+	//! \brief Set the uniforms needed by the currently used program to
+	//!        decode the attributes of a mesh.
+	//!
+	//! Must be called for meshes with a regular layout as well, as
+	//! otherwise the settings of the previously drawn mesh stick.
+	//!
+	//! @param [in] locations where to set the decoding settings
+	//! @param [in] decoding decoding settings of the mesh about to be
+	//!             drawn
+	void setVertexDecodingUniforms(vertex_decoding_locations const& locations,
+	                               vertex_decoding const& decoding);
+
+	//! \brief Convenience overload of `setVertexDecodingUniforms()`,
+	//!        looking up the locations every time.
+	void setVertexDecodingUniforms(GLuint program, vertex_decoding const& decoding);
+
+	//! \brief Issue the draw call for a mesh, whose VAO must already be
+	//!        bound.
+	//!
+	//! Taking the base vertex and index offset into account, this works
+	//! for meshes with their own VAO as well as for meshes sharing one.
+	//!
+	//! @param [in] mesh mesh to draw
+	//! @param [in] lod level of detail to draw, 0 being the full mesh
+	//!             and `i` standing for `mesh.lods[i - 1]`
+	void drawMesh(mesh_data const& mesh, std::size_t lod = 0u);
+
+	//! \brief Select the coarsest level of detail whose error covers at
+	//!        most `max_error_px` pixels on screen.
+	//!
+	//! The error of each level is projected at the distance between the
+	//! camera and the bounding sphere of the geometry, so that levels do
+	//! not change while the camera is within the sphere.
+	//!
+	//! @param [in] lods levels of detail, as in `mesh_data::lods`
+	//! @param [in] bounding_center centre of the bounding sphere, in
+	//!             model-space
+	//! @param [in] bounding_radius radius of the bounding sphere, in
+	//!             model-space
+	//! @param [in] world Matrix transforming from model-space to
+	//!             world-space
+	//! @param [in] camera_position in world-space
+	//! @param [in] screen_height_px height of the viewport, in pixels
+	//! @param [in] vertical_fov vertical field of view of the camera, in
+	//!             radians
+	//! @param [in] max_error_px how far, in pixels, the rendered surface
+	//!             may be from the full geometry
+	//! @return the level to pass to `drawMesh()`, 0 being the full mesh
+	std::size_t selectLod(std::vector<mesh_lod> const& lods,
+	                      glm::vec3 const& bounding_center, float bounding_radius,
+	                      glm::mat4 const& world, glm::vec3 const& camera_position,
+	                      float screen_height_px, float vertical_fov,
+	                      float max_error_px = 1.0f);
+
+	//! \brief Convenience overload of `selectLod()` for a mesh.
+	std::size_t selectLod(mesh_data const& mesh,
+	                      glm::mat4 const& world, glm::vec3 const& camera_position,
+	                      float screen_height_px, float vertical_fov,
+	                      float max_error_px = 1.0f);
+
 	//! \brief Create an OpenGL program consisting of a vertex and a
 	//!        fragment shader.
 	//!
@@ -0,0 +1,291 @@
+#include "material_packer.hpp"
+
+#include "core/opengl.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace
+{
+	struct source_texture {
+		GLsizei width{ 0 };
+		GLsizei height{ 0 };
+		GLenum internal_format{ GL_RGBA8 };
+		bool is_compressed{ false };
+		std::vector<GLint> compressed_sizes; //!< per level, only filled for compressed textures
+		GLint levels_nb{ 0 };
+	};
+
+	// Textures created with unsized internal formats are resolved to
+	// sized ones, so that they group with textures created with the
+	// latter.
+	GLenum
+	getSizedFormat(GLenum internal_format)
+	{
+		switch (internal_format) {
+		case GL_RED:  return GL_R8;
+		case GL_RG:   return GL_RG8;
+		case GL_RGB:  return GL_RGB8;
+		case GL_RGBA: return GL_RGBA8;
+		default:      return internal_format;
+		}
+	}
+
+	// Any format matching the internal format will do, as no data gets
+	// transferred when allocating the arrays.
+	GLenum
+	getPixelFormat(GLenum internal_format)
+	{
+		switch (internal_format) {
+		case GL_R8:    return GL_RED;
+		case GL_RG8:   return GL_RG;
+		case GL_RGB8:
+		case GL_SRGB8: return GL_RGB;
+		default:       return GL_RGBA;
+		}
+	}
+
+	bool
+	isSrgb(GLenum internal_format)
+	{
+		return internal_format == GL_SRGB8_ALPHA8 || internal_format == GL_SRGB8;
+	}
+
+	GLint
+	getFullLevelsNb(GLsizei width, GLsizei height)
+	{
+		GLint levels_nb = 1;
+		for (auto size = std::max(width, height); size > 1; size /= 2)
+			++levels_nb;
+		return levels_nb;
+	}
+
+	source_texture
+	describeTexture(GLuint texture)
+	{
+		source_texture description;
+		GLint value = 0;
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &description.width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &description.height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &value);
+		description.internal_format = getSizedFormat(static_cast<GLenum>(value));
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &value);
+		description.is_compressed = value != GL_FALSE;
+
+		// Levels which were never specified report a width of 0.
+		GLint max_level = 0;
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &max_level);
+		auto const full_levels_nb = getFullLevelsNb(description.width, description.height);
+		while (description.levels_nb < std::min(full_levels_nb, max_level + 1)) {
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, description.levels_nb, GL_TEXTURE_WIDTH, &value);
+			if (value == 0)
+				break;
+			if (description.is_compressed) {
+				glGetTexLevelParameteriv(GL_TEXTURE_2D, description.levels_nb, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &value);
+				description.compressed_sizes.push_back(value);
+			}
+			++description.levels_nb;
+		}
+		glBindTexture(GL_TEXTURE_2D, 0u);
+
+		return description;
+	}
+
+	GLsizei
+	getLevelSize(GLsizei size, GLint level)
+	{
+		return std::max(size >> level, 1);
+	}
+}
+
+bonobo::packed_materials
+bonobo::material_packer::pack(std::vector<mesh_data> const& meshes,
+                              std::vector<std::string> const& slots,
+                              material_packing_options const& options)
+{
+	packed_materials materials;
+	materials.slots = slots;
+	materials.arrays.resize(slots.size());
+	materials.meshes.assign(meshes.size(), std::vector<packed_texture>(slots.size()));
+
+	// Assign a layer to each distinct texture of each slot, grouping them
+	// by size and format.
+	using group_key = std::tuple<GLsizei, GLsizei, GLenum, GLint>;
+	struct layer_source {
+		GLuint texture;
+		source_texture description;
+		packed_texture destination;
+	};
+	std::vector<std::vector<std::vector<layer_source>>> arrays_layers(slots.size()); // [slot][array][layer]
+	std::unordered_map<GLuint, source_texture> descriptions;
+	for (std::size_t slot = 0u; slot < slots.size(); ++slot) {
+		std::map<group_key, std::int32_t> arrays_indices;
+		std::unordered_map<GLuint, packed_texture> packed_textures;
+		for (std::size_t mesh = 0u; mesh < meshes.size(); ++mesh) {
+			auto const binding = meshes[mesh].bindings.find(slots[slot]);
+			if (binding == meshes[mesh].bindings.end() || binding->second == 0u
+			    || binding->second == options.ignored_texture)
+				continue;
+			auto const texture = binding->second;
+
+			auto const packed = packed_textures.find(texture);
+			if (packed != packed_textures.end()) {
+				materials.meshes[mesh][slot] = packed->second;
+				continue;
+			}
+
+			auto description = descriptions.find(texture);
+			if (description == descriptions.end())
+				description = descriptions.emplace(texture, describeTexture(texture)).first;
+			auto const& source = description->second;
+			if (source.width == 0 || source.height == 0)
+				continue;
+
+			// Compressed textures keep their size and their levels, as
+			// they can only be copied as they are.
+			auto const is_resampled = options.resampled_size > 0 && !source.is_compressed;
+			auto const width = is_resampled ? options.resampled_size : source.width;
+			auto const height = is_resampled ? options.resampled_size : source.height;
+			auto const levels_nb = source.is_compressed ? source.levels_nb : getFullLevelsNb(width, height);
+			auto const key = group_key(width, height, source.internal_format, levels_nb);
+			auto array = arrays_indices.find(key);
+			if (array == arrays_indices.end()) {
+				array = arrays_indices.emplace(key, static_cast<std::int32_t>(arrays_layers[slot].size())).first;
+				arrays_layers[slot].emplace_back();
+				texture_array created;
+				created.internal_format = source.internal_format;
+				created.width = width;
+				created.height = height;
+				materials.arrays[slot].push_back(created);
+			}
+
+			auto& layers = arrays_layers[slot][array->second];
+			packed_texture destination;
+			destination.array = array->second;
+			destination.layer = static_cast<std::int32_t>(layers.size());
+			layers.push_back({ texture, source, destination });
+			packed_textures.emplace(texture, destination);
+			materials.meshes[mesh][slot] = destination;
+		}
+	}
+
+	// The blits below go through the framebuffer bindings, and are
+	// affected by scissoring and sRGB conversions; restore all of those
+	// once done. Depending on the OpenGL version, blits from an sRGB
+	// texture decode it either always or only with GL_FRAMEBUFFER_SRGB,
+	// so it is enabled for sRGB arrays, which then get encoded back.
+	GLint previous_read_framebuffer = 0, previous_draw_framebuffer = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_framebuffer);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw_framebuffer);
+	auto const was_scissor_test_enabled = glIsEnabled(GL_SCISSOR_TEST);
+	auto const was_framebuffer_srgb_enabled = glIsEnabled(GL_FRAMEBUFFER_SRGB);
+	glDisable(GL_SCISSOR_TEST);
+
+	GLuint framebuffers[2] = { 0u, 0u };
+	glGenFramebuffers(2, framebuffers);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+
+	std::vector<GLubyte> compressed_level;
+	for (std::size_t slot = 0u; slot < slots.size(); ++slot) {
+		for (std::size_t a = 0u; a < materials.arrays[slot].size(); ++a) {
+			auto& array = materials.arrays[slot][a];
+			auto const& layers = arrays_layers[slot][a];
+			assert(!layers.empty());
+			auto const& first_source = layers.front().description;
+			array.layers_nb = static_cast<GLsizei>(layers.size());
+			auto const levels_nb = first_source.is_compressed ? first_source.levels_nb : getFullLevelsNb(array.width, array.height);
+
+			glGenTextures(1, &array.texture);
+			assert(array.texture != 0u);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels_nb - 1);
+			for (GLint level = 0; level < levels_nb; ++level) {
+				auto const level_width = getLevelSize(array.width, level);
+				auto const level_height = getLevelSize(array.height, level);
+				if (first_source.is_compressed)
+					glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, array.internal_format,
+					                       level_width, level_height, array.layers_nb, 0,
+					                       first_source.compressed_sizes[level] * array.layers_nb, nullptr);
+				else
+					glTexImage3D(GL_TEXTURE_2D_ARRAY, level, static_cast<GLint>(array.internal_format),
+					             level_width, level_height, array.layers_nb, 0,
+					             getPixelFormat(array.internal_format), GL_UNSIGNED_BYTE, nullptr);
+			}
+
+			if (isSrgb(array.internal_format))
+				glEnable(GL_FRAMEBUFFER_SRGB);
+			else
+				glDisable(GL_FRAMEBUFFER_SRGB);
+			for (auto const& layer : layers) {
+				auto const& source = layer.description;
+				if (source.is_compressed) {
+					for (GLint level = 0; level < levels_nb; ++level) {
+						compressed_level.resize(static_cast<std::size_t>(source.compressed_sizes[level]));
+						glBindTexture(GL_TEXTURE_2D, layer.texture);
+						glGetCompressedTexImage(GL_TEXTURE_2D, level, compressed_level.data());
+						glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer.destination.layer,
+						                          getLevelSize(array.width, level), getLevelSize(array.height, level), 1,
+						                          array.internal_format, source.compressed_sizes[level], compressed_level.data());
+					}
+					glBindTexture(GL_TEXTURE_2D, 0u);
+					continue;
+				}
+
+				for (GLint level = 0; level < levels_nb; ++level) {
+					auto const level_width = getLevelSize(array.width, level);
+					auto const level_height = getLevelSize(array.height, level);
+
+					// Blit from the smallest source level still covering the
+					// destination one, so that minification stays within
+					// what bilinear filtering handles without aliasing.
+					GLint source_level = 0;
+					while (source_level + 1 < source.levels_nb
+					       && getLevelSize(source.width, source_level + 1) >= level_width
+					       && getLevelSize(source.height, source_level + 1) >= level_height)
+						++source_level;
+					auto const source_width = getLevelSize(source.width, source_level);
+					auto const source_height = getLevelSize(source.height, source_level);
+
+					glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer.texture, source_level);
+					glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array.texture, level, layer.destination.layer);
+					auto const is_same_size = source_width == level_width && source_height == level_height;
+					glBlitFramebuffer(0, 0, source_width, source_height, 0, 0, level_width, level_height,
+					                  GL_COLOR_BUFFER_BIT, is_same_size ? GL_NEAREST : GL_LINEAR);
+				}
+			}
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0u);
+
+			utils::opengl::debug::nameObject(GL_TEXTURE, array.texture,
+			                                 slots[slot] + " array " + std::to_string(array.width) + "x" + std::to_string(array.height));
+		}
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous_read_framebuffer));
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(previous_draw_framebuffer));
+	glDeleteFramebuffers(2, framebuffers);
+	if (was_scissor_test_enabled)
+		glEnable(GL_SCISSOR_TEST);
+	if (was_framebuffer_srgb_enabled)
+		glEnable(GL_FRAMEBUFFER_SRGB);
+	else
+		glDisable(GL_FRAMEBUFFER_SRGB);
+
+	return materials;
+}
+
+void
+bonobo::material_packer::release(packed_materials& materials)
+{
+	for (auto& slot_arrays : materials.arrays)
+		for (auto& array : slot_arrays)
+			glDeleteTextures(1, &array.texture);
+	materials = packed_materials();
+}
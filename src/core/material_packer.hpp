@@ -0,0 +1,74 @@
+#pragma once
+
+#include "helpers.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Where the texture a mesh had bound to a slot ended up.
+	struct packed_texture {
+		std::int32_t array{ -1 }; //!< index into `packed_materials::arrays[slot]`, or -1 if the mesh had no texture for that slot
+		std::int32_t layer{ -1 };
+	};
+
+	//! \brief 2D-texture array holding same-sized textures, one per layer.
+	struct texture_array {
+		GLuint texture{ 0u };
+		GLenum internal_format{ GL_RGBA8 };
+		GLsizei width{ 0 };
+		GLsizei height{ 0 };
+		GLsizei layers_nb{ 0 };
+	};
+
+	//! \brief Textures of a set of meshes, packed into texture arrays.
+	struct packed_materials {
+		std::vector<std::string> slots;                  //!< sampler names, e.g. "diffuse_texture"
+		std::vector<std::vector<texture_array>> arrays;  //!< [slot][array]
+		std::vector<std::vector<packed_texture>> meshes; //!< [mesh][slot], in the order the meshes were given
+	};
+
+	struct material_packing_options {
+		//! \brief Width and height all uncompressed textures get resampled
+		//!        to, so that each slot ends up in a single array; with 0,
+		//!        textures keep their size and get one array per size.
+		GLsizei resampled_size{ 0 };
+
+		//! \brief Texture to consider as missing, e.g. the debug texture
+		//!        standing in for those still being streamed in.
+		GLuint ignored_texture{ 0u };
+	};
+
+	namespace material_packer
+	{
+		//! \brief Copy the textures bound to the given slots of each mesh
+		//!        into `GL_TEXTURE_2D_ARRAY`s, so that all meshes can be
+		//!        drawn with a single texture per slot and per-draw layer
+		//!        indices.
+		//!
+		//! Textures of a slot sharing their size and internal format, after
+		//! resampling if requested, go into the same array; a texture used
+		//! by several meshes only gets one layer. Copies are done on the
+		//! GPU by blitting each level of the arrays from the closest level
+		//! of the source texture that is at least as large, so that their
+		//! mip chains are preserved when no resampling happens. Compressed
+		//! textures cannot be blitted; they are copied level by level, at
+		//! their own size.
+		//!
+		//! The source textures are left untouched, and still owned by the
+		//! caller.
+		//!
+		//! @param [in] meshes meshes whose `bindings` get packed
+		//! @param [in] slots names of the bindings to pack
+		//! @param [in] options how to group the textures
+		packed_materials pack(std::vector<mesh_data> const& meshes,
+		                      std::vector<std::string> const& slots,
+		                      material_packing_options const& options = material_packing_options());
+
+		//! \brief Delete the texture arrays created by `pack()`, and clear
+		//!        `materials`.
+		void release(packed_materials& materials);
+	}
+}
@@ -0,0 +1,386 @@
+#include "mesh_optimizer.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+	// Parameters from Tom Forsyth's article; the LRU cache temporarily
+	// holds up to three more vertices while a triangle is being added.
+	constexpr std::size_t forsyth_cache_size = 32u;
+	constexpr float cache_decay_power = 1.5f;
+	constexpr float last_triangle_score = 0.75f;
+	constexpr float valence_boost_scale = 2.0f;
+	constexpr float valence_boost_power = 0.5f;
+
+	float computeVertexScore(int cache_position, std::uint32_t remaining_triangles_nb)
+	{
+		if (remaining_triangles_nb == 0u)
+			return -1.0f;
+
+		auto score = 0.0f;
+		if (cache_position >= 0) {
+			if (cache_position < 3) {
+				score = last_triangle_score;
+			} else {
+				auto const scaler = 1.0f / static_cast<float>(forsyth_cache_size - 3u);
+				score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scaler, cache_decay_power);
+			}
+		}
+
+		score += valence_boost_scale * std::pow(static_cast<float>(remaining_triangles_nb), -valence_boost_power);
+		return score;
+	}
+
+	//! \brief Mark the start of a new cluster whenever a triangle does
+	//!        not reuse any vertex from the simulated cache.
+	std::vector<std::size_t> findClusters(GLuint const* indices, std::size_t indices_nb,
+	                                      std::size_t vertices_nb)
+	{
+		std::vector<std::size_t> cache_timestamps(vertices_nb, 0u);
+		std::size_t timestamp = bonobo::mesh_optimizer::simulated_cache_size + 1u;
+
+		std::vector<std::size_t> cluster_starts;
+		for (std::size_t i = 0u; i < indices_nb; i += 3u) {
+			auto misses_nb = 0u;
+			for (std::size_t j = 0u; j < 3u; ++j) {
+				auto const vertex = indices[i + j];
+				if (timestamp - cache_timestamps[vertex] > bonobo::mesh_optimizer::simulated_cache_size) {
+					cache_timestamps[vertex] = timestamp++;
+					++misses_nb;
+				}
+			}
+			if (i == 0u || misses_nb == 3u)
+				cluster_starts.push_back(i / 3u);
+		}
+		return cluster_starts;
+	}
+
+	//! \brief Replace the attributes of `mesh` with the vertices listed
+	//!        in `new_to_old`, as returned by `optimizeVertexFetch()`.
+	void remapAttributes(bonobo::mesh_source& mesh, std::vector<GLuint> const& new_to_old)
+	{
+		// Gather the remapped attributes into a new storage, as the current
+		// ones may live in it already.
+		glm::vec3 const** const attributes[] = {
+			&mesh.vertices, &mesh.normals, &mesh.texcoords, &mesh.tangents, &mesh.binormals
+		};
+		std::size_t attributes_nb = 0u;
+		for (auto const attribute : attributes)
+			if (*attribute != nullptr)
+				++attributes_nb;
+
+		std::vector<glm::vec3> attributes_storage(attributes_nb * new_to_old.size());
+		std::size_t offset = 0u;
+		for (auto const attribute : attributes) {
+			if (*attribute == nullptr)
+				continue;
+			auto* const destination = attributes_storage.data() + offset;
+			for (std::size_t v = 0u; v < new_to_old.size(); ++v)
+				destination[v] = (*attribute)[new_to_old[v]];
+			offset += new_to_old.size();
+		}
+
+		mesh.attributes_storage = std::move(attributes_storage);
+		offset = 0u;
+		for (auto const attribute : attributes) {
+			if (*attribute == nullptr)
+				continue;
+			*attribute = mesh.attributes_storage.data() + offset;
+			offset += new_to_old.size();
+		}
+		mesh.vertices_nb = static_cast<std::uint32_t>(new_to_old.size());
+	}
+}
+
+float
+bonobo::mesh_optimizer::computeACMR(GLuint const* indices, std::size_t indices_nb,
+                                    std::size_t vertices_nb, std::size_t cache_size)
+{
+	if (indices_nb < 3u)
+		return 0.0f;
+
+	// A vertex is in the FIFO if it was pushed less than `cache_size`
+	// pushes ago; this avoids having to maintain the FIFO itself.
+	std::vector<std::size_t> cache_timestamps(vertices_nb, 0u);
+	std::size_t timestamp = cache_size + 1u;
+	std::size_t misses_nb = 0u;
+	for (std::size_t i = 0u; i < indices_nb; ++i) {
+		auto const vertex = indices[i];
+		if (timestamp - cache_timestamps[vertex] > cache_size) {
+			cache_timestamps[vertex] = timestamp++;
+			++misses_nb;
+		}
+	}
+
+	return static_cast<float>(misses_nb) / static_cast<float>(indices_nb / 3u);
+}
+
+void
+bonobo::mesh_optimizer::optimizeVertexCache(GLuint* indices, std::size_t indices_nb,
+                                            std::size_t vertices_nb)
+{
+	auto const triangles_nb = indices_nb / 3u;
+	if (triangles_nb == 0u)
+		return;
+
+	// Build the vertex to triangles adjacency, in CSR form.
+	std::vector<std::uint32_t> remaining_triangles_nb(vertices_nb, 0u);
+	for (std::size_t i = 0u; i < triangles_nb * 3u; ++i)
+		++remaining_triangles_nb[indices[i]];
+
+	std::vector<std::uint32_t> adjacency_offsets(vertices_nb + 1u, 0u);
+	for (std::size_t v = 0u; v < vertices_nb; ++v)
+		adjacency_offsets[v + 1u] = adjacency_offsets[v] + remaining_triangles_nb[v];
+
+	std::vector<std::uint32_t> adjacency(triangles_nb * 3u);
+	{
+		std::vector<std::uint32_t> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (std::size_t t = 0u; t < triangles_nb; ++t)
+			for (std::size_t j = 0u; j < 3u; ++j)
+				adjacency[fill_offsets[indices[t * 3u + j]]++] = static_cast<std::uint32_t>(t);
+	}
+
+	std::vector<int> cache_positions(vertices_nb, -1);
+	std::vector<float> vertex_scores(vertices_nb);
+	for (std::size_t v = 0u; v < vertices_nb; ++v)
+		vertex_scores[v] = computeVertexScore(-1, remaining_triangles_nb[v]);
+
+	std::vector<bool> is_emitted(triangles_nb, false);
+	std::vector<GLuint> output;
+	output.reserve(triangles_nb * 3u);
+
+	std::vector<GLuint> cache, next_cache;
+	cache.reserve(forsyth_cache_size + 3u);
+	next_cache.reserve(forsyth_cache_size + 3u);
+
+	std::size_t scan_cursor = 0u;
+	auto best_triangle = std::numeric_limits<std::size_t>::max();
+	for (std::size_t emitted_nb = 0u; emitted_nb < triangles_nb; ++emitted_nb) {
+		// Only triangles touching the cache get considered after each
+		// step; when none is left, fall back to the first non-emitted
+		// triangle, which keeps the whole pass linear.
+		if (best_triangle == std::numeric_limits<std::size_t>::max()) {
+			while (is_emitted[scan_cursor])
+				++scan_cursor;
+			best_triangle = scan_cursor;
+		}
+
+		is_emitted[best_triangle] = true;
+		GLuint const* const triangle = indices + best_triangle * 3u;
+		output.insert(output.end(), triangle, triangle + 3u);
+
+		// Remove the triangle from its vertices' adjacency lists.
+		for (std::size_t j = 0u; j < 3u; ++j) {
+			auto const vertex = triangle[j];
+			auto const begin = adjacency.begin() + adjacency_offsets[vertex];
+			auto const end = begin + remaining_triangles_nb[vertex];
+			auto const it = std::find(begin, end, static_cast<std::uint32_t>(best_triangle));
+			assert(it != end);
+			std::iter_swap(it, end - 1);
+			--remaining_triangles_nb[vertex];
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache.
+		next_cache.assign(triangle, triangle + 3u);
+		for (auto const vertex : cache)
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				next_cache.push_back(vertex);
+		std::swap(cache, next_cache);
+
+		for (std::size_t i = 0u; i < cache.size(); ++i) {
+			auto const vertex = cache[i];
+			cache_positions[vertex] = i < forsyth_cache_size ? static_cast<int>(i) : -1;
+			vertex_scores[vertex] = computeVertexScore(cache_positions[vertex], remaining_triangles_nb[vertex]);
+		}
+		if (cache.size() > forsyth_cache_size)
+			cache.resize(forsyth_cache_size);
+
+		// Rescore the triangles touching the cache and pick the best.
+		best_triangle = std::numeric_limits<std::size_t>::max();
+		auto best_score = -1.0f;
+		for (auto const vertex : cache) {
+			auto const begin = adjacency_offsets[vertex];
+			for (auto k = begin; k < begin + remaining_triangles_nb[vertex]; ++k) {
+				auto const t = adjacency[k];
+				auto const score = vertex_scores[indices[t * 3u]]
+				                 + vertex_scores[indices[t * 3u + 1u]]
+				                 + vertex_scores[indices[t * 3u + 2u]];
+				if (score > best_score) {
+					best_score = score;
+					best_triangle = t;
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void
+bonobo::mesh_optimizer::optimizeOverdraw(GLuint* indices, std::size_t indices_nb,
+                                         glm::vec3 const* positions, std::size_t vertices_nb,
+                                         float threshold)
+{
+	auto const triangles_nb = indices_nb / 3u;
+	if (triangles_nb == 0u)
+		return;
+
+	auto const cluster_starts = findClusters(indices, indices_nb, vertices_nb);
+	if (cluster_starts.size() < 2u)
+		return;
+
+	auto mesh_centroid = glm::vec3(0.0f);
+	for (std::size_t v = 0u; v < vertices_nb; ++v)
+		mesh_centroid += positions[v];
+	mesh_centroid /= static_cast<float>(vertices_nb);
+
+	// Clusters whose area-weighted normal points away from the centre of
+	// the mesh are likely to occlude the others, so draw them first.
+	std::vector<float> sort_keys(cluster_starts.size());
+	for (std::size_t c = 0u; c < cluster_starts.size(); ++c) {
+		auto const first = cluster_starts[c];
+		auto const last = c + 1u < cluster_starts.size() ? cluster_starts[c + 1u] : triangles_nb;
+
+		auto centroid = glm::vec3(0.0f);
+		auto normal = glm::vec3(0.0f);
+		auto area = 0.0f;
+		for (auto t = first; t < last; ++t) {
+			auto const& p0 = positions[indices[t * 3u]];
+			auto const& p1 = positions[indices[t * 3u + 1u]];
+			auto const& p2 = positions[indices[t * 3u + 2u]];
+			auto const weighted_normal = glm::cross(p1 - p0, p2 - p0);
+			auto const triangle_area = glm::length(weighted_normal);
+			centroid += (p0 + p1 + p2) * (triangle_area / 3.0f);
+			normal += weighted_normal;
+			area += triangle_area;
+		}
+		if (area > 0.0f)
+			centroid /= area;
+		auto const normal_length = glm::length(normal);
+		if (normal_length > 0.0f)
+			normal /= normal_length;
+
+		sort_keys[c] = glm::dot(centroid - mesh_centroid, normal);
+	}
+
+	std::vector<std::size_t> cluster_order(cluster_starts.size());
+	std::iota(cluster_order.begin(), cluster_order.end(), 0u);
+	std::stable_sort(cluster_order.begin(), cluster_order.end(),
+	                 [&sort_keys](std::size_t lhs, std::size_t rhs) {
+	                         return sort_keys[lhs] > sort_keys[rhs];
+	                 });
+
+	std::vector<GLuint> output;
+	output.reserve(triangles_nb * 3u);
+	for (auto const c : cluster_order) {
+		auto const first = cluster_starts[c];
+		auto const last = c + 1u < cluster_starts.size() ? cluster_starts[c + 1u] : triangles_nb;
+		output.insert(output.end(), indices + first * 3u, indices + last * 3u);
+	}
+
+	auto const acmr_before = computeACMR(indices, triangles_nb * 3u, vertices_nb);
+	auto const acmr_after = computeACMR(output.data(), output.size(), vertices_nb);
+	if (acmr_after > acmr_before * threshold)
+		return;
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+std::vector<GLuint>
+bonobo::mesh_optimizer::optimizeVertexFetch(GLuint* indices, std::size_t indices_nb,
+                                            std::size_t vertices_nb)
+{
+	auto const unassigned = std::numeric_limits<GLuint>::max();
+	std::vector<GLuint> old_to_new(vertices_nb, unassigned);
+	std::vector<GLuint> new_to_old;
+	new_to_old.reserve(vertices_nb);
+
+	for (std::size_t i = 0u; i < indices_nb; ++i) {
+		auto& new_index = old_to_new[indices[i]];
+		if (new_index == unassigned) {
+			new_index = static_cast<GLuint>(new_to_old.size());
+			new_to_old.push_back(indices[i]);
+		}
+		indices[i] = new_index;
+	}
+
+	return new_to_old;
+}
+
+bonobo::mesh_optimizer::statistics
+bonobo::mesh_optimizer::optimize(mesh_source& mesh)
+{
+	statistics stats;
+	if (mesh.drawing_mode != GL_TRIANGLES || mesh.indices == nullptr
+	    || mesh.vertices == nullptr || mesh.indices_nb < 3u)
+		return stats;
+
+	// Trailing indices not making up a whole triangle would not be drawn
+	// anyway, and would be left pointing at the old vertices; drop them.
+	auto const indices_nb = static_cast<std::size_t>(mesh.indices_nb - mesh.indices_nb % 3u);
+
+	if (mesh.indices != mesh.indices_storage.data())
+		mesh.indices_storage.assign(mesh.indices, mesh.indices + indices_nb);
+	else
+		mesh.indices_storage.resize(indices_nb);
+	auto* const indices = mesh.indices_storage.data();
+	mesh.indices = indices;
+	mesh.indices_nb = static_cast<std::uint32_t>(indices_nb);
+
+	stats.acmr_before = computeACMR(indices, indices_nb, mesh.vertices_nb);
+
+	optimizeVertexCache(indices, indices_nb, mesh.vertices_nb);
+	optimizeOverdraw(indices, indices_nb, mesh.vertices, mesh.vertices_nb);
+	remapAttributes(mesh, optimizeVertexFetch(indices, indices_nb, mesh.vertices_nb));
+
+	stats.acmr_after = computeACMR(indices, indices_nb, mesh.vertices_nb);
+	return stats;
+}
+
+void
+bonobo::mesh_optimizer::optimizeMeshlets(mesh_source& mesh, std::vector<meshlet> const& meshlets,
+                                         statistics& stats)
+{
+	if (meshlets.empty() || mesh.indices != mesh.indices_storage.data())
+		return;
+	auto* const indices = mesh.indices_storage.data();
+
+	// Each meshlet gets optimised on its own vertices, renumbered from 0,
+	// so that the work stays proportional to its size.
+	auto const unassigned = std::numeric_limits<GLuint>::max();
+	std::vector<GLuint> global_to_local(mesh.vertices_nb, unassigned);
+	std::vector<GLuint> local_to_global;
+	std::vector<GLuint> local_indices;
+	for (auto const& cluster : meshlets) {
+		auto* const cluster_indices = indices + cluster.first_index;
+		auto const cluster_indices_nb = 3u * static_cast<std::size_t>(cluster.triangles_nb);
+		local_to_global.clear();
+		local_indices.resize(cluster_indices_nb);
+		for (std::size_t i = 0u; i < cluster_indices_nb; ++i) {
+			auto& local = global_to_local[cluster_indices[i]];
+			if (local == unassigned) {
+				local = static_cast<GLuint>(local_to_global.size());
+				local_to_global.push_back(cluster_indices[i]);
+			}
+			local_indices[i] = local;
+		}
+
+		optimizeVertexCache(local_indices.data(), cluster_indices_nb, local_to_global.size());
+
+		for (std::size_t i = 0u; i < cluster_indices_nb; ++i)
+			cluster_indices[i] = local_to_global[local_indices[i]];
+		for (auto const v : local_to_global)
+			global_to_local[v] = unassigned;
+	}
+
+	auto const indices_nb = static_cast<std::size_t>(mesh.indices_nb - mesh.indices_nb % 3u);
+	remapAttributes(mesh, optimizeVertexFetch(indices, indices_nb, mesh.vertices_nb));
+
+	stats.acmr_after = computeACMR(indices, indices_nb, mesh.vertices_nb);
+}
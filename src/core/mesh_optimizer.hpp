@@ -0,0 +1,74 @@
+#pragma once
+
+#include "mesh_upload.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace bonobo
+{
+	namespace mesh_optimizer
+	{
+		//! \brief Size of the FIFO post-transform cache used for
+		//!        simulating and reporting cache efficiency.
+		constexpr std::size_t simulated_cache_size = 32u;
+
+		//! \brief Compute the Average Cache Miss Ratio of a triangle list,
+		//!        i.e. the average number of vertex shader invocations per
+		//!        triangle, by simulating a FIFO post-transform cache.
+		//!
+		//! @return a value between 0.5 (best case on regular grids) and 3
+		//!         (no vertex reuse at all)
+		float computeACMR(GLuint const* indices, std::size_t indices_nb,
+		                  std::size_t vertices_nb,
+		                  std::size_t cache_size = simulated_cache_size);
+
+		//! \brief Reorder triangles for post-transform cache locality,
+		//!        following Tom Forsyth's "Linear-Speed Vertex Cache
+		//!        Optimisation".
+		void optimizeVertexCache(GLuint* indices, std::size_t indices_nb,
+		                         std::size_t vertices_nb);
+
+		//! \brief Reorder clusters of triangles so that outward-facing
+		//!        ones get drawn first, reducing overdraw.
+		//!
+		//! Clusters are delimited where the cache-optimised order starts a
+		//! triangle with no cached vertex, so that the reordering mostly
+		//! preserves cache efficiency; the new order is discarded if it
+		//! raises the ACMR above `threshold` times its previous value.
+		void optimizeOverdraw(GLuint* indices, std::size_t indices_nb,
+		                      glm::vec3 const* positions, std::size_t vertices_nb,
+		                      float threshold = 1.05f);
+
+		//! \brief Renumber vertices in the order they are first referenced,
+		//!        so that vertex fetching walks the buffer linearly.
+		//!
+		//! @return for each new vertex, the index of the old vertex it
+		//!         comes from; unreferenced vertices are dropped
+		std::vector<GLuint> optimizeVertexFetch(GLuint* indices, std::size_t indices_nb,
+		                                        std::size_t vertices_nb);
+
+		struct statistics {
+			float acmr_before{ 0.0f };
+			float acmr_after{ 0.0f };
+		};
+
+		//! \brief Run all the passes above on a triangle mesh.
+		//!
+		//! The mesh is made to own its indices and attributes, which are
+		//! rewritten in place; trailing indices not making up a whole
+		//! triangle are dropped. Meshes not made of triangles are left
+		//! untouched.
+		statistics optimize(mesh_source& mesh);
+
+		//! \brief Restore cache locality within each meshlet, after
+		//!        `meshlet_builder::build()` reordered the triangles of a
+		//!        mesh processed by `optimize()`.
+		//!
+		//! The triangles of each meshlet are reordered among themselves,
+		//! and the vertices renumbered again for fetching; meshlets stay
+		//! valid. `stats.acmr_after` is updated to the final order.
+		void optimizeMeshlets(mesh_source& mesh, std::vector<meshlet> const& meshlets,
+		                      statistics& stats);
+	}
+}
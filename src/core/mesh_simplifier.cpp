@@ -0,0 +1,272 @@
+#include "mesh_simplifier.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace
+{
+	// Below that cosine between the normals of a triangle before and
+	// after a collapse, the triangle is considered flipped, or close
+	// enough to it to look wrong.
+	constexpr double min_flip_cosine = 0.25;
+
+	// Levels reducing the triangle count by less than that are not worth
+	// their memory.
+	constexpr float max_kept_ratio = 0.9f;
+
+	//! \brief Sum of squared distances to a set of planes, weighted by
+	//!        the areas of the triangles they come from.
+	struct quadric {
+		double a2{ 0.0 }, ab{ 0.0 }, ac{ 0.0 }, ad{ 0.0 };
+		double b2{ 0.0 }, bc{ 0.0 }, bd{ 0.0 };
+		double c2{ 0.0 }, cd{ 0.0 };
+		double d2{ 0.0 };
+		double area{ 0.0 };
+
+		void addPlane(glm::dvec3 const& normal, double d, double weight)
+		{
+			a2 += weight * normal.x * normal.x;
+			ab += weight * normal.x * normal.y;
+			ac += weight * normal.x * normal.z;
+			ad += weight * normal.x * d;
+			b2 += weight * normal.y * normal.y;
+			bc += weight * normal.y * normal.z;
+			bd += weight * normal.y * d;
+			c2 += weight * normal.z * normal.z;
+			cd += weight * normal.z * d;
+			d2 += weight * d * d;
+			area += weight;
+		}
+
+		void add(quadric const& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+			area += other.area;
+		}
+
+		// Returns the mean squared distance of `p` to the planes.
+		double evaluate(quadric const& other, glm::dvec3 const& p) const
+		{
+			auto const x = p.x, y = p.y, z = p.z;
+			auto const sum = (a2 + other.a2) * x * x + 2.0 * (ab + other.ab) * x * y + 2.0 * (ac + other.ac) * x * z + 2.0 * (ad + other.ad) * x
+			               + (b2 + other.b2) * y * y + 2.0 * (bc + other.bc) * y * z + 2.0 * (bd + other.bd) * y
+			               + (c2 + other.c2) * z * z + 2.0 * (cd + other.cd) * z
+			               + (d2 + other.d2);
+			auto const total_area = area + other.area;
+			return total_area > 0.0 ? std::max(sum, 0.0) / total_area : 0.0;
+		}
+	};
+
+	struct collapse {
+		float cost;
+		float distance_squared;
+		std::uint32_t from;
+		std::uint32_t to;
+		std::uint32_t from_version;
+		std::uint32_t to_version;
+
+		bool operator>(collapse const& other) const { return cost > other.cost; }
+	};
+}
+
+std::vector<bonobo::lod_source>
+bonobo::mesh_simplifier::build(mesh_source const& mesh, std::size_t lods_nb, float attributes_weight)
+{
+	std::vector<lod_source> lods;
+	if (mesh.drawing_mode != GL_TRIANGLES || mesh.indices == nullptr
+	    || mesh.vertices == nullptr || mesh.indices_nb < 3u || lods_nb == 0u)
+		return lods;
+
+	auto const triangles_nb = mesh.indices_nb / 3u;
+	auto const vertices_nb = mesh.vertices_nb;
+	auto const* const positions = mesh.vertices;
+	std::vector<GLuint> triangles(mesh.indices, mesh.indices + 3u * triangles_nb);
+
+	// Index of the corner following corner `i` within its triangle.
+	auto const next = [](std::uint32_t i){ return i - i % 3u + (i % 3u + 1u) % 3u; };
+	auto const position = [positions](std::uint32_t v){ return glm::dvec3(positions[v]); };
+	auto const computeNormal = [](glm::dvec3 const& p0, glm::dvec3 const& p1, glm::dvec3 const& p2){
+		return glm::cross(p1 - p0, p2 - p0);
+	};
+
+	// Gather the planes of the triangles around each vertex.
+	std::vector<quadric> quadrics(vertices_nb);
+	glm::vec3 min_position(std::numeric_limits<float>::max());
+	glm::vec3 max_position(std::numeric_limits<float>::lowest());
+	for (std::uint32_t t = 0u; t < triangles_nb; ++t) {
+		auto const* const triangle = triangles.data() + 3u * t;
+		auto const p0 = position(triangle[0]);
+		auto const normal = computeNormal(p0, position(triangle[1]), position(triangle[2]));
+		auto const double_area = glm::length(normal);
+		if (double_area == 0.0)
+			continue;
+		auto const unit_normal = normal / double_area;
+		auto const d = -glm::dot(unit_normal, p0);
+		for (std::uint32_t k = 0u; k < 3u; ++k)
+			quadrics[triangle[k]].addPlane(unit_normal, d, 0.5 * double_area);
+	}
+	for (std::uint32_t v = 0u; v < vertices_nb; ++v) {
+		min_position = glm::min(min_position, positions[v]);
+		max_position = glm::max(max_position, positions[v]);
+	}
+	auto const diagonal = glm::length(max_position - min_position);
+	auto const attributes_scale = attributes_weight * diagonal * diagonal;
+
+	// Vertices on an edge not shared by exactly two triangles are locked.
+	std::vector<bool> is_locked(vertices_nb, false);
+	{
+		std::unordered_map<std::uint64_t, std::uint32_t> edge_uses;
+		edge_uses.reserve(3u * triangles_nb);
+		auto const edgeKey = [](std::uint32_t a, std::uint32_t b){
+			return (static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+		};
+		for (std::uint32_t i = 0u; i < 3u * triangles_nb; ++i)
+			++edge_uses[edgeKey(triangles[i], triangles[next(i)])];
+		for (auto const& edge : edge_uses)
+			if (edge.second != 2u) {
+				is_locked[static_cast<std::uint32_t>(edge.first >> 32)] = true;
+				is_locked[static_cast<std::uint32_t>(edge.first & 0xffffffffu)] = true;
+			}
+	}
+
+	// Triangles around each vertex; removed triangles and those no longer
+	// using the vertex get skipped, and pruned when a collapse ends on it.
+	std::vector<std::vector<std::uint32_t>> adjacency(vertices_nb);
+	for (std::uint32_t i = 0u; i < 3u * triangles_nb; ++i)
+		adjacency[triangles[i]].push_back(i / 3u);
+
+	std::vector<bool> is_removed(triangles_nb, false);
+	std::vector<std::uint32_t> versions(vertices_nb, 0u);
+	auto const uses = [&triangles](std::uint32_t t, std::uint32_t v){
+		return triangles[3u * t] == v || triangles[3u * t + 1u] == v || triangles[3u * t + 2u] == v;
+	};
+
+	std::priority_queue<collapse, std::vector<collapse>, std::greater<collapse>> candidates;
+	auto const push = [&](std::uint32_t from, std::uint32_t to){
+		if (is_locked[from] || from == to)
+			return;
+		auto const distance_squared = quadrics[from].evaluate(quadrics[to], position(to));
+		auto attributes_difference = 0.0f;
+		if (mesh.normals != nullptr) {
+			auto const difference = mesh.normals[from] - mesh.normals[to];
+			attributes_difference += glm::dot(difference, difference);
+		}
+		if (mesh.texcoords != nullptr) {
+			auto const difference = glm::vec2(mesh.texcoords[from]) - glm::vec2(mesh.texcoords[to]);
+			attributes_difference += glm::dot(difference, difference);
+		}
+		candidates.push({ static_cast<float>(distance_squared) + attributes_scale * attributes_difference,
+		                  static_cast<float>(distance_squared), from, to, versions[from], versions[to] });
+	};
+	for (std::uint32_t i = 0u; i < 3u * triangles_nb; ++i)
+		push(triangles[i], triangles[next(i)]);
+
+	// Moving `from` onto `to` must not flip any of the triangles left.
+	auto const flips = [&](std::uint32_t from, std::uint32_t to){
+		auto const p_to = position(to);
+		for (auto const t : adjacency[from]) {
+			if (is_removed[t] || !uses(t, from) || uses(t, to))
+				continue;
+			glm::dvec3 before[3], after[3];
+			for (std::uint32_t k = 0u; k < 3u; ++k) {
+				auto const v = triangles[3u * t + k];
+				before[k] = position(v);
+				after[k] = v == from ? p_to : before[k];
+			}
+			auto const normal_before = computeNormal(before[0], before[1], before[2]);
+			auto const normal_after = computeNormal(after[0], after[1], after[2]);
+			auto const length_before = glm::length(normal_before);
+			if (length_before == 0.0)
+				continue;
+			// Also rejects triangles becoming degenerate.
+			if (glm::dot(normal_before, normal_after)
+			    <= min_flip_cosine * length_before * glm::length(normal_after))
+				return true;
+		}
+		return false;
+	};
+
+	auto live_triangles_nb = triangles_nb;
+	auto target_triangles_nb = triangles_nb;
+	auto last_lod_triangles_nb = triangles_nb;
+	auto max_distance_squared = 0.0f;
+	auto const emitLod = [&](){
+		lod_source lod;
+		lod.indices.reserve(3u * live_triangles_nb);
+		for (std::uint32_t t = 0u; t < triangles_nb; ++t)
+			if (!is_removed[t])
+				lod.indices.insert(lod.indices.end(), triangles.begin() + 3u * t, triangles.begin() + 3u * t + 3u);
+		lod.error = std::sqrt(max_distance_squared);
+		lods.push_back(std::move(lod));
+		last_lod_triangles_nb = live_triangles_nb;
+	};
+
+	while (lods.size() < lods_nb) {
+		target_triangles_nb /= 2u;
+		while (live_triangles_nb > target_triangles_nb && !candidates.empty()) {
+			auto const candidate = candidates.top();
+			candidates.pop();
+			auto const from = candidate.from;
+			auto const to = candidate.to;
+			if (candidate.from_version != versions[from] || candidate.to_version != versions[to])
+				continue; // Stale; re-pushed with an up-to-date cost when it changed.
+			if (flips(from, to))
+				continue;
+
+			// Remove the triangles along the edge, and make the others
+			// use `to` instead of `from`.
+			for (auto const t : adjacency[from]) {
+				if (is_removed[t] || !uses(t, from))
+					continue;
+				if (uses(t, to)) {
+					is_removed[t] = true;
+					--live_triangles_nb;
+					continue;
+				}
+				for (std::uint32_t k = 0u; k < 3u; ++k)
+					if (triangles[3u * t + k] == from)
+						triangles[3u * t + k] = to;
+				adjacency[to].push_back(t);
+			}
+			adjacency[from].clear();
+			quadrics[to].add(quadrics[from]);
+			max_distance_squared = std::max(max_distance_squared, candidate.distance_squared);
+
+			// `from` is gone, and all collapses involving `to` changed.
+			++versions[from];
+			++versions[to];
+			auto& around = adjacency[to];
+			around.erase(std::remove_if(around.begin(), around.end(),
+			                            [&](std::uint32_t t){ return is_removed[t] || !uses(t, to); }),
+			             around.end());
+			for (auto const t : around) {
+				for (std::uint32_t k = 0u; k < 3u; ++k) {
+					auto const v = triangles[3u * t + k];
+					if (v == to)
+						continue;
+					push(v, to);
+					push(to, v);
+				}
+			}
+		}
+
+		if (live_triangles_nb == 0u
+		    || static_cast<float>(live_triangles_nb) > max_kept_ratio * static_cast<float>(last_lod_triangles_nb))
+			break;
+		emitLod();
+		if (live_triangles_nb > target_triangles_nb)
+			break; // Simplification got stuck.
+	}
+
+	return lods;
+}
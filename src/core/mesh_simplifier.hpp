@@ -0,0 +1,46 @@
+#pragma once
+
+#include "mesh_upload.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace bonobo
+{
+	namespace mesh_simplifier
+	{
+		//! \brief Default number of levels of detail, each keeping half the
+		//!        triangles of the previous one: 50%, 25% and 12.5%.
+		constexpr std::size_t lods_nb = 3u;
+
+		//! \brief Default weight of the difference in normals and texture
+		//!        coordinates in the cost of a collapse, relative to the
+		//!        squared distance to the original surface expressed as a
+		//!        fraction of the mesh's diagonal.
+		constexpr float attributes_weight = 0.01f;
+
+		//! \brief Build a chain of simplified index lists for a triangle
+		//!        mesh, all referencing its existing vertices.
+		//!
+		//! Edges are collapsed one vertex onto the other, cheapest first,
+		//! following Garland and Heckbert's "Surface Simplification Using
+		//! Quadric Error Metrics", with the cost of moving a vertex also
+		//! accounting for how much its normal and texture coordinates
+		//! differ from the ones of the vertex it collapses onto. As no
+		//! vertex ever moves or gets created, all levels can share the
+		//! vertex buffer of the mesh. Vertices on borders, which include
+		//! the seams where attributes got split, are never removed, and
+		//! collapses flipping a triangle are rejected; a level is thus
+		//! left out when simplification gets stuck before halving the
+		//! triangles of the previous one. Meshes not made of triangles
+		//! get no levels.
+		//!
+		//! @param [in] mesh mesh to simplify
+		//! @param [in] lods_nb maximum number of levels to build
+		//! @param [in] attributes_weight see `mesh_simplifier::attributes_weight`
+		//! @return the levels, from the most to the least detailed
+		std::vector<lod_source> build(mesh_source const& mesh,
+		                              std::size_t lods_nb = mesh_simplifier::lods_nb,
+		                              float attributes_weight = mesh_simplifier::attributes_weight);
+	}
+}
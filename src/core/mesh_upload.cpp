@@ -0,0 +1,416 @@
+#include "mesh_upload.hpp"
+
+#include "GeometryArena.hpp"
+
+#include "core/opengl.hpp"
+#include "core/UploadManager.hpp"
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace
+{
+	constexpr std::size_t attributes_nb = 5u;
+
+	std::uint32_t getAttributeBit(bonobo::shader_bindings attribute)
+	{
+		return 1u << static_cast<unsigned int>(attribute);
+	}
+
+	// Attributes of a mesh, in the order of `shader_bindings`.
+	std::array<glm::vec3 const*, attributes_nb> getAttributes(bonobo::mesh_source const& mesh)
+	{
+		return { { mesh.vertices, mesh.normals, mesh.texcoords, mesh.tangents, mesh.binormals } };
+	}
+
+	// Offset of each attribute within `bonobo::interleaved_vertex`.
+	std::array<std::size_t, attributes_nb> const interleaved_offsets = { {
+		offsetof(bonobo::interleaved_vertex, vertex),
+		offsetof(bonobo::interleaved_vertex, normal),
+		offsetof(bonobo::interleaved_vertex, texcoord),
+		offsetof(bonobo::interleaved_vertex, tangent),
+		offsetof(bonobo::interleaved_vertex, binormal)
+	} };
+
+	// Same for the packed layouts, where binormals point to the w
+	// component of the position, holding their sign.
+	std::array<std::size_t, attributes_nb> const packed_offsets = { {
+		offsetof(bonobo::packed_vertex, vertex),
+		offsetof(bonobo::packed_vertex, normal),
+		offsetof(bonobo::packed_vertex, texcoord),
+		offsetof(bonobo::packed_vertex, tangent),
+		offsetof(bonobo::packed_vertex, vertex) + 3u * sizeof(float)
+	} };
+	std::array<std::size_t, attributes_nb> const packed_quantized_offsets = { {
+		offsetof(bonobo::packed_quantized_vertex, vertex),
+		offsetof(bonobo::packed_quantized_vertex, normal),
+		offsetof(bonobo::packed_quantized_vertex, texcoord),
+		offsetof(bonobo::packed_quantized_vertex, tangent),
+		offsetof(bonobo::packed_quantized_vertex, vertex) + 3u * sizeof(std::uint16_t)
+	} };
+
+	static_assert(sizeof(bonobo::packed_vertex) == 28u, "packed_vertex should not have any padding");
+	static_assert(sizeof(bonobo::packed_quantized_vertex) == 20u, "packed_quantized_vertex should not have any padding");
+
+	std::int16_t toSnorm16(float value)
+	{
+		return static_cast<std::int16_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	std::uint16_t toUnorm16(float value)
+	{
+		return static_cast<std::uint16_t>(std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	// Project the unit vector onto the octahedron |x| + |y| + |z| = 1,
+	// then fold the lower half over the upper one.
+	void encodeOctahedral(glm::vec3 const& vector, std::int16_t (&encoded)[2])
+	{
+		auto const l1_norm = std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z);
+		if (l1_norm == 0.0f) {
+			encoded[0] = encoded[1] = 0;
+			return;
+		}
+
+		auto projected = glm::vec2(vector.x, vector.y) / l1_norm;
+		if (vector.z < 0.0f) {
+			auto const signs = glm::vec2(projected.x >= 0.0f ? 1.0f : -1.0f,
+			                             projected.y >= 0.0f ? 1.0f : -1.0f);
+			projected = (glm::vec2(1.0f) - glm::abs(glm::vec2(projected.y, projected.x))) * signs;
+		}
+		encoded[0] = toSnorm16(projected.x);
+		encoded[1] = toSnorm16(projected.y);
+	}
+
+	// Bounds of the positions and texture coordinates, which the packed
+	// layouts store normalised.
+	bonobo::vertex_decoding getPackedDecoding(bonobo::mesh_source const& mesh, bool quantize_positions)
+	{
+		auto const get_scale = [](float extent){ return extent > 0.0f ? extent : 1.0f; };
+
+		bonobo::vertex_decoding decoding;
+		decoding.is_packed = true;
+		if (quantize_positions && mesh.vertices_nb > 0u) {
+			auto min_position = mesh.vertices[0];
+			auto max_position = mesh.vertices[0];
+			for (std::uint32_t i = 1u; i < mesh.vertices_nb; ++i) {
+				min_position = glm::min(min_position, mesh.vertices[i]);
+				max_position = glm::max(max_position, mesh.vertices[i]);
+			}
+			auto const extent = max_position - min_position;
+			decoding.position_offset = min_position;
+			decoding.position_scale = glm::vec3(get_scale(extent.x), get_scale(extent.y), get_scale(extent.z));
+		}
+		if (mesh.texcoords != nullptr && mesh.vertices_nb > 0u) {
+			auto min_texcoord = glm::vec2(mesh.texcoords[0]);
+			auto max_texcoord = glm::vec2(mesh.texcoords[0]);
+			for (std::uint32_t i = 1u; i < mesh.vertices_nb; ++i) {
+				min_texcoord = glm::min(min_texcoord, glm::vec2(mesh.texcoords[i]));
+				max_texcoord = glm::max(max_texcoord, glm::vec2(mesh.texcoords[i]));
+			}
+			auto const extent = max_texcoord - min_texcoord;
+			decoding.texcoord_offset = min_texcoord;
+			decoding.texcoord_scale = glm::vec2(get_scale(extent.x), get_scale(extent.y));
+		}
+		return decoding;
+	}
+
+	void setPosition(bonobo::packed_vertex& vertex, glm::vec3 const& position, bool is_binormal_positive,
+	                 bonobo::vertex_decoding const& /*decoding*/)
+	{
+		vertex.vertex = glm::vec4(position, is_binormal_positive ? 1.0f : 0.0f);
+	}
+
+	void setPosition(bonobo::packed_quantized_vertex& vertex, glm::vec3 const& position, bool is_binormal_positive,
+	                 bonobo::vertex_decoding const& decoding)
+	{
+		auto const normalised = (position - decoding.position_offset) / decoding.position_scale;
+		vertex.vertex[0] = toUnorm16(normalised.x);
+		vertex.vertex[1] = toUnorm16(normalised.y);
+		vertex.vertex[2] = toUnorm16(normalised.z);
+		vertex.vertex[3] = is_binormal_positive ? 65535u : 0u;
+	}
+
+	template<typename Vertex>
+	void uploadPackedAttributes(bonobo::mesh_source const& mesh, bonobo::vertex_layout_t layout, GLuint bo,
+	                            std::uint32_t vertices_capacity, std::uint32_t base_vertex,
+	                            bonobo::vertex_decoding const& decoding)
+	{
+		std::vector<Vertex> vertices(mesh.vertices_nb);
+		for (size_t i = 0u; i < vertices.size(); ++i) {
+			auto& vertex = vertices[i];
+
+			auto const normal = mesh.normals != nullptr ? glm::normalize(mesh.normals[i]) : glm::vec3(0.0f, 0.0f, 1.0f);
+			encodeOctahedral(normal, vertex.normal);
+
+			auto is_binormal_positive = true;
+			if (mesh.tangents != nullptr) {
+				encodeOctahedral(glm::normalize(mesh.tangents[i]), vertex.tangent);
+				if (mesh.binormals != nullptr)
+					is_binormal_positive = glm::dot(glm::cross(normal, mesh.tangents[i]), mesh.binormals[i]) >= 0.0f;
+			} else {
+				vertex.tangent[0] = vertex.tangent[1] = 0;
+			}
+
+			setPosition(vertex, mesh.vertices[i], is_binormal_positive, decoding);
+
+			if (mesh.texcoords != nullptr) {
+				auto const normalised = (glm::vec2(mesh.texcoords[i]) - decoding.texcoord_offset) / decoding.texcoord_scale;
+				vertex.texcoord[0] = toUnorm16(normalised.x);
+				vertex.texcoord[1] = toUnorm16(normalised.y);
+			} else {
+				vertex.texcoord[0] = vertex.texcoord[1] = 0u;
+			}
+		}
+
+		auto const offset = bonobo::getAttributeOffset(layout, bonobo::getAttributesMask(mesh), vertices_capacity,
+		                                               bonobo::shader_bindings::vertices, base_vertex);
+		auto const size = static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex));
+		UploadManager::GetShared().UploadBuffer(bo, static_cast<GLintptr>(offset), size, vertices.data());
+	}
+
+	void uploadPlanarAttributes(bonobo::mesh_source const& mesh, GLuint bo,
+	                            std::uint32_t vertices_capacity, std::uint32_t base_vertex)
+	{
+		auto& upload_manager = UploadManager::GetShared();
+		auto const attributes_mask = bonobo::getAttributesMask(mesh);
+		auto const attributes = getAttributes(mesh);
+		auto const attribute_size = static_cast<GLsizeiptr>(mesh.vertices_nb * sizeof(glm::vec3));
+
+		for (std::size_t i = 0u; i < attributes_nb; ++i) {
+			if (attributes[i] == nullptr)
+				continue;
+
+			auto const offset = bonobo::getAttributeOffset(bonobo::vertex_layout_t::planar, attributes_mask, vertices_capacity,
+			                                               static_cast<bonobo::shader_bindings>(i), base_vertex);
+			upload_manager.UploadBuffer(bo, static_cast<GLintptr>(offset), attribute_size, attributes[i]);
+		}
+	}
+
+	void uploadInterleavedAttributes(bonobo::mesh_source const& mesh, GLuint bo,
+	                                 std::uint32_t vertices_capacity, std::uint32_t base_vertex)
+	{
+		std::vector<bonobo::interleaved_vertex> vertices(mesh.vertices_nb);
+		for (size_t i = 0u; i < vertices.size(); ++i) {
+			auto& vertex = vertices[i];
+			vertex.vertex = mesh.vertices[i];
+			vertex.normal = mesh.normals != nullptr ? mesh.normals[i] : glm::vec3(0.0f);
+			vertex.texcoord = mesh.texcoords != nullptr ? glm::vec2(mesh.texcoords[i]) : glm::vec2(0.0f);
+			vertex.tangent = mesh.tangents != nullptr ? mesh.tangents[i] : glm::vec3(0.0f);
+			vertex.binormal = mesh.binormals != nullptr ? mesh.binormals[i] : glm::vec3(0.0f);
+		}
+
+		auto const offset = bonobo::getAttributeOffset(bonobo::vertex_layout_t::interleaved, bonobo::getAttributesMask(mesh), vertices_capacity,
+		                                               bonobo::shader_bindings::vertices, base_vertex);
+		auto const size = static_cast<GLsizeiptr>(vertices.size() * sizeof(bonobo::interleaved_vertex));
+		UploadManager::GetShared().UploadBuffer(bo, static_cast<GLintptr>(offset), size, vertices.data());
+	}
+}
+
+std::uint32_t
+bonobo::getAttributesMask(mesh_source const& mesh)
+{
+	auto const attributes = getAttributes(mesh);
+
+	std::uint32_t attributes_mask = 0u;
+	for (std::size_t i = 0u; i < attributes_nb; ++i)
+		if (attributes[i] != nullptr)
+			attributes_mask |= getAttributeBit(static_cast<shader_bindings>(i));
+	return attributes_mask;
+}
+
+std::size_t
+bonobo::getVertexSize(vertex_layout_t layout, std::uint32_t attributes_mask)
+{
+	switch (layout) {
+	case vertex_layout_t::interleaved:      return sizeof(interleaved_vertex);
+	case vertex_layout_t::packed:           return sizeof(packed_vertex);
+	case vertex_layout_t::packed_quantized: return sizeof(packed_quantized_vertex);
+	case vertex_layout_t::planar:           break;
+	}
+
+	std::size_t vertex_size = 0u;
+	for (std::size_t i = 0u; i < attributes_nb; ++i)
+		if ((attributes_mask & getAttributeBit(static_cast<shader_bindings>(i))) != 0u)
+			vertex_size += sizeof(glm::vec3);
+	return vertex_size;
+}
+
+std::size_t
+bonobo::getAttributeOffset(vertex_layout_t layout, std::uint32_t attributes_mask,
+                           std::uint32_t vertices_capacity,
+                           shader_bindings attribute, std::uint32_t vertex_index)
+{
+	auto const attribute_index = static_cast<std::size_t>(attribute);
+	switch (layout) {
+	case vertex_layout_t::interleaved:      return vertex_index * sizeof(interleaved_vertex) + interleaved_offsets[attribute_index];
+	case vertex_layout_t::packed:           return vertex_index * sizeof(packed_vertex) + packed_offsets[attribute_index];
+	case vertex_layout_t::packed_quantized: return vertex_index * sizeof(packed_quantized_vertex) + packed_quantized_offsets[attribute_index];
+	case vertex_layout_t::planar:           break;
+	}
+
+	std::size_t region_offset = 0u;
+	for (std::size_t i = 0u; i < attribute_index; ++i)
+		if ((attributes_mask & getAttributeBit(static_cast<shader_bindings>(i))) != 0u)
+			region_offset += vertices_capacity * sizeof(glm::vec3);
+	return region_offset + vertex_index * sizeof(glm::vec3);
+}
+
+void
+bonobo::setupVertexAttributes(vertex_layout_t layout, std::uint32_t attributes_mask,
+                              std::uint32_t vertices_capacity)
+{
+	auto const is_packed = layout == vertex_layout_t::packed || layout == vertex_layout_t::packed_quantized;
+	auto const stride = layout == vertex_layout_t::planar ? 0 : static_cast<GLsizei>(getVertexSize(layout, attributes_mask));
+	for (std::size_t i = 0u; i < attributes_nb; ++i) {
+		auto const attribute = static_cast<shader_bindings>(i);
+		if ((attributes_mask & getAttributeBit(attribute)) == 0u)
+			continue;
+
+		// Interleaved texture coordinates only keep two components.
+		GLint components_nb = layout == vertex_layout_t::interleaved && attribute == shader_bindings::texcoords ? 2 : 3;
+		GLenum type = GL_FLOAT;
+		GLboolean is_normalized = GL_FALSE;
+		if (is_packed) {
+			switch (attribute) {
+			case shader_bindings::vertices:
+				// The w component holds the sign of the binormal.
+				components_nb = 4;
+				if (layout == vertex_layout_t::packed_quantized) {
+					type = GL_UNSIGNED_SHORT;
+					is_normalized = GL_TRUE;
+				}
+				break;
+			case shader_bindings::normals:
+			case shader_bindings::tangents:
+				components_nb = 2;
+				type = GL_SHORT;
+				is_normalized = GL_TRUE;
+				break;
+			case shader_bindings::texcoords:
+				components_nb = 2;
+				type = GL_UNSIGNED_SHORT;
+				is_normalized = GL_TRUE;
+				break;
+			case shader_bindings::binormals:
+				continue;
+			}
+		}
+
+		auto const offset = getAttributeOffset(layout, attributes_mask, vertices_capacity, attribute, 0u);
+		glEnableVertexAttribArray(static_cast<unsigned int>(attribute));
+		glVertexAttribPointer(static_cast<unsigned int>(attribute), components_nb, type, is_normalized, stride, reinterpret_cast<GLvoid const*>(offset));
+	}
+}
+
+bonobo::mesh_data
+bonobo::uploadMesh(mesh_source const& mesh, mesh_upload_options const& options)
+{
+	bonobo::mesh_data object;
+	object.name = mesh.name;
+	object.drawing_mode = mesh.drawing_mode;
+	object.vertices_nb = static_cast<GLsizei>(mesh.vertices_nb);
+	object.indices_nb = static_cast<GLsizei>(mesh.indices_nb);
+
+	// With a base vertex, indices are relative to the mesh's first vertex,
+	// so sharing a buffer does not prevent using short indices.
+	auto const use_short_indices = options.allow_short_indices && mesh.vertices_nb <= std::numeric_limits<GLushort>::max() + 1u;
+	object.indices_type = use_short_indices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	auto const index_size = use_short_indices ? sizeof(GLushort) : sizeof(GLuint);
+	std::size_t indices_total_nb = mesh.indices_nb;
+	for (auto const& lod : mesh.lods)
+		indices_total_nb += lod.indices.size();
+	auto const ibo_size = indices_total_nb * index_size;
+
+	auto const attributes_mask = getAttributesMask(mesh);
+	auto vertices_capacity = mesh.vertices_nb;
+	if (options.use_geometry_arena) {
+		auto const allocation = GeometryArena::GetShared().Allocate(options.vertex_layout, attributes_mask,
+		                                                            mesh.vertices_nb, ibo_size);
+		object.vao = allocation.vao;
+		object.bo = allocation.bo;
+		object.ibo = allocation.ibo;
+		object.base_vertex = allocation.base_vertex;
+		object.indices_offset = allocation.indices_offset;
+		object.is_in_geometry_arena = true;
+		vertices_capacity = allocation.vertices_capacity;
+	} else {
+		glGenVertexArrays(1, &object.vao);
+		assert(object.vao != 0u);
+		glBindVertexArray(object.vao);
+
+		glGenBuffers(1, &object.bo);
+		assert(object.bo != 0u);
+		glBindBuffer(GL_ARRAY_BUFFER, object.bo);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(mesh.vertices_nb * getVertexSize(options.vertex_layout, attributes_mask)),
+		             nullptr, GL_STATIC_DRAW);
+		setupVertexAttributes(options.vertex_layout, attributes_mask, mesh.vertices_nb);
+
+		glGenBuffers(1, &object.ibo);
+		assert(object.ibo != 0u);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.ibo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(ibo_size), nullptr, GL_STATIC_DRAW);
+
+		glBindVertexArray(0u);
+		glBindBuffer(GL_ARRAY_BUFFER, 0u);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+
+		utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, object.vao, object.name + " VAO");
+		utils::opengl::debug::nameObject(GL_BUFFER, object.bo, object.name + " VBO");
+		utils::opengl::debug::nameObject(GL_BUFFER, object.ibo, object.name + " IBO");
+	}
+
+	auto const base_vertex = static_cast<std::uint32_t>(object.base_vertex);
+	switch (options.vertex_layout) {
+	case vertex_layout_t::planar:
+		uploadPlanarAttributes(mesh, object.bo, vertices_capacity, base_vertex);
+		break;
+	case vertex_layout_t::interleaved:
+		uploadInterleavedAttributes(mesh, object.bo, vertices_capacity, base_vertex);
+		break;
+	case vertex_layout_t::packed:
+		object.decoding = getPackedDecoding(mesh, false);
+		uploadPackedAttributes<packed_vertex>(mesh, options.vertex_layout, object.bo, vertices_capacity, base_vertex, object.decoding);
+		break;
+	case vertex_layout_t::packed_quantized:
+		object.decoding = getPackedDecoding(mesh, true);
+		uploadPackedAttributes<packed_quantized_vertex>(mesh, options.vertex_layout, object.bo, vertices_capacity, base_vertex, object.decoding);
+		break;
+	}
+
+	auto const uploadIndices = [&object,use_short_indices,index_size](GLuint const* indices, std::size_t indices_nb, std::size_t offset){
+		auto const size = static_cast<GLsizeiptr>(indices_nb * index_size);
+		if (use_short_indices) {
+			std::vector<GLushort> short_indices(indices, indices + indices_nb);
+			UploadManager::GetShared().UploadBuffer(object.ibo, static_cast<GLintptr>(offset), size, short_indices.data());
+		} else {
+			UploadManager::GetShared().UploadBuffer(object.ibo, static_cast<GLintptr>(offset), size, indices);
+		}
+	};
+	uploadIndices(mesh.indices, mesh.indices_nb, object.indices_offset);
+
+	auto lod_offset = object.indices_offset + mesh.indices_nb * index_size;
+	object.lods.reserve(mesh.lods.size());
+	for (auto const& lod : mesh.lods) {
+		uploadIndices(lod.indices.data(), lod.indices.size(), lod_offset);
+		object.lods.push_back({ lod_offset, static_cast<GLsizei>(lod.indices.size()), lod.error });
+		lod_offset += lod.indices.size() * index_size;
+	}
+
+	// A sphere around the bounding box is loose, but good enough for
+	// picking levels of detail.
+	if (mesh.vertices != nullptr && mesh.vertices_nb > 0u) {
+		glm::vec3 min_position = mesh.vertices[0], max_position = mesh.vertices[0];
+		for (std::uint32_t i = 1u; i < mesh.vertices_nb; ++i) {
+			min_position = glm::min(min_position, mesh.vertices[i]);
+			max_position = glm::max(max_position, mesh.vertices[i]);
+		}
+		object.bounding_center = 0.5f * (min_position + max_position);
+		object.bounding_radius = 0.5f * glm::length(max_position - min_position);
+	}
+
+	return object;
+}
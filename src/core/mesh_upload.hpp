@@ -0,0 +1,118 @@
+#pragma once
+
+#include "helpers.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Coarser version of a mesh, see `mesh_simplifier::build()`.
+	struct lod_source {
+		std::vector<GLuint> indices; //!< referencing the vertices of the full mesh
+		float error{ 0.0f };         //!< estimated maximal distance to the full mesh, in model units
+	};
+
+	//! \brief CPU-side view of a mesh's geometry, before being uploaded.
+	//!
+	//! The attribute and index pointers either point into an Assimp
+	//! scene, into the storage members, into a mapped cache file, or into
+	//! arrays owned by the caller; in all cases they are only valid while
+	//! their owner is alive. Missing attributes are left as `nullptr`.
+	struct mesh_source {
+		std::string name;
+		std::uint32_t material_index{ 0u };
+		GLenum drawing_mode{ GL_TRIANGLES };
+		std::uint32_t vertices_nb{ 0u };
+		std::uint32_t indices_nb{ 0u };
+		glm::vec3 const* vertices{ nullptr };
+		glm::vec3 const* normals{ nullptr };
+		glm::vec3 const* texcoords{ nullptr };
+		glm::vec3 const* tangents{ nullptr };
+		glm::vec3 const* binormals{ nullptr };
+		GLuint const* indices{ nullptr };
+		std::vector<GLuint> indices_storage;
+		std::vector<glm::vec3> attributes_storage; //!< all attributes, one after the other, when owned
+		std::vector<lod_source> lods; //!< uploaded after `indices`, in the same index buffer
+	};
+
+	//! \brief Vertex as stored with `vertex_layout_t::interleaved`.
+	//!
+	//! Texture coordinates only keep their first two components; shaders
+	//! declaring them as `vec3` get 0 as third component. Attributes
+	//! missing from the source mesh are zero-filled and left disabled in
+	//! the VAO.
+	struct interleaved_vertex {
+		glm::vec3 vertex;
+		glm::vec3 normal;
+		glm::vec2 texcoord;
+		glm::vec3 tangent;
+		glm::vec3 binormal;
+	};
+
+	//! \brief Vertex as stored with `vertex_layout_t::packed`, in 28
+	//!        bytes rather than 60 with the planar layout.
+	//!
+	//! Normals and tangents are octahedral-encoded as two signed
+	//! normalised shorts; binormals are not stored, but rebuilt as
+	//! `cross(normal, tangent)` times the sign kept in the w component of
+	//! the position (0 for -1, 1 for +1). Texture coordinates are
+	//! unsigned normalised shorts spanning the mesh's texture coordinate
+	//! bounds. See `vertex_decoding` for how shaders get the values back.
+	struct packed_vertex {
+		glm::vec4 vertex;
+		std::int16_t normal[2];
+		std::int16_t tangent[2];
+		std::uint16_t texcoord[2];
+	};
+
+	//! \brief Vertex as stored with `vertex_layout_t::packed_quantized`,
+	//!        in 20 bytes.
+	//!
+	//! Same as `packed_vertex`, except for the position, stored as
+	//! unsigned normalised shorts spanning the mesh's bounding box.
+	struct packed_quantized_vertex {
+		std::uint16_t vertex[4];
+		std::int16_t normal[2];
+		std::int16_t tangent[2];
+		std::uint16_t texcoord[2];
+	};
+
+	//! \brief Bit set of the attributes present in a mesh, with bit `i`
+	//!        standing for `static_cast<shader_bindings>(i)`.
+	std::uint32_t getAttributesMask(mesh_source const& mesh);
+
+	//! \brief Number of bytes taken by a single vertex.
+	std::size_t getVertexSize(vertex_layout_t layout, std::uint32_t attributes_mask);
+
+	//! \brief Offset in bytes of an attribute of a vertex, within a
+	//!        buffer laid out for `vertices_capacity` vertices.
+	//!
+	//! With the planar layout, each attribute present in
+	//! `attributes_mask` gets a region of `vertices_capacity` elements,
+	//! in the order of `shader_bindings`.
+	std::size_t getAttributeOffset(vertex_layout_t layout, std::uint32_t attributes_mask,
+	                               std::uint32_t vertices_capacity,
+	                               shader_bindings attribute, std::uint32_t vertex_index);
+
+	//! \brief Enable and point the attributes present in
+	//!        `attributes_mask` into the buffer currently bound to
+	//!        GL_ARRAY_BUFFER, for the currently bound VAO.
+	void setupVertexAttributes(vertex_layout_t layout, std::uint32_t attributes_mask,
+	                           std::uint32_t vertices_capacity);
+
+	//! \brief Create the VAO, buffer object and index buffer object for a
+	//!        mesh, or suballocate them from the geometry arena.
+	//!
+	//! The attributes are bound to the locations given by
+	//! `shader_bindings`, whichever layout is used. The indices of each
+	//! level of detail follow those of the full mesh.
+	//!
+	//! @param [in] mesh geometry to upload
+	//! @param [in] options how to lay out the geometry
+	//! @return the uploaded mesh, without any material nor textures
+	mesh_data uploadMesh(mesh_source const& mesh,
+	                     mesh_upload_options const& options = mesh_upload_options());
+}
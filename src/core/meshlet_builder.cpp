@@ -0,0 +1,243 @@
+#include "meshlet_builder.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// Below that, the normals are spread over more than a hemisphere
+	// (minus a little margin), and no camera position sees all the
+	// triangles from behind.
+	constexpr float min_cone_cosine = 0.1f;
+
+	//! \brief Sphere enclosing all the given vertices, following Jack
+	//!        Ritter's "An Efficient Bounding Sphere".
+	void computeBoundingSphere(glm::vec3 const* positions, std::vector<std::uint32_t> const& vertices,
+	                           bonobo::meshlet& cluster)
+	{
+		// Start from the most distant pair of the points that are extreme
+		// along each axis.
+		std::uint32_t extremes[3][2];
+		for (int axis = 0; axis < 3; ++axis)
+			extremes[axis][0] = extremes[axis][1] = vertices.front();
+		for (auto const v : vertices)
+			for (int axis = 0; axis < 3; ++axis) {
+				if (positions[v][axis] < positions[extremes[axis][0]][axis])
+					extremes[axis][0] = v;
+				if (positions[v][axis] > positions[extremes[axis][1]][axis])
+					extremes[axis][1] = v;
+			}
+
+		int widest_axis = 0;
+		float widest_distance = -1.0f;
+		for (int axis = 0; axis < 3; ++axis) {
+			auto const distance = glm::distance(positions[extremes[axis][0]], positions[extremes[axis][1]]);
+			if (distance > widest_distance) {
+				widest_axis = axis;
+				widest_distance = distance;
+			}
+		}
+
+		auto center = (positions[extremes[widest_axis][0]] + positions[extremes[widest_axis][1]]) * 0.5f;
+		auto radius = widest_distance * 0.5f;
+
+		// Then grow the sphere just enough to include each point left out.
+		for (auto const v : vertices) {
+			auto const distance = glm::distance(positions[v], center);
+			if (distance <= radius)
+				continue;
+			auto const new_radius = (radius + distance) * 0.5f;
+			center += (positions[v] - center) * ((new_radius - radius) / distance);
+			radius = new_radius;
+		}
+
+		cluster.center = center;
+		cluster.radius = radius;
+	}
+
+	//! \brief Cone containing the normals of all the given triangles,
+	//!        with its apex behind all of them.
+	void computeNormalCone(glm::vec3 const* positions, GLuint const* indices, bonobo::meshlet& cluster)
+	{
+		struct plane {
+			glm::vec3 point;
+			glm::vec3 normal;
+		};
+		std::vector<plane> planes;
+		planes.reserve(cluster.triangles_nb);
+		glm::vec3 normals_sum(0.0f);
+		for (std::uint32_t t = 0u; t < cluster.triangles_nb; ++t) {
+			auto const& p0 = positions[indices[3u * t + 0u]];
+			auto const& p1 = positions[indices[3u * t + 1u]];
+			auto const& p2 = positions[indices[3u * t + 2u]];
+			auto const normal = glm::cross(p1 - p0, p2 - p0);
+			auto const length = glm::length(normal);
+			if (length == 0.0f)
+				continue; // Degenerate triangles are never rasterised.
+			planes.push_back({ p0, normal / length });
+			normals_sum += normal / length;
+		}
+
+		cluster.cone_apex = cluster.center;
+		cluster.cone_axis = glm::vec3(0.0f, 0.0f, 1.0f);
+		cluster.cone_cutoff = 1.0f;
+		auto const axis_length = glm::length(normals_sum);
+		if (planes.empty() || axis_length == 0.0f)
+			return;
+
+		auto const axis = normals_sum / axis_length;
+		auto min_cosine = 1.0f;
+		for (auto const& p : planes)
+			min_cosine = std::min(min_cosine, glm::dot(axis, p.normal));
+		cluster.cone_axis = axis;
+		if (min_cosine <= min_cone_cosine)
+			return;
+
+		// Move the apex back along the axis, starting from the centre of
+		// the bounding sphere, until it is behind the plane of each
+		// triangle.
+		auto max_distance = 0.0f;
+		for (auto const& p : planes) {
+			auto const distance = glm::dot(cluster.center - p.point, p.normal) / glm::dot(axis, p.normal);
+			max_distance = std::max(max_distance, distance);
+		}
+		cluster.cone_apex = cluster.center - axis * max_distance;
+
+		// Viewing directions within 90° minus the cone's half-angle of its
+		// axis see all the triangles from behind.
+		cluster.cone_cutoff = std::sqrt(1.0f - min_cosine * min_cosine);
+	}
+}
+
+std::vector<bonobo::meshlet>
+bonobo::meshlet_builder::build(mesh_source& mesh, std::uint32_t max_vertices_nb, std::uint32_t max_triangles_nb)
+{
+	std::vector<meshlet> meshlets;
+	if (mesh.drawing_mode != GL_TRIANGLES || mesh.indices == nullptr
+	    || mesh.vertices == nullptr || mesh.indices_nb < 3u)
+		return meshlets;
+	assert(max_vertices_nb >= 3u && max_triangles_nb >= 1u);
+
+	auto const triangles_nb = mesh.indices_nb / 3u;
+	if (mesh.indices != mesh.indices_storage.data())
+		mesh.indices_storage.assign(mesh.indices, mesh.indices + mesh.indices_nb);
+	auto const* const indices = mesh.indices_storage.data();
+
+	// Triangles using each vertex, as consecutive ranges of `adjacency`.
+	std::vector<std::uint32_t> adjacency_offsets(mesh.vertices_nb + 1u, 0u);
+	for (std::uint32_t i = 0u; i < 3u * triangles_nb; ++i)
+		++adjacency_offsets[indices[i] + 1u];
+	for (std::uint32_t v = 0u; v < mesh.vertices_nb; ++v)
+		adjacency_offsets[v + 1u] += adjacency_offsets[v];
+	std::vector<std::uint32_t> adjacency(3u * triangles_nb);
+	{
+		std::vector<std::uint32_t> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (std::uint32_t i = 0u; i < 3u * triangles_nb; ++i)
+			adjacency[fill_offsets[indices[i]]++] = i / 3u;
+	}
+
+	std::vector<bool> is_assigned(triangles_nb, false);
+	// Tag of the meshlet a vertex was last added to, i.e. its index plus
+	// one, to tell in constant time whether it is in the current one.
+	std::vector<std::uint32_t> vertex_tags(mesh.vertices_nb, 0u);
+	std::vector<std::uint32_t> meshlet_vertices;
+	std::vector<std::uint32_t> candidates;
+	std::vector<GLuint> reordered_indices;
+	reordered_indices.reserve(mesh.indices_nb);
+
+	std::uint32_t next_seed = 0u;
+	for (;;) {
+		while (next_seed < triangles_nb && is_assigned[next_seed])
+			++next_seed;
+		if (next_seed == triangles_nb)
+			break;
+
+		meshlet cluster;
+		cluster.first_index = static_cast<std::uint32_t>(reordered_indices.size());
+		auto const tag = static_cast<std::uint32_t>(meshlets.size() + 1u);
+		meshlet_vertices.clear();
+		candidates.clear();
+
+		auto const add_triangle = [&](std::uint32_t triangle){
+			is_assigned[triangle] = true;
+			++cluster.triangles_nb;
+			for (std::uint32_t k = 0u; k < 3u; ++k) {
+				auto const v = indices[3u * triangle + k];
+				reordered_indices.push_back(v);
+				if (vertex_tags[v] == tag)
+					continue;
+				vertex_tags[v] = tag;
+				meshlet_vertices.push_back(v);
+				for (auto a = adjacency_offsets[v]; a < adjacency_offsets[v + 1u]; ++a)
+					if (!is_assigned[adjacency[a]])
+						candidates.push_back(adjacency[a]);
+			}
+		};
+
+		add_triangle(next_seed);
+		while (cluster.triangles_nb < max_triangles_nb) {
+			// Pick the neighbouring triangle adding the fewest vertices,
+			// which keeps meshlets compact; the earliest one on ties, as
+			// it is the closest to the seed. Triangles assigned since
+			// they became candidates get dropped along the way.
+			auto best_candidate = std::numeric_limits<std::uint32_t>::max();
+			auto best_new_vertices_nb = 4u;
+			std::size_t kept_candidates_nb = 0u;
+			for (auto const candidate : candidates) {
+				if (is_assigned[candidate])
+					continue;
+				candidates[kept_candidates_nb++] = candidate;
+				auto new_vertices_nb = 0u;
+				for (std::uint32_t k = 0u; k < 3u; ++k)
+					new_vertices_nb += vertex_tags[indices[3u * candidate + k]] != tag ? 1u : 0u;
+				if (new_vertices_nb < best_new_vertices_nb) {
+					best_candidate = candidate;
+					best_new_vertices_nb = new_vertices_nb;
+				}
+			}
+			candidates.resize(kept_candidates_nb);
+
+			if (best_candidate == std::numeric_limits<std::uint32_t>::max()
+			    || meshlet_vertices.size() + best_new_vertices_nb > max_vertices_nb)
+				break;
+			add_triangle(best_candidate);
+		}
+
+		cluster.vertices_nb = static_cast<std::uint32_t>(meshlet_vertices.size());
+		computeBoundingSphere(mesh.vertices, meshlet_vertices, cluster);
+		computeNormalCone(mesh.vertices, reordered_indices.data() + cluster.first_index, cluster);
+		meshlets.push_back(cluster);
+	}
+
+	// Indices not making up a whole triangle are kept at the end.
+	reordered_indices.insert(reordered_indices.end(), indices + 3u * triangles_nb, indices + mesh.indices_nb);
+	mesh.indices_storage = std::move(reordered_indices);
+	mesh.indices = mesh.indices_storage.data();
+
+	return meshlets;
+}
+
+void
+bonobo::meshlet_builder::accumulateStatistics(std::vector<meshlet> const& meshlets, statistics& stats)
+{
+	stats.meshlets_nb += meshlets.size();
+	for (auto const& cluster : meshlets) {
+		stats.triangles_nb += cluster.triangles_nb;
+		stats.vertices_nb += cluster.vertices_nb;
+	}
+}
+
+bool
+bonobo::meshlet_builder::isBackFacing(meshlet const& cluster, glm::vec3 const& camera_position)
+{
+	if (cluster.cone_cutoff >= 1.0f)
+		return false;
+
+	auto const direction = cluster.cone_apex - camera_position;
+	auto const distance = glm::length(direction);
+	return distance > 0.0f && glm::dot(direction, cluster.cone_axis) >= cluster.cone_cutoff * distance;
+}
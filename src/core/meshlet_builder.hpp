@@ -0,0 +1,48 @@
+#pragma once
+
+#include "mesh_upload.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	namespace meshlet_builder
+	{
+		//! \brief Default limits on the size of a meshlet, matching what
+		//!        mesh shaders typically handle in one workgroup.
+		constexpr std::uint32_t max_vertices_nb = 64u;
+		constexpr std::uint32_t max_triangles_nb = 124u;
+
+		struct statistics {
+			std::size_t meshlets_nb{ 0u };
+			std::size_t triangles_nb{ 0u };
+			std::size_t vertices_nb{ 0u }; //!< summed over all meshlets, so vertices shared by several meshlets count several times
+		};
+
+		//! \brief Split a triangle mesh into meshlets.
+		//!
+		//! Each meshlet is grown from the first triangle not yet assigned,
+		//! by repeatedly adding the neighbouring triangle that brings the
+		//! fewest new vertices, until either limit is reached or it has
+		//! no neighbours left. The triangles are then reordered so that
+		//! those of each meshlet are contiguous; the mesh is made to own
+		//! its indices, which are rewritten in place. Meshes not made of
+		//! triangles get no meshlets.
+		//!
+		//! @return the meshlets, in the order of their triangles
+		std::vector<meshlet> build(mesh_source& mesh,
+		                           std::uint32_t max_vertices_nb = meshlet_builder::max_vertices_nb,
+		                           std::uint32_t max_triangles_nb = meshlet_builder::max_triangles_nb);
+
+		//! \brief Add the meshlets of a mesh to `stats`.
+		void accumulateStatistics(std::vector<meshlet> const& meshlets, statistics& stats);
+
+		//! \brief Whether all triangles of a meshlet face away from a
+		//!        camera, i.e. whether it can be culled.
+		//!
+		//! @param [in] camera_position in the space of the mesh
+		bool isBackFacing(meshlet const& cluster, glm::vec3 const& camera_position);
+	}
+}
@@ -0,0 +1,472 @@
+#include "mip_generator.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <future>
+#include <vector>
+
+// SSE2 is part of x86-64, so no extra compiler flag nor runtime check is
+// needed for it; other architectures use the scalar code paths.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define MIP_GENERATOR_HAS_SSE2 1
+#	include <emmintrin.h>
+#else
+#	define MIP_GENERATOR_HAS_SSE2 0
+#endif
+
+namespace
+{
+	namespace constant
+	{
+		constexpr int max_taps_nb = 6;
+		constexpr std::size_t srgb_encoding_entries_nb = 1u << 14;
+		constexpr float inverse_255 = 1.0f / 255.0f;
+		constexpr double pi = 3.14159265358979323846;
+		constexpr double kaiser_alpha = 4.0;
+		constexpr double kaiser_half_width = 3.0; // in source texels
+
+		// Below that many destination texels per band, splitting a
+		// level costs more in synchronisation than it saves.
+		constexpr std::size_t min_texels_per_band = 64u * 1024u;
+	}
+
+	struct level_pair {
+		std::uint8_t const* source;
+		std::uint32_t source_width;
+		std::uint32_t source_height;
+		std::uint8_t* destination;
+		std::uint32_t destination_width;
+		std::uint32_t destination_height;
+		std::uint32_t channels_nb;
+	};
+
+	// Separable kernel: the same weights are used horizontally and
+	// vertically. Tap `i` of destination texel `x` reads source texel
+	// `2x + first_offset + i`.
+	struct kernel {
+		std::array<float, constant::max_taps_nb> weights;
+		int first_offset;
+		int taps_nb;
+	};
+
+	struct srgb_tables {
+		std::array<float, 256> to_linear;
+		// Indexed by linear values scaled to the size of the table; it
+		// is large enough for decoding then encoding any value to give
+		// it back.
+		std::array<std::uint8_t, constant::srgb_encoding_entries_nb> to_srgb;
+	};
+
+	// Modified Bessel function of the first kind and of order 0.
+	double besselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; ++k) {
+			auto const ratio = x / (2.0 * k);
+			term *= ratio * ratio;
+			sum += term;
+		}
+		return sum;
+	}
+
+	kernel makeKernel(bonobo::mip_filter_t filter)
+	{
+		kernel k;
+		k.weights.fill(0.0f);
+		if (filter == bonobo::mip_filter_t::box) {
+			k.first_offset = 0;
+			k.taps_nb = 2;
+			k.weights[0] = 0.5f;
+			k.weights[1] = 0.5f;
+			return k;
+		}
+
+		k.first_offset = -2;
+		k.taps_nb = 6;
+		std::array<double, constant::max_taps_nb> weights;
+		double sum = 0.0;
+		for (int i = 0; i < k.taps_nb; ++i) {
+			// Distance between the centre of the tap and that of the
+			// destination texel, in source texels; never zero.
+			auto const distance = static_cast<double>(k.first_offset + i) - 0.5;
+			auto const x = constant::pi * distance / 2.0;
+			auto const r = distance / constant::kaiser_half_width;
+			auto const window = besselI0(constant::kaiser_alpha * std::sqrt(std::max(1.0 - r * r, 0.0)))
+			                  / besselI0(constant::kaiser_alpha);
+			weights[i] = std::sin(x) / x * window;
+			sum += weights[i];
+		}
+		for (int i = 0; i < k.taps_nb; ++i)
+			k.weights[i] = static_cast<float>(weights[i] / sum);
+		return k;
+	}
+
+	kernel const& getKernel(bonobo::mip_filter_t filter)
+	{
+		static kernel const box = makeKernel(bonobo::mip_filter_t::box);
+		static kernel const kaiser = makeKernel(bonobo::mip_filter_t::kaiser);
+		return filter == bonobo::mip_filter_t::kaiser ? kaiser : box;
+	}
+
+	srgb_tables makeSrgbTables()
+	{
+		srgb_tables tables;
+		for (std::size_t i = 0u; i < tables.to_linear.size(); ++i) {
+			auto const c = static_cast<double>(i) / 255.0;
+			tables.to_linear[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+		}
+		for (std::size_t i = 0u; i < tables.to_srgb.size(); ++i) {
+			auto const l = static_cast<double>(i) / (tables.to_srgb.size() - 1u);
+			auto const c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+			tables.to_srgb[i] = static_cast<std::uint8_t>(c * 255.0 + 0.5);
+		}
+		return tables;
+	}
+
+	srgb_tables const& getSrgbTables()
+	{
+		static srgb_tables const tables = makeSrgbTables();
+		return tables;
+	}
+
+	bool isAlpha(std::size_t value_index, std::uint32_t channels_nb)
+	{
+		return channels_nb == 4u && value_index % 4u == 3u;
+	}
+
+	//
+	// Box filter of linear data, computed on integers
+	//
+
+	void boxFilterRowScalar(std::uint8_t const* row0, std::uint8_t const* row1, std::uint32_t source_width,
+	                        std::uint8_t* target, std::uint32_t first_x, std::uint32_t destination_width,
+	                        std::uint32_t channels_nb)
+	{
+		for (std::uint32_t x = first_x; x < destination_width; ++x) {
+			auto const x0 = std::min(2u * x, source_width - 1u) * channels_nb;
+			auto const x1 = std::min(2u * x + 1u, source_width - 1u) * channels_nb;
+			for (std::uint32_t c = 0u; c < channels_nb; ++c)
+				target[x * channels_nb + c] = static_cast<std::uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2u) / 4u);
+		}
+	}
+
+#if MIP_GENERATOR_HAS_SSE2
+	// Filters the destination texels whose sources need no clamping, in
+	// groups, and returns how many were filtered, starting from the
+	// first one; the others are left to the scalar version.
+	std::uint32_t boxFilterRowSse2(std::uint8_t const* row0, std::uint8_t const* row1, std::uint32_t source_width,
+	                               std::uint8_t* target, std::uint32_t destination_width,
+	                               std::uint32_t channels_nb)
+	{
+		auto const zero = _mm_setzero_si128();
+		auto const two = _mm_set1_epi16(2);
+		std::uint32_t x = 0u;
+
+		if (channels_nb == 4u) {
+			// Two destination texels out of 2×4 source ones.
+			for (; x + 2u <= destination_width && 2u * x + 4u <= source_width; x += 2u) {
+				auto const a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + 8u * x));
+				auto const b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + 8u * x));
+				auto const first_pair = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				auto const second_pair = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+				auto const sums = _mm_add_epi16(_mm_unpacklo_epi64(first_pair, second_pair),
+				                                _mm_unpackhi_epi64(first_pair, second_pair));
+				auto const averages = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(target + 4u * x), _mm_packus_epi16(averages, averages));
+			}
+		} else if (channels_nb == 1u) {
+			// Eight destination texels out of 2×16 source ones; pairs of
+			// neighbouring sums get added by the multiply-add.
+			auto const ones = _mm_set1_epi16(1);
+			for (; x + 8u <= destination_width && 2u * x + 16u <= source_width; x += 8u) {
+				auto const a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + 2u * x));
+				auto const b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + 2u * x));
+				auto const low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				auto const high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+				auto const sums = _mm_packs_epi32(_mm_madd_epi16(low, ones), _mm_madd_epi16(high, ones));
+				auto const averages = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(target + x), _mm_packus_epi16(averages, averages));
+			}
+		}
+
+		return x;
+	}
+#endif
+
+	void boxFilterRows(level_pair const& level, bool use_simd, std::uint32_t first_row, std::uint32_t last_row)
+	{
+		auto const source_row_size = static_cast<std::size_t>(level.source_width) * level.channels_nb;
+		auto const destination_row_size = static_cast<std::size_t>(level.destination_width) * level.channels_nb;
+		for (std::uint32_t y = first_row; y < last_row; ++y) {
+			auto const* const row0 = level.source + std::min(2u * y, level.source_height - 1u) * source_row_size;
+			auto const* const row1 = level.source + std::min(2u * y + 1u, level.source_height - 1u) * source_row_size;
+			auto* const target = level.destination + y * destination_row_size;
+
+			std::uint32_t x = 0u;
+#if MIP_GENERATOR_HAS_SSE2
+			if (use_simd)
+				x = boxFilterRowSse2(row0, row1, level.source_width, target, level.destination_width, level.channels_nb);
+#else
+			static_cast<void>(use_simd);
+#endif
+			boxFilterRowScalar(row0, row1, level.source_width, target, x, level.destination_width, level.channels_nb);
+		}
+	}
+
+	//
+	// Any filter, computed on linear floating-point values
+	//
+
+	void decodeRow(std::uint8_t const* source, std::size_t values_nb, std::uint32_t channels_nb,
+	               bool is_srgb, bool use_simd, float* values)
+	{
+		if (is_srgb) {
+			auto const& to_linear = getSrgbTables().to_linear;
+			for (std::size_t i = 0u; i < values_nb; ++i)
+				values[i] = isAlpha(i, channels_nb) ? source[i] * constant::inverse_255 : to_linear[source[i]];
+			return;
+		}
+
+		std::size_t i = 0u;
+#if MIP_GENERATOR_HAS_SSE2
+		if (use_simd) {
+			auto const zero = _mm_setzero_si128();
+			auto const scale = _mm_set1_ps(constant::inverse_255);
+			for (; i + 16u <= values_nb; i += 16u) {
+				auto const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i));
+				auto const low = _mm_unpacklo_epi8(bytes, zero);
+				auto const high = _mm_unpackhi_epi8(bytes, zero);
+				_mm_storeu_ps(values + i,       _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+				_mm_storeu_ps(values + i + 4u,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+				_mm_storeu_ps(values + i + 8u,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+				_mm_storeu_ps(values + i + 12u, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+			}
+		}
+#else
+		static_cast<void>(use_simd);
+#endif
+		for (; i < values_nb; ++i)
+			values[i] = source[i] * constant::inverse_255;
+	}
+
+	void encodeRow(float const* values, std::size_t values_nb, std::uint32_t channels_nb,
+	               bool is_srgb, bool use_simd, std::uint8_t* target)
+	{
+		if (is_srgb) {
+			auto const& to_srgb = getSrgbTables().to_srgb;
+			auto const scale = static_cast<float>(to_srgb.size() - 1u);
+			for (std::size_t i = 0u; i < values_nb; ++i) {
+				auto const value = std::min(std::max(values[i], 0.0f), 1.0f);
+				target[i] = isAlpha(i, channels_nb) ? static_cast<std::uint8_t>(value * 255.0f + 0.5f)
+				                                    : to_srgb[static_cast<std::size_t>(value * scale + 0.5f)];
+			}
+			return;
+		}
+
+		std::size_t i = 0u;
+#if MIP_GENERATOR_HAS_SSE2
+		if (use_simd) {
+			auto const zero = _mm_setzero_ps();
+			auto const one = _mm_set1_ps(1.0f);
+			auto const scale = _mm_set1_ps(255.0f);
+			auto const half = _mm_set1_ps(0.5f);
+			auto const quantise = [&](float const* v){
+				auto const clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(v), zero), one);
+				return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), half));
+			};
+			for (; i + 16u <= values_nb; i += 16u) {
+				auto const low = _mm_packs_epi32(quantise(values + i), quantise(values + i + 4u));
+				auto const high = _mm_packs_epi32(quantise(values + i + 8u), quantise(values + i + 12u));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_packus_epi16(low, high));
+			}
+		}
+#else
+		static_cast<void>(use_simd);
+#endif
+		for (; i < values_nb; ++i)
+			target[i] = static_cast<std::uint8_t>(std::min(std::max(values[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+
+	// Weighted sum of whole rows, i.e. the vertical pass.
+	void accumulateRows(std::array<float const*, constant::max_taps_nb> const& rows, kernel const& k,
+	                    std::size_t values_nb, bool use_simd, float* sums)
+	{
+		std::size_t i = 0u;
+#if MIP_GENERATOR_HAS_SSE2
+		if (use_simd) {
+			__m128 weights[constant::max_taps_nb];
+			for (int t = 0; t < k.taps_nb; ++t)
+				weights[t] = _mm_set1_ps(k.weights[t]);
+			for (; i + 4u <= values_nb; i += 4u) {
+				auto sum = _mm_mul_ps(weights[0], _mm_loadu_ps(rows[0] + i));
+				for (int t = 1; t < k.taps_nb; ++t)
+					sum = _mm_add_ps(sum, _mm_mul_ps(weights[t], _mm_loadu_ps(rows[t] + i)));
+				_mm_storeu_ps(sums + i, sum);
+			}
+		}
+#else
+		static_cast<void>(use_simd);
+#endif
+		for (; i < values_nb; ++i) {
+			auto sum = k.weights[0] * rows[0][i];
+			for (int t = 1; t < k.taps_nb; ++t)
+				sum += k.weights[t] * rows[t][i];
+			sums[i] = sum;
+		}
+	}
+
+	// Horizontal pass, from a row of the source width to one of the
+	// destination width.
+	void filterRow(float const* row, std::uint32_t source_width, kernel const& k,
+	               std::uint32_t destination_width, std::uint32_t channels_nb, bool use_simd, float* filtered)
+	{
+		std::array<std::size_t, constant::max_taps_nb> taps;
+		auto const fetchTaps = [&](std::uint32_t x){
+			for (int t = 0; t < k.taps_nb; ++t) {
+				auto const source_x = static_cast<int>(2u * x) + k.first_offset + t;
+				taps[t] = static_cast<std::size_t>(std::min(std::max(source_x, 0), static_cast<int>(source_width) - 1)) * channels_nb;
+			}
+		};
+
+#if MIP_GENERATOR_HAS_SSE2
+		if (use_simd && channels_nb == 4u) {
+			// One whole texel per vector.
+			__m128 weights[constant::max_taps_nb];
+			for (int t = 0; t < k.taps_nb; ++t)
+				weights[t] = _mm_set1_ps(k.weights[t]);
+			for (std::uint32_t x = 0u; x < destination_width; ++x) {
+				fetchTaps(x);
+				auto sum = _mm_mul_ps(weights[0], _mm_loadu_ps(row + taps[0]));
+				for (int t = 1; t < k.taps_nb; ++t)
+					sum = _mm_add_ps(sum, _mm_mul_ps(weights[t], _mm_loadu_ps(row + taps[t])));
+				_mm_storeu_ps(filtered + 4u * x, sum);
+			}
+			return;
+		}
+#else
+		static_cast<void>(use_simd);
+#endif
+		for (std::uint32_t x = 0u; x < destination_width; ++x) {
+			fetchTaps(x);
+			for (std::uint32_t c = 0u; c < channels_nb; ++c) {
+				auto sum = k.weights[0] * row[taps[0] + c];
+				for (int t = 1; t < k.taps_nb; ++t)
+					sum += k.weights[t] * row[taps[t] + c];
+				filtered[x * channels_nb + c] = sum;
+			}
+		}
+	}
+
+	void filterRows(level_pair const& level, kernel const& k, bool is_srgb, bool use_simd,
+	                std::uint32_t first_row, std::uint32_t last_row)
+	{
+		auto const source_row_size = static_cast<std::size_t>(level.source_width) * level.channels_nb;
+		auto const destination_row_size = static_cast<std::size_t>(level.destination_width) * level.channels_nb;
+
+		// Consecutive destination rows share most of their source rows,
+		// so the decoded source rows are kept in a small ring; the
+		// source rows read for any destination row are consecutive once
+		// clamped, so they never compete for the same slot.
+		std::vector<float> decoded_rows(static_cast<std::size_t>(k.taps_nb) * source_row_size);
+		std::array<int, constant::max_taps_nb> decoded_rows_indices;
+		decoded_rows_indices.fill(-1);
+		std::vector<float> sums(source_row_size);
+		std::vector<float> filtered(destination_row_size);
+		std::array<float const*, constant::max_taps_nb> rows{};
+
+		for (std::uint32_t y = first_row; y < last_row; ++y) {
+			for (int t = 0; t < k.taps_nb; ++t) {
+				auto const source_y = std::min(std::max(static_cast<int>(2u * y) + k.first_offset + t, 0),
+				                                static_cast<int>(level.source_height) - 1);
+				auto const slot = static_cast<std::size_t>(source_y % k.taps_nb);
+				auto* const decoded_row = decoded_rows.data() + slot * source_row_size;
+				if (decoded_rows_indices[slot] != source_y) {
+					decodeRow(level.source + source_y * source_row_size, source_row_size, level.channels_nb,
+					          is_srgb, use_simd, decoded_row);
+					decoded_rows_indices[slot] = source_y;
+				}
+				rows[t] = decoded_row;
+			}
+
+			accumulateRows(rows, k, source_row_size, use_simd, sums.data());
+			filterRow(sums.data(), level.source_width, k, level.destination_width, level.channels_nb, use_simd, filtered.data());
+			encodeRow(filtered.data(), destination_row_size, level.channels_nb, is_srgb, use_simd,
+			          level.destination + y * destination_row_size);
+		}
+	}
+}
+
+bool
+bonobo::mip_generator::hasSimd()
+{
+	return MIP_GENERATOR_HAS_SSE2 != 0;
+}
+
+void
+bonobo::mip_generator::generateLevel(std::uint8_t const* source, std::uint32_t source_width, std::uint32_t source_height,
+                                     std::uint8_t* destination, std::uint32_t channels_nb,
+                                     mip_settings const& settings, execution_policy const& policy)
+{
+	assert(channels_nb >= 1u && channels_nb <= 4u);
+	assert(source_width > 0u && source_height > 0u);
+
+	level_pair const level = {
+		source, source_width, source_height,
+		destination, std::max(source_width / 2u, 1u), std::max(source_height / 2u, 1u),
+		channels_nb
+	};
+	auto const use_simd = policy.use_simd && hasSimd();
+
+	// Linear data filtered with a box gives the same result on integers,
+	// only much faster.
+	auto const filter_rows = [&level,&settings,use_simd](std::uint32_t first_row, std::uint32_t last_row){
+		if (settings.filter == mip_filter_t::box && !settings.is_srgb)
+			boxFilterRows(level, use_simd, first_row, last_row);
+		else
+			filterRows(level, getKernel(settings.filter), settings.is_srgb, use_simd, first_row, last_row);
+	};
+
+	// Workers waiting on tasks queued behind them on their own pool could
+	// all end up waiting, hence filtering the whole level right away.
+	std::size_t bands_nb = 1u;
+	if (policy.use_thread_pool) {
+		auto const& thread_pool = ThreadPool::GetShared();
+		if (!thread_pool.IsWorkerThread()) {
+			auto const texels_nb = static_cast<std::size_t>(level.destination_width) * level.destination_height;
+			bands_nb = std::min({ texels_nb / constant::min_texels_per_band,
+			                      static_cast<std::size_t>(level.destination_height),
+			                      thread_pool.GetThreadCount() + 1u });
+		}
+	}
+	if (bands_nb <= 1u) {
+		filter_rows(0u, level.destination_height);
+		return;
+	}
+
+	// The calling thread takes the first band rather than idling.
+	auto& thread_pool = ThreadPool::GetShared();
+	auto const band_start = [&level,bands_nb](std::size_t band){
+		return static_cast<std::uint32_t>(level.destination_height * band / bands_nb);
+	};
+	std::vector<std::future<void>> pending_bands;
+	pending_bands.reserve(bands_nb - 1u);
+	for (std::size_t band = 1u; band < bands_nb; ++band) {
+		auto const first_row = band_start(band);
+		auto const last_row = band_start(band + 1u);
+		pending_bands.push_back(thread_pool.Enqueue([&filter_rows,first_row,last_row](){ filter_rows(first_row, last_row); }));
+	}
+	filter_rows(0u, band_start(1u));
+
+	// Wait for all bands before letting any exception through, as they
+	// all reference this frame.
+	for (auto& band : pending_bands)
+		band.wait();
+	for (auto& band : pending_bands)
+		band.get();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bonobo
+{
+	//! \brief Filter used to compute each mip level from the previous one.
+	enum class mip_filter_t : std::uint32_t {
+		box = 0u, //!< average of 2×2 texels
+		kaiser    //!< Kaiser-windowed sinc over 6×6 texels, which keeps the lower levels sharper
+	};
+
+	//! \brief Settings affecting the content of generated mip levels.
+	struct mip_settings {
+		mip_filter_t filter{ mip_filter_t::box };
+
+		//! Whether the colour channels hold sRGB-encoded values, which
+		//! then get filtered in linear space; the fourth channel, alpha,
+		//! is always treated as linear.
+		bool is_srgb{ false };
+	};
+
+	namespace mip_generator
+	{
+		//! \brief How the work gets done; it does not affect the output.
+		struct execution_policy {
+			//! Use the SSE2 code paths, when compiled in.
+			bool use_simd{ true };
+
+			//! Split large levels into bands of rows filtered on
+			//! `ThreadPool::GetShared()`; ignored when called from one of
+			//! its workers, which then filters the whole level itself.
+			bool use_thread_pool{ true };
+		};
+
+		//! \brief Whether SIMD code paths were compiled in.
+		bool hasSimd();
+
+		//! \brief Compute a mip level out of the previous one.
+		//!
+		//! Texel (x, y) of the destination is centred on the corner shared
+		//! by texels (2x, 2y) and (2x + 1, 2y + 1) of the source, whose
+		//! last row and column are ignored when the source dimensions
+		//! are odd; texels past the source's edges are clamped to them.
+		//!
+		//! @param [in] source tightly packed 8-bit texels
+		//! @param [in] source_width width of the source, in texels
+		//! @param [in] source_height height of the source, in texels
+		//! @param [out] destination tightly packed 8-bit texels, of
+		//!              max(source_width / 2, 1) × max(source_height / 2, 1)
+		//!              texels
+		//! @param [in] channels_nb number of 8-bit channels of a texel,
+		//!             between 1 and 4
+		//! @param [in] settings which filter to use, and how to interpret
+		//!             the colour channels
+		//! @param [in] policy how to spread the work
+		void generateLevel(std::uint8_t const* source, std::uint32_t source_width, std::uint32_t source_height,
+		                   std::uint8_t* destination, std::uint32_t channels_nb,
+		                   mip_settings const& settings, execution_policy const& policy = execution_policy());
+	}
+}
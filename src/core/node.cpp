@@ -7,6 +7,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+
 void
 Node::render(glm::mat4 const& view_projection, glm::mat4 const& parent_transform) const
 {
@@ -31,6 +33,7 @@ Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint pr
 	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(world));
 	glUniformMatrix4fv(glGetUniformLocation(program, "normal_model_to_world"), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
 	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(view_projection));
+	bonobo::setVertexDecodingUniforms(program, _decoding);
 
 	for (size_t i = 0u; i < _textures.size(); ++i) {
 		auto const& texture = _textures[i];
@@ -50,11 +53,22 @@ Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint pr
 	glUniform1f(glGetUniformLocation(program, "index_of_refraction_value"), _constants.indexOfRefraction);
 	glUniform1f(glGetUniformLocation(program, "opacity_value"), _constants.opacity);
 
+	auto const draw_elements = [this](GLsizei indices_nb, std::size_t indices_offset){
+		if (_instances_nb == 1)
+			glDrawElementsBaseVertex(_drawing_mode, indices_nb, _indices_type, reinterpret_cast<GLvoid const*>(indices_offset), _base_vertex);
+		else
+			glDrawElementsInstancedBaseVertex(_drawing_mode, indices_nb, _indices_type, reinterpret_cast<GLvoid const*>(indices_offset), _instances_nb, _base_vertex);
+	};
+
 	glBindVertexArray(_vao);
-	if (_has_indices)
-		glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
+	if (_has_indices && _lod > 0u)
+		draw_elements(_lods[_lod - 1u].indices_nb, _lods[_lod - 1u].indices_offset);
+	else if (_has_indices)
+		draw_elements(_indices_nb, _indices_offset);
+	else if (_instances_nb == 1)
+		glDrawArrays(_drawing_mode, _base_vertex, _vertices_nb);
 	else
-		glDrawArrays(_drawing_mode, 0, _vertices_nb);
+		glDrawArraysInstanced(_drawing_mode, _base_vertex, _vertices_nb, _instances_nb);
 	glBindVertexArray(0u);
 
 	for (auto const& texture : _textures) {
@@ -77,7 +91,15 @@ Node::set_geometry(bonobo::mesh_data const& shape)
 	_vertices_nb = static_cast<GLsizei>(shape.vertices_nb);
 	_indices_nb = static_cast<GLsizei>(shape.indices_nb);
 	_drawing_mode = shape.drawing_mode;
+	_indices_type = shape.indices_type;
+	_base_vertex = shape.base_vertex;
+	_indices_offset = shape.indices_offset;
+	_decoding = shape.decoding;
 	_has_indices = shape.ibo != 0u;
+	_lods = shape.lods;
+	_lod = 0u;
+	_bounding_center = shape.bounding_center;
+	_bounding_radius = shape.bounding_radius;
 	_name = std::string("Render ") + shape.name;
 
 	if (!shape.bindings.empty()) {
@@ -124,6 +146,33 @@ Node::set_indices_nb(size_t const& indices_nb)
 	_indices_nb = static_cast<GLsizei>(indices_nb);
 }
 
+void
+Node::set_instances_nb(GLsizei instances_nb)
+{
+	_instances_nb = instances_nb;
+}
+
+size_t
+Node::get_lods_nb() const
+{
+	return _lods.size() + 1u;
+}
+
+void
+Node::set_lod(size_t lod)
+{
+	_lod = std::min(lod, _lods.size());
+}
+
+size_t
+Node::select_lod(glm::mat4 const& world, glm::vec3 const& camera_position,
+                 float screen_height_px, float vertical_fov, float max_error_px)
+{
+	_lod = bonobo::selectLod(_lods, _bounding_center, _bounding_radius, world, camera_position,
+	                         screen_height_px, vertical_fov, max_error_px);
+	return _lod;
+}
+
 void
 Node::add_texture(std::string const& name, GLuint tex_id, GLenum type)
 {
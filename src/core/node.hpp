@@ -72,6 +72,47 @@ public:
 	//! @param [in] indices_nb how many indices to use when rendering
 	void set_indices_nb(size_t const& indices_nb);
 
+	//! \brief Set how many instances of the geometry to draw.
+	//!
+	//! All instances share the transform, uniforms and textures of the
+	//! node; shaders tell them apart through `gl_InstanceID`.
+	//!
+	//! @param [in] instances_nb how many instances to draw; 1, the
+	//!             default, draws without instancing
+	void set_instances_nb(GLsizei instances_nb);
+
+	//! \brief Get the number of levels of detail of the geometry.
+	//!
+	//! @return how many levels can be passed to |set_lod()|, including
+	//!         the full geometry, which is level 0
+	size_t get_lods_nb() const;
+
+	//! \brief Set the level of detail to use when rendering.
+	//!
+	//! Level 0, the default, is the full geometry, limited to
+	//! |get_indices_nb()| indices; level `i` stands for
+	//! `lods[i - 1]` of the mesh given to |set_geometry()|.
+	//!
+	//! @param [in] lod level of detail to use; clamped to the last one
+	void set_lod(size_t lod);
+
+	//! \brief Select, and set, the coarsest level of detail whose error
+	//!        covers at most |max_error_px| pixels on screen; see
+	//!        `bonobo::selectLod()`.
+	//!
+	//! @param [in] world Matrix transforming from model-space to
+	//!             world-space
+	//! @param [in] camera_position in world-space
+	//! @param [in] screen_height_px height of the viewport, in pixels
+	//! @param [in] vertical_fov vertical field of view of the camera, in
+	//!             radians
+	//! @param [in] max_error_px how far, in pixels, the rendered surface
+	//!             may be from the full geometry
+	//! @return the selected level of detail
+	size_t select_lod(glm::mat4 const& world, glm::vec3 const& camera_position,
+	                  float screen_height_px, float vertical_fov,
+	                  float max_error_px = 1.0f);
+
 	//! \brief Set the program of this node.
 	//!
 	//! A node without a program will not render itself, but its children
@@ -136,7 +177,16 @@ private:
 	GLsizei _vertices_nb{ 0u };
 	GLsizei _indices_nb{ 0u };
 	GLenum _drawing_mode{ GL_TRIANGLES };
+	GLenum _indices_type{ GL_UNSIGNED_INT };
+	GLint _base_vertex{ 0 };
+	std::size_t _indices_offset{ 0u };
+	GLsizei _instances_nb{ 1 };
+	bonobo::vertex_decoding _decoding;
 	bool _has_indices{ false };
+	std::vector<bonobo::mesh_lod> _lods;
+	size_t _lod{ 0u };
+	glm::vec3 _bounding_center{ 0.0f };
+	float _bounding_radius{ 0.0f };
 
 	// Program data
 	GLuint const* _program{ nullptr };
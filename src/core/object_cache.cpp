@@ -0,0 +1,332 @@
+#include "object_cache.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	// Bump whenever the layout below changes, to discard older caches.
+	std::uint32_t const cache_version = 2u;
+	char const cache_magic[8] = { 'B', 'O', 'N', 'O', 'B', 'O', 'O', 'C' };
+
+	enum attribute_flags : std::uint32_t {
+		has_normals = 1u << 0,
+		has_texcoords = 1u << 1,
+		has_tangents_and_binormals = 1u << 2
+	};
+
+	struct cache_header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t import_flags;
+		std::uint64_t source_size;
+		std::int64_t source_modification_time;
+		std::uint64_t file_size;
+		std::uint32_t materials_nb;
+		std::uint32_t meshes_nb;
+		std::uint32_t nodes_nb;
+		std::uint32_t padding;
+	};
+
+	// Walks over a mapped cache, refusing to read past its end.
+	class cache_reader
+	{
+	public:
+		cache_reader(std::uint8_t const* data, std::size_t size) : _data(data), _size(size) {}
+
+		std::uint8_t const* take(std::size_t byte_count)
+		{
+			if (_failed || byte_count > _size - _offset) {
+				_failed = true;
+				return nullptr;
+			}
+			auto const ptr = _data + _offset;
+			_offset += byte_count;
+			return ptr;
+		}
+
+		template<typename T>
+		T read()
+		{
+			T value{};
+			auto const ptr = take(sizeof(T));
+			if (ptr != nullptr)
+				std::memcpy(&value, ptr, sizeof(T));
+			return value;
+		}
+
+		std::string readString()
+		{
+			auto const length = read<std::uint32_t>();
+			auto const ptr = take(length);
+			return ptr != nullptr ? std::string(reinterpret_cast<char const*>(ptr), length) : std::string();
+		}
+
+		void align()
+		{
+			auto const padding = (4u - (_offset & 3u)) & 3u;
+			take(padding);
+		}
+
+		bool failed() const { return _failed; }
+
+	private:
+		std::uint8_t const* _data;
+		std::size_t _size;
+		std::size_t _offset{ 0u };
+		bool _failed{ false };
+	};
+
+	class cache_writer
+	{
+	public:
+		explicit cache_writer(std::ofstream& stream) : _stream(stream) {}
+
+		void write(void const* data, std::size_t byte_count)
+		{
+			_stream.write(reinterpret_cast<char const*>(data), static_cast<std::streamsize>(byte_count));
+			_offset += byte_count;
+		}
+
+		template<typename T>
+		void write(T const& value)
+		{
+			write(&value, sizeof(T));
+		}
+
+		void writeString(std::string const& str)
+		{
+			write(static_cast<std::uint32_t>(str.size()));
+			write(str.data(), str.size());
+		}
+
+		void align()
+		{
+			std::uint8_t const zeros[4] = { 0u, 0u, 0u, 0u };
+			write(zeros, (4u - (_offset & 3u)) & 3u);
+		}
+
+		std::size_t offset() const { return _offset; }
+
+	private:
+		std::ofstream& _stream;
+		std::size_t _offset{ 0u };
+	};
+
+	void writeMaterialConstants(cache_writer& writer, bonobo::material_data const& constants)
+	{
+		writer.write(constants.diffuse);
+		writer.write(constants.specular);
+		writer.write(constants.ambient);
+		writer.write(constants.emissive);
+		writer.write(constants.shininess);
+		writer.write(constants.indexOfRefraction);
+		writer.write(constants.opacity);
+	}
+
+	bonobo::material_data readMaterialConstants(cache_reader& reader)
+	{
+		bonobo::material_data constants;
+		constants.diffuse = reader.read<glm::vec3>();
+		constants.specular = reader.read<glm::vec3>();
+		constants.ambient = reader.read<glm::vec3>();
+		constants.emissive = reader.read<glm::vec3>();
+		constants.shininess = reader.read<float>();
+		constants.indexOfRefraction = reader.read<float>();
+		constants.opacity = reader.read<float>();
+		return constants;
+	}
+}
+
+std::string
+bonobo::object_cache::getPath(std::string const& filename)
+{
+	return filename + ".bonobo_cache";
+}
+
+bool
+bonobo::object_cache::read(std::string const& cache_path, utils::file_stamp const& source_stamp,
+                           std::uint32_t import_flags, scene_source& scene)
+{
+	scene.materials.clear();
+	scene.meshes.clear();
+	scene.nodes.clear();
+	if (!scene.mapping.open(cache_path))
+		return false;
+
+	cache_reader reader(scene.mapping.data(), scene.mapping.size());
+	auto const header = reader.read<cache_header>();
+	if (reader.failed()
+	 || std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0
+	 || header.version != cache_version
+	 || header.import_flags != import_flags
+	 || header.source_size != source_stamp.size
+	 || header.source_modification_time != source_stamp.modification_time
+	 || header.file_size != scene.mapping.size()) {
+		scene.mapping.close();
+		return false;
+	}
+
+	scene.materials.resize(header.materials_nb);
+	for (auto& material : scene.materials) {
+		material.name = reader.readString();
+		material.is_used = reader.read<std::uint32_t>() != 0u;
+		material.constants = readMaterialConstants(reader);
+		material.textures.resize(reader.read<std::uint32_t>());
+		for (auto& texture : material.textures) {
+			texture.type_as_str = reader.readString();
+			texture.name = reader.readString();
+			texture.path = reader.readString();
+		}
+		if (reader.failed())
+			break;
+	}
+
+	scene.meshes.resize(reader.failed() ? 0u : header.meshes_nb);
+	for (auto& mesh : scene.meshes) {
+		mesh.name = reader.readString();
+		mesh.material_index = reader.read<std::uint32_t>();
+		mesh.drawing_mode = static_cast<GLenum>(reader.read<std::uint32_t>());
+		mesh.vertices_nb = reader.read<std::uint32_t>();
+		mesh.indices_nb = reader.read<std::uint32_t>();
+		auto const attributes = reader.read<std::uint32_t>();
+		reader.align();
+
+		// The attributes are stored planar, in the same order as in the
+		// buffer object built by `loadObjects()`.
+		auto const attribute_size = static_cast<std::size_t>(mesh.vertices_nb) * sizeof(glm::vec3);
+		auto const take_attribute = [&reader,attribute_size](){
+			return reinterpret_cast<glm::vec3 const*>(reader.take(attribute_size));
+		};
+		mesh.vertices = take_attribute();
+		if (attributes & has_normals)
+			mesh.normals = take_attribute();
+		if (attributes & has_texcoords)
+			mesh.texcoords = take_attribute();
+		if (attributes & has_tangents_and_binormals) {
+			mesh.tangents = take_attribute();
+			mesh.binormals = take_attribute();
+		}
+		mesh.indices = reinterpret_cast<GLuint const*>(reader.take(static_cast<std::size_t>(mesh.indices_nb) * sizeof(GLuint)));
+		if (reader.failed())
+			break;
+	}
+
+	scene.nodes.resize(reader.failed() ? 0u : header.nodes_nb);
+	for (auto& node : scene.nodes) {
+		node.name = reader.readString();
+		node.parent = reader.read<std::int32_t>();
+		node.translation = reader.read<glm::vec3>();
+		node.rotation = reader.read<glm::quat>();
+		node.scale = reader.read<glm::vec3>();
+		node.meshes.resize(reader.read<std::uint32_t>());
+		for (auto& mesh_index : node.meshes)
+			mesh_index = reader.read<std::uint32_t>();
+		if (reader.failed())
+			break;
+	}
+
+	if (reader.failed()) {
+		scene.materials.clear();
+		scene.meshes.clear();
+		scene.nodes.clear();
+		scene.mapping.close();
+		return false;
+	}
+
+	return true;
+}
+
+bool
+bonobo::object_cache::write(std::string const& cache_path, utils::file_stamp const& source_stamp,
+                            std::uint32_t import_flags, scene_source const& scene)
+{
+	// The cache is written next to its final location and only moved
+	// there once complete, so that a concurrent reader or a crash never
+	// leaves a partial cache behind.
+	auto const temporary_path = cache_path + ".tmp";
+	std::ofstream stream(utils::widen(temporary_path), std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+		return false;
+
+	cache_writer writer(stream);
+
+	// The final size is only known at the end; it is used by `read()` to
+	// detect truncated files.
+	cache_header header;
+	std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+	header.version = cache_version;
+	header.import_flags = import_flags;
+	header.source_size = source_stamp.size;
+	header.source_modification_time = source_stamp.modification_time;
+	header.file_size = 0u;
+	header.materials_nb = static_cast<std::uint32_t>(scene.materials.size());
+	header.meshes_nb = static_cast<std::uint32_t>(scene.meshes.size());
+	header.nodes_nb = static_cast<std::uint32_t>(scene.nodes.size());
+	header.padding = 0u;
+	writer.write(header);
+
+	for (auto const& material : scene.materials) {
+		writer.writeString(material.name);
+		writer.write(static_cast<std::uint32_t>(material.is_used ? 1u : 0u));
+		writeMaterialConstants(writer, material.constants);
+		writer.write(static_cast<std::uint32_t>(material.textures.size()));
+		for (auto const& texture : material.textures) {
+			writer.writeString(texture.type_as_str);
+			writer.writeString(texture.name);
+			writer.writeString(texture.path);
+		}
+	}
+
+	for (auto const& mesh : scene.meshes) {
+		std::uint32_t attributes = 0u;
+		if (mesh.normals != nullptr)
+			attributes |= has_normals;
+		if (mesh.texcoords != nullptr)
+			attributes |= has_texcoords;
+		if (mesh.tangents != nullptr && mesh.binormals != nullptr)
+			attributes |= has_tangents_and_binormals;
+
+		writer.writeString(mesh.name);
+		writer.write(mesh.material_index);
+		writer.write(static_cast<std::uint32_t>(mesh.drawing_mode));
+		writer.write(mesh.vertices_nb);
+		writer.write(mesh.indices_nb);
+		writer.write(attributes);
+		writer.align();
+
+		auto const attribute_size = static_cast<std::size_t>(mesh.vertices_nb) * sizeof(glm::vec3);
+		writer.write(mesh.vertices, attribute_size);
+		if (attributes & has_normals)
+			writer.write(mesh.normals, attribute_size);
+		if (attributes & has_texcoords)
+			writer.write(mesh.texcoords, attribute_size);
+		if (attributes & has_tangents_and_binormals) {
+			writer.write(mesh.tangents, attribute_size);
+			writer.write(mesh.binormals, attribute_size);
+		}
+		writer.write(mesh.indices, static_cast<std::size_t>(mesh.indices_nb) * sizeof(GLuint));
+	}
+
+	for (auto const& node : scene.nodes) {
+		writer.writeString(node.name);
+		writer.write(node.parent);
+		writer.write(node.translation);
+		writer.write(node.rotation);
+		writer.write(node.scale);
+		writer.write(static_cast<std::uint32_t>(node.meshes.size()));
+		for (auto const mesh_index : node.meshes)
+			writer.write(mesh_index);
+	}
+
+	header.file_size = writer.offset();
+	stream.seekp(0);
+	stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	stream.close();
+	if (!stream.good()) {
+		utils::remove_file(temporary_path);
+		return false;
+	}
+
+	return utils::replace_file(temporary_path, cache_path);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "helpers.hpp"
+#include "mesh_upload.hpp"
+#include "various.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Texture referenced by a material, before being loaded.
+	struct texture_source {
+		std::string type_as_str; //!< human-readable slot, e.g. "diffuse"
+		std::string name;        //!< GLSL sampler name, e.g. "diffuse_texture"
+		std::string path;        //!< path relative to the scene file
+	};
+
+	//! \brief CPU-side description of a material, before its textures
+	//!        are loaded.
+	struct material_source {
+		std::string name;
+		bool is_used{ false };   //!< whether any mesh refers to it
+		material_data constants{};
+		std::vector<texture_source> textures;
+	};
+
+	//! \brief CPU-side content of an object/scene file.
+	struct scene_source {
+		std::vector<material_source> materials;
+		std::vector<mesh_source> meshes;
+		std::vector<scene_node> nodes; //!< depth-first, starting with the root
+		utils::mapped_file mapping; //!< backing storage when read from a cache
+	};
+
+	namespace object_cache
+	{
+		//! \brief Path of the cache file associated to an object/scene file.
+		std::string getPath(std::string const& filename);
+
+		//! \brief Map a cache file and point `scene` into it.
+		//!
+		//! @param [in] cache_path path of the cache file
+		//! @param [in] source_stamp stamp of the object/scene file the
+		//!             cache was derived from
+		//! @param [in] import_flags Assimp post-processing flags that were
+		//!             used for importing the object/scene file
+		//! @param [out] scene filled in on success
+		//! @return false if the cache is missing, corrupted or out of
+		//!         date, in which case `scene` is left empty
+		bool read(std::string const& cache_path, utils::file_stamp const& source_stamp,
+		          std::uint32_t import_flags, scene_source& scene);
+
+		//! \brief Write the content of `scene` to a cache file.
+		//!
+		//! @return whether the whole cache could be written
+		bool write(std::string const& cache_path, utils::file_stamp const& source_stamp,
+		           std::uint32_t import_flags, scene_source const& scene);
+	}
+}
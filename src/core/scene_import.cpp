@@ -0,0 +1,236 @@
+#include "scene_import.hpp"
+
+#include "core/various.hpp"
+
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	void addMessage(bonobo::scene_import_report& report, Log::Type type, char const* format, ...)
+	{
+		char buffer[1024];
+		va_list arguments;
+		va_start(arguments, format);
+		std::vsnprintf(buffer, sizeof(buffer), format, arguments);
+		va_end(arguments);
+
+		report.messages.emplace_back(type, std::string(buffer));
+	}
+
+	bool importWithAssimp(Assimp::Importer& importer, std::string const& filename, unsigned int import_flags,
+	                      bonobo::scene_source& scene, bonobo::scene_import_report& report)
+	{
+		auto const assimp_scene = importer.ReadFile(filename, import_flags);
+		if (assimp_scene == nullptr || assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || assimp_scene->mRootNode == nullptr) {
+			addMessage(report, Log::TYPE_ERROR, "Assimp failed to load \"%s\": %s", filename.c_str(), importer.GetErrorString());
+			return false;
+		}
+
+		if (assimp_scene->mNumMeshes == 0u) {
+			addMessage(report, Log::TYPE_ERROR, "No mesh available; loading \"%s\" must have had issues", filename.c_str());
+			return false;
+		}
+
+		scene.materials.resize(assimp_scene->mNumMaterials);
+		for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j) {
+			auto const assimp_object_mesh = assimp_scene->mMeshes[j];
+			auto const material_id = assimp_object_mesh->mMaterialIndex;
+			if (material_id >= assimp_scene->mNumMaterials)
+				addMessage(report, Log::TYPE_ERROR, "Mesh \"%s\" has a material index of %u, but only %u materials are present.", assimp_object_mesh->mName.C_Str(), material_id, assimp_scene->mNumMaterials);
+			else
+				scene.materials[material_id].is_used = true;
+		}
+
+		for (size_t i = 0; i < assimp_scene->mNumMaterials; ++i) {
+			auto& material_source = scene.materials[i];
+			if (!material_source.is_used)
+				continue;
+
+			auto const material = assimp_scene->mMaterials[i];
+			material_source.name = material->GetName().C_Str();
+
+			auto const gather_texture = [&material,&material_source,&report](aiTextureType type, std::string const& type_as_str, std::string const& name){
+				if (material->GetTextureCount(type) == 0u)
+					return;
+
+				if (material->GetTextureCount(type) > 1)
+					addMessage(report, Log::TYPE_WARNING, "Material \"%s\" has more than one %s texture: discarding all but the first one.", material->GetName().C_Str(), type_as_str.c_str());
+				aiString path;
+				material->GetTexture(type, 0, &path);
+				material_source.textures.push_back({ type_as_str, name, std::string(path.C_Str()) });
+			};
+
+			aiColor3D color;
+			auto& constants = material_source.constants;
+
+			material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
+			constants.diffuse = glm::vec3(color.r, color.g, color.b);
+			material->Get(AI_MATKEY_COLOR_SPECULAR, color);
+			constants.specular = glm::vec3(color.r, color.g, color.b);
+			material->Get(AI_MATKEY_COLOR_AMBIENT, color);
+			constants.ambient = glm::vec3(color.r, color.g, color.b);
+			material->Get(AI_MATKEY_COLOR_EMISSIVE, color);
+			constants.emissive = glm::vec3(color.r, color.g, color.b);
+			material->Get(AI_MATKEY_SHININESS, constants.shininess);
+			material->Get(AI_MATKEY_REFRACTI, constants.indexOfRefraction);
+			material->Get(AI_MATKEY_OPACITY, constants.opacity);
+
+			gather_texture(aiTextureType_DIFFUSE,  "diffuse",  "diffuse_texture");
+			gather_texture(aiTextureType_SPECULAR, "specular", "specular_texture");
+			gather_texture(aiTextureType_NORMALS,  "normals",  "normals_texture");
+			gather_texture(aiTextureType_OPACITY,  "opacity",  "opacity_texture");
+			gather_texture(aiTextureType_EMISSIVE,  "emissive",  "emissive_texture");
+		}
+
+		// Index of each Assimp mesh within `scene.meshes`, as unsupported
+		// ones get skipped.
+		std::vector<std::int64_t> mesh_indices(assimp_scene->mNumMeshes, -1);
+		scene.meshes.reserve(assimp_scene->mNumMeshes);
+		for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j) {
+			auto const assimp_object_mesh = assimp_scene->mMeshes[j];
+
+			if (!assimp_object_mesh->HasFaces()) {
+				addMessage(report, Log::TYPE_ERROR, "Unsupported mesh \"%s\": has no faces", assimp_object_mesh->mName.C_Str());
+				continue;
+			}
+			if ((assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_POINT | aiPrimitiveType_NGONEncodingFlag))    != 0u
+			 && (assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_LINE | aiPrimitiveType_NGONEncodingFlag))     != 0u
+			 && (assimp_object_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_TRIANGLE | aiPrimitiveType_NGONEncodingFlag)) != 0u) {
+				addMessage(report, Log::TYPE_ERROR, "Unsupported mesh \"%s\": uses multiple primitive types", assimp_object_mesh->mName.C_Str());
+				continue;
+			}
+			if ((assimp_object_mesh->mPrimitiveTypes & static_cast<uint32_t>(aiPrimitiveType_POLYGON)) == static_cast<uint32_t>(aiPrimitiveType_POLYGON)) {
+				addMessage(report, Log::TYPE_ERROR, "Unsupported mesh \"%s\": uses polygons", assimp_object_mesh->mName.C_Str());
+				continue;
+			}
+			if (!assimp_object_mesh->HasPositions()) {
+				addMessage(report, Log::TYPE_ERROR, "Unsupported mesh \"%s\": has no positions", assimp_object_mesh->mName.C_Str());
+				continue;
+			}
+
+			mesh_indices[j] = static_cast<std::int64_t>(scene.meshes.size());
+			scene.meshes.emplace_back();
+			auto& mesh = scene.meshes.back();
+			if (assimp_object_mesh->mName.length != 0)
+				mesh.name = std::string(assimp_object_mesh->mName.C_Str());
+			else
+				mesh.name = bonobo::mesh_data().name;
+			mesh.material_index = assimp_object_mesh->mMaterialIndex;
+			mesh.vertices_nb = assimp_object_mesh->mNumVertices;
+
+			static_assert(sizeof(glm::vec3) == sizeof(aiVector3D), "Assimp vectors are expected to be laid out as glm::vec3");
+			mesh.vertices = reinterpret_cast<glm::vec3 const*>(assimp_object_mesh->mVertices);
+			if (assimp_object_mesh->HasNormals())
+				mesh.normals = reinterpret_cast<glm::vec3 const*>(assimp_object_mesh->mNormals);
+			if (assimp_object_mesh->HasTextureCoords(0u))
+				mesh.texcoords = reinterpret_cast<glm::vec3 const*>(assimp_object_mesh->mTextureCoords[0u]);
+			if (assimp_object_mesh->HasTangentsAndBitangents()) {
+				mesh.tangents = reinterpret_cast<glm::vec3 const*>(assimp_object_mesh->mTangents);
+				mesh.binormals = reinterpret_cast<glm::vec3 const*>(assimp_object_mesh->mBitangents);
+			}
+
+			auto const num_vertices_per_face = assimp_object_mesh->mFaces[0u].mNumIndices;
+			mesh.indices_nb = assimp_object_mesh->mNumFaces * num_vertices_per_face;
+			mesh.indices_storage.resize(mesh.indices_nb);
+			for (size_t i = 0u; i < assimp_object_mesh->mNumFaces; ++i) {
+				auto const& face = assimp_object_mesh->mFaces[i];
+				assert(face.mNumIndices <= 3);
+				mesh.indices_storage[num_vertices_per_face * i + 0u] = face.mIndices[0u];
+				if (num_vertices_per_face > 1u)
+					mesh.indices_storage[num_vertices_per_face * i + 1u] = face.mIndices[1u];
+				if (num_vertices_per_face > 2u)
+					mesh.indices_storage[num_vertices_per_face * i + 2u] = face.mIndices[2u];
+			}
+			mesh.indices = mesh.indices_storage.data();
+		}
+
+		// Flatten the node hierarchy depth-first, so that parents come
+		// before their children.
+		std::vector<std::pair<aiNode const*, std::int32_t>> pending_nodes{ { assimp_scene->mRootNode, -1 } };
+		while (!pending_nodes.empty()) {
+			auto const assimp_node = pending_nodes.back().first;
+			auto const parent = pending_nodes.back().second;
+			pending_nodes.pop_back();
+
+			scene.nodes.emplace_back();
+			auto& node = scene.nodes.back();
+			node.name = assimp_node->mName.C_Str();
+			node.parent = parent;
+
+			aiVector3t<ai_real> scaling, position;
+			aiQuaterniont<ai_real> rotation;
+			assimp_node->mTransformation.Decompose(scaling, rotation, position);
+			node.translation = glm::vec3(position.x, position.y, position.z);
+			node.rotation = glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+			node.scale = glm::vec3(scaling.x, scaling.y, scaling.z);
+
+			for (unsigned int m = 0u; m < assimp_node->mNumMeshes; ++m) {
+				auto const mesh_index = mesh_indices[assimp_node->mMeshes[m]];
+				if (mesh_index >= 0)
+					node.meshes.push_back(static_cast<std::uint32_t>(mesh_index));
+			}
+
+			auto const node_index = static_cast<std::int32_t>(scene.nodes.size() - 1u);
+			for (auto i = assimp_node->mNumChildren; i > 0u; --i)
+				pending_nodes.emplace_back(assimp_node->mChildren[i - 1u], node_index);
+		}
+
+		return !scene.meshes.empty();
+	}
+}
+
+bool
+bonobo::importScene(std::string const& filename, bool use_object_cache,
+                    Assimp::Importer& importer, scene_source& scene,
+                    scene_import_report& report)
+{
+	auto const start_time = std::chrono::high_resolution_clock::now();
+
+	// The cache has to be invalidated whenever those flags change, as they
+	// affect the imported geometry.
+	auto const import_flags = static_cast<std::uint32_t>(aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_CalcTangentSpace);
+	auto const cache_path = object_cache::getPath(filename);
+	utils::file_stamp source_stamp;
+	bool const use_cache = use_object_cache && utils::get_file_stamp(filename, source_stamp);
+
+	report.is_from_cache = use_cache && object_cache::read(cache_path, source_stamp, import_flags, scene);
+	if (!report.is_from_cache) {
+		if (!importWithAssimp(importer, filename, import_flags, scene, report))
+			return false;
+		if (use_cache && !object_cache::write(cache_path, source_stamp, import_flags, scene))
+			addMessage(report, Log::TYPE_WARNING, "Failed to write the object cache \"%s\"", cache_path.c_str());
+	}
+
+	auto const end_time = std::chrono::high_resolution_clock::now();
+	report.import_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
+
+	return true;
+}
+
+void
+bonobo::logSceneImportReport(scene_import_report const& report)
+{
+	for (auto const& message : report.messages)
+		LogType(message.first, "%s", message.second.c_str());
+}
+
+bonobo::texture_role_t
+bonobo::getTextureRole(texture_source const& texture)
+{
+	if (texture.type_as_str == "diffuse" || texture.type_as_str == "emissive")
+		return texture_role_t::color;
+	if (texture.type_as_str == "specular" || texture.type_as_str == "opacity")
+		return texture_role_t::mask;
+	if (texture.type_as_str == "normals")
+		return texture_role_t::normal_map;
+	return texture_role_t::generic;
+}
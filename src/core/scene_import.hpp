@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core/Log.h"
+#include "object_cache.hpp"
+
+#include <assimp/Importer.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Outcome of `importScene()`, which does not log anything
+	//!        itself so that it can run on worker threads.
+	struct scene_import_report {
+		bool is_from_cache{ false };
+		float import_time_ms{ 0.0f };
+		std::vector<std::pair<Log::Type, std::string>> messages;
+	};
+
+	//! \brief Read the CPU-side content of an object/scene file, either
+	//!        from its object cache or through Assimp.
+	//!
+	//! @param [in] filename of the object/scene file to load
+	//! @param [in] use_object_cache see `object_load_options::use_object_cache`
+	//! @param [in,out] importer owns the data pointed to by `scene` when it
+	//!                 is not read from the cache, so must outlive it
+	//! @param [out] scene filled in on success
+	//! @param [out] report errors, warnings and timings to be logged by
+	//!              the caller, e.g. with `logSceneImportReport()`
+	//! @return whether at least one mesh could be read
+	bool importScene(std::string const& filename, bool use_object_cache,
+	                 Assimp::Importer& importer, scene_source& scene,
+	                 scene_import_report& report);
+
+	//! \brief Log the messages gathered by `importScene()`.
+	void logSceneImportReport(scene_import_report const& report);
+
+	//! \brief Role of a texture given the material slot it comes from:
+	//!        diffuse and emissive maps are colours, specular and
+	//!        opacity maps are masks, and normal maps are normal maps.
+	texture_role_t getTextureRole(texture_source const& texture);
+}
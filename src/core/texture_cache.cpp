@@ -0,0 +1,350 @@
+#include "texture_cache.hpp"
+
+#include "block_compressor.hpp"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	// Bump whenever the layout below changes, to discard older caches.
+	std::uint32_t const cache_version = 4u;
+	char const cache_magic[8] = { 'B', 'O', 'N', 'O', 'B', 'O', 'T', 'C' };
+	// Images are always decoded as RGBA, and only then stripped of the
+	// channels their role does not need.
+	std::uint32_t const decoded_channels_nb = 4u;
+
+	struct cache_header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t flip;
+		std::uint64_t source_size;
+		std::int64_t source_modification_time;
+		std::uint64_t file_size;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t levels_nb;
+		std::uint32_t mips;
+		std::uint32_t channels_nb;
+		std::uint32_t format;
+		float psnr_db;
+	};
+
+	std::uint32_t encodeMipSettings(bonobo::mip_settings const& mips)
+	{
+		return static_cast<std::uint32_t>(mips.filter) | (mips.is_srgb ? 1u << 8 : 0u);
+	}
+
+	// Colour maps get filtered in linear space whatever the settings.
+	bonobo::mip_settings getEffectiveMipSettings(bonobo::mip_settings const& mips, bonobo::texture_role_t role)
+	{
+		auto effective_mips = mips;
+		if (role == bonobo::texture_role_t::color)
+			effective_mips.is_srgb = true;
+		return effective_mips;
+	}
+
+	char const* getRoleSuffix(bonobo::texture_role_t role)
+	{
+		switch (role) {
+		case bonobo::texture_role_t::color:      return ".color";
+		case bonobo::texture_role_t::mask:       return ".mask";
+		case bonobo::texture_role_t::normal_map: return ".normal_map";
+		default:                                 return "";
+		}
+	}
+
+	// Move the first `channels_nb` channels of each texel to the front
+	// of the buffer, in place; as texels only move towards the start,
+	// none gets overwritten before being read.
+	void keepChannels(std::uint8_t* texels, std::size_t texels_nb, std::uint32_t channels_nb)
+	{
+		if (channels_nb == decoded_channels_nb)
+			return;
+		for (std::size_t i = 0u; i < texels_nb; ++i)
+			for (std::uint32_t c = 0u; c < channels_nb; ++c)
+				texels[i * channels_nb + c] = texels[i * decoded_channels_nb + c];
+	}
+
+	std::size_t getLevelSize(std::uint32_t width, std::uint32_t height, std::uint32_t channels_nb,
+	                         bonobo::block_format_t format)
+	{
+		if (format != bonobo::block_format_t::none)
+			return bonobo::block_compressor::getCompressedSize(format, width, height);
+		return static_cast<std::size_t>(width) * height * channels_nb;
+	}
+
+	// Whether blocks of the given format can hold that many channels, as
+	// picked by `block_compressor::getFormat()`.
+	bool isFormatValid(bonobo::block_format_t format, std::uint32_t channels_nb)
+	{
+		switch (format) {
+		case bonobo::block_format_t::none: return true;
+		case bonobo::block_format_t::bc1:
+		case bonobo::block_format_t::bc3:  return channels_nb == 4u;
+		case bonobo::block_format_t::bc4:  return channels_nb == 1u;
+		case bonobo::block_format_t::bc5:  return channels_nb == 2u;
+		default:                           return false;
+		}
+	}
+
+	std::uint32_t getLevelsCount(std::uint32_t width, std::uint32_t height)
+	{
+		std::uint32_t levels_nb = 1u;
+		while (width > 1u || height > 1u) {
+			width = std::max(width / 2u, 1u);
+			height = std::max(height / 2u, 1u);
+			++levels_nb;
+		}
+		return levels_nb;
+	}
+
+	std::size_t getChainSize(std::uint32_t width, std::uint32_t height, std::uint32_t levels_nb, std::uint32_t channels_nb,
+	                         bonobo::block_format_t format)
+	{
+		std::size_t size = 0u;
+		for (std::uint32_t i = 0u; i < levels_nb; ++i) {
+			size += getLevelSize(width, height, channels_nb, format);
+			width = std::max(width / 2u, 1u);
+			height = std::max(height / 2u, 1u);
+		}
+		return size;
+	}
+
+	// Add `levels_nb` levels to `image`, pointing into a contiguous
+	// buffer holding them all, finest first.
+	void appendLevels(bonobo::mipmapped_image& image, std::uint8_t const* texels,
+	                  std::uint32_t width, std::uint32_t height, std::uint32_t levels_nb)
+	{
+		for (std::uint32_t i = 0u; i < levels_nb; ++i) {
+			image.levels.push_back({ width, height, texels });
+			texels += getLevelSize(width, height, image.channels_nb, image.format);
+			width = std::max(width / 2u, 1u);
+			height = std::max(height / 2u, 1u);
+		}
+	}
+}
+
+std::uint32_t
+bonobo::getChannelsNb(texture_role_t role)
+{
+	switch (role) {
+	case texture_role_t::mask:       return 1u;
+	case texture_role_t::normal_map: return 2u;
+	default:                         return 4u;
+	}
+}
+
+char const*
+bonobo::getBlockFormatName(block_format_t format)
+{
+	switch (format) {
+	case block_format_t::bc1: return "BC1";
+	case block_format_t::bc3: return "BC3";
+	case block_format_t::bc4: return "BC4";
+	case block_format_t::bc5: return "BC5";
+	default:                  return "uncompressed";
+	}
+}
+
+std::size_t
+bonobo::getLevelDataSize(mipmapped_image const& image, std::size_t level)
+{
+	return getLevelSize(image.levels[level].width, image.levels[level].height, image.channels_nb, image.format);
+}
+
+bonobo::image_buffer
+bonobo::allocateImageBuffer(std::size_t size)
+{
+	return image_buffer(static_cast<std::uint8_t*>(std::malloc(size)), std::free);
+}
+
+std::string
+bonobo::texture_cache::getPath(std::string const& filename, bool flip, mip_settings const& mips,
+                               texture_role_t role, bool compress)
+{
+	auto const effective_mips = getEffectiveMipSettings(mips, role);
+	return filename + (flip ? ".flipped" : "")
+	     + (effective_mips.filter == mip_filter_t::kaiser ? ".kaiser" : "")
+	     + (effective_mips.is_srgb ? ".srgb" : "")
+	     + getRoleSuffix(role)
+	     + (compress ? ".bc" : "")
+	     + ".bonobo_cache";
+}
+
+bool
+bonobo::texture_cache::read(std::string const& cache_path, utils::file_stamp const& source_stamp,
+                            bool flip, mip_settings const& mips, texture_role_t role, bool compress,
+                            mipmapped_image& image, float& psnr_db)
+{
+	image.levels.clear();
+	image.channels_nb = getChannelsNb(role);
+	image.format = block_format_t::none;
+	auto mapping = std::make_unique<utils::mapped_file>();
+	if (!mapping->open(cache_path) || mapping->size() < sizeof(cache_header))
+		return false;
+
+	cache_header header;
+	std::memcpy(&header, mapping->data(), sizeof(header));
+	if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0
+	 || header.version != cache_version
+	 || header.flip != (flip ? 1u : 0u)
+	 || header.mips != encodeMipSettings(getEffectiveMipSettings(mips, role))
+	 || header.channels_nb != image.channels_nb
+	 || (header.format != static_cast<std::uint32_t>(block_format_t::none)) != compress
+	 || !isFormatValid(static_cast<block_format_t>(header.format), header.channels_nb)
+	 || header.source_size != source_stamp.size
+	 || header.source_modification_time != source_stamp.modification_time
+	 || header.file_size != mapping->size()
+	 || header.width == 0u || header.height == 0u
+	 || header.levels_nb == 0u || header.levels_nb > getLevelsCount(header.width, header.height))
+		return false;
+
+	auto const format = static_cast<block_format_t>(header.format);
+	if (sizeof(cache_header) + getChainSize(header.width, header.height, header.levels_nb, image.channels_nb, format) != mapping->size())
+		return false;
+
+	image.format = format;
+	psnr_db = header.psnr_db;
+
+	appendLevels(image, mapping->data() + sizeof(cache_header), header.width, header.height, header.levels_nb);
+	image.storage.clear();
+	image.mapping = std::move(mapping);
+
+	return true;
+}
+
+bool
+bonobo::texture_cache::write(std::string const& cache_path, utils::file_stamp const& source_stamp,
+                             bool flip, mip_settings const& mips, texture_role_t role,
+                             mipmapped_image const& image, float psnr_db)
+{
+	if (image.levels.empty() || image.channels_nb != getChannelsNb(role))
+		return false;
+
+	// As for object caches, the file is only moved into place once
+	// complete.
+	auto const temporary_path = cache_path + ".tmp";
+	std::ofstream stream(utils::widen(temporary_path), std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+		return false;
+
+	cache_header header;
+	std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+	header.version = cache_version;
+	header.flip = flip ? 1u : 0u;
+	header.source_size = source_stamp.size;
+	header.source_modification_time = source_stamp.modification_time;
+	header.file_size = sizeof(cache_header);
+	header.width = image.levels.front().width;
+	header.height = image.levels.front().height;
+	header.levels_nb = static_cast<std::uint32_t>(image.levels.size());
+	header.mips = encodeMipSettings(getEffectiveMipSettings(mips, role));
+	header.channels_nb = image.channels_nb;
+	header.format = static_cast<std::uint32_t>(image.format);
+	header.psnr_db = psnr_db;
+	for (std::size_t level = 0u; level < image.levels.size(); ++level)
+		header.file_size += getLevelDataSize(image, level);
+
+	stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	for (std::size_t level = 0u; level < image.levels.size(); ++level)
+		stream.write(reinterpret_cast<char const*>(image.levels[level].texels), static_cast<std::streamsize>(getLevelDataSize(image, level)));
+	stream.close();
+	if (!stream.good()) {
+		utils::remove_file(temporary_path);
+		return false;
+	}
+
+	return utils::replace_file(temporary_path, cache_path);
+}
+
+void
+bonobo::texture_cache::generateMipChain(mipmapped_image& image, mip_settings const& mips,
+                                        mip_generator::execution_policy const& policy)
+{
+	if (image.levels.empty())
+		return;
+	assert(image.format == block_format_t::none);
+
+	auto const width = image.levels.front().width;
+	auto const height = image.levels.front().height;
+	auto const levels_nb = getLevelsCount(width, height);
+	image.levels.resize(1u);
+	if (levels_nb == 1u)
+		return;
+
+	auto const next_width = std::max(width / 2u, 1u);
+	auto const next_height = std::max(height / 2u, 1u);
+	auto block = allocateImageBuffer(getChainSize(next_width, next_height, levels_nb - 1u, image.channels_nb, image.format));
+	appendLevels(image, block.get(), next_width, next_height, levels_nb - 1u);
+	image.storage.push_back(std::move(block));
+
+	for (std::uint32_t i = 1u; i < levels_nb; ++i) {
+		auto const& source = image.levels[i - 1u];
+		mip_generator::generateLevel(source.texels, source.width, source.height,
+		                             const_cast<std::uint8_t*>(image.levels[i].texels), image.channels_nb,
+		                             mips, policy);
+	}
+}
+
+bonobo::mipmapped_image
+bonobo::texture_cache::load(std::string const& filename, bool flip, mip_settings const& mips,
+                            texture_role_t role, bool compress, bool use_cache, load_report& report)
+{
+	auto const start_time = std::chrono::high_resolution_clock::now();
+	report = load_report();
+	mipmapped_image image;
+
+	utils::file_stamp source_stamp;
+	auto const cache_path = getPath(filename, flip, mips, role, compress);
+	use_cache = use_cache && utils::get_file_stamp(filename, source_stamp);
+	if (use_cache && read(cache_path, source_stamp, flip, mips, role, compress, image, report.psnr_db)) {
+		report.was_cached = true;
+		report.decode_time_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+		return image;
+	}
+
+	int width = 0, height = 0;
+	stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
+	unsigned char* image_data = stbi_load(filename.c_str(), &width, &height, nullptr, static_cast<int>(decoded_channels_nb));
+	if (image_data == nullptr)
+		return image;
+	image.channels_nb = getChannelsNb(role);
+	keepChannels(image_data, static_cast<std::size_t>(width) * height, image.channels_nb);
+
+	// Adopt stb's buffer as the first level rather than copying it; the
+	// other levels get a block of their own.
+	image.storage.emplace_back(image_data, stbi_image_free);
+	image.levels.push_back({ static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), image_data });
+
+	auto const mips_start_time = std::chrono::high_resolution_clock::now();
+	generateMipChain(image, getEffectiveMipSettings(mips, role));
+	auto const mips_end_time = std::chrono::high_resolution_clock::now();
+
+	// The quality is measured against the uncompressed image, before it
+	// gets replaced.
+	auto const format = compress ? block_compressor::getFormat(image) : block_format_t::none;
+	if (format != block_format_t::none) {
+		auto compressed = block_compressor::compress(image, format);
+		report.psnr_db = block_compressor::computePsnr(image, compressed);
+		image = std::move(compressed);
+	}
+	auto const compression_end_time = std::chrono::high_resolution_clock::now();
+
+	if (use_cache)
+		write(cache_path, source_stamp, flip, mips, role, image, report.psnr_db);
+
+	auto const end_time = std::chrono::high_resolution_clock::now();
+	report.mip_generation_time_ms = std::chrono::duration<float, std::milli>(mips_end_time - mips_start_time).count();
+	report.compression_time_ms = std::chrono::duration<float, std::milli>(compression_end_time - mips_end_time).count();
+	report.decode_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count()
+	                      - report.mip_generation_time_ms - report.compression_time_ms;
+
+	return image;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "mip_generator.hpp"
+#include "various.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Block of texels, released with the function matching the
+	//!        allocator it came from, e.g. `stbi_image_free()` for the
+	//!        buffers returned by stb, so that they can be adopted as is.
+	using image_buffer = std::unique_ptr<std::uint8_t, void (*)(void*)>;
+
+	//! \brief Allocate an uninitialised image buffer of `size` bytes.
+	image_buffer allocateImageBuffer(std::size_t size);
+
+	//! \brief What an image is used for, which decides which of its
+	//!        channels are kept and how `uploadTexture2D()` stores them.
+	enum class texture_role_t : std::uint32_t {
+		generic = 0u, //!< all four channels, stored as GL_RGBA8
+		color,        //!< all four channels, sRGB-encoded, stored as GL_SRGB8_ALPHA8; its mip chain is always filtered in linear space
+		mask,         //!< red channel only, stored as GL_R8; e.g. opacity or specular masks
+		normal_map    //!< red and green channels only, i.e. x and y, stored as GL_RG8; shaders reconstruct z as sqrt(1 - x² - y²)
+	};
+
+	//! \brief Number of channels kept for images with a given role.
+	std::uint32_t getChannelsNb(texture_role_t role);
+
+	//! \brief How the texels of an image are stored.
+	enum class block_format_t : std::uint32_t {
+		none = 0u, //!< one byte per channel and per texel
+		bc1,       //!< 4×4 blocks of 8 bytes, for opaque RGBA images; also known as DXT1
+		bc3,       //!< 4×4 blocks of 16 bytes, for RGBA images with alpha; also known as DXT5
+		bc4,       //!< 4×4 blocks of 8 bytes, for single-channel images; also known as RGTC1
+		bc5        //!< 4×4 blocks of 16 bytes, for two-channel images; also known as RGTC2
+	};
+
+	//! \brief Name of a block format, e.g. "BC1", for logging it.
+	char const* getBlockFormatName(block_format_t format);
+
+	//! \brief 8-bit image along with its mip chain, ready to be uploaded.
+	struct mipmapped_image {
+		struct level {
+			std::uint32_t width{ 0u };
+			std::uint32_t height{ 0u };
+			std::uint8_t const* texels{ nullptr };
+		};
+
+		std::vector<level> levels;                     //!< finest level first; empty if loading failed
+		std::uint32_t channels_nb{ 4u };               //!< 4 for RGBA, 2 for normal maps, 1 for masks; see `texture_role_t`
+		block_format_t format{ block_format_t::none }; //!< when not `none`, levels hold blocks covering `channels_nb` channels rather than texels
+		std::vector<image_buffer> storage;             //!< backing storage when decoded: the decoder's own buffer for the first level, then one block for all others
+		std::unique_ptr<utils::mapped_file> mapping;   //!< backing storage when read from the cache
+	};
+
+	//! \brief Number of bytes taken by a level of an image, be it made
+	//!        of texels or of blocks.
+	std::size_t getLevelDataSize(mipmapped_image const& image, std::size_t level);
+
+	namespace texture_cache
+	{
+		//! \brief Path of the cache file associated to an image; images
+		//!        loaded with different settings get different caches.
+		std::string getPath(std::string const& filename, bool flip, mip_settings const& mips,
+		                    texture_role_t role = texture_role_t::generic, bool compress = false);
+
+		//! \brief Map a cache file and point `image` into it.
+		//!
+		//! @param [out] psnr_db quality of the blocks when `compress` is
+		//!              set, as measured when they were encoded
+		//! @return false if the cache is missing, corrupted or out of
+		//!         date with respect to `source_stamp`
+		bool read(std::string const& cache_path, utils::file_stamp const& source_stamp,
+		          bool flip, mip_settings const& mips, texture_role_t role, bool compress,
+		          mipmapped_image& image, float& psnr_db);
+
+		//! \brief Write all the levels of `image` to a cache file.
+		//!
+		//! @param [in] psnr_db quality of the blocks, if `image` is
+		//!             compressed
+		//! @return whether the whole cache could be written; only images
+		//!         with as many channels as `role` requires can be
+		//!         cached
+		bool write(std::string const& cache_path, utils::file_stamp const& source_stamp,
+		           bool flip, mip_settings const& mips, texture_role_t role,
+		           mipmapped_image const& image, float psnr_db);
+
+		//! \brief Compute the whole mip chain of an image, each level
+		//!        being filtered out of the previous one with
+		//!        `mip_generator::generateLevel()`.
+		//!
+		//! The first level is left where it is; all others go into a
+		//! single new block of `storage`.
+		//!
+		//! @param [in,out] image with a single level, which gets extended
+		//!                 with all others
+		//! @param [in] mips which filter to use, and how to interpret the
+		//!             colour channels
+		//! @param [in] policy how to spread the work
+		void generateMipChain(mipmapped_image& image, mip_settings const& mips = mip_settings(),
+		                      mip_generator::execution_policy const& policy = mip_generator::execution_policy());
+
+		//! \brief What `load()` went through to get an image.
+		struct load_report {
+			bool was_cached{ false };             //!< whether the image came from the cache
+			float decode_time_ms{ 0.0f };         //!< reading the cache, or decoding the image and updating the cache
+			float mip_generation_time_ms{ 0.0f }; //!< 0 when the image came from the cache
+			float compression_time_ms{ 0.0f };    //!< 0 when the image came from the cache or was not compressed
+			float psnr_db{ 0.0f };                //!< quality of the first level once compressed, see `block_compressor::computePsnr()`; 0 when not compressed
+		};
+
+		//! \brief Get an image and its mip chain, from the cache if it is
+		//!        up to date, by decoding it and generating its mips
+		//!        otherwise (updating the cache if `use_cache` is set).
+		//!
+		//! When `compress` is set, all levels then get block-compressed
+		//! with `block_compressor::compress()`, in the format picked by
+		//! `block_compressor::getFormat()`; the cache then holds the
+		//! blocks rather than the texels.
+		//!
+		//! @param [in] filename of the image to load
+		//! @param [in] flip whether to flip the image vertically
+		//! @param [in] mips how to generate the mip chain
+		//! @param [in] role which channels to keep
+		//! @param [in] compress whether to block-compress the image
+		//! @param [in] use_cache whether to go through the cache at all
+		//! @param [out] report whether the cache was used, and timings
+		//! @return the loaded image, with `getChannelsNb(role)` channels,
+		//!         and no levels on failure
+		mipmapped_image load(std::string const& filename, bool flip, mip_settings const& mips,
+		                     texture_role_t role, bool compress, bool use_cache, load_report& report);
+	}
+}
@@ -0,0 +1,195 @@
+#include "texture_upload.hpp"
+
+#include "block_compressor.hpp"
+#include "helpers.hpp"
+#include "UploadManager.hpp"
+
+#include "core/Log.h"
+
+#include <cassert>
+#include <cstring>
+
+// S3TC formats come from GL_EXT_texture_compression_s3tc, and their sRGB
+// variants from GL_EXT_texture_sRGB, neither of which GLAD was generated
+// with.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#	define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#	define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#	define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#	define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace
+{
+	bool hasExtension(char const* name)
+	{
+		GLint extensions_nb = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensions_nb);
+		for (GLint i = 0; i < extensions_nb; ++i) {
+			auto const extension = reinterpret_cast<char const*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+			if (extension != nullptr && std::strcmp(extension, name) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	GLuint uploadCompressedTexture2D(bonobo::mipmapped_image const& image, bool generate_mipmap, bonobo::texture_role_t role)
+	{
+		auto& upload_manager = UploadManager::GetShared();
+
+		GLuint texture = 0u;
+		glGenTextures(1, &texture);
+		assert(texture != 0u);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		auto const levels_nb = generate_mipmap ? image.levels.size() : 1u;
+		// The driver cannot generate the missing levels of compressed
+		// textures, so only those provided are used.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels_nb - 1u));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		auto const internal_format = bonobo::getCompressedInternalFormat(image.format, role);
+		for (size_t level = 0u; level < levels_nb; ++level)
+			upload_manager.UploadCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internal_format,
+			                                          static_cast<GLsizei>(image.levels[level].width), static_cast<GLsizei>(image.levels[level].height),
+			                                          static_cast<GLsizei>(bonobo::getLevelDataSize(image, level)), image.levels[level].texels);
+		glBindTexture(GL_TEXTURE_2D, 0u);
+
+		return texture;
+	}
+}
+
+GLenum
+bonobo::getCompressedInternalFormat(block_format_t format, texture_role_t role)
+{
+	auto const is_srgb = role == texture_role_t::color;
+	switch (format) {
+	case block_format_t::bc1: return is_srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case block_format_t::bc3: return is_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case block_format_t::bc4: return GL_COMPRESSED_RED_RGTC1;
+	case block_format_t::bc5: return GL_COMPRESSED_RG_RGTC2;
+	default:                  return GL_NONE;
+	}
+}
+
+bool
+bonobo::isBlockFormatSupported(block_format_t format, texture_role_t role)
+{
+	static bool const has_s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+	static bool const has_srgb_s3tc = has_s3tc && hasExtension("GL_EXT_texture_sRGB");
+	switch (format) {
+	case block_format_t::bc1:
+	case block_format_t::bc3: return role == texture_role_t::color ? has_srgb_s3tc : has_s3tc;
+	case block_format_t::bc4:
+	case block_format_t::bc5: return true;
+	default:                  return false;
+	}
+}
+
+GLuint
+bonobo::uploadTexture2D(mipmapped_image const& image, bool generate_mipmap, texture_role_t role)
+{
+	if (image.format != block_format_t::none) {
+		if (isBlockFormatSupported(image.format, role))
+			return uploadCompressedTexture2D(image, generate_mipmap, role);
+
+		static bool was_warned = false;
+		if (!was_warned) {
+			LogWarning("%s textures are not supported by this OpenGL context; they will be uploaded uncompressed.",
+			           getBlockFormatName(image.format));
+			was_warned = true;
+		}
+		return uploadTexture2D(block_compressor::decompress(image), generate_mipmap, role);
+	}
+
+	auto& upload_manager = UploadManager::GetShared();
+
+	GLuint texture = 0u;
+	glGenTextures(1, &texture);
+	assert(texture != 0u);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLenum format = GL_RGBA;
+	GLint internal_format = role == texture_role_t::color ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+	switch (image.channels_nb) {
+	case 1u:
+		format = GL_RED;
+		internal_format = GL_R8;
+		break;
+	case 2u:
+		format = GL_RG;
+		internal_format = GL_RG8;
+		break;
+	default:
+		break;
+	}
+	auto const levels_nb = generate_mipmap ? image.levels.size() : 1u;
+	for (size_t level = 0u; level < levels_nb; ++level)
+		upload_manager.UploadTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internal_format,
+		                                static_cast<GLsizei>(image.levels[level].width), static_cast<GLsizei>(image.levels[level].height),
+		                                format, GL_UNSIGNED_BYTE, image.levels[level].texels);
+	if (generate_mipmap && image.levels.size() == 1u)
+		glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0u);
+
+	return texture;
+}
+
+std::uint32_t
+bonobo::getTextureKeyFlags(mip_settings const& mips)
+{
+	return (mips.filter == mip_filter_t::kaiser ? texture_key_kaiser : 0u)
+	     | (mips.is_srgb ? texture_key_srgb : 0u);
+}
+
+std::uint32_t
+bonobo::getTextureKeyFlags(texture_role_t role)
+{
+	switch (role) {
+	case texture_role_t::color:      return texture_key_color;
+	case texture_role_t::mask:       return texture_key_mask;
+	case texture_role_t::normal_map: return texture_key_normal_map;
+	default:                         return 0u;
+	}
+}
+
+std::uint64_t
+bonobo::getUploadedSize(mipmapped_image const& image, bool generate_mipmap)
+{
+	if (image.levels.empty())
+		return 0u;
+
+	std::uint64_t size = getLevelDataSize(image, 0u);
+	if (!generate_mipmap)
+		return size;
+	if (image.levels.size() == 1u && image.format == block_format_t::none)
+		return size * 4u / 3u;
+
+	for (size_t level = 1u; level < image.levels.size(); ++level)
+		size += getLevelDataSize(image, level);
+	return size;
+}
+
+std::uint64_t
+bonobo::getRgbaSize(mipmapped_image const& image, bool generate_mipmap)
+{
+	if (image.levels.empty())
+		return 0u;
+
+	auto const& base_level = image.levels.front();
+	std::uint64_t size = static_cast<std::uint64_t>(base_level.width) * base_level.height * 4u;
+	if (!generate_mipmap)
+		return size;
+	if (image.levels.size() == 1u)
+		return size * 4u / 3u;
+
+	for (size_t level = 1u; level < image.levels.size(); ++level)
+		size += static_cast<std::uint64_t>(image.levels[level].width) * image.levels[level].height * 4u;
+	return size;
+}
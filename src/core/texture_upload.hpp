@@ -0,0 +1,71 @@
+#pragma once
+
+#include "texture_cache.hpp"
+
+#include "core/opengl.hpp"
+
+#include <cstdint>
+
+namespace bonobo
+{
+	//! \brief Options affecting the content of a texture, used alongside
+	//!        its path(s) to key it in the texture registry.
+	enum texture_key_flags : std::uint32_t {
+		texture_key_flipped    = 1u << 0,
+		texture_key_mipmapped  = 1u << 1,
+		texture_key_cube_map   = 1u << 2,
+		texture_key_kaiser     = 1u << 3, //!< mip chain filtered with `mip_filter_t::kaiser`
+		texture_key_srgb       = 1u << 4, //!< mip chain filtered in linear space
+		texture_key_color      = 1u << 5, //!< see `texture_role_t::color`
+		texture_key_mask       = 1u << 6, //!< see `texture_role_t::mask`
+		texture_key_normal_map = 1u << 7, //!< see `texture_role_t::normal_map`
+		texture_key_compressed = 1u << 8  //!< block-compressed, see `block_compressor::compress()`
+	};
+
+	//! \brief Key flags matching the settings used to generate a mip
+	//!        chain.
+	std::uint32_t getTextureKeyFlags(mip_settings const& mips);
+
+	//! \brief Key flags matching the role of a texture.
+	std::uint32_t getTextureKeyFlags(texture_role_t role);
+
+	//! \brief Whether the current OpenGL context can store textures in a
+	//!        given block format; RGTC (BC4 and BC5) is part of the core
+	//!        profile, while S3TC (BC1 and BC3) is an extension.
+	//!
+	//! @param [in] format block format to check
+	//! @param [in] role what the texture is used for, as colour maps
+	//!             additionally need the sRGB variants of the format
+	bool isBlockFormatSupported(block_format_t format, texture_role_t role = texture_role_t::generic);
+
+	//! \brief Internal format storing blocks of a given format, in sRGB
+	//!        for colour maps.
+	GLenum getCompressedInternalFormat(block_format_t format, texture_role_t role = texture_role_t::generic);
+
+	//! \brief Create a 2D-texture out of an image and its mip chain.
+	//!
+	//! Block-compressed images are uploaded as they are, or expanded
+	//! back to texels first if the context does not support their
+	//! format; the texture then only gets the levels they provide.
+	//!
+	//! @param [in] image image to upload; must have at least one level
+	//! @param [in] generate_mipmap whether to upload the whole mip chain
+	//!             (or have the driver generate it, if `image` only has
+	//!             one level) or only the first level
+	//! @param [in] role what the image is used for; the internal format
+	//!             follows its number of channels, and is sRGB for
+	//!             four-channel colour maps
+	//! @return the name of the OpenGL 2D-texture
+	GLuint uploadTexture2D(mipmapped_image const& image, bool generate_mipmap,
+	                       texture_role_t role = texture_role_t::generic);
+
+	//! \brief Size of the texture created by `uploadTexture2D()`, ignoring
+	//!        any padding added by the driver; compressed images count
+	//!        their blocks.
+	std::uint64_t getUploadedSize(mipmapped_image const& image, bool generate_mipmap);
+
+	//! \brief Size the texture created by `uploadTexture2D()` would take
+	//!        with four uncompressed channels, i.e. without any role nor
+	//!        block compression, for comparison.
+	std::uint64_t getRgbaSize(mipmapped_image const& image, bool generate_mipmap);
+}
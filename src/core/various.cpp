@@ -2,12 +2,19 @@
 
 #include "core/Log.h"
 
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
 #if defined(_WIN32)
 #include <Windows.h>
+#else
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #if defined(_WIN32)
@@ -88,3 +95,153 @@ utils::slurp_file(std::string const& path)
 
   return std::string(content.get());
 }
+
+bool
+utils::get_file_stamp(std::string const& path, file_stamp& stamp)
+{
+#if defined(_WIN32)
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!::GetFileAttributesExW(utils::widen(path).c_str(), GetFileExInfoStandard, &attributes))
+		return false;
+
+	stamp.size = (static_cast<std::uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	stamp.modification_time = static_cast<std::int64_t>((static_cast<std::uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime);
+#else
+	struct stat attributes;
+	if (::stat(path.c_str(), &attributes) != 0)
+		return false;
+
+	stamp.size = static_cast<std::uint64_t>(attributes.st_size);
+	// Whole seconds would miss a file being regenerated right after the
+	// files derived from it.
+#if defined(__APPLE__)
+	auto const& modification_time = attributes.st_mtimespec;
+#else
+	auto const& modification_time = attributes.st_mtim;
+#endif
+	stamp.modification_time = static_cast<std::int64_t>(modification_time.tv_sec) * 1000000000
+	                        + static_cast<std::int64_t>(modification_time.tv_nsec);
+#endif
+
+	return true;
+}
+
+bool
+utils::remove_file(std::string const& path)
+{
+#if defined(_WIN32)
+	return ::DeleteFileW(utils::widen(path).c_str()) != 0;
+#else
+	return ::unlink(path.c_str()) == 0;
+#endif
+}
+
+bool
+utils::replace_file(std::string const& from, std::string const& to)
+{
+#if defined(_WIN32)
+	if (::MoveFileExW(utils::widen(from).c_str(), utils::widen(to).c_str(), MOVEFILE_REPLACE_EXISTING))
+		return true;
+#else
+	if (::rename(from.c_str(), to.c_str()) == 0)
+		return true;
+#endif
+
+	remove_file(from);
+	return false;
+}
+
+std::string
+utils::get_canonical_path(std::string const& path)
+{
+#if defined(_WIN32)
+	char canonical_path[_MAX_PATH];
+	if (::_fullpath(canonical_path, path.c_str(), _MAX_PATH) == nullptr)
+		return path;
+#else
+	char canonical_path[PATH_MAX];
+	if (::realpath(path.c_str(), canonical_path) == nullptr)
+		return path;
+#endif
+
+	return std::string(canonical_path);
+}
+
+utils::mapped_file::~mapped_file()
+{
+	close();
+}
+
+bool
+utils::mapped_file::open(std::string const& path)
+{
+	close();
+
+#if defined(_WIN32)
+	_file = ::CreateFileW(utils::widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (_file == INVALID_HANDLE_VALUE) {
+		_file = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!::GetFileSizeEx(_file, &file_size) || file_size.QuadPart == 0) {
+		close();
+		return false;
+	}
+
+	_mapping = ::CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mapping == nullptr) {
+		close();
+		return false;
+	}
+
+	_data = static_cast<std::uint8_t const*>(::MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (_data == nullptr) {
+		close();
+		return false;
+	}
+	_size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+	int const file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat attributes;
+	if (::fstat(file, &attributes) != 0 || attributes.st_size == 0) {
+		::close(file);
+		return false;
+	}
+
+	void* const data = ::mmap(nullptr, static_cast<std::size_t>(attributes.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping keeps its own reference to the file.
+	::close(file);
+	if (data == MAP_FAILED)
+		return false;
+
+	_data = static_cast<std::uint8_t const*>(data);
+	_size = static_cast<std::size_t>(attributes.st_size);
+#endif
+
+	return true;
+}
+
+void
+utils::mapped_file::close()
+{
+#if defined(_WIN32)
+	if (_data != nullptr)
+		::UnmapViewOfFile(_data);
+	if (_mapping != nullptr)
+		::CloseHandle(_mapping);
+	if (_file != nullptr)
+		::CloseHandle(_file);
+	_mapping = nullptr;
+	_file = nullptr;
+#else
+	if (_data != nullptr)
+		::munmap(const_cast<std::uint8_t*>(_data), _size);
+#endif
+	_data = nullptr;
+	_size = 0u;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 
@@ -17,4 +19,70 @@ inline std::string const& widen(std::string const& utf8) { return utf8; }
 
 std::string slurp_file(std::string const& path);
 
+//! \brief Size and last modification time of a file, used for detecting
+//!        whether files derived from it are out of date.
+struct file_stamp {
+	std::uint64_t size{ 0u };
+	std::int64_t modification_time{ 0 }; //!< at the finest resolution the platform offers
+};
+
+//! \brief Retrieve the size and last modification time of a file.
+//!
+//! @param [in] path of the file to query
+//! @param [out] stamp filled in on success
+//! @return whether the file could be queried
+bool get_file_stamp(std::string const& path, file_stamp& stamp);
+
+//! \brief Delete a file.
+//!
+//! @return whether the file could be deleted
+bool remove_file(std::string const& path);
+
+//! \brief Move a file over another one, replacing it in a single step so
+//!        that readers either see the old or the new content in full.
+//!
+//! @param [in] from path of the file to move; it is removed on failure
+//! @param [in] to path of the file to replace, which may not exist yet
+//! @return whether the file could be moved
+bool replace_file(std::string const& from, std::string const& to);
+
+//! \brief Turn a path into an absolute one with all symbolic links, `.`
+//!        and `..` components resolved, so that different spellings of
+//!        the same file compare equal.
+//!
+//! @param [in] path of an existing file
+//! @return the canonical path, or `path` itself if it cannot be resolved
+std::string get_canonical_path(std::string const& path);
+
+//! \brief Read-only memory mapping of a whole file.
+//!
+//! The mapping stays valid until the object is destroyed.
+class mapped_file
+{
+public:
+	mapped_file() = default;
+	~mapped_file();
+	mapped_file(mapped_file const&) = delete;
+	mapped_file& operator=(mapped_file const&) = delete;
+
+	//! \brief Map the given file, closing any previous mapping.
+	//!
+	//! @param [in] path of the file to map
+	//! @return whether the file could be mapped; empty files cannot
+	bool open(std::string const& path);
+	void close();
+
+	bool is_open() const { return _data != nullptr; }
+	std::uint8_t const* data() const { return _data; }
+	std::size_t size() const { return _size; }
+
+private:
+	std::uint8_t const* _data{ nullptr };
+	std::size_t _size{ 0u };
+#if defined(_WIN32)
+	void* _file{ nullptr };
+	void* _mapping{ nullptr };
+#endif
+};
+
 } // end of namespace